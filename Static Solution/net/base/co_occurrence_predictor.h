@@ -0,0 +1,237 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_CO_OCCURRENCE_PREDICTOR_H_
+#define NET_BASE_CO_OCCURRENCE_PREDICTOR_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/containers/cxx20_erase.h"
+#include "base/containers/lru_cache.h"
+#include "base/memory/raw_ptr.h"
+#include "base/time/time.h"
+
+namespace net {
+
+// Learns which keys are seen together, and predicts the likely followers of a
+// key as soon as it is seen, so that its Delegate can warm them up.
+//
+// A "group" starts with the first key seen for a GroupKey that has no group
+// in progress, and covers all keys seen for that GroupKey within
+// Params::group_window. When a group ends, every key seen during it gains
+// confidence as a follower of the group's leading key, and every remembered
+// follower that was not seen loses some. Leading keys are remembered per
+// GroupKey.
+//
+// Both GroupKey and Key must be copyable and ordered by operator<.
+template <typename GroupKey, typename Key>
+class CoOccurrencePredictor {
+ public:
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    // Called for each confident follower of the leader of a group that has
+    // just started, most likely first. Returns true if the prediction was
+    // acted on, in which case it counts as a hit if |key| is seen before the
+    // group ends, and as a miss otherwise.
+    virtual bool OnPrediction(const Key& key) = 0;
+
+    // Called when a group that acted on predictions ends.
+    virtual void OnGroupEnded(size_t hits, size_t misses) = 0;
+  };
+
+  struct Params {
+    // Keys seen within this long of a group's first key belong to that group.
+    base::TimeDelta group_window;
+    // A follower is predicted once it has been seen with its leader this many
+    // more times than it has been missed.
+    int min_confidence;
+    // Maximum number of followers remembered, and predicted, per leading key.
+    size_t max_followers_per_leader;
+    // Maximum number of leading keys remembered.
+    size_t max_leaders;
+  };
+
+  using TimeFunc = base::TimeTicks (*)();
+
+  CoOccurrencePredictor(const Params& params,
+                        Delegate* delegate,
+                        TimeFunc time_func)
+      : params_(params),
+        delegate_(delegate),
+        time_func_(time_func),
+        followers_by_leader_(params.max_leaders) {
+    DCHECK(delegate_);
+    DCHECK_GT(params_.max_leaders, 0u);
+    DCHECK_GT(params_.max_followers_per_leader, 0u);
+  }
+
+  CoOccurrencePredictor(const CoOccurrencePredictor&) = delete;
+  CoOccurrencePredictor& operator=(const CoOccurrencePredictor&) = delete;
+
+  ~CoOccurrencePredictor() = default;
+
+  // Called whenever |key| is seen for |group_key|. Returns true if |key| was
+  // predicted for the group in progress, and the prediction was acted on.
+  bool OnKeySeen(const GroupKey& group_key, const Key& key) {
+    const base::TimeTicks now = time_func_();
+    EndExpiredGroups(now);
+
+    auto it = groups_.find(group_key);
+    if (it == groups_.end()) {
+      StartGroup(group_key, key, now);
+      return false;
+    }
+
+    Group& group = it->second;
+    if (key == group.leader)
+      return false;
+    group.seen.insert(key);
+    if (!group.pending_predictions.erase(key))
+      return false;
+    ++group.hits;
+    return true;
+  }
+
+  // Ends all groups in progress without learning from them. Learned
+  // associations are kept. Returns the number of predictions acted on that
+  // were neither hit nor missed yet.
+  size_t AbandonGroups() {
+    size_t pending_predictions = 0;
+    for (const auto& [group_key, group] : groups_)
+      pending_predictions += group.pending_predictions.size();
+    groups_.clear();
+    return pending_predictions;
+  }
+
+ private:
+  // Confidence is clamped to this value, so that an association that stops
+  // holding is forgotten after a few misses.
+  static constexpr int kMaxConfidence = 4;
+
+  using LeaderKey = std::pair<GroupKey, Key>;
+
+  struct Follower {
+    Key key;
+    int confidence;
+  };
+  using FollowerList = std::vector<Follower>;
+
+  struct Group {
+    Group(const Key& leader, base::TimeTicks start_time)
+        : leader(leader), start_time(start_time) {}
+
+    Key leader;
+    base::TimeTicks start_time;
+    // Keys other than |leader| seen during this group.
+    std::set<Key> seen;
+    // Keys predicted for this group that have not been seen yet.
+    std::set<Key> pending_predictions;
+    size_t hits = 0;
+  };
+  using GroupMap = std::map<GroupKey, Group>;
+
+  // Ends every group that started more than |params_.group_window| before
+  // |now|.
+  void EndExpiredGroups(base::TimeTicks now) {
+    auto it = groups_.begin();
+    while (it != groups_.end()) {
+      auto current = it++;
+      if (now - current->second.start_time > params_.group_window)
+        EndGroup(current);
+    }
+  }
+
+  // Learns from |it| and erases it.
+  void EndGroup(typename GroupMap::iterator it) {
+    const Group& group = it->second;
+    Learn(it->first, group);
+
+    const size_t misses = group.pending_predictions.size();
+    if (group.hits > 0 || misses > 0)
+      delegate_->OnGroupEnded(group.hits, misses);
+    groups_.erase(it);
+  }
+
+  // Starts a group of |group_key| led by |key| and predicts its confident
+  // followers.
+  void StartGroup(const GroupKey& group_key,
+                  const Key& key,
+                  base::TimeTicks now) {
+    Group& group = groups_.emplace(group_key, Group(key, now)).first->second;
+
+    auto followers_it = followers_by_leader_.Get(LeaderKey(group_key, key));
+    if (followers_it == followers_by_leader_.end())
+      return;
+
+    // Followers are kept sorted by decreasing confidence.
+    for (const Follower& follower : followers_it->second) {
+      if (follower.confidence < params_.min_confidence)
+        break;
+      if (delegate_->OnPrediction(follower.key))
+        group.pending_predictions.insert(follower.key);
+    }
+  }
+
+  // Updates the followers of the leader of |group| with its outcome.
+  void Learn(const GroupKey& group_key, const Group& group) {
+    const LeaderKey leader(group_key, group.leader);
+    auto followers_it = followers_by_leader_.Get(leader);
+    if (followers_it == followers_by_leader_.end()) {
+      if (group.seen.empty())
+        return;
+      followers_it = followers_by_leader_.Put(leader, FollowerList());
+    }
+    FollowerList& followers = followers_it->second;
+
+    // Penalize remembered followers that were not seen this time.
+    for (Follower& follower : followers) {
+      if (!group.seen.count(follower.key))
+        --follower.confidence;
+    }
+
+    for (const Key& key : group.seen) {
+      auto follower_it =
+          std::find_if(followers.begin(), followers.end(),
+                       [&key](const Follower& f) { return f.key == key; });
+      if (follower_it != followers.end()) {
+        follower_it->confidence =
+            std::min(follower_it->confidence + 1, kMaxConfidence);
+      } else {
+        followers.push_back({key, 1});
+      }
+    }
+
+    base::EraseIf(followers,
+                  [](const Follower& f) { return f.confidence <= 0; });
+    std::stable_sort(followers.begin(), followers.end(),
+                     [](const Follower& a, const Follower& b) {
+                       return a.confidence > b.confidence;
+                     });
+    if (followers.size() > params_.max_followers_per_leader)
+      followers.resize(params_.max_followers_per_leader);
+
+    if (followers.empty())
+      followers_by_leader_.Erase(followers_it);
+  }
+
+  const Params params_;
+  const raw_ptr<Delegate> delegate_;
+  const TimeFunc time_func_;
+
+  base::LRUCache<LeaderKey, FollowerList> followers_by_leader_;
+  GroupMap groups_;
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_CO_OCCURRENCE_PREDICTOR_H_
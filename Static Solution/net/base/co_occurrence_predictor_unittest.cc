@@ -0,0 +1,204 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/co_occurrence_predictor.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+namespace {
+
+using TestPredictor = CoOccurrencePredictor<std::string, std::string>;
+
+base::TimeTicks g_now;
+
+base::TimeTicks TestTimeFunc() {
+  return g_now;
+}
+
+class TestDelegate : public TestPredictor::Delegate {
+ public:
+  bool OnPrediction(const std::string& key) override {
+    predictions_.push_back(key);
+    return !declined_.count(key);
+  }
+
+  void OnGroupEnded(size_t hits, size_t misses) override {
+    hits_ += hits;
+    misses_ += misses;
+  }
+
+  void Decline(const std::string& key) { declined_.insert(key); }
+
+  const std::vector<std::string>& predictions() const { return predictions_; }
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  std::set<std::string> declined_;
+  std::vector<std::string> predictions_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+class CoOccurrencePredictorTest : public testing::Test {
+ protected:
+  CoOccurrencePredictorTest() { g_now = base::TimeTicks() + base::Days(1); }
+
+  void CreatePredictor(size_t max_followers_per_leader = 16) {
+    params_ = {base::Seconds(5), /*min_confidence=*/2, max_followers_per_leader,
+               /*max_leaders=*/512};
+    predictor_ =
+        std::make_unique<TestPredictor>(params_, &delegate_, &TestTimeFunc);
+  }
+
+  // Sees |leader| followed by |followers| for |group_key| in a fresh group,
+  // and returns how many of them were hits.
+  size_t RunGroup(const std::string& group_key,
+                  const std::string& leader,
+                  const std::vector<std::string>& followers) {
+    g_now += params_.group_window + base::Seconds(1);
+    size_t hits = 0;
+    if (predictor_->OnKeySeen(group_key, leader))
+      ++hits;
+    for (const std::string& follower : followers) {
+      if (predictor_->OnKeySeen(group_key, follower))
+        ++hits;
+    }
+    return hits;
+  }
+
+  size_t RunGroup(const std::string& leader,
+                  const std::vector<std::string>& followers) {
+    return RunGroup(kGroupKey, leader, followers);
+  }
+
+  static constexpr char kGroupKey[] = "group";
+  static constexpr char kLeader[] = "leader";
+  static constexpr char kFollower1[] = "follower1";
+  static constexpr char kFollower2[] = "follower2";
+
+  TestPredictor::Params params_;
+  TestDelegate delegate_;
+  std::unique_ptr<TestPredictor> predictor_;
+};
+
+TEST_F(CoOccurrencePredictorTest, PredictsOnceConfident) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1, kFollower2});
+  RunGroup(kLeader, {kFollower1});
+  EXPECT_TRUE(delegate_.predictions().empty());
+
+  // Only |kFollower1| has been seen twice with the leader.
+  RunGroup(kLeader, {});
+  ASSERT_EQ(1u, delegate_.predictions().size());
+  EXPECT_EQ(kFollower1, delegate_.predictions()[0]);
+}
+
+TEST_F(CoOccurrencePredictorTest, CountsHitsAndMisses) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {kFollower1});
+
+  // Predicted follower seen within the window: a hit.
+  EXPECT_EQ(1u, RunGroup(kLeader, {kFollower1}));
+
+  // Predicted follower not seen before the group ends: a miss.
+  EXPECT_EQ(0u, RunGroup(kLeader, {}));
+  RunGroup(kFollower2, {});
+  EXPECT_EQ(2u, delegate_.predictions().size());
+  EXPECT_EQ(1u, delegate_.hits());
+  EXPECT_EQ(1u, delegate_.misses());
+}
+
+TEST_F(CoOccurrencePredictorTest, DeclinedPredictionsAreNotCounted) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {kFollower1});
+  delegate_.Decline(kFollower1);
+
+  EXPECT_EQ(0u, RunGroup(kLeader, {kFollower1}));
+  RunGroup(kFollower2, {});
+  EXPECT_EQ(1u, delegate_.predictions().size());
+  EXPECT_EQ(0u, delegate_.hits());
+  EXPECT_EQ(0u, delegate_.misses());
+}
+
+TEST_F(CoOccurrencePredictorTest, ForgetsFollowerAfterMisses) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {});
+  ASSERT_EQ(1u, delegate_.predictions().size());
+
+  // The last group lowered the follower's confidence below the threshold.
+  RunGroup(kLeader, {});
+  EXPECT_EQ(1u, delegate_.predictions().size());
+}
+
+TEST_F(CoOccurrencePredictorTest, LimitsFollowersPerLeader) {
+  CreatePredictor(/*max_followers_per_leader=*/1);
+
+  RunGroup(kLeader, {kFollower1, kFollower2});
+  RunGroup(kLeader, {kFollower1, kFollower2});
+  RunGroup(kLeader, {});
+
+  EXPECT_EQ(1u, delegate_.predictions().size());
+}
+
+TEST_F(CoOccurrencePredictorTest, LeadersAreSeparatedByGroupKey) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {kFollower1});
+
+  // The same leader seen for another group key has learned nothing yet.
+  RunGroup("other", kLeader, {});
+  EXPECT_TRUE(delegate_.predictions().empty());
+
+  RunGroup(kLeader, {});
+  EXPECT_EQ(1u, delegate_.predictions().size());
+}
+
+TEST_F(CoOccurrencePredictorTest, GroupsAreSeparatedByGroupKey) {
+  CreatePredictor();
+
+  // Keys seen for different group keys in the same window never form a group.
+  for (int i = 0; i < 3; ++i) {
+    g_now += params_.group_window + base::Seconds(1);
+    predictor_->OnKeySeen(kGroupKey, kLeader);
+    predictor_->OnKeySeen("other", kFollower1);
+  }
+  EXPECT_TRUE(delegate_.predictions().empty());
+}
+
+TEST_F(CoOccurrencePredictorTest, AbandonGroupsKeepsAssociations) {
+  CreatePredictor();
+
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {kFollower1});
+  RunGroup(kLeader, {});
+  ASSERT_EQ(1u, delegate_.predictions().size());
+
+  EXPECT_EQ(1u, predictor_->AbandonGroups());
+  EXPECT_EQ(0u, predictor_->AbandonGroups());
+
+  // The abandoned group was neither learned from nor counted.
+  RunGroup(kLeader, {});
+  EXPECT_EQ(2u, delegate_.predictions().size());
+  EXPECT_EQ(0u, delegate_.misses());
+}
+
+}  // namespace
+}  // namespace net
@@ -307,4 +307,69 @@ const base::Feature kStaticKeyPinningEnforcement(
 const base::Feature kCookieDomainRejectNonASCII{
     "CookieDomainRejectNonASCII", base::FEATURE_DISABLED_BY_DEFAULT};
 
+const base::Feature kSpdyHeadersToHttpResponseUseBuilder{
+    "SpdyHeadersToHttpResponseUseBuilder", base::FEATURE_ENABLED_BY_DEFAULT};
+
+const base::Feature kHttpCacheWritersBroadcast{
+    "HttpCacheWritersBroadcast", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<int> kHttpCacheWritersBroadcastBufferSize{
+    &kHttpCacheWritersBroadcast, "buffer_size", 256 * 1024};
+
+const base::Feature kHttpCacheBackgroundRevalidation{
+    "HttpCacheBackgroundRevalidation", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kHttpCacheLockTimeout{"HttpCacheLockTimeout",
+                                          base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<base::TimeDelta> kHttpCacheLockTimeoutDuration{
+    &kHttpCacheLockTimeout, "timeout", base::Seconds(20)};
+
+const base::Feature kHttpCachePrefetchPredictedEntries{
+    "HttpCachePrefetchPredictedEntries", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kDnsRefreshAhead{"DnsRefreshAhead",
+                                     base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<double> kDnsRefreshAheadTtlFraction{
+    &kDnsRefreshAhead, "ttl_fraction", 0.1};
+
+const base::FeatureParam<int> kDnsRefreshAheadMinHits{&kDnsRefreshAhead,
+                                                      "min_hits", 2};
+
+const base::FeatureParam<int> kDnsRefreshAheadMaxPerMinute{
+    &kDnsRefreshAhead, "max_per_minute", 30};
+
+const base::Feature kDohKeepSessionWarm{"DohKeepSessionWarm",
+                                        base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<base::TimeDelta> kDohKeepSessionWarmInterval{
+    &kDohKeepSessionWarm, "interval", base::Seconds(45)};
+
+const base::FeatureParam<base::TimeDelta> kDohKeepSessionWarmIdleTimeout{
+    &kDohKeepSessionWarm, "idle_timeout", base::Minutes(5)};
+
+const base::Feature kDnsUdpPacing{"DnsUdpPacing",
+                                  base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<int> kDnsUdpPacingQueriesPerSecond{
+    &kDnsUdpPacing, "queries_per_second", 100};
+
+const base::FeatureParam<int> kDnsUdpPacingBurst{&kDnsUdpPacing, "burst", 32};
+
+const base::Feature kDeduplicateSystemLookups{
+    "DeduplicateSystemLookups", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::Feature kHappyEyeballsRttFallback{
+    "HappyEyeballsRttFallback", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<double> kHappyEyeballsRttFallbackMultiplier{
+    &kHappyEyeballsRttFallback, "rtt_multiplier", 2.0};
+
+const base::FeatureParam<base::TimeDelta> kHappyEyeballsRttFallbackMinDelay{
+    &kHappyEyeballsRttFallback, "min_delay", base::Milliseconds(100)};
+
+const base::FeatureParam<base::TimeDelta> kHappyEyeballsRttFallbackMaxDelay{
+    &kHappyEyeballsRttFallback, "max_delay", base::Seconds(2)};
+
 }  // namespace net::features
@@ -439,6 +439,95 @@ NET_EXPORT extern const base::Feature kStaticKeyPinningEnforcement;
 // When enabled, cookies with a non-ASCII domain attribute will be rejected.
 NET_EXPORT extern const base::Feature kCookieDomainRejectNonASCII;
 
+// When enabled, HTTP/2 and HTTP/3 response header blocks are converted to
+// HttpResponseHeaders with HttpResponseHeaders::Builder instead of going
+// through an intermediate raw header string.
+NET_EXPORT extern const base::Feature kSpdyHeadersToHttpResponseUseBuilder;
+
+// When enabled, HttpCache::Writers keeps the most recent response body bytes
+// read from the network in a shared ring buffer while several transactions
+// are writing the same entry. Waiting transactions are handed each read as
+// soon as it arrives from the network instead of after it is written to the
+// entry, and transactions that have fallen behind are served from the buffer
+// instead of reading the entry back from disk.
+NET_EXPORT extern const base::Feature kHttpCacheWritersBroadcast;
+
+// Size in bytes of the ring buffer used by kHttpCacheWritersBroadcast.
+NET_EXPORT extern const base::FeatureParam<int>
+    kHttpCacheWritersBroadcastBufferSize;
+
+// When enabled, a stale cache entry that is still within its
+// stale-while-revalidate window is served right away even if the request does
+// not set LOAD_SUPPORT_ASYNC_REVALIDATION, and HttpCache revalidates it in the
+// background. At most one background revalidation runs per entry. Cookies set
+// by the revalidation response are not saved.
+NET_EXPORT extern const base::Feature kHttpCacheBackgroundRevalidation;
+
+// When enabled, a transaction waits kHttpCacheLockTimeoutDuration instead of
+// 20 seconds for the lock on a cache entry that other transactions are using,
+// and then bypasses the cache.
+NET_EXPORT extern const base::Feature kHttpCacheLockTimeout;
+
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kHttpCacheLockTimeoutDuration;
+
+// When enabled, HttpCache learns which entries are read together under the
+// same top-frame site, and opens and reads ahead the rest of a group as soon
+// as its first entry is read.
+NET_EXPORT extern const base::Feature kHttpCachePrefetchPredictedEntries;
+
+// When enabled, HostResolverManager refreshes DNS results that keep being
+// served from the HostCache close to their expiration, by starting a
+// low-priority background resolution for them before they expire.
+NET_EXPORT extern const base::Feature kDnsRefreshAhead;
+// Fraction of an entry's TTL, counted back from its expiration, within which a
+// cache hit may trigger a refresh.
+NET_EXPORT extern const base::FeatureParam<double> kDnsRefreshAheadTtlFraction;
+// Number of cache hits an entry must have had before it is refreshed.
+NET_EXPORT extern const base::FeatureParam<int> kDnsRefreshAheadMinHits;
+// Maximum number of refreshes started per minute.
+NET_EXPORT extern const base::FeatureParam<int> kDnsRefreshAheadMaxPerMinute;
+
+// When enabled, the DoH probe runner keeps sending an occasional low-priority
+// probe query to each available DoH server that has recently answered real
+// queries, so that the HTTP/2 session all DoH queries share stays open between
+// bursts of lookups.
+NET_EXPORT extern const base::Feature kDohKeepSessionWarm;
+// Interval between keep-warm queries to a server.
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kDohKeepSessionWarmInterval;
+// A server is only kept warm while its last successful query is more recent
+// than this.
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kDohKeepSessionWarmIdleTimeout;
+
+// When enabled, classic DNS queries sent over UDP are paced per nameserver
+// with a token bucket, so that a burst of resolutions does not flood the
+// server.
+NET_EXPORT extern const base::Feature kDnsUdpPacing;
+// Sustained queries per second allowed per nameserver.
+NET_EXPORT extern const base::FeatureParam<int> kDnsUdpPacingQueriesPerSecond;
+// Queries that can be sent to a nameserver at once before pacing applies.
+NET_EXPORT extern const base::FeatureParam<int> kDnsUdpPacingBurst;
+
+// When enabled, a system resolver lookup is shared by all HostResolverManager
+// jobs that need the same hostname, address family and flags, even if the
+// jobs differ in query types or NetworkIsolationKey.
+NET_EXPORT extern const base::Feature kDeduplicateSystemLookups;
+
+// When enabled, TransportConnectJob derives the delay before racing IPv4
+// against IPv6 from the transport RTT of the current network, and starts IPv4
+// as soon as the first IPv6 address fails rather than waiting for the delay.
+NET_EXPORT extern const base::Feature kHappyEyeballsRttFallback;
+// The delay is the transport RTT multiplied by this value...
+NET_EXPORT extern const base::FeatureParam<double>
+    kHappyEyeballsRttFallbackMultiplier;
+// ...clamped to these bounds.
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kHappyEyeballsRttFallbackMinDelay;
+NET_EXPORT extern const base::FeatureParam<base::TimeDelta>
+    kHappyEyeballsRttFallbackMaxDelay;
+
 }  // namespace net::features
 
 #endif  // NET_BASE_FEATURES_H_
@@ -50,6 +50,7 @@
 #include "net/disk_cache/disk_cache_test_util.h"
 #include "net/disk_cache/memory/mem_backend_impl.h"
 #include "net/disk_cache/simple/simple_backend_impl.h"
+#include "net/disk_cache/simple/simple_blob_store.h"
 #include "net/disk_cache/simple/simple_entry_format.h"
 #include "net/disk_cache/simple/simple_histogram_enums.h"
 #include "net/disk_cache/simple/simple_index.h"
@@ -3473,6 +3474,108 @@ TEST_F(DiskCacheBackendTest, MemoryOnlyBackendEviction) {
   BackendEviction();
 }
 
+// Verify that slab memory the memory backend cannot release because of
+// fragmentation counts against its maximum size.
+TEST_F(DiskCacheBackendTest, MemoryOnlyChargesSlabFragmentation) {
+  const int kMaxSize = 512 * 1024;
+  const int kChunkSize = disk_cache::MemSlabAllocator::kChunkSize;
+  const int kSlabSize = disk_cache::MemSlabAllocator::kSlabSize;
+  SetMemoryOnlyMode();
+  SetMaxSize(kMaxSize);
+  InitCache();
+
+  // Fill four slabs with one-chunk entries, then doom every other entry, so
+  // that no slab can be released. The others are kept open, so that eviction
+  // cannot release the slabs either.
+  const int kChunkEntries = 4 * disk_cache::MemSlabAllocator::kChunksPerSlab;
+  scoped_refptr<net::IOBuffer> buffer =
+      base::MakeRefCounted<net::IOBuffer>(kChunkSize);
+  CacheTestFillBuffer(buffer->data(), kChunkSize, false);
+  std::vector<disk_cache::ScopedEntryPtr> open_entries;
+  for (int i = 0; i < kChunkEntries; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(CreateEntry(base::StringPrintf("chunk%d", i), &entry), IsOk());
+    EXPECT_EQ(kChunkSize,
+              WriteData(entry, 1, 0, buffer.get(), kChunkSize, false));
+    if (i % 2) {
+      entry->Doom();
+      entry->Close();
+    } else {
+      open_entries.emplace_back(entry);
+    }
+  }
+  const scoped_refptr<disk_cache::MemSlabAllocator>& allocator =
+      mem_cache_->slab_allocator();
+  EXPECT_EQ(static_cast<size_t>(kChunkEntries / 2 * kChunkSize),
+            allocator->unused_reserved_bytes());
+
+  // Then fill the cache with entries small enough not to use slab chunks.
+  const int kSmallSize = 1000;
+  for (int i = 0; i < kMaxSize / kSmallSize; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(CreateEntry(base::StringPrintf("small%d", i), &entry), IsOk());
+    EXPECT_EQ(kSmallSize,
+              WriteData(entry, 1, 0, buffer.get(), kSmallSize, false));
+    entry->Close();
+  }
+
+  // Only the empty slab that the allocator keeps is not charged.
+  EXPECT_LE(CalculateSizeOfAllEntries() +
+                static_cast<int64_t>(allocator->unused_reserved_bytes()),
+            kMaxSize + kSlabSize);
+}
+
+// Eviction stops once evicting entries no longer releases slabs, rather than
+// emptying the cache around slabs that open entries pin.
+TEST_F(DiskCacheBackendTest, MemoryOnlyEvictionStopsAtPinnedSlabs) {
+  const int kMaxSize = 4 * 1024 * 1024;
+  const int kChunkSize = disk_cache::MemSlabAllocator::kChunkSize;
+  const int kChunksPerSlab = disk_cache::MemSlabAllocator::kChunksPerSlab;
+  SetMemoryOnlyMode();
+  SetMaxSize(kMaxSize);
+  InitCache();
+
+  // Fill slabs with one-chunk entries, keeping the first entry of each slab
+  // open so that none of them can be released.
+  const int kPinnedSlabs = 32;
+  scoped_refptr<net::IOBuffer> buffer =
+      base::MakeRefCounted<net::IOBuffer>(kChunkSize);
+  CacheTestFillBuffer(buffer->data(), kChunkSize, false);
+  std::vector<disk_cache::ScopedEntryPtr> open_entries;
+  for (int i = 0; i < kPinnedSlabs * kChunksPerSlab; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(CreateEntry(base::StringPrintf("chunk%d", i), &entry), IsOk());
+    EXPECT_EQ(kChunkSize,
+              WriteData(entry, 1, 0, buffer.get(), kChunkSize, false));
+    if (i % kChunksPerSlab == 0)
+      open_entries.emplace_back(entry);
+    else
+      entry->Close();
+  }
+  const scoped_refptr<disk_cache::MemSlabAllocator>& allocator =
+      mem_cache_->slab_allocator();
+  EXPECT_EQ(static_cast<size_t>(kPinnedSlabs * kChunksPerSlab),
+            allocator->chunks_in_use());
+
+  // The entries that are left after the live bytes fit the target only hold
+  // chunks of pinned slabs, so most of them are kept.
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_LE(CalculateSizeOfAllEntries(), kMaxSize / 10);
+  EXPECT_GT(cache_->GetEntryCount(), 2 * kPinnedSlabs);
+  EXPECT_EQ(static_cast<size_t>(kPinnedSlabs) *
+                disk_cache::MemSlabAllocator::kSlabSize,
+            allocator->reserved_bytes());
+
+  // The fragmentation does not refuse writes either.
+  disk_cache::Entry* entry = nullptr;
+  ASSERT_THAT(CreateEntry("after", &entry), IsOk());
+  EXPECT_EQ(kChunkSize,
+            WriteData(entry, 1, 0, buffer.get(), kChunkSize, false));
+  entry->Close();
+}
+
 // TODO(morlovich): Enable BackendEviction test for simple cache after
 // performance problems are addressed. See crbug.com/588184 for more
 // information.
@@ -4381,6 +4484,124 @@ TEST_F(DiskCacheBackendTest, DISABLED_SimpleCachePrioritizedEntryOrder) {
   entry3->Close();
 }
 
+// Verify that identical bodies are stored once, and stay readable through a
+// restart and the doom of the other entries sharing them.
+TEST_F(DiskCacheBackendTest, SimpleCacheDeduplication) {
+  base::test::ScopedFeatureList scoped_feature_list;
+  scoped_feature_list.InitAndEnableFeatureWithParameters(
+      disk_cache::kSimpleCacheDeduplication,
+      {{disk_cache::kSimpleCacheDeduplicationMinBytesParam, "1024"}});
+  SetSimpleCacheMode();
+  InitCache();
+
+  const int kNumEntries = 3;
+  const int kSize = 4096;
+  scoped_refptr<net::IOBuffer> buffer =
+      base::MakeRefCounted<net::IOBuffer>(kSize);
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+
+  for (int i = 0; i < kNumEntries; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(CreateEntry(base::StringPrintf("key%d", i), &entry), IsOk());
+    EXPECT_EQ(kSize, WriteData(entry, 1, 0, buffer.get(), kSize, false));
+    entry->Close();
+    RunUntilIdle();
+  }
+
+  // The second entry created a blob, and the first one moved to it once that
+  // happened, so all of them share it.
+  auto* simple_cache =
+      static_cast<disk_cache::SimpleBackendImpl*>(cache_.get());
+  ASSERT_TRUE(simple_cache->blob_store());
+  EXPECT_EQ(kSize, simple_cache->blob_store()->GetTotalSize());
+  EXPECT_EQ(static_cast<size_t>(kNumEntries),
+            simple_cache->blob_store()->GetReferenceCount());
+
+  auto check_entries = [&](int first, int last) {
+    for (int i = first; i <= last; ++i) {
+      disk_cache::Entry* entry = nullptr;
+      ASSERT_THAT(OpenEntry(base::StringPrintf("key%d", i), &entry), IsOk());
+      EXPECT_EQ(kSize, entry->GetDataSize(1));
+      auto read_buffer = base::MakeRefCounted<net::IOBuffer>(kSize);
+      EXPECT_EQ(kSize, ReadData(entry, 1, 0, read_buffer.get(), kSize));
+      EXPECT_EQ(0, memcmp(buffer->data(), read_buffer->data(), kSize));
+      entry->Close();
+    }
+  };
+  check_entries(0, kNumEntries - 1);
+
+  cache_.reset();
+  RunUntilIdle();
+  DisableFirstCleanup();
+  InitCache();
+  simple_cache = static_cast<disk_cache::SimpleBackendImpl*>(cache_.get());
+  EXPECT_EQ(kSize, simple_cache->blob_store()->GetTotalSize());
+  check_entries(0, kNumEntries - 1);
+
+  // The blob goes away with the last entry that references it.
+  EXPECT_THAT(DoomEntry("key1"), IsOk());
+  RunUntilIdle();
+  EXPECT_EQ(kSize, simple_cache->blob_store()->GetTotalSize());
+  check_entries(2, 2);
+  EXPECT_THAT(DoomEntry("key2"), IsOk());
+  RunUntilIdle();
+  EXPECT_EQ(kSize, simple_cache->blob_store()->GetTotalSize());
+  check_entries(0, 0);
+  EXPECT_THAT(DoomEntry("key0"), IsOk());
+  RunUntilIdle();
+  EXPECT_EQ(0, simple_cache->blob_store()->GetTotalSize());
+}
+
+// Tests that deduplicated entries survive an unclean exit, since the blob
+// references are saved as they change rather than at shutdown.
+TEST_F(DiskCacheBackendTest, SimpleCacheDeduplicationAfterCrash) {
+  base::test::ScopedFeatureList scoped_feature_list;
+  scoped_feature_list.InitAndEnableFeatureWithParameters(
+      disk_cache::kSimpleCacheDeduplication,
+      {{disk_cache::kSimpleCacheDeduplicationMinBytesParam, "1024"}});
+  SetSimpleCacheMode();
+  InitCache();
+
+  const int kNumEntries = 3;
+  const int kSize = 4096;
+  scoped_refptr<net::IOBuffer> buffer =
+      base::MakeRefCounted<net::IOBuffer>(kSize);
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  for (int i = 0; i < kNumEntries; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(CreateEntry(base::StringPrintf("key%d", i), &entry), IsOk());
+    EXPECT_EQ(kSize, WriteData(entry, 1, 0, buffer.get(), kSize, false));
+    entry->Close();
+    RunUntilIdle();
+  }
+
+  // Take the files as they are while the backend is still running, as a
+  // crash would leave them, and restart from those.
+  base::ScopedTempDir crash_dir;
+  ASSERT_TRUE(crash_dir.CreateUniqueTempDir());
+  const base::FilePath crashed_cache_path =
+      crash_dir.GetPath().AppendASCII("cache");
+  ASSERT_TRUE(base::CopyDirectory(cache_path_, crashed_cache_path, true));
+  cache_.reset();
+  RunUntilIdle();
+  ASSERT_TRUE(base::DeletePathRecursively(cache_path_));
+  ASSERT_TRUE(base::CopyDirectory(crashed_cache_path, cache_path_, true));
+  DisableFirstCleanup();
+  InitCache();
+
+  auto* simple_cache =
+      static_cast<disk_cache::SimpleBackendImpl*>(cache_.get());
+  EXPECT_EQ(kSize, simple_cache->blob_store()->GetTotalSize());
+  for (int i = 0; i < kNumEntries; ++i) {
+    disk_cache::Entry* entry = nullptr;
+    ASSERT_THAT(OpenEntry(base::StringPrintf("key%d", i), &entry), IsOk());
+    auto read_buffer = base::MakeRefCounted<net::IOBuffer>(kSize);
+    EXPECT_EQ(kSize, ReadData(entry, 1, 0, read_buffer.get(), kSize));
+    EXPECT_EQ(0, memcmp(buffer->data(), read_buffer->data(), kSize));
+    entry->Close();
+  }
+}
+
 // Tests that enumerations include entries with long keys.
 TEST_F(DiskCacheBackendTest, SimpleCacheEnumerationLongKeys) {
   SetSimpleCacheMode();
@@ -5,6 +5,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/barrier_closure.h"
 #include "base/bind.h"
@@ -128,7 +129,8 @@ class DiskCachePerfTest : public DiskCacheTestWithCache {
   bool TimeWrites(const std::string& story);
   bool TimeReads(WhatToRead what_to_read,
                  const std::string& metric,
-                 const std::string& story);
+                 const std::string& story,
+                 int parallel_operations = kMaxParallelOperations);
   void ResetAndEvictSystemDiskCache();
 
   // Callbacks used within tests for intermediate operations.
@@ -142,6 +144,7 @@ class DiskCachePerfTest : public DiskCacheTestWithCache {
 
   // Complete perf tests.
   void CacheBackendPerformance(const std::string& story);
+  void SimpleCacheParallelReadsPerformance();
 
   const size_t kFdLimitForCacheTests = 8192;
 
@@ -272,14 +275,15 @@ class ReadHandler {
   ReadHandler(const DiskCachePerfTest* test,
               WhatToRead what_to_read,
               disk_cache::Backend* cache,
+              int parallel_operations,
               net::CompletionOnceCallback final_callback)
       : test_(test),
         what_to_read_(what_to_read),
         cache_(cache),
         final_callback_(std::move(final_callback)) {
-    for (int i = 0; i < kMaxParallelOperations; ++i)
-      read_buffers_[i] = base::MakeRefCounted<net::IOBuffer>(
-          std::max(kHeadersSize, kChunkSize));
+    for (int i = 0; i < parallel_operations; ++i)
+      read_buffers_.push_back(base::MakeRefCounted<net::IOBuffer>(
+          std::max(kHeadersSize, kChunkSize)));
   }
 
   void Run();
@@ -311,11 +315,12 @@ class ReadHandler {
 
   int pending_result_ = net::OK;
 
-  scoped_refptr<net::IOBuffer> read_buffers_[kMaxParallelOperations];
+  // One per parallel operation.
+  std::vector<scoped_refptr<net::IOBuffer>> read_buffers_;
 };
 
 void ReadHandler::Run() {
-  for (int i = 0; i < kMaxParallelOperations; ++i) {
+  for (size_t i = 0; i < read_buffers_.size(); ++i) {
     OpenNextEntry(pending_operations_count_);
     ++pending_operations_count_;
   }
@@ -424,12 +429,14 @@ bool DiskCachePerfTest::TimeWrites(const std::string& story) {
 
 bool DiskCachePerfTest::TimeReads(WhatToRead what_to_read,
                                   const std::string& metric,
-                                  const std::string& story) {
+                                  const std::string& story,
+                                  int parallel_operations) {
   auto reporter = SetUpDiskCacheReporter(story);
   base::ElapsedTimer timer;
 
   net::TestCompletionCallback cb;
-  ReadHandler read_handler(this, what_to_read, cache_.get(), cb.callback());
+  ReadHandler read_handler(this, what_to_read, cache_.get(),
+                           parallel_operations, cb.callback());
   read_handler.Run();
   auto result = cb.WaitForResult();
   reporter.AddResult(metric, timer.Elapsed().InMillisecondsF());
@@ -529,6 +536,50 @@ TEST_F(DiskCachePerfTest, MAYBE_SimpleCacheBackendPerformance) {
   CacheBackendPerformance("simple_cache");
 }
 
+// Measures warm reads of the same entries with an increasing number of reads
+// in flight. The simple cache runs each entry's I/O on a sequence of its own,
+// so the time should keep dropping until the thread pool runs out of workers,
+// without splitting the entries over several task runners.
+void DiskCachePerfTest::SimpleCacheParallelReadsPerformance() {
+  base::test::ScopedRunLoopTimeout default_timeout(
+      FROM_HERE, TestTimeouts::action_max_timeout());
+
+  SetSimpleCacheMode();
+  SetMaxSize(500 * 1024 * 1024);
+  InitCache();
+  EXPECT_TRUE(TimeWrites("simple_cache_parallel_reads"));
+
+  disk_cache::FlushCacheThreadForTesting();
+  base::RunLoop().RunUntilIdle();
+
+  // Once to warm up the file system cache.
+  EXPECT_TRUE(TimeReads(WhatToRead::HEADERS_AND_BODY,
+                        kMetricCacheEntriesReadTimeWarmMs,
+                        "simple_cache_parallel_reads"));
+  for (int parallel_operations : {1, 2, 4, 8, 16, 32}) {
+    EXPECT_TRUE(TimeReads(
+        WhatToRead::HEADERS_AND_BODY, kMetricCacheEntriesReadTimeWarmMs,
+        "simple_cache_parallel_reads_" +
+            base::NumberToString(parallel_operations),
+        parallel_operations));
+  }
+
+  disk_cache::FlushCacheThreadForTesting();
+  base::RunLoop().RunUntilIdle();
+}
+
+#if BUILDFLAG(IS_FUCHSIA)
+// TODO(crbug.com/851083): Fix this test on Fuchsia and re-enable.
+#define MAYBE_SimpleCacheParallelReadsPerformance \
+  DISABLED_SimpleCacheParallelReadsPerformance
+#else
+#define MAYBE_SimpleCacheParallelReadsPerformance \
+  SimpleCacheParallelReadsPerformance
+#endif
+TEST_F(DiskCachePerfTest, MAYBE_SimpleCacheParallelReadsPerformance) {
+  SimpleCacheParallelReadsPerformance();
+}
+
 // Creating and deleting "entries" on a block-file is something quite frequent
 // (after all, almost everything is stored on block files). The operation is
 // almost free when the file is empty, but can be expensive if the file gets
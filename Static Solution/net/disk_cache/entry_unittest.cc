@@ -5552,6 +5552,42 @@ TEST_F(DiskCacheEntryTest, SimpleCacheCloseResurrection) {
   entry2->Close();
 }
 
+// Reading a large stream through in chunks, with the read-ahead hint given,
+// returns the data that was written.
+TEST_F(DiskCacheEntryTest, SimpleCacheSequentialReadAhead) {
+  base::test::ScopedFeatureList scoped_feature_list;
+  scoped_feature_list.InitAndEnableFeatureWithParameters(
+      disk_cache::kSimpleCacheSequentialReadAhead,
+      {{disk_cache::kSimpleCacheSequentialReadAheadMinBytesParam, "16384"}});
+
+  const int kSize = 64 * 1024;
+  const int kChunkSize = 4096;
+  scoped_refptr<net::IOBuffer> buffer =
+      base::MakeRefCounted<net::IOBuffer>(kSize);
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+
+  const char kKey[] = "key";
+  SetSimpleCacheMode();
+  InitCache();
+
+  disk_cache::Entry* entry = nullptr;
+  ASSERT_THAT(CreateEntry(kKey, &entry), IsOk());
+  EXPECT_EQ(kSize, WriteData(entry, 1, 0, buffer.get(), kSize, false));
+  entry->Close();
+
+  ASSERT_THAT(OpenEntry(kKey, &entry), IsOk());
+  scoped_refptr<net::IOBuffer> read_buffer =
+      base::MakeRefCounted<net::IOBuffer>(kChunkSize);
+  for (int offset = 0; offset < kSize; offset += kChunkSize) {
+    EXPECT_EQ(kChunkSize,
+              ReadData(entry, 1, offset, read_buffer.get(), kChunkSize));
+    EXPECT_EQ(0, memcmp(buffer->data() + offset, read_buffer->data(),
+                        kChunkSize));
+  }
+  EXPECT_EQ(0, ReadData(entry, 1, kSize, read_buffer.get(), kChunkSize));
+  entry->Close();
+}
+
 TEST_F(DiskCacheEntryTest, BlockFileSparsePendingAfterDtor) {
   // Test of behavior of ~EntryImpl for sparse entry that runs after backend
   // destruction.
@@ -0,0 +1,101 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/frequency_sketch.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "base/check_op.h"
+
+namespace disk_cache {
+
+namespace {
+
+// Odd multipliers that give each row of the sketch an independent-enough
+// spread of the same key.
+const uint64_t kRowSeeds[] = {
+    UINT64_C(0x9e3779b97f4a7c15), UINT64_C(0xc2b2ae3d27d4eb4f),
+    UINT64_C(0x165667b19e3779f9), UINT64_C(0xd6e8feb86659fd93)};
+
+const int kRows = std::size(kRowSeeds);
+
+// Each table word holds 16 counters of 4 bits.
+const int kCounterBits = 4;
+const int kCountersPerWord = 64 / kCounterBits;
+const uint64_t kCounterMask = (1 << kCounterBits) - 1;
+
+// Clears the low bit of each counter once the word is shifted right by one.
+const uint64_t kHalveMask = UINT64_C(0x7777777777777777);
+
+// How many times the capacity can be recorded before the counters are halved.
+const size_t kSampleSizeFactor = 10;
+
+const size_t kMinTableSize = 64;
+
+}  // namespace
+
+FrequencySketch::FrequencySketch(size_t capacity) {
+  SetCapacity(capacity);
+}
+
+FrequencySketch::~FrequencySketch() = default;
+
+void FrequencySketch::SetCapacity(size_t capacity) {
+  size_t table_size = kMinTableSize;
+  while (table_size < capacity)
+    table_size *= 2;
+  if (table_size == table_.size())
+    return;
+  table_.assign(table_size, 0);
+  sample_size_ = kSampleSizeFactor * std::max(capacity, kMinTableSize);
+  additions_ = 0;
+}
+
+void FrequencySketch::Increment(uint64_t key) {
+  bool incremented = false;
+  for (int row = 0; row < kRows; ++row) {
+    size_t index;
+    int shift;
+    Locate(key, row, &index, &shift);
+    if (((table_[index] >> shift) & kCounterMask) < kMaxFrequency) {
+      table_[index] += uint64_t{1} << shift;
+      incremented = true;
+    }
+  }
+  if (incremented && ++additions_ >= sample_size_)
+    Age();
+}
+
+int FrequencySketch::Frequency(uint64_t key) const {
+  int frequency = kMaxFrequency;
+  for (int row = 0; row < kRows; ++row) {
+    size_t index;
+    int shift;
+    Locate(key, row, &index, &shift);
+    frequency = std::min(
+        frequency, static_cast<int>((table_[index] >> shift) & kCounterMask));
+  }
+  return frequency;
+}
+
+void FrequencySketch::Locate(uint64_t key,
+                             int row,
+                             size_t* index,
+                             int* shift) const {
+  DCHECK_LT(row, kRows);
+  uint64_t hash = (key + kRowSeeds[row]) * kRowSeeds[row];
+  hash ^= hash >> 32;
+  // The table size is a power of two.
+  *index = static_cast<size_t>(hash) & (table_.size() - 1);
+  *shift = static_cast<int>((hash >> 48) % kCountersPerWord) * kCounterBits;
+}
+
+void FrequencySketch::Age() {
+  for (uint64_t& word : table_)
+    word = (word >> 1) & kHalveMask;
+  additions_ /= 2;
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,63 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+#define NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "net/base/net_export.h"
+
+namespace disk_cache {
+
+// Estimates how often each key has been seen recently, in a fixed amount of
+// memory, like the frequency counter of TinyLFU. It is a count-min sketch
+// of 4-bit counters, so estimates saturate at 15 and may be too high but
+// never too low. Once as many keys have been recorded as ten times the
+// capacity, all counters are halved, so that the estimates follow changes in
+// popularity.
+//
+// Keys are expected to be hashes already, like the entry hashes of the
+// simple cache.
+class NET_EXPORT_PRIVATE FrequencySketch {
+ public:
+  static constexpr int kMaxFrequency = 15;
+
+  // Sizes the sketch for about |capacity| distinct keys of interest.
+  explicit FrequencySketch(size_t capacity);
+
+  FrequencySketch(const FrequencySketch&) = delete;
+  FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+  ~FrequencySketch();
+
+  // Resizes the sketch for |capacity| keys, if that means a different size.
+  // Resizing forgets everything recorded so far.
+  void SetCapacity(size_t capacity);
+
+  void Increment(uint64_t key);
+  int Frequency(uint64_t key) const;
+
+  // The number of increments since the counters were last halved.
+  size_t additions() const { return additions_; }
+
+ private:
+  // Returns the index in |table_| and the shift within that word of the
+  // counter for |key| in row |row|.
+  void Locate(uint64_t key, int row, size_t* index, int* shift) const;
+
+  // Halves all the counters.
+  void Age();
+
+  std::vector<uint64_t> table_;
+  size_t sample_size_ = 0;
+  size_t additions_ = 0;
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_FREQUENCY_SKETCH_H_
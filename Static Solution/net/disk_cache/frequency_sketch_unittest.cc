@@ -0,0 +1,48 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/frequency_sketch.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace disk_cache {
+namespace {
+
+TEST(FrequencySketchTest, CountsAndSaturates) {
+  FrequencySketch sketch(1024);
+  EXPECT_EQ(0, sketch.Frequency(1));
+  for (int i = 0; i < 5; ++i)
+    sketch.Increment(1);
+  sketch.Increment(2);
+  EXPECT_EQ(5, sketch.Frequency(1));
+  EXPECT_EQ(1, sketch.Frequency(2));
+  EXPECT_EQ(0, sketch.Frequency(3));
+
+  for (int i = 0; i < 100; ++i)
+    sketch.Increment(1);
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.Frequency(1));
+}
+
+TEST(FrequencySketchTest, AgesCounts) {
+  FrequencySketch sketch(64);
+  for (int i = 0; i < 20; ++i)
+    sketch.Increment(1);
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.Frequency(1));
+
+  // Recording enough other keys to reach the sample size halves all the
+  // counters.
+  uint64_t key = 1000;
+  size_t additions;
+  do {
+    additions = sketch.additions();
+    sketch.Increment(++key);
+  } while (sketch.additions() > additions);
+  EXPECT_EQ(FrequencySketch::kMaxFrequency / 2, sketch.Frequency(1));
+}
+
+}  // namespace
+}  // namespace disk_cache
@@ -44,6 +44,7 @@ base::LinkNode<MemEntryImpl>* NextSkippingChildren(
 
 MemBackendImpl::MemBackendImpl(net::NetLog* net_log)
     : Backend(net::MEMORY_CACHE),
+      slab_allocator_(base::MakeRefCounted<MemSlabAllocator>()),
       net_log_(net_log),
       memory_pressure_listener_(
           FROM_HERE,
@@ -318,16 +319,61 @@ void MemBackendImpl::OnExternalCacheHit(const std::string& key) {
     it->second->UpdateStateOnUse(MemEntryImpl::ENTRY_WAS_NOT_MODIFIED);
 }
 
+int64_t MemBackendImpl::GetChargedFragmentation() const {
+  // A slab stays allocated as long as any of its chunks is in use, so the
+  // free chunks around the ones entries hold count against the limit too.
+  // Otherwise fragmentation could let the allocator hold many times
+  // |max_size_|. The allocator keeps one empty slab regardless, and that one
+  // is not charged.
+  const size_t unused = slab_allocator_->unused_reserved_bytes();
+  const size_t charged = unused > MemSlabAllocator::kSlabSize
+                             ? unused - MemSlabAllocator::kSlabSize
+                             : 0;
+  return static_cast<int64_t>(charged);
+}
+
+int64_t MemBackendImpl::GetAccountedSize() const {
+  return current_size_ + GetChargedFragmentation();
+}
+
 void MemBackendImpl::EvictIfNeeded() {
-  if (current_size_ <= max_size_)
+  // Fragmentation that the last eviction could not reduce is not held against
+  // the cache again, or every write would evict more entries to no effect.
+  const int64_t fragmentation = std::max<int64_t>(
+      GetChargedFragmentation() - pinned_fragmentation_, 0);
+  if (current_size_ + fragmentation <= max_size_)
     return;
   int target_size = std::max(0, max_size_ - kDefaultEvictionSize);
   EvictTill(target_size);
 }
 
 void MemBackendImpl::EvictTill(int target_size) {
+  pinned_fragmentation_ = 0;
+
+  // Once the entries fit in |target_size|, only fragmentation keeps the
+  // cache over it, and evicting helps only while it still releases slabs.
+  // Freeing a slab's worth of chunks without releasing any means that the
+  // remaining slabs are pinned by entries in use.
+  bool entries_fit = false;
+  size_t last_reserved_bytes = 0;
+  size_t chunks_at_last_release = 0;
+
   base::LinkNode<MemEntryImpl>* entry = lru_list_.head();
-  while (current_size_ > target_size && entry != lru_list_.end()) {
+  while (GetAccountedSize() > target_size && entry != lru_list_.end()) {
+    if (current_size_ <= target_size) {
+      const size_t reserved_bytes = slab_allocator_->reserved_bytes();
+      const size_t chunks_in_use = slab_allocator_->chunks_in_use();
+      if (!entries_fit || reserved_bytes < last_reserved_bytes) {
+        entries_fit = true;
+        last_reserved_bytes = reserved_bytes;
+        chunks_at_last_release = chunks_in_use;
+      } else if (chunks_in_use + MemSlabAllocator::kChunksPerSlab <=
+                 chunks_at_last_release) {
+        pinned_fragmentation_ = GetChargedFragmentation();
+        return;
+      }
+    }
+
     MemEntryImpl* to_doom = entry->value();
     entry = NextSkippingChildren(lru_list_, entry);
 
@@ -17,12 +17,14 @@
 #include "base/containers/linked_list.h"
 #include "base/memory/memory_pressure_listener.h"
 #include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/strings/string_split.h"
 #include "base/time/time.h"
 #include "net/base/net_export.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/memory/mem_entry_impl.h"
+#include "net/disk_cache/memory/mem_slab_allocator.h"
 
 namespace base {
 class Clock;
@@ -87,6 +89,11 @@ class NET_EXPORT_PRIVATE MemBackendImpl final : public Backend {
   // size.
   bool HasExceededStorageSize() const;
 
+  // The allocator that entries of this backend take their storage from.
+  const scoped_refptr<MemSlabAllocator>& slab_allocator() const {
+    return slab_allocator_;
+  }
+
   // Sets a callback to be posted after we are destroyed. Should be called at
   // most once.
   void SetPostCleanupCallback(base::OnceClosure cb);
@@ -130,10 +137,19 @@ class NET_EXPORT_PRIVATE MemBackendImpl final : public Backend {
 
   using EntryMap = std::unordered_map<std::string, MemEntryImpl*>;
 
+  // Returns the bytes that |slab_allocator_| holds beyond the storage of the
+  // entries and that are held against |max_size_|.
+  int64_t GetChargedFragmentation() const;
+
+  // Returns the size that is held against |max_size_|: the storage of the
+  // entries, plus the charged fragmentation.
+  int64_t GetAccountedSize() const;
+
   // Deletes entries from the cache until the current size is below the limit.
   void EvictIfNeeded();
 
-  // Deletes entries until the current size is below |goal|.
+  // Deletes entries until the current size is below |goal|. Stops early if
+  // only fragmentation that evictions don't reduce is left above it.
   void EvictTill(int target_size);
 
   // Called when we get low on memory.
@@ -151,6 +167,12 @@ class NET_EXPORT_PRIVATE MemBackendImpl final : public Backend {
   int32_t max_size_ = 0;  // Maximum data size for this instance.
   int32_t current_size_ = 0;
 
+  // Charged fragmentation that the last eviction could not reduce, because
+  // entries in use pin the slabs holding it.
+  int64_t pinned_fragmentation_ = 0;
+
+  const scoped_refptr<MemSlabAllocator> slab_allocator_;
+
   raw_ptr<net::NetLog> net_log_;
   base::OnceClosure post_cleanup_callback_;
 
@@ -0,0 +1,180 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/memory/mem_chunked_buffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check_op.h"
+
+namespace disk_cache {
+
+namespace {
+
+constexpr int kChunkSize = MemSlabAllocator::kChunkSize;
+
+size_t NumChunksFor(int size) {
+  return (static_cast<size_t>(size) + kChunkSize - 1) / kChunkSize;
+}
+
+// Returns the offset in the buffer at which chunk |index| starts.
+int ChunkStart(size_t index) {
+  return static_cast<int>(index) * kChunkSize;
+}
+
+}  // namespace
+
+MemChunkedBuffer::MemChunkedBuffer(scoped_refptr<MemSlabAllocator> allocator)
+    : allocator_(std::move(allocator)) {
+  DCHECK(allocator_);
+}
+
+MemChunkedBuffer::~MemChunkedBuffer() {
+  for (const Chunk& chunk : chunks_)
+    FreeChunk(chunk);
+}
+
+int MemChunkedBuffer::CapacityAfterResize(int new_size) const {
+  DCHECK_GE(new_size, 0);
+  const size_t num_chunks = NumChunksFor(new_size);
+  if (!num_chunks)
+    return 0;
+
+  const int full_chunks_size = ChunkStart(num_chunks - 1);
+  const int needed = new_size - full_chunks_size;
+  int last_capacity;
+  if (num_chunks < chunks_.size()) {
+    // Everything but the last chunk is full-sized.
+    last_capacity = kChunkSize;
+  } else if (num_chunks == chunks_.size()) {
+    last_capacity = chunks_.back().capacity;
+    if (last_capacity < needed)
+      last_capacity = GrownChunkCapacity(last_capacity, needed);
+  } else {
+    last_capacity = GrownChunkCapacity(0, needed);
+  }
+  return full_chunks_size + last_capacity;
+}
+
+void MemChunkedBuffer::Resize(int new_size) {
+  DCHECK_GE(new_size, 0);
+  DCHECK_EQ(NumChunksFor(size_), chunks_.size());
+  const size_t num_chunks = NumChunksFor(new_size);
+
+  while (chunks_.size() > num_chunks) {
+    FreeChunk(chunks_.back());
+    capacity_ -= chunks_.back().capacity;
+    chunks_.pop_back();
+  }
+
+  if (num_chunks > chunks_.size()) {
+    // The current last chunk is about to be followed by others, so it has to
+    // be full-sized.
+    if (!chunks_.empty() && chunks_.back().capacity < kChunkSize)
+      ReallocateLastChunk(kChunkSize, size_ - ChunkStart(chunks_.size() - 1));
+    while (chunks_.size() < num_chunks) {
+      const int capacity =
+          chunks_.size() + 1 < num_chunks
+              ? kChunkSize
+              : GrownChunkCapacity(0, new_size - ChunkStart(num_chunks - 1));
+      chunks_.push_back({AllocateChunk(capacity), capacity});
+      capacity_ += capacity;
+    }
+  } else if (num_chunks) {
+    const int last_start = ChunkStart(num_chunks - 1);
+    const int last_capacity = chunks_.back().capacity;
+    if (last_capacity < new_size - last_start) {
+      ReallocateLastChunk(
+          GrownChunkCapacity(last_capacity, new_size - last_start),
+          size_ - last_start);
+    }
+  }
+
+  size_ = new_size;
+  DCHECK_EQ(CapacityAfterResize(size_), capacity_);
+}
+
+template <typename Visitor>
+void MemChunkedBuffer::ForEachPiece(int offset,
+                                    int len,
+                                    Visitor visitor) const {
+  DCHECK_GE(offset, 0);
+  DCHECK_GE(len, 0);
+  DCHECK_LE(offset, size_ - len);
+  size_t index = static_cast<size_t>(offset / kChunkSize);
+  int offset_in_chunk = offset % kChunkSize;
+  while (len > 0) {
+    const int piece_len = std::min(len, kChunkSize - offset_in_chunk);
+    visitor(chunks_[index].data + offset_in_chunk, piece_len);
+    len -= piece_len;
+    ++index;
+    offset_in_chunk = 0;
+  }
+}
+
+void MemChunkedBuffer::Read(int offset, int len, char* dest) const {
+  ForEachPiece(offset, len, [&dest](char* piece, int piece_len) {
+    memcpy(dest, piece, piece_len);
+    dest += piece_len;
+  });
+}
+
+void MemChunkedBuffer::Write(int offset, const char* src, int len) {
+  ForEachPiece(offset, len, [&src](char* piece, int piece_len) {
+    memcpy(piece, src, piece_len);
+    src += piece_len;
+  });
+}
+
+void MemChunkedBuffer::Zero(int offset, int len) {
+  ForEachPiece(offset, len, [](char* piece, int piece_len) {
+    memset(piece, 0, piece_len);
+  });
+}
+
+void MemChunkedBuffer::Compact() {
+  if (chunks_.empty())
+    return;
+  const int used = size_ - ChunkStart(chunks_.size() - 1);
+  if (used < chunks_.back().capacity)
+    ReallocateLastChunk(used, used);
+}
+
+// static
+int MemChunkedBuffer::GrownChunkCapacity(int capacity, int needed) {
+  DCHECK_LE(needed, kChunkSize);
+  return std::min(kChunkSize, std::max(needed, 2 * capacity));
+}
+
+void MemChunkedBuffer::ReallocateLastChunk(int new_capacity, int used) {
+  DCHECK(!chunks_.empty());
+  DCHECK_LE(used, new_capacity);
+  Chunk& last = chunks_.back();
+  DCHECK_LE(used, last.capacity);
+  char* data = AllocateChunk(new_capacity);
+  memcpy(data, last.data, used);
+  FreeChunk(last);
+  capacity_ += new_capacity - last.capacity;
+  last = {data, new_capacity};
+}
+
+char* MemChunkedBuffer::AllocateChunk(int capacity) {
+  DCHECK_GT(capacity, 0);
+  DCHECK_LE(capacity, kChunkSize);
+  if (capacity == kChunkSize)
+    return allocator_->AllocateChunk();
+  return new char[capacity];
+}
+
+void MemChunkedBuffer::FreeChunk(const Chunk& chunk) {
+  if (chunk.capacity == kChunkSize)
+    allocator_->FreeChunk(chunk.data);
+  else
+    delete[] chunk.data;
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,86 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_MEMORY_MEM_CHUNKED_BUFFER_H_
+#define NET_DISK_CACHE_MEMORY_MEM_CHUNKED_BUFFER_H_
+
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/memory/mem_slab_allocator.h"
+
+namespace disk_cache {
+
+// The contents of one MemEntryImpl stream. Data is kept in a list of chunks
+// of MemSlabAllocator::kChunkSize bytes, so growing the stream never moves
+// what is already stored; only the last chunk may be smaller. A small last
+// chunk comes from the heap and grows geometrically up to a full chunk, and
+// Compact() trims it to fit.
+class NET_EXPORT_PRIVATE MemChunkedBuffer {
+ public:
+  explicit MemChunkedBuffer(scoped_refptr<MemSlabAllocator> allocator);
+
+  MemChunkedBuffer(const MemChunkedBuffer&) = delete;
+  MemChunkedBuffer& operator=(const MemChunkedBuffer&) = delete;
+
+  ~MemChunkedBuffer();
+
+  int size() const { return size_; }
+
+  // The number of bytes of memory held for this buffer's data.
+  int capacity() const { return capacity_; }
+
+  // Returns what capacity() would be after Resize(|new_size|).
+  int CapacityAfterResize(int new_size) const;
+
+  // Sets the size to |new_size|. Bytes added by growing the buffer have
+  // unspecified values until they are written.
+  void Resize(int new_size);
+
+  // Copies |len| bytes at |offset| into |dest|. The range must be within
+  // size().
+  void Read(int offset, int len, char* dest) const;
+
+  // Copies |len| bytes from |src| to |offset|. The range must be within
+  // size().
+  void Write(int offset, const char* src, int len);
+
+  // Sets |len| bytes at |offset| to zero. The range must be within size().
+  void Zero(int offset, int len);
+
+  // Releases unused capacity, so that capacity() == size().
+  void Compact();
+
+ private:
+  struct Chunk {
+    char* data;
+    int capacity;
+  };
+
+  // Returns the capacity that a last chunk currently of |capacity| bytes
+  // would be given to hold |needed| bytes.
+  static int GrownChunkCapacity(int capacity, int needed);
+
+  // Replaces the last chunk with one of |new_capacity| bytes, keeping the
+  // first |used| bytes of it.
+  void ReallocateLastChunk(int new_capacity, int used);
+
+  char* AllocateChunk(int capacity);
+  void FreeChunk(const Chunk& chunk);
+
+  // Calls |visitor| with each piece of chunk memory that makes up the
+  // |len| bytes at |offset|, in order.
+  template <typename Visitor>
+  void ForEachPiece(int offset, int len, Visitor visitor) const;
+
+  const scoped_refptr<MemSlabAllocator> allocator_;
+  std::vector<Chunk> chunks_;
+  int size_ = 0;
+  int capacity_ = 0;
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_MEMORY_MEM_CHUNKED_BUFFER_H_
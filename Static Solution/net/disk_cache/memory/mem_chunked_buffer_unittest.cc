@@ -0,0 +1,133 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/memory/mem_chunked_buffer.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "net/disk_cache/memory/mem_slab_allocator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace disk_cache {
+
+namespace {
+
+constexpr int kChunkSize = MemSlabAllocator::kChunkSize;
+
+std::string PatternString(int len) {
+  std::string result(len, '\0');
+  for (int i = 0; i < len; ++i)
+    result[i] = static_cast<char>('a' + i % 26);
+  return result;
+}
+
+std::string ReadAll(const MemChunkedBuffer& buffer) {
+  std::string result(buffer.size(), '\0');
+  buffer.Read(0, buffer.size(), &result[0]);
+  return result;
+}
+
+}  // namespace
+
+TEST(MemSlabAllocatorTest, ReusesFreedChunks) {
+  auto allocator = base::MakeRefCounted<MemSlabAllocator>();
+  char* first = allocator->AllocateChunk();
+  char* second = allocator->AllocateChunk();
+  EXPECT_NE(first, second);
+  EXPECT_EQ(2u, allocator->chunks_in_use());
+  EXPECT_EQ(static_cast<size_t>(MemSlabAllocator::kSlabSize),
+            allocator->reserved_bytes());
+
+  allocator->FreeChunk(first);
+  EXPECT_EQ(first, allocator->AllocateChunk());
+
+  allocator->FreeChunk(first);
+  allocator->FreeChunk(second);
+  EXPECT_EQ(0u, allocator->chunks_in_use());
+}
+
+TEST(MemSlabAllocatorTest, ReleasesEmptySlabs) {
+  auto allocator = base::MakeRefCounted<MemSlabAllocator>();
+  std::vector<char*> chunks;
+  for (int i = 0; i < 3 * MemSlabAllocator::kChunksPerSlab; ++i)
+    chunks.push_back(allocator->AllocateChunk());
+  EXPECT_EQ(3u * MemSlabAllocator::kSlabSize, allocator->reserved_bytes());
+
+  for (char* chunk : chunks)
+    allocator->FreeChunk(chunk);
+  // One empty slab is kept for the next allocation.
+  EXPECT_EQ(static_cast<size_t>(MemSlabAllocator::kSlabSize),
+            allocator->reserved_bytes());
+}
+
+TEST(MemChunkedBufferTest, SmallBufferGrowsGeometrically) {
+  MemChunkedBuffer buffer(base::MakeRefCounted<MemSlabAllocator>());
+  EXPECT_EQ(0, buffer.capacity());
+
+  buffer.Resize(10);
+  EXPECT_EQ(10, buffer.capacity());
+  buffer.Resize(11);
+  EXPECT_EQ(20, buffer.capacity());
+  EXPECT_EQ(40, buffer.CapacityAfterResize(21));
+
+  buffer.Compact();
+  EXPECT_EQ(11, buffer.size());
+  EXPECT_EQ(11, buffer.capacity());
+}
+
+TEST(MemChunkedBufferTest, ReadWriteAcrossChunks) {
+  auto allocator = base::MakeRefCounted<MemSlabAllocator>();
+  MemChunkedBuffer buffer(allocator);
+  const std::string data = PatternString(3 * kChunkSize + 100);
+
+  // Grow through a partial last chunk before spilling into later chunks.
+  buffer.Resize(100);
+  buffer.Write(0, data.data(), 100);
+  buffer.Resize(data.size());
+  buffer.Write(100, data.data() + 100, data.size() - 100);
+  EXPECT_EQ(data, ReadAll(buffer));
+  EXPECT_EQ(3u, allocator->chunks_in_use());
+  EXPECT_EQ(buffer.CapacityAfterResize(buffer.size()), buffer.capacity());
+
+  std::string middle(2 * kChunkSize, '\0');
+  buffer.Read(kChunkSize / 2, middle.size(), &middle[0]);
+  EXPECT_EQ(data.substr(kChunkSize / 2, middle.size()), middle);
+
+  buffer.Zero(kChunkSize - 1, 2);
+  EXPECT_EQ(0, ReadAll(buffer)[kChunkSize - 1]);
+  EXPECT_EQ(0, ReadAll(buffer)[kChunkSize]);
+
+  buffer.Compact();
+  EXPECT_EQ(static_cast<int>(data.size()), buffer.capacity());
+}
+
+TEST(MemChunkedBufferTest, ShrinkReturnsChunks) {
+  auto allocator = base::MakeRefCounted<MemSlabAllocator>();
+  {
+    MemChunkedBuffer buffer(allocator);
+    const std::string data = PatternString(4 * kChunkSize);
+    buffer.Resize(data.size());
+    buffer.Write(0, data.data(), data.size());
+    EXPECT_EQ(4u, allocator->chunks_in_use());
+
+    buffer.Resize(kChunkSize + 1);
+    EXPECT_EQ(2u, allocator->chunks_in_use());
+    EXPECT_EQ(data.substr(0, kChunkSize + 1), ReadAll(buffer));
+
+    // The one byte left in the last chunk moves to a heap allocation.
+    buffer.Compact();
+    EXPECT_EQ(1u, allocator->chunks_in_use());
+    EXPECT_EQ(kChunkSize + 1, buffer.capacity());
+    EXPECT_EQ(data.substr(0, kChunkSize + 1), ReadAll(buffer));
+
+    buffer.Resize(0);
+    EXPECT_EQ(0u, allocator->chunks_in_use());
+    EXPECT_EQ(0, buffer.capacity());
+  }
+  EXPECT_EQ(0u, allocator->chunks_in_use());
+}
+
+}  // namespace disk_cache
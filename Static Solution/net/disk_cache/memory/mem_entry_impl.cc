@@ -119,7 +119,7 @@ bool MemEntryImpl::InUse() const {
 int MemEntryImpl::GetStorageSize() const {
   int storage_size = static_cast<int32_t>(key_.size());
   for (const auto& i : data_)
-    storage_size += i.size();
+    storage_size += i.capacity();
   return storage_size;
 }
 
@@ -289,6 +289,9 @@ MemEntryImpl::MemEntryImpl(base::WeakPtr<MemBackendImpl> backend,
                            MemEntryImpl* parent,
                            net::NetLog* net_log)
     : key_(key),
+      data_{MemChunkedBuffer(backend->slab_allocator()),
+            MemChunkedBuffer(backend->slab_allocator()),
+            MemChunkedBuffer(backend->slab_allocator())},
       child_id_(child_id),
       parent_(parent),
       last_modified_(MemBackendImpl::Now(backend)),
@@ -340,8 +343,7 @@ int MemEntryImpl::InternalReadData(int index, int offset, IOBuffer* buf,
     buf_len = entry_size - offset;
 
   UpdateStateOnUse(ENTRY_WAS_NOT_MODIFIED);
-  std::copy(data_[index].begin() + offset,
-            data_[index].begin() + offset + buf_len, buf->data());
+  data_[index].Read(offset, buf_len, buf->data());
   return buf_len;
 }
 
@@ -368,20 +370,19 @@ int MemEntryImpl::InternalWriteData(int index, int offset, IOBuffer* buf,
 
   int old_data_size = data_[index].size();
   if (truncate || old_data_size < end_offset) {
-    int delta = end_offset - old_data_size;
+    int delta =
+        data_[index].CapacityAfterResize(end_offset) - data_[index].capacity();
     backend_->ModifyStorageSize(delta);
     if (backend_->HasExceededStorageSize()) {
       backend_->ModifyStorageSize(-delta);
       return net::ERR_INSUFFICIENT_RESOURCES;
     }
 
-    data_[index].resize(end_offset);
+    data_[index].Resize(end_offset);
 
-    // Zero fill any hole.
-    if (old_data_size < offset) {
-      std::fill(data_[index].begin() + old_data_size,
-                data_[index].begin() + offset, 0);
-    }
+    // Zero fill any hole. Everything past it is about to be written.
+    if (old_data_size < offset)
+      data_[index].Zero(old_data_size, offset - old_data_size);
   }
 
   UpdateStateOnUse(ENTRY_WAS_MODIFIED);
@@ -389,7 +390,7 @@ int MemEntryImpl::InternalWriteData(int index, int offset, IOBuffer* buf,
   if (!buf_len)
     return 0;
 
-  std::copy(buf->data(), buf->data() + buf_len, data_[index].begin() + offset);
+  data_[index].Write(offset, buf->data(), buf_len);
   return buf_len;
 }
 
@@ -618,9 +619,11 @@ net::Interval<int64_t> MemEntryImpl::ChildInterval(
 }
 
 void MemEntryImpl::Compact() {
-  // Stream 0 should already be fine since it's written out in a single WriteData().
-  data_[1].shrink_to_fit();
-  data_[2].shrink_to_fit();
+  const int old_storage_size = GetStorageSize();
+  for (auto& stream : data_)
+    stream.Compact();
+  if (backend_)
+    backend_->ModifyStorageSize(GetStorageSize() - old_storage_size);
 }
 
 }  // namespace disk_cache
@@ -10,7 +10,6 @@
 #include <map>
 #include <memory>
 #include <string>
-#include <vector>
 
 #include "base/containers/linked_list.h"
 #include "base/gtest_prod_util.h"
@@ -21,6 +20,7 @@
 #include "net/base/interval.h"
 #include "net/base/net_export.h"
 #include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/memory/mem_chunked_buffer.h"
 #include "net/log/net_log_with_source.h"
 
 namespace net {
@@ -98,7 +98,8 @@ class NET_EXPORT_PRIVATE MemEntryImpl final
   int64_t child_id() const { return child_id_; }
   base::Time last_used() const { return last_used_; }
 
-  // The in-memory size of this entry to use for the purposes of eviction.
+  // The in-memory size of this entry to use for the purposes of eviction: the
+  // key plus the memory held for the streams, including unused capacity.
   int GetStorageSize() const;
 
   // Update an entry's position in the backend LRU list and set |last_used_|. If
@@ -177,11 +178,11 @@ class NET_EXPORT_PRIVATE MemEntryImpl final
   net::Interval<int64_t> ChildInterval(
       MemEntryImpl::EntryMap::const_iterator i);
 
-  // Compact vectors to try to avoid over-allocation due to exponential growth.
+  // Releases the unused capacity of the streams.
   void Compact();
 
   std::string key_;
-  std::vector<char> data_[kNumStreams];  // User data.
+  MemChunkedBuffer data_[kNumStreams];  // User data.
   uint32_t ref_count_ = 0;
 
   int64_t child_id_;     // The ID of a child entry.
@@ -0,0 +1,81 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/memory/mem_slab_allocator.h"
+
+#include <utility>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+
+namespace disk_cache {
+
+namespace {
+
+const uint16_t kAllChunksFree = 0xffff;
+
+}  // namespace
+
+MemSlabAllocator::Slab::Slab()
+    : memory(new char[kSlabSize]), free_chunks(kAllChunksFree) {}
+
+MemSlabAllocator::Slab::~Slab() = default;
+
+MemSlabAllocator::MemSlabAllocator() = default;
+
+MemSlabAllocator::~MemSlabAllocator() {
+  DCHECK_EQ(0u, chunks_in_use_);
+}
+
+char* MemSlabAllocator::AllocateChunk() {
+  if (slabs_with_free_chunks_.empty()) {
+    auto slab = std::make_unique<Slab>();
+    const char* key = slab->memory.get();
+    slabs_.emplace(key, std::move(slab));
+    slabs_with_free_chunks_.insert(key);
+  }
+
+  auto free_it = slabs_with_free_chunks_.begin();
+  Slab* slab = slabs_.find(*free_it)->second.get();
+  DCHECK(slab->free_chunks);
+  const int index = base::bits::CountTrailingZeroBits(slab->free_chunks);
+  slab->free_chunks &= ~(1u << index);
+  if (!slab->free_chunks)
+    slabs_with_free_chunks_.erase(free_it);
+
+  ++chunks_in_use_;
+  return slab->memory.get() + index * kChunkSize;
+}
+
+void MemSlabAllocator::FreeChunk(char* chunk) {
+  DCHECK(chunk);
+  auto it = slabs_.upper_bound(chunk);
+  DCHECK(it != slabs_.begin());
+  --it;
+  Slab* slab = it->second.get();
+  const ptrdiff_t offset = chunk - slab->memory.get();
+  DCHECK_LT(offset, kSlabSize);
+  DCHECK_EQ(0, offset % kChunkSize);
+  const int index = offset / kChunkSize;
+  DCHECK(!(slab->free_chunks & (1u << index)));
+
+  slab->free_chunks |= 1u << index;
+  DCHECK_GT(chunks_in_use_, 0u);
+  --chunks_in_use_;
+
+  if (slab->free_chunks != kAllChunksFree) {
+    slabs_with_free_chunks_.insert(it->first);
+    return;
+  }
+
+  // Keep this slab if it would be the only one left to allocate from.
+  slabs_with_free_chunks_.erase(it->first);
+  if (slabs_with_free_chunks_.empty()) {
+    slabs_with_free_chunks_.insert(it->first);
+    return;
+  }
+  slabs_.erase(it);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,90 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_MEMORY_MEM_SLAB_ALLOCATOR_H_
+#define NET_DISK_CACHE_MEMORY_MEM_SLAB_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <set>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/base/net_export.h"
+
+namespace disk_cache {
+
+// Hands out the fixed-size chunks that MemEntryImpl stores its data in. Chunks
+// are carved out of larger slabs, so that a backend full of entries makes a
+// few large allocations instead of many differently-sized ones, and a chunk
+// freed by one entry is reused by the next. A slab is returned to the system
+// once none of its chunks are in use, except that one empty slab is kept
+// around to absorb churn. A slab with even one chunk in use is kept whole, so
+// the owner should account for unused_reserved_bytes() too.
+//
+// Reference counted because entries that are still open may outlive the
+// MemBackendImpl that created them. Not thread-safe, like the rest of the
+// memory backend.
+class NET_EXPORT_PRIVATE MemSlabAllocator
+    : public base::RefCounted<MemSlabAllocator> {
+ public:
+  static constexpr int kChunkSize = 4096;
+  static constexpr int kChunksPerSlab = 16;
+  static constexpr int kSlabSize = kChunkSize * kChunksPerSlab;
+
+  MemSlabAllocator();
+
+  MemSlabAllocator(const MemSlabAllocator&) = delete;
+  MemSlabAllocator& operator=(const MemSlabAllocator&) = delete;
+
+  // Returns an uninitialized chunk of |kChunkSize| bytes.
+  char* AllocateChunk();
+
+  // Returns |chunk|, which must have come from AllocateChunk() on this
+  // allocator, to the pool.
+  void FreeChunk(char* chunk);
+
+  size_t chunks_in_use() const { return chunks_in_use_; }
+
+  // Memory held from the system, whether or not it is handed out.
+  size_t reserved_bytes() const { return slabs_.size() * kSlabSize; }
+
+  // Memory held from the system but not handed out, because it is in slabs
+  // that still have other chunks in use, or in the empty slab that is kept.
+  size_t unused_reserved_bytes() const {
+    return reserved_bytes() - chunks_in_use_ * kChunkSize;
+  }
+
+ private:
+  friend class base::RefCounted<MemSlabAllocator>;
+
+  struct Slab {
+    Slab();
+    ~Slab();
+
+    std::unique_ptr<char[]> memory;
+    // Bit i is set when chunk i is free.
+    uint16_t free_chunks;
+  };
+  static_assert(kChunksPerSlab == 16, "Slab::free_chunks holds 16 bits");
+
+  ~MemSlabAllocator();
+
+  // Slabs, keyed by the address of their memory, so that the slab a chunk
+  // belongs to can be found from the chunk's address.
+  std::map<const char*, std::unique_ptr<Slab>> slabs_;
+
+  // Slabs that have at least one free chunk. Chunks are taken from the
+  // lowest-addressed one, which keeps the others emptying out.
+  std::set<const char*> slabs_with_free_chunks_;
+
+  size_t chunks_in_use_ = 0;
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_MEMORY_MEM_SLAB_ALLOCATOR_H_
@@ -26,6 +26,7 @@
 #include "base/metrics/field_trial_params.h"
 #include "base/metrics/histogram_functions.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/system/sys_info.h"
 #include "base/task/task_runner_util.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
@@ -36,6 +37,7 @@
 #include "net/base/prioritized_task_runner.h"
 #include "net/disk_cache/backend_cleanup_tracker.h"
 #include "net/disk_cache/cache_util.h"
+#include "net/disk_cache/simple/simple_blob_store.h"
 #include "net/disk_cache/simple/simple_entry_format.h"
 #include "net/disk_cache/simple/simple_entry_impl.h"
 #include "net/disk_cache/simple/simple_file_tracker.h"
@@ -169,6 +171,12 @@ void RecordIndexLoad(net::CacheType cache_type,
   }
 }
 
+// Closes the entry |result| opened, if any.
+void CloseOpenedEntry(EntryResult result) {
+  if (result.net_error() == net::OK)
+    result.ReleaseEntry()->Close();
+}
+
 SimpleEntryImpl::OperationsMode CacheTypeToOperationsMode(net::CacheType type) {
   return (type == net::DISK_CACHE || type == net::GENERATED_BYTE_CODE_CACHE ||
           type == net::GENERATED_NATIVE_CODE_CACHE ||
@@ -222,6 +230,11 @@ SimpleBackendImpl::SimpleBackendImpl(
       file_tracker_(file_tracker ? file_tracker
                                  : g_simple_file_tracker.Pointer()),
       path_(path),
+      blob_store_(
+          cache_type == net::DISK_CACHE &&
+                  base::FeatureList::IsEnabled(kSimpleCacheDeduplication)
+              ? base::MakeRefCounted<SimpleBlobStore>(path)
+              : nullptr),
       orig_max_size_(max_bytes),
       entry_operations_mode_(CacheTypeToOperationsMode(cache_type)),
       post_doom_waiting_(
@@ -240,6 +253,28 @@ SimpleBackendImpl::~SimpleBackendImpl() {
     index_->WriteToDisk(SimpleIndex::INDEX_WRITE_REASON_SHUTDOWN);
 }
 
+void SimpleBackendImpl::MoveFirstCopyToBlob(uint64_t entry_hash) {
+  EntryResult result =
+      OpenEntryFromHash(entry_hash, base::BindOnce(&CloseOpenedEntry));
+  if (result.net_error() != net::ERR_IO_PENDING)
+    CloseOpenedEntry(std::move(result));
+}
+
+void SimpleBackendImpl::OnBlobStorageChanged() {
+  DCHECK(blob_store_);
+  std::vector<SimpleBlobStore::ReferenceChange> reference_changes =
+      blob_store_->TakeReferenceChanges();
+  if (reference_changes.empty())
+    return;
+  std::vector<SimpleIndex::SharedStorageChange> changes;
+  changes.reserve(reference_changes.size());
+  for (const SimpleBlobStore::ReferenceChange& change : reference_changes) {
+    changes.push_back({change.entry_hash, change.blob_id,
+                       base::checked_cast<uint64_t>(change.blob_size)});
+  }
+  index_->UpdateSharedStorage(changes);
+}
+
 void SimpleBackendImpl::SetTaskRunnerForTesting(
     scoped_refptr<base::SequencedTaskRunner> task_runner) {
   prioritized_task_runner_ =
@@ -270,7 +305,7 @@ net::Error SimpleBackendImpl::Init(CompletionOnceCallback completion_callback) {
       FROM_HERE,
       base::BindOnce(&SimpleBackendImpl::InitCacheStructureOnDisk,
                      std::move(file_operations), path_, orig_max_size_,
-                     GetCacheType()),
+                     GetCacheType(), blob_store_),
       base::BindOnce(&SimpleBackendImpl::InitializeIndex, AsWeakPtr(),
                      std::move(completion_callback)));
   return net::ERR_IO_PENDING;
@@ -359,7 +394,7 @@ void SimpleBackendImpl::DoomEntries(std::vector<uint64_t>* entry_hashes,
   task_runner->PostTaskAndReplyWithResult(
       FROM_HERE,
       base::BindOnce(&SimpleSynchronousEntry::DeleteEntrySetFiles,
-                     mass_doom_entry_hashes_ptr, path_,
+                     mass_doom_entry_hashes_ptr, path_, blob_store_,
                      file_operations_factory_->CreateUnbound()),
       base::BindOnce(&SimpleBackendImpl::DoomEntriesComplete, AsWeakPtr(),
                      std::move(mass_doom_entry_hashes), barrier_callback));
@@ -374,6 +409,7 @@ EntryResult SimpleBackendImpl::OpenEntry(const std::string& key,
                                          net::RequestPriority request_priority,
                                          EntryResultCallback callback) {
   const uint64_t entry_hash = simple_util::GetEntryHashKey(key);
+  index_->RecordAccess(entry_hash);
 
   std::vector<SimplePostDoomWaiter>* post_doom = nullptr;
   scoped_refptr<SimpleEntryImpl> simple_entry = CreateOrFindActiveOrDoomedEntry(
@@ -409,6 +445,7 @@ EntryResult SimpleBackendImpl::CreateEntry(
     EntryResultCallback callback) {
   DCHECK_LT(0u, key.size());
   const uint64_t entry_hash = simple_util::GetEntryHashKey(key);
+  index_->RecordAccess(entry_hash);
 
   std::vector<SimplePostDoomWaiter>* post_doom = nullptr;
   scoped_refptr<SimpleEntryImpl> simple_entry = CreateOrFindActiveOrDoomedEntry(
@@ -441,6 +478,7 @@ EntryResult SimpleBackendImpl::OpenOrCreateEntry(
     EntryResultCallback callback) {
   DCHECK_LT(0u, key.size());
   const uint64_t entry_hash = simple_util::GetEntryHashKey(key);
+  index_->RecordAccess(entry_hash);
 
   std::vector<SimplePostDoomWaiter>* post_doom = nullptr;
   scoped_refptr<SimpleEntryImpl> simple_entry = CreateOrFindActiveOrDoomedEntry(
@@ -640,7 +678,9 @@ void SimpleBackendImpl::GetStats(base::StringPairs* stats) {
 }
 
 void SimpleBackendImpl::OnExternalCacheHit(const std::string& key) {
-  index_->UseIfExists(simple_util::GetEntryHashKey(key));
+  const uint64_t entry_hash = simple_util::GetEntryHashKey(key);
+  index_->RecordAccess(entry_hash);
+  index_->UseIfExists(entry_hash);
 }
 
 uint8_t SimpleBackendImpl::GetEntryInMemoryData(const std::string& key) {
@@ -663,6 +703,8 @@ void SimpleBackendImpl::InitializeIndex(CompletionOnceCallback callback,
       index_->set_app_status_listener(app_status_listener_);
 #endif
     index_->Initialize(result.cache_dir_mtime);
+    if (blob_store_)
+      OnBlobStorageChanged();
   }
   std::move(callback).Run(result.net_error);
 }
@@ -703,7 +745,8 @@ SimpleBackendImpl::DiskStatResult SimpleBackendImpl::InitCacheStructureOnDisk(
     std::unique_ptr<BackendFileOperations> file_operations,
     const base::FilePath& path,
     uint64_t suggested_max_size,
-    net::CacheType cache_type) {
+    net::CacheType cache_type,
+    scoped_refptr<SimpleBlobStore> blob_store) {
   DiskStatResult result;
   result.max_size = suggested_max_size;
   result.net_error = net::OK;
@@ -744,6 +787,10 @@ SimpleBackendImpl::DiskStatResult SimpleBackendImpl::InitCacheStructureOnDisk(
                << " path: " << path.LossyDisplayName();
     result.net_error = net::ERR_FAILED;
   } else {
+    // Done before looking at the mtime, since this may create the blob
+    // directory.
+    if (blob_store)
+      blob_store->Initialize(file_operations.get());
     absl::optional<base::File::Info> file_info =
         file_operations->GetFileInfo(path);
     if (!file_info.has_value()) {
@@ -906,6 +953,8 @@ void SimpleBackendImpl::DoomEntriesComplete(
     int result) {
   for (const uint64_t& entry_hash : *entry_hashes)
     post_doom_waiting_->OnDoomComplete(entry_hash);
+  if (blob_store_)
+    OnBlobStorageChanged();
   std::move(callback).Run(result);
 }
 
@@ -52,6 +52,7 @@ namespace disk_cache {
 
 class BackendCleanupTracker;
 class BackendFileOperationsFactory;
+class SimpleBlobStore;
 class SimpleEntryImpl;
 class SimpleFileTracker;
 class SimpleIndex;
@@ -76,6 +77,20 @@ class NET_EXPORT_PRIVATE SimpleBackendImpl : public Backend,
 
   SimpleIndex* index() { return index_.get(); }
 
+  // Null unless kSimpleCacheDeduplication is enabled for this cache.
+  const scoped_refptr<SimpleBlobStore>& blob_store() const {
+    return blob_store_;
+  }
+
+  // Called when blobs may have been added to or removed from blob_store(), to
+  // keep the index's view of the cache size, and of what evicting each entry
+  // frees, current.
+  void OnBlobStorageChanged();
+
+  // Opens and closes the entry |entry_hash|, which has the first copy of the
+  // contents of a new blob, so that its close moves it to the blob.
+  void MoveFirstCopyToBlob(uint64_t entry_hash);
+
   void SetTaskRunnerForTesting(
       scoped_refptr<base::SequencedTaskRunner> task_runner);
 
@@ -189,7 +204,8 @@ class NET_EXPORT_PRIVATE SimpleBackendImpl : public Backend,
       std::unique_ptr<BackendFileOperations> file_operations,
       const base::FilePath& path,
       uint64_t suggested_max_size,
-      net::CacheType cache_type);
+      net::CacheType cache_type,
+      scoped_refptr<SimpleBlobStore> blob_store);
 
   // Looks at current state of |entries_pending_doom_| and |active_entries_|
   // relevant to |entry_hash|, and, as appropriate, either returns a valid entry
@@ -262,6 +278,7 @@ class NET_EXPORT_PRIVATE SimpleBackendImpl : public Backend,
   const raw_ptr<SimpleFileTracker> file_tracker_;
 
   const base::FilePath path_;
+  const scoped_refptr<SimpleBlobStore> blob_store_;
   std::unique_ptr<SimpleIndex> index_;
 
   // This is used for all the entry I/O.
@@ -0,0 +1,527 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_blob_store.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "base/metrics/field_trial_params.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/simple/simple_file_tracker.h"
+#include "net/disk_cache/simple/simple_util.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace disk_cache {
+
+const base::Feature kSimpleCacheDeduplication = {
+    "SimpleCacheDeduplication", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const char kSimpleCacheDeduplicationMinBytesParam[] = "MinBlobBytes";
+
+namespace {
+
+constexpr base::FeatureParam<int> kSimpleCacheDeduplicationMinBytes{
+    &kSimpleCacheDeduplication, kSimpleCacheDeduplicationMinBytesParam,
+    64 * 1024};
+
+const char kBlobDirectory[] = "blobs";
+const char kJournalFileName[] = "journal";
+const char kTempJournalFileName[] = "journal.tmp";
+
+const uint32_t kJournalAddMagicNumber = 0x9e27d4f0;
+const uint32_t kJournalReleaseMagicNumber = 0x5a3c1b61;
+
+// How many once-seen contents to remember.
+const size_t kMaxSeenOnce = 4096;
+
+// The journal is compacted once it has this many records, and at least
+// kJournalCompactionFactor times as many as there are references.
+const size_t kMinJournalRecordsToCompact = 1024;
+const size_t kJournalCompactionFactor = 4;
+
+// Separates the hash of a blob's contents from its ID in its file name.
+const char kBlobIdSeparator = '_';
+
+// One change to the references, as stored in the journal.
+struct JournalRecord {
+  uint64_t entry_hash;
+  uint8_t blob_hash[32];
+  // kJournalAddMagicNumber or kJournalReleaseMagicNumber.
+  uint32_t magic_number;
+  // Of the fields above.
+  uint32_t crc;
+};
+static_assert(sizeof(JournalRecord) == 48, "JournalRecord must be packed");
+static_assert(sizeof(JournalRecord::blob_hash) == sizeof(net::SHA256HashValue),
+              "JournalRecord must hold a SHA-256");
+
+uint32_t CalculateJournalRecordCRC(const JournalRecord& record) {
+  return simple_util::Crc32(reinterpret_cast<const char*>(&record),
+                            offsetof(JournalRecord, crc));
+}
+
+JournalRecord MakeJournalRecord(
+    uint64_t entry_hash,
+    const absl::optional<net::SHA256HashValue>& hash) {
+  JournalRecord record = {};
+  record.entry_hash = entry_hash;
+  if (hash)
+    memcpy(record.blob_hash, hash->data, sizeof(record.blob_hash));
+  record.magic_number =
+      hash ? kJournalAddMagicNumber : kJournalReleaseMagicNumber;
+  record.crc = CalculateJournalRecordCRC(record);
+  return record;
+}
+
+// Parses the name of a blob file into the hash of its contents and its ID.
+bool ParseBlobFileName(const std::string& name,
+                       net::SHA256HashValue* out_hash,
+                       uint64_t* out_id) {
+  const size_t separator = name.find(kBlobIdSeparator);
+  if (separator == std::string::npos)
+    return false;
+  std::vector<uint8_t> hash_bytes;
+  if (!base::HexStringToBytes(name.substr(0, separator), &hash_bytes) ||
+      hash_bytes.size() != sizeof(out_hash->data) ||
+      !base::HexStringToUInt64(name.substr(separator + 1), out_id)) {
+    return false;
+  }
+  memcpy(out_hash->data, hash_bytes.data(), sizeof(out_hash->data));
+  return true;
+}
+
+}  // namespace
+
+int GetSimpleCacheDeduplicationMinBytes() {
+  return kSimpleCacheDeduplicationMinBytes.Get();
+}
+
+SimpleBlobStore::SimpleBlobStore(const base::FilePath& cache_path)
+    : cache_path_(cache_path),
+      blob_directory_(cache_path.AppendASCII(kBlobDirectory)) {}
+
+SimpleBlobStore::~SimpleBlobStore() = default;
+
+void SimpleBlobStore::Initialize(BackendFileOperations* file_operations) {
+  if (!file_operations->DirectoryExists(blob_directory_)) {
+    file_operations->CreateDirectory(blob_directory_);
+    return;
+  }
+
+  // Replay the journal. Records are applied in order, and reading stops at
+  // the first one that is torn or corrupt.
+  std::unordered_map<uint64_t, net::SHA256HashValue> saved_references;
+  base::File journal = file_operations->OpenFile(
+      GetJournalPath(), base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (journal.IsValid()) {
+    const int64_t length = journal.GetLength();
+    std::vector<char> contents;
+    if (length > 0 && base::IsValueInRangeForNumericType<int>(length)) {
+      contents.resize(length);
+      if (journal.Read(0, contents.data(), contents.size()) != length)
+        contents.clear();
+    }
+    journal.Close();
+    for (size_t offset = 0; offset + sizeof(JournalRecord) <= contents.size();
+         offset += sizeof(JournalRecord)) {
+      JournalRecord record;
+      memcpy(&record, contents.data() + offset, sizeof(record));
+      if (record.crc != CalculateJournalRecordCRC(record))
+        break;
+      if (record.magic_number == kJournalAddMagicNumber) {
+        net::SHA256HashValue hash;
+        memcpy(hash.data, record.blob_hash, sizeof(hash.data));
+        saved_references[record.entry_hash] = hash;
+      } else if (record.magic_number == kJournalReleaseMagicNumber) {
+        saved_references.erase(record.entry_hash);
+      } else {
+        break;
+      }
+    }
+  }
+
+  // A reference can outlive its entry if the entry's files went away without
+  // the store hearing of it, e.g. in a crash right after they were deleted.
+  for (auto it = saved_references.begin(); it != saved_references.end();) {
+    const base::FilePath entry_path = cache_path_.AppendASCII(
+        simple_util::GetFilenameFromEntryFileKeyAndFileIndex(
+            SimpleFileTracker::EntryFileKey(it->first), 0));
+    if (file_operations->PathExists(entry_path))
+      ++it;
+    else
+      it = saved_references.erase(it);
+  }
+
+  std::set<net::SHA256HashValue> referenced_blobs;
+  for (const auto& reference : saved_references)
+    referenced_blobs.insert(reference.second);
+
+  std::map<net::SHA256HashValue, Blob> blobs;
+  uint64_t next_blob_id = 0;
+  std::unique_ptr<BackendFileOperations::FileEnumerator> enumerator =
+      file_operations->EnumerateFiles(blob_directory_);
+  while (absl::optional<BackendFileOperations::FileEnumerationEntry> file =
+             enumerator->Next()) {
+    if (file->path == GetJournalPath())
+      continue;
+    net::SHA256HashValue hash;
+    uint64_t id;
+    if (ParseBlobFileName(file->path.BaseName().MaybeAsASCII(), &hash, &id)) {
+      next_blob_id = std::max(next_blob_id, id + 1);
+      // A crash can leave two copies of the same contents; keep one.
+      if (referenced_blobs.count(hash) &&
+          blobs.emplace(hash, Blob{file->size, 0, id}).second) {
+        continue;
+      }
+    }
+    // Leftover temporary files and blobs nothing points at.
+    file_operations->DeleteFile(file->path);
+  }
+
+  {
+    base::AutoLock auto_lock(lock_);
+    DCHECK(blobs_.empty());
+    blobs_ = std::move(blobs);
+    next_blob_id_ = next_blob_id;
+    for (const auto& blob : blobs_)
+      total_size_ += blob.second.size;
+    for (const auto& reference : saved_references) {
+      auto blob_it = blobs_.find(reference.second);
+      if (blob_it == blobs_.end())
+        continue;
+      ++blob_it->second.references;
+      references_.insert(reference);
+      reference_changes_.push_back(
+          {reference.first, blob_it->second.id, blob_it->second.size});
+    }
+    pending_journal_rewrite_ = references_;
+    journal_records_ = references_.size();
+  }
+  WriteChanges(file_operations, {});
+}
+
+SimpleBlobStore::Disposition SimpleBlobStore::AddReference(
+    BackendFileOperations* file_operations,
+    uint64_t entry_hash,
+    const net::SHA256HashValue& hash) {
+  std::vector<base::FilePath> unreferenced_blob_paths;
+  Disposition disposition;
+  {
+    base::AutoLock auto_lock(lock_);
+    disposition =
+        AddReferenceLocked(entry_hash, hash, &unreferenced_blob_paths);
+  }
+  WriteChanges(file_operations, unreferenced_blob_paths);
+  return disposition;
+}
+
+base::FilePath SimpleBlobStore::GetTempFilePath(uint64_t entry_hash) const {
+  return blob_directory_.AppendASCII(
+      base::StringPrintf("tmp_%016" PRIx64, entry_hash));
+}
+
+bool SimpleBlobStore::CommitBlob(BackendFileOperations* file_operations,
+                                 uint64_t entry_hash,
+                                 const net::SHA256HashValue& hash,
+                                 int64_t size,
+                                 absl::optional<uint64_t>*
+                                     out_first_copy_entry_hash) {
+  *out_first_copy_entry_hash = absl::nullopt;
+  const base::FilePath temp_path = GetTempFilePath(entry_hash);
+  std::vector<base::FilePath> unreferenced_blob_paths;
+  bool blob_exists;
+  uint64_t id = 0;
+  {
+    base::AutoLock auto_lock(lock_);
+    ReleaseReferenceLocked(entry_hash, &unreferenced_blob_paths);
+    blob_exists = blobs_.count(hash) > 0;
+    if (!blob_exists)
+      id = next_blob_id_++;
+  }
+
+  // Each blob file has an ID of its own, so nothing else can be using the
+  // name this one is moved to.
+  bool moved = false;
+  if (blob_exists) {
+    file_operations->DeleteFile(temp_path);
+  } else {
+    base::File::Error error;
+    moved = file_operations->ReplaceFile(temp_path, GetBlobPath(hash, id),
+                                         &error);
+    if (!moved)
+      file_operations->DeleteFile(temp_path);
+  }
+
+  bool committed = false;
+  {
+    base::AutoLock auto_lock(lock_);
+    auto blob_it = blobs_.find(hash);
+    if (blob_it != blobs_.end()) {
+      // Another entry may have created the blob meanwhile.
+      if (moved)
+        unreferenced_blob_paths.push_back(GetBlobPath(hash, id));
+      committed = true;
+    } else if (moved) {
+      blob_it = blobs_.emplace(hash, Blob{size, 0, id}).first;
+      total_size_ += size;
+      auto seen_it = seen_once_.find(hash);
+      if (seen_it != seen_once_.end()) {
+        if (seen_it->second != entry_hash) {
+          if (pending_moves_.size() >= kMaxSeenOnce)
+            pending_moves_.clear();
+          pending_moves_[seen_it->second] = hash;
+          *out_first_copy_entry_hash = seen_it->second;
+        }
+        seen_once_.erase(seen_it);
+      }
+      committed = true;
+    }
+    // Otherwise the blob this was going to share went away meanwhile, or the
+    // new one could not be moved into place.
+    if (committed) {
+      ++blob_it->second.references;
+      references_[entry_hash] = hash;
+      QueueChangeLocked(entry_hash, hash);
+    }
+  }
+  WriteChanges(file_operations, unreferenced_blob_paths);
+  return committed;
+}
+
+absl::optional<net::SHA256HashValue> SimpleBlobStore::TakePendingMove(
+    uint64_t entry_hash) {
+  base::AutoLock auto_lock(lock_);
+  auto it = pending_moves_.find(entry_hash);
+  if (it == pending_moves_.end())
+    return absl::nullopt;
+  const net::SHA256HashValue hash = it->second;
+  pending_moves_.erase(it);
+  return hash;
+}
+
+base::File SimpleBlobStore::OpenBlob(BackendFileOperations* file_operations,
+                                     uint64_t entry_hash,
+                                     const net::SHA256HashValue& hash) {
+  base::FilePath path;
+  {
+    base::AutoLock auto_lock(lock_);
+    auto reference_it = references_.find(entry_hash);
+    if (reference_it == references_.end() || !(reference_it->second == hash))
+      return base::File();
+    path = GetBlobPath(hash, blobs_.at(hash).id);
+  }
+  // The entry's own reference keeps the blob from being deleted meanwhile.
+  return file_operations->OpenFile(
+      path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                base::File::FLAG_WIN_SHARE_DELETE);
+}
+
+void SimpleBlobStore::ReleaseReference(BackendFileOperations* file_operations,
+                                       uint64_t entry_hash) {
+  std::vector<base::FilePath> unreferenced_blob_paths;
+  {
+    base::AutoLock auto_lock(lock_);
+    pending_moves_.erase(entry_hash);
+    ReleaseReferenceLocked(entry_hash, &unreferenced_blob_paths);
+  }
+  WriteChanges(file_operations, unreferenced_blob_paths);
+}
+
+int64_t SimpleBlobStore::GetTotalSize() const {
+  base::AutoLock auto_lock(lock_);
+  return total_size_;
+}
+
+size_t SimpleBlobStore::GetReferenceCount() const {
+  base::AutoLock auto_lock(lock_);
+  return references_.size();
+}
+
+std::vector<SimpleBlobStore::ReferenceChange>
+SimpleBlobStore::TakeReferenceChanges() {
+  base::AutoLock auto_lock(lock_);
+  std::vector<ReferenceChange> changes;
+  changes.swap(reference_changes_);
+  return changes;
+}
+
+base::FilePath SimpleBlobStore::GetBlobPath(const net::SHA256HashValue& hash,
+                                            uint64_t id) const {
+  return blob_directory_.AppendASCII(
+      base::HexEncode(hash.data, sizeof(hash.data)) + kBlobIdSeparator +
+      base::StringPrintf("%" PRIx64, id));
+}
+
+base::FilePath SimpleBlobStore::GetJournalPath() const {
+  return blob_directory_.AppendASCII(kJournalFileName);
+}
+
+SimpleBlobStore::Disposition SimpleBlobStore::AddReferenceLocked(
+    uint64_t entry_hash,
+    const net::SHA256HashValue& hash,
+    std::vector<base::FilePath>* unreferenced_blob_paths) {
+  pending_moves_.erase(entry_hash);
+  auto reference_it = references_.find(entry_hash);
+  if (reference_it != references_.end() && reference_it->second == hash)
+    return Disposition::kReferenced;
+  ReleaseReferenceLocked(entry_hash, unreferenced_blob_paths);
+
+  auto blob_it = blobs_.find(hash);
+  if (blob_it != blobs_.end()) {
+    ++blob_it->second.references;
+    references_[entry_hash] = hash;
+    QueueChangeLocked(entry_hash, hash);
+    return Disposition::kReferenced;
+  }
+  auto seen_it = seen_once_.find(hash);
+  // An entry that is rewritten with the same contents is not a duplicate.
+  if (seen_it != seen_once_.end() && seen_it->second != entry_hash)
+    return Disposition::kCreateBlob;
+  if (seen_once_.size() >= kMaxSeenOnce)
+    seen_once_.clear();
+  seen_once_[hash] = entry_hash;
+  return Disposition::kKeepInline;
+}
+
+void SimpleBlobStore::ReleaseReferenceLocked(
+    uint64_t entry_hash,
+    std::vector<base::FilePath>* unreferenced_blob_paths) {
+  auto reference_it = references_.find(entry_hash);
+  if (reference_it == references_.end())
+    return;
+  auto blob_it = blobs_.find(reference_it->second);
+  references_.erase(reference_it);
+  QueueChangeLocked(entry_hash, absl::nullopt);
+  DCHECK(blob_it != blobs_.end());
+  DCHECK_GT(blob_it->second.references, 0);
+  if (--blob_it->second.references > 0)
+    return;
+  unreferenced_blob_paths->push_back(
+      GetBlobPath(blob_it->first, blob_it->second.id));
+  total_size_ -= blob_it->second.size;
+  blobs_.erase(blob_it);
+}
+
+void SimpleBlobStore::QueueChangeLocked(
+    uint64_t entry_hash,
+    const absl::optional<net::SHA256HashValue>& hash) {
+  ReferenceChange change = {entry_hash};
+  if (hash) {
+    const Blob& blob = blobs_.at(*hash);
+    change.blob_id = blob.id;
+    change.blob_size = blob.size;
+  }
+  reference_changes_.push_back(change);
+
+  pending_journal_records_.push_back({entry_hash, hash});
+  ++journal_records_;
+  if (journal_records_ < kMinJournalRecordsToCompact ||
+      journal_records_ < kJournalCompactionFactor * references_.size()) {
+    return;
+  }
+  // The current references already include every queued record.
+  pending_journal_rewrite_ = references_;
+  pending_journal_records_in_rewrite_ = pending_journal_records_.size();
+  journal_records_ = references_.size();
+}
+
+void SimpleBlobStore::WriteChanges(
+    BackendFileOperations* file_operations,
+    const std::vector<base::FilePath>& unreferenced_blob_paths) {
+  WriteJournal(file_operations);
+  // Only once the journal no longer points at them.
+  for (const base::FilePath& path : unreferenced_blob_paths)
+    file_operations->DeleteFile(path);
+}
+
+void SimpleBlobStore::WriteJournal(BackendFileOperations* file_operations) {
+  // Taking the queue while holding |journal_lock_| keeps the records in the
+  // order they were queued in.
+  base::AutoLock journal_auto_lock(journal_lock_);
+  std::vector<PendingJournalRecord> pending_records;
+  absl::optional<std::unordered_map<uint64_t, net::SHA256HashValue>> rewrite;
+  size_t records_in_rewrite = 0;
+  {
+    base::AutoLock auto_lock(lock_);
+    pending_records.swap(pending_journal_records_);
+    rewrite.swap(pending_journal_rewrite_);
+    records_in_rewrite = pending_journal_records_in_rewrite_;
+    pending_journal_records_in_rewrite_ = 0;
+  }
+
+  // If the rewrite fails, everything is appended to the old journal instead.
+  // It is then compacted again once it has grown as much again.
+  size_t first_record = 0;
+  if (rewrite && RewriteJournal(file_operations, *rewrite))
+    first_record = records_in_rewrite;
+  if (first_record == pending_records.size())
+    return;
+
+  std::vector<JournalRecord> records;
+  records.reserve(pending_records.size() - first_record);
+  for (size_t i = first_record; i < pending_records.size(); ++i) {
+    records.push_back(MakeJournalRecord(pending_records[i].entry_hash,
+                                        pending_records[i].hash));
+  }
+  const int size =
+      base::checked_cast<int>(records.size() * sizeof(JournalRecord));
+  base::File file = file_operations->OpenFile(
+      GetJournalPath(), base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND |
+                            base::File::FLAG_WIN_SHARE_DELETE);
+  if (!file.IsValid() ||
+      file.WriteAtCurrentPos(reinterpret_cast<const char*>(records.data()),
+                             size) != size) {
+    // The next startup may then drop some entries' blobs, or keep some too
+    // long.
+    LOG(ERROR) << "Failed to append to the blob journal";
+  }
+}
+
+bool SimpleBlobStore::RewriteJournal(
+    BackendFileOperations* file_operations,
+    const std::unordered_map<uint64_t, net::SHA256HashValue>& references) {
+  std::vector<JournalRecord> records;
+  records.reserve(references.size());
+  for (const auto& reference : references)
+    records.push_back(MakeJournalRecord(reference.first, reference.second));
+
+  const base::FilePath temp_path =
+      blob_directory_.AppendASCII(kTempJournalFileName);
+  base::File file = file_operations->OpenFile(
+      temp_path, base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE |
+                     base::File::FLAG_WIN_SHARE_DELETE);
+  const int size =
+      base::checked_cast<int>(records.size() * sizeof(JournalRecord));
+  const bool written =
+      file.IsValid() &&
+      (size == 0 || file.Write(0, reinterpret_cast<const char*>(records.data()),
+                               size) == size);
+  file.Close();
+  base::File::Error error;
+  if (!written ||
+      !file_operations->ReplaceFile(temp_path, GetJournalPath(), &error)) {
+    // The old journal is still in place.
+    LOG(ERROR) << "Failed to rewrite the blob journal";
+    file_operations->DeleteFile(temp_path);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace disk_cache
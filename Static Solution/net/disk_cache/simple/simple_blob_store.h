@@ -0,0 +1,232 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_SIMPLE_BLOB_STORE_H_
+#define NET_DISK_CACHE_SIMPLE_SIMPLE_BLOB_STORE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "base/feature_list.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/base/hash_value.h"
+#include "net/base/net_export.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace disk_cache {
+
+class BackendFileOperations;
+
+// When enabled, a stream 1 of at least MinBlobBytes that is byte-identical to
+// that of another entry is stored once, in a blob shared by both entries.
+NET_EXPORT_PRIVATE extern const base::Feature kSimpleCacheDeduplication;
+NET_EXPORT_PRIVATE extern const char kSimpleCacheDeduplicationMinBytesParam[];
+
+// Returns the smallest stream 1 that kSimpleCacheDeduplication considers.
+NET_EXPORT_PRIVATE int GetSimpleCacheDeduplicationMinBytes();
+
+// Content-addressed storage for the stream 1 data of simple cache entries.
+// Each blob is a file in the "blobs" subdirectory of the cache, named after the
+// SHA-256 of its contents and an ID unique to that copy of the blob, and is
+// shared by all the entries whose stream 1 has those contents. The store knows
+// which blob each entry references and deletes a blob once no entry does.
+//
+// A body is only moved to a blob the second time it is seen, so that content
+// which is never duplicated costs no extra I/O. The entry that has the first
+// copy is then moved to the blob as well, the next time it is closed; see
+// TakePendingMove().
+//
+// Every change to the references is appended to a journal as it happens, so
+// that they survive an unclean exit. Initialize() replays the journal and
+// writes it out again compacted, which is also done whenever it grows well
+// past the number of live references. A torn last record is ignored; at worst
+// that leaks a blob until its entry is removed, or makes one entry fail to
+// open like any other corrupt entry.
+//
+// This class is thread-safe. Methods that take a BackendFileOperations do file
+// I/O and must be called on a sequence that allows blocking. Only the
+// in-memory state is kept under |lock_|; journal records are queued there and
+// written out afterwards, under |journal_lock_|, and blobs are moved and
+// deleted with neither held.
+class NET_EXPORT_PRIVATE SimpleBlobStore
+    : public base::RefCountedThreadSafe<SimpleBlobStore> {
+ public:
+  enum class Disposition {
+    // The contents have not been seen before; keep them in the entry.
+    kKeepInline,
+    // A blob with the contents exists, and the entry now references it.
+    kReferenced,
+    // The contents have been seen before but have no blob yet. The caller
+    // should write them to GetTempFilePath() and call CommitBlob().
+    kCreateBlob,
+  };
+
+  // A change to the blob an entry references.
+  struct ReferenceChange {
+    uint64_t entry_hash;
+    // The ID of the copy of the blob the entry now references, unique for the
+    // life of the store, and its size. Unset if the entry references nothing.
+    absl::optional<uint64_t> blob_id;
+    int64_t blob_size = 0;
+  };
+
+  explicit SimpleBlobStore(const base::FilePath& cache_path);
+
+  SimpleBlobStore(const SimpleBlobStore&) = delete;
+  SimpleBlobStore& operator=(const SimpleBlobStore&) = delete;
+
+  // Loads the references from the journal, drops those held by entries that
+  // no longer exist, and deletes any blob that is not referenced. Must be
+  // called before anything else.
+  void Initialize(BackendFileOperations* file_operations);
+
+  // Called when stream 1 of the entry |entry_hash| is complete and its
+  // contents hash to |hash|. Drops whatever blob the entry referenced before.
+  Disposition AddReference(BackendFileOperations* file_operations,
+                           uint64_t entry_hash,
+                           const net::SHA256HashValue& hash);
+
+  // Where the caller should write a blob after kCreateBlob.
+  base::FilePath GetTempFilePath(uint64_t entry_hash) const;
+
+  // Moves the blob of |size| bytes written to GetTempFilePath(|entry_hash|)
+  // into place as the one for |hash|, and makes |entry_hash| reference it.
+  // If another entry got there first, the temporary file is deleted and the
+  // existing blob is used instead. Returns false on failure.
+  //
+  // If the blob is new, |*out_first_copy_entry_hash| is set to the entry that
+  // kept the first copy of the contents inline, if any. That entry should be
+  // closed, after opening it if need be, so that it moves to the blob too.
+  bool CommitBlob(BackendFileOperations* file_operations,
+                  uint64_t entry_hash,
+                  const net::SHA256HashValue& hash,
+                  int64_t size,
+                  absl::optional<uint64_t>* out_first_copy_entry_hash);
+
+  // Returns the hash of the blob that |entry_hash| should move its stream 1 to,
+  // if it kept the first copy of some blob's contents inline, and forgets
+  // about it. The caller should check that the stream still has those
+  // contents, and then call AddReference().
+  absl::optional<net::SHA256HashValue> TakePendingMove(uint64_t entry_hash);
+
+  // Opens the blob |entry_hash| references for reading, which must be the one
+  // for |hash|. Returns an invalid file if it does not.
+  base::File OpenBlob(BackendFileOperations* file_operations,
+                      uint64_t entry_hash,
+                      const net::SHA256HashValue& hash);
+
+  // Drops the reference held by |entry_hash|, if any, and deletes the blob if
+  // that was the last one.
+  void ReleaseReference(BackendFileOperations* file_operations,
+                        uint64_t entry_hash);
+
+  // The total size of all the blobs, in bytes.
+  int64_t GetTotalSize() const;
+
+  // The number of entries that reference a blob.
+  size_t GetReferenceCount() const;
+
+  // Returns the changes to the references since the last call, oldest first.
+  // Initialize() reports all the references it loads as changes.
+  std::vector<ReferenceChange> TakeReferenceChanges();
+
+ private:
+  friend class base::RefCountedThreadSafe<SimpleBlobStore>;
+
+  struct Blob {
+    int64_t size;
+    int references;
+    // Tells this copy of the blob's file apart from any other that had the
+    // same contents, so that it can be deleted without holding the lock.
+    uint64_t id;
+  };
+
+  // A change to the references that is still to be written to the journal.
+  struct PendingJournalRecord {
+    uint64_t entry_hash;
+    // Unset if the entry no longer references anything.
+    absl::optional<net::SHA256HashValue> hash;
+  };
+
+  ~SimpleBlobStore();
+
+  base::FilePath GetBlobPath(const net::SHA256HashValue& hash,
+                             uint64_t id) const;
+  base::FilePath GetJournalPath() const;
+
+  // These add the paths of the blobs that are no longer referenced to
+  // |*unreferenced_blob_paths|, for WriteChanges() to delete.
+  Disposition AddReferenceLocked(
+      uint64_t entry_hash,
+      const net::SHA256HashValue& hash,
+      std::vector<base::FilePath>* unreferenced_blob_paths)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void ReleaseReferenceLocked(
+      uint64_t entry_hash,
+      std::vector<base::FilePath>* unreferenced_blob_paths)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Queues a journal record and a ReferenceChange saying that |entry_hash| now
+  // references |hash|, or with an unset |hash| that it no longer references
+  // anything. Also queues a rewrite of the journal if it is due for
+  // compaction.
+  void QueueChangeLocked(
+      uint64_t entry_hash,
+      const absl::optional<net::SHA256HashValue>& hash)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Writes out the queued journal records, and then deletes the blobs at
+  // |unreferenced_blob_paths|. Must be called without |lock_| held after
+  // every change to the references.
+  void WriteChanges(BackendFileOperations* file_operations,
+                    const std::vector<base::FilePath>& unreferenced_blob_paths);
+  void WriteJournal(BackendFileOperations* file_operations);
+
+  // Replaces the journal with one that only adds |references|. Returns false
+  // if the old journal was left in place. Must be called with |journal_lock_|
+  // held.
+  bool RewriteJournal(
+      BackendFileOperations* file_operations,
+      const std::unordered_map<uint64_t, net::SHA256HashValue>& references);
+
+  const base::FilePath cache_path_;
+  const base::FilePath blob_directory_;
+
+  // Serializes writes to the journal. Acquired before |lock_|, never after.
+  base::Lock journal_lock_;
+
+  mutable base::Lock lock_;
+  std::map<net::SHA256HashValue, Blob> blobs_ GUARDED_BY(lock_);
+  uint64_t next_blob_id_ GUARDED_BY(lock_) = 0;
+  std::unordered_map<uint64_t, net::SHA256HashValue> references_
+      GUARDED_BY(lock_);
+  // Contents seen once, that a second sighting will turn into a blob, and the
+  // entry they were seen in. This is bounded, so a duplicate that shows up
+  // much later can be missed.
+  std::map<net::SHA256HashValue, uint64_t> seen_once_ GUARDED_BY(lock_);
+  // Entries that kept the first copy of a blob inline, and the blob.
+  std::unordered_map<uint64_t, net::SHA256HashValue> pending_moves_
+      GUARDED_BY(lock_);
+  int64_t total_size_ GUARDED_BY(lock_) = 0;
+  // Number of records in the journal once the queued changes are written.
+  size_t journal_records_ GUARDED_BY(lock_) = 0;
+  std::vector<PendingJournalRecord> pending_journal_records_ GUARDED_BY(lock_);
+  // The references to rewrite the journal with, if it is due for compaction,
+  // and how many of |pending_journal_records_| they already include.
+  absl::optional<std::unordered_map<uint64_t, net::SHA256HashValue>>
+      pending_journal_rewrite_ GUARDED_BY(lock_);
+  size_t pending_journal_records_in_rewrite_ GUARDED_BY(lock_) = 0;
+  std::vector<ReferenceChange> reference_changes_ GUARDED_BY(lock_);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_SIMPLE_BLOB_STORE_H_
@@ -0,0 +1,158 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_blob_store.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/base/hash_value.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/simple/simple_file_tracker.h"
+#include "net/disk_cache/simple/simple_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace disk_cache {
+
+namespace {
+
+// Forwards to TrivialFileOperations, but can fail to replace the journal.
+class FailingJournalFileOperations : public BackendFileOperations {
+ public:
+  FailingJournalFileOperations() = default;
+  ~FailingJournalFileOperations() override = default;
+
+  void set_fail_journal_replace(bool fail) { fail_journal_replace_ = fail; }
+
+  // BackendFileOperations implementation:
+  bool CreateDirectory(const base::FilePath& path) override {
+    return file_operations_.CreateDirectory(path);
+  }
+  bool PathExists(const base::FilePath& path) override {
+    return file_operations_.PathExists(path);
+  }
+  bool DirectoryExists(const base::FilePath& path) override {
+    return file_operations_.DirectoryExists(path);
+  }
+  base::File OpenFile(const base::FilePath& path, uint32_t flags) override {
+    return file_operations_.OpenFile(path, flags);
+  }
+  bool DeleteFile(const base::FilePath& path, DeleteFileMode mode) override {
+    return file_operations_.DeleteFile(path, mode);
+  }
+  bool ReplaceFile(const base::FilePath& from_path,
+                   const base::FilePath& to_path,
+                   base::File::Error* error) override {
+    if (fail_journal_replace_ && to_path.BaseName().value() ==
+                                     FILE_PATH_LITERAL("journal")) {
+      *error = base::File::FILE_ERROR_ACCESS_DENIED;
+      return false;
+    }
+    return file_operations_.ReplaceFile(from_path, to_path, error);
+  }
+  absl::optional<base::File::Info> GetFileInfo(
+      const base::FilePath& path) override {
+    return file_operations_.GetFileInfo(path);
+  }
+  std::unique_ptr<FileEnumerator> EnumerateFiles(
+      const base::FilePath& path) override {
+    return file_operations_.EnumerateFiles(path);
+  }
+  void CleanupDirectory(const base::FilePath& path,
+                        base::OnceCallback<void(bool)> callback) override {
+    file_operations_.CleanupDirectory(path, std::move(callback));
+  }
+  std::unique_ptr<UnboundBackendFileOperations> Unbind() override {
+    return file_operations_.Unbind();
+  }
+
+ private:
+  TrivialFileOperations file_operations_;
+  bool fail_journal_replace_ = false;
+};
+
+net::SHA256HashValue MakeHash(uint8_t value) {
+  net::SHA256HashValue hash;
+  memset(hash.data, value, sizeof(hash.data));
+  return hash;
+}
+
+class SimpleBlobStoreTest : public DiskCacheTest {
+ protected:
+  scoped_refptr<SimpleBlobStore> CreateStore() {
+    auto store = base::MakeRefCounted<SimpleBlobStore>(cache_path_);
+    store->Initialize(&file_operations_);
+    return store;
+  }
+
+  // Creates the first file of the entry |entry_hash|, so that its references
+  // are kept when a store is initialized.
+  void CreateEntryFile(uint64_t entry_hash) {
+    ASSERT_TRUE(base::WriteFile(
+        cache_path_.AppendASCII(
+            simple_util::GetFilenameFromEntryFileKeyAndFileIndex(
+                SimpleFileTracker::EntryFileKey(entry_hash), 0)),
+        ""));
+  }
+
+  // Creates the blob for |hash| through |first_entry_hash| seeing its
+  // contents first, and |entry_hash| committing them.
+  void CreateBlob(SimpleBlobStore* store,
+                  uint64_t first_entry_hash,
+                  uint64_t entry_hash,
+                  const net::SHA256HashValue& hash) {
+    const std::string kContents = "contents";
+    EXPECT_EQ(SimpleBlobStore::Disposition::kKeepInline,
+              store->AddReference(&file_operations_, first_entry_hash, hash));
+    EXPECT_EQ(SimpleBlobStore::Disposition::kCreateBlob,
+              store->AddReference(&file_operations_, entry_hash, hash));
+    ASSERT_TRUE(base::WriteFile(store->GetTempFilePath(entry_hash), kContents));
+    absl::optional<uint64_t> first_copy_entry_hash;
+    ASSERT_TRUE(store->CommitBlob(&file_operations_, entry_hash, hash,
+                                  kContents.size(), &first_copy_entry_hash));
+    EXPECT_EQ(first_entry_hash, first_copy_entry_hash);
+  }
+
+  FailingJournalFileOperations file_operations_;
+};
+
+// A change that triggers compaction of the journal is still recorded when the
+// journal can't be rewritten.
+TEST_F(SimpleBlobStoreTest, JournalRewriteFailure) {
+  const net::SHA256HashValue kHash = MakeHash(1);
+  CreateEntryFile(2);
+  CreateEntryFile(3);
+
+  scoped_refptr<SimpleBlobStore> store = CreateStore();
+  CreateBlob(store.get(), 1, 2, kHash);
+
+  // Enough changes that the journal needs compacting several times over.
+  file_operations_.set_fail_journal_replace(true);
+  for (int i = 0; i < 1500; ++i) {
+    EXPECT_EQ(SimpleBlobStore::Disposition::kReferenced,
+              store->AddReference(&file_operations_, 3, kHash));
+    store->ReleaseReference(&file_operations_, 3);
+  }
+  EXPECT_EQ(SimpleBlobStore::Disposition::kReferenced,
+            store->AddReference(&file_operations_, 3, kHash));
+  store.reset();
+
+  file_operations_.set_fail_journal_replace(false);
+  store = CreateStore();
+  EXPECT_EQ(2u, store->GetReferenceCount());
+  EXPECT_TRUE(store->OpenBlob(&file_operations_, 3, kHash).IsValid());
+}
+
+}  // namespace
+
+}  // namespace disk_cache
@@ -61,6 +61,10 @@ struct NET_EXPORT_PRIVATE SimpleFileEOF {
   enum Flags {
     FLAG_HAS_CRC32 = (1U << 0),
     FLAG_HAS_KEY_SHA256 = (1U << 1),  // Preceding the record if present.
+    // Stream 1 only. The stream's data lives in a SimpleBlobStore blob; what
+    // precedes the record is the blob's SHA-256, and |stream_size| and
+    // |data_crc32| describe the blob's contents.
+    FLAG_STREAM_IN_BLOB = (1U << 2),
   };
 
   SimpleFileEOF();
@@ -68,7 +72,8 @@ struct NET_EXPORT_PRIVATE SimpleFileEOF {
   uint64_t final_magic_number;
   uint32_t flags;
   uint32_t data_crc32;
-  // |stream_size| is only used in the EOF record for stream 0.
+  // |stream_size| is only used in the EOF record for stream 0, and for
+  // stream 1 with FLAG_STREAM_IN_BLOB.
   uint32_t stream_size;
 };
 
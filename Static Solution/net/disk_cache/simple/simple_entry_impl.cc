@@ -29,6 +29,7 @@
 #include "net/disk_cache/backend_cleanup_tracker.h"
 #include "net/disk_cache/net_log_parameters.h"
 #include "net/disk_cache/simple/simple_backend_impl.h"
+#include "net/disk_cache/simple/simple_blob_store.h"
 #include "net/disk_cache/simple/simple_histogram_enums.h"
 #include "net/disk_cache/simple/simple_histogram_macros.h"
 #include "net/disk_cache/simple/simple_index.h"
@@ -48,11 +49,11 @@ const int64_t kMaxSparseDataSizeDivisor = 10;
 
 OpenEntryIndexEnum ComputeIndexState(SimpleBackendImpl* backend,
                                      uint64_t entry_hash) {
+  if (!backend->index()->Has(entry_hash))
+    return INDEX_MISS;
   if (!backend->index()->initialized())
     return INDEX_NOEXIST;
-  if (backend->index()->Has(entry_hash))
-    return INDEX_HIT;
-  return INDEX_MISS;
+  return INDEX_HIT;
 }
 
 void RecordOpenEntryIndexState(net::CacheType cache_type,
@@ -137,6 +138,7 @@ SimpleEntryImpl::SimpleEntryImpl(
     : cleanup_tracker_(std::move(cleanup_tracker)),
       backend_(backend->AsWeakPtr()),
       file_tracker_(file_tracker),
+      blob_store_(backend->blob_store()),
       file_operations_factory_(std::move(file_operations_factory)),
       cache_type_(cache_type),
       path_(path),
@@ -654,6 +656,7 @@ void SimpleEntryImpl::ResetEntry() {
   std::memset(crc32s_, 0, sizeof(crc32s_));
   std::memset(have_written_, 0, sizeof(have_written_));
   std::memset(data_size_, 0, sizeof(data_size_));
+  stream_1_in_blob_ = false;
 }
 
 void SimpleEntryImpl::ReturnEntryToCaller() {
@@ -805,7 +808,7 @@ void SimpleEntryImpl::OpenEntryInternal(
 
   base::OnceClosure task = base::BindOnce(
       &SimpleSynchronousEntry::OpenEntry, cache_type_, path_, key_, entry_hash_,
-      file_tracker_, file_operations_factory_->CreateUnbound(),
+      file_tracker_, blob_store_, file_operations_factory_->CreateUnbound(),
       trailer_prefetch_size, results.get());
 
   base::OnceClosure reply = base::BindOnce(
@@ -852,7 +855,7 @@ void SimpleEntryImpl::CreateEntryInternal(
 
   OnceClosure task =
       base::BindOnce(&SimpleSynchronousEntry::CreateEntry, cache_type_, path_,
-                     key_, entry_hash_, file_tracker_,
+                     key_, entry_hash_, file_tracker_, blob_store_,
                      file_operations_factory_->CreateUnbound(), results.get());
   OnceClosure reply = base::BindOnce(
       &SimpleEntryImpl::CreationOperationComplete, this, result_state,
@@ -915,7 +918,8 @@ void SimpleEntryImpl::OpenOrCreateEntryInternal(
   base::OnceClosure task =
       base::BindOnce(&SimpleSynchronousEntry::OpenOrCreateEntry, cache_type_,
                      path_, key_, entry_hash_, index_state, optimistic_create,
-                     file_tracker_, file_operations_factory_->CreateUnbound(),
+                     file_tracker_, blob_store_,
+                     file_operations_factory_->CreateUnbound(),
                      trailer_prefetch_size, results.get());
 
   base::OnceClosure reply = base::BindOnce(
@@ -1120,9 +1124,12 @@ void SimpleEntryImpl::WriteDataInternal(int stream_index,
   if (doom_state_ == DOOM_NONE && backend_.get())
     backend_->index()->UseIfExists(entry_hash_);
 
-  // Any stream 1 write invalidates the prefetched data.
-  if (stream_index == 1)
+  // Any stream 1 write invalidates the prefetched data, and brings the stream
+  // back into the entry's files if it was in a blob.
+  if (stream_index == 1) {
     stream_1_prefetch_data_ = nullptr;
+    stream_1_in_blob_ = false;
+  }
 
   bool request_update_crc = false;
   uint32_t initial_crc = 0;
@@ -1334,7 +1341,8 @@ void SimpleEntryImpl::DoomEntryInternal(net::CompletionOnceCallback callback) {
     prioritized_task_runner_->PostTaskAndReplyWithResult(
         FROM_HERE,
         base::BindOnce(&SimpleSynchronousEntry::TruncateEntryFiles, path_,
-                       entry_hash_, file_operations_factory_->CreateUnbound()),
+                       entry_hash_, blob_store_,
+                       file_operations_factory_->CreateUnbound()),
         base::BindOnce(&SimpleEntryImpl::DoomOperationComplete, this,
                        std::move(callback),
                        // Return to STATE_FAILURE after dooming, since no
@@ -1363,7 +1371,7 @@ void SimpleEntryImpl::DoomEntryInternal(net::CompletionOnceCallback callback) {
     prioritized_task_runner_->PostTaskAndReplyWithResult(
         FROM_HERE,
         base::BindOnce(&SimpleSynchronousEntry::DeleteEntryFiles, path_,
-                       cache_type_, entry_hash_,
+                       cache_type_, entry_hash_, blob_store_,
                        file_operations_factory_->CreateUnbound()),
         base::BindOnce(&SimpleEntryImpl::DoomOperationComplete, this,
                        std::move(callback), state_),
@@ -1417,6 +1425,7 @@ void SimpleEntryImpl::CreationOperationComplete(
 
   state_ = STATE_READY;
   synchronous_entry_ = in_results->sync_entry;
+  stream_1_in_blob_ = in_results->stream_1_in_blob;
 
   // Copy over any pre-fetched data and its CRCs.
   for (int stream = 0; stream < 2; ++stream) {
@@ -1609,6 +1618,9 @@ void SimpleEntryImpl::DoomOperationComplete(
     int result) {
   state_ = state_to_restore;
   doom_state_ = DOOM_COMPLETED;
+  // Dooming drops the entry's reference to its blob, if it had one.
+  if (blob_store_ && backend_)
+    backend_->OnBlobStorageChanged();
   net_log_.AddEvent(net::NetLogEventType::SIMPLE_CACHE_ENTRY_DOOM_END);
   PostClientCallback(std::move(callback), result);
   RunNextOperationIfNeeded();
@@ -1631,6 +1643,23 @@ void SimpleEntryImpl::CloseOperationComplete(
     backend_->index()->SetTrailerPrefetchSize(
         entry_hash_, in_results->estimated_trailer_prefetch_size);
   }
+  // Stream 1 may have moved to or from a blob, either because it was written
+  // or because another entry turned out to have the same contents. That
+  // changes both the entry's size on disk and the blob storage eviction
+  // accounts for.
+  SimpleBackendImpl* backend_ptr = backend_.get();
+  if (blob_store_ && backend_ptr &&
+      (have_written_[1] ||
+       in_results->stream_1_in_blob != stream_1_in_blob_)) {
+    stream_1_in_blob_ = in_results->stream_1_in_blob;
+    if (doom_state_ == DOOM_NONE) {
+      backend_ptr->index()->UpdateEntrySize(
+          entry_hash_, base::checked_cast<uint32_t>(GetDiskUsage()));
+    }
+    backend_ptr->OnBlobStorageChanged();
+    if (in_results->first_copy_entry_hash)
+      backend_ptr->MoveFirstCopyToBlob(*in_results->first_copy_entry_hash);
+  }
   ResetEntry();
   RunNextOperationIfNeeded();
 }
@@ -1658,8 +1687,13 @@ void SimpleEntryImpl::UpdateDataFromEntryStat(
 int64_t SimpleEntryImpl::GetDiskUsage() const {
   int64_t file_size = 0;
   for (int i = 0; i < kSimpleEntryStreamCount; ++i) {
+    // A stream 1 in a blob only takes the space of the blob's hash here; the
+    // blob itself is accounted for once by the backend.
+    const int32_t size_in_file = i == 1 && stream_1_in_blob_
+                                     ? sizeof(net::SHA256HashValue)
+                                     : data_size_[i];
     file_size +=
-        simple_util::GetFileSizeFromDataSize(key_.size(), data_size_[i]);
+        simple_util::GetFileSizeFromDataSize(key_.size(), size_in_file);
   }
   file_size += sparse_data_size_;
   return file_size;
@@ -42,6 +42,7 @@ namespace disk_cache {
 
 class BackendCleanupTracker;
 class SimpleBackendImpl;
+class SimpleBlobStore;
 class SimpleEntryStat;
 class SimpleFileTracker;
 class SimpleSynchronousEntry;
@@ -368,6 +369,7 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
 
   const base::WeakPtr<SimpleBackendImpl> backend_;
   const raw_ptr<SimpleFileTracker> file_tracker_;
+  const scoped_refptr<SimpleBlobStore> blob_store_;
   const scoped_refptr<BackendFileOperationsFactory> file_operations_factory_;
   const net::CacheType cache_type_;
   const base::FilePath path_;
@@ -383,6 +385,10 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
   int32_t data_size_[kSimpleEntryStreamCount];
   int32_t sparse_data_size_ = 0;
 
+  // True if stream 1 lives in a blob of |blob_store_| as of the last open or
+  // close, in which case the entry's own files only hold a reference to it.
+  bool stream_1_in_blob_ = false;
+
   // Number of times this object has been returned from Backend::OpenEntry() and
   // Backend::CreateEntry() without subsequent Entry::Close() calls. Used to
   // notify the backend when this entry not used by any callers.
@@ -0,0 +1,248 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_eviction_policy.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include "base/check.h"
+#include "base/numerics/clamped_math.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace disk_cache {
+
+const base::Feature kSimpleCacheFrequencyEviction = {
+    "SimpleCacheFrequencyEviction", base::FEATURE_DISABLED_BY_DEFAULT};
+
+namespace {
+
+// This is added to the size of each entry before using the size
+// to determine which entries to evict first. It's basically an
+// estimate of the filesystem overhead, but it also serves to flatten
+// the curve so that 1-byte entries and 2-byte entries are basically
+// treated the same.
+const int kEstimatedEntryOverhead = 512;
+
+// Slack added to the first batch of eviction candidates, on top of the number
+// of average-sized entries needed to get down to the low watermark. Entries
+// picked for eviction tend to be larger than average when the size heuristic
+// is on, so this rarely has to take a second batch.
+const size_t kMinEvictionBatchSize = 64;
+
+// SimpleFrequencyEvictionPolicy treats this fraction of the entries, by
+// count, as candidates for admission: the most recently used ones.
+const size_t kRecentWindowDivisor = 100;
+
+// The frequency sketch is sized for the number of entries a cache of a given
+// size holds if they average this size, within the limits below.
+const uint64_t kSketchBytesPerEntry = 16 * 1024;
+const size_t kMinSketchCapacity = 1024;
+const size_t kMaxSketchCapacity = 128 * 1024;
+
+using Candidate = SimpleIndex::EntrySet::value_type;
+
+// Lower ranks are evicted first. |size| is the charged size of the entry.
+uint64_t RecencyRank(const EntryMetadata& metadata,
+                     uint64_t size,
+                     uint32_t now,
+                     bool use_size_heuristic) {
+  uint64_t sort_value = now - metadata.RawTimeForSorting();
+  // See crbug.com/736437 for context.
+  //
+  // Saturates rather than overflowing, since a charge for shared storage can
+  // make the size larger than 32 bits.
+  if (use_size_heuristic)
+    sort_value = base::ClampMul(sort_value,
+                                base::ClampAdd(size, kEstimatedEntryOverhead));
+  // Subtract so we don't need a custom comparator.
+  return std::numeric_limits<uint64_t>::max() - sort_value;
+}
+
+// Appends the lowest ranked of |candidates| to |entry_hashes|, in order,
+// until they add up to |amount_to_evict| bytes.
+//
+// Only the entries that end up evicted need to be in order, and that is
+// usually a small fraction of the index. So rather than sorting everything,
+// partition off a batch of the lowest ranks, sort just that batch, and take
+// from it; if that wasn't enough, do the same on what is left with a larger
+// batch. The result is the same as sorting the whole vector, at a cost of
+// roughly O(n + k log k) for k evicted entries.
+template <typename Rank>
+void SelectLowestRanked(
+    const SimpleEvictionPolicy& policy,
+    std::vector<std::pair<Rank, const Candidate*>>* candidates,
+    uint64_t total_size,
+    uint64_t amount_to_evict,
+    std::vector<uint64_t>* entry_hashes) {
+  uint64_t evicted_so_far_size = 0;
+  const uint64_t average_entry_size = std::max<uint64_t>(
+      total_size / std::max<size_t>(candidates->size(), 1), 1);
+  size_t batch_size = base::saturated_cast<size_t>(
+      amount_to_evict / average_entry_size + kMinEvictionBatchSize);
+  auto batch_begin = candidates->begin();
+  while (batch_begin != candidates->end() &&
+         evicted_so_far_size < amount_to_evict) {
+    auto batch_end = candidates->end();
+    if (static_cast<size_t>(candidates->end() - batch_begin) > batch_size) {
+      batch_end = batch_begin + batch_size;
+      std::nth_element(batch_begin, batch_end, candidates->end());
+    }
+    std::sort(batch_begin, batch_end);
+    for (; batch_begin != batch_end; ++batch_begin) {
+      if (evicted_so_far_size >= amount_to_evict)
+        break;
+      evicted_so_far_size += policy.GetChargedSize(*batch_begin->second);
+      entry_hashes->push_back(batch_begin->second->first);
+    }
+    batch_size *= 2;
+  }
+}
+
+uint32_t SecondsSinceEpoch(base::Time time) {
+  return (time - base::Time::UnixEpoch()).InSeconds();
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<SimpleEvictionPolicy> SimpleEvictionPolicy::Create(
+    net::CacheType cache_type) {
+  const bool use_size_heuristic =
+      (cache_type != net::GENERATED_BYTE_CODE_CACHE &&
+       cache_type != net::GENERATED_WEBUI_BYTE_CODE_CACHE);
+  // APP_CACHE does not track use, so there is nothing to count.
+  if (cache_type != net::APP_CACHE &&
+      base::FeatureList::IsEnabled(kSimpleCacheFrequencyEviction)) {
+    return std::make_unique<SimpleFrequencyEvictionPolicy>(use_size_heuristic);
+  }
+  return std::make_unique<SimpleRecencyEvictionPolicy>(use_size_heuristic);
+}
+
+void SimpleEvictionPolicy::SetSharedStorage(
+    uint64_t entry_hash,
+    absl::optional<uint64_t> storage_id,
+    uint64_t storage_size) {
+  auto entry_it = entry_shared_storage_.find(entry_hash);
+  if (entry_it != entry_shared_storage_.end()) {
+    if (storage_id == entry_it->second)
+      return;
+    auto storage_it = shared_storage_.find(entry_it->second);
+    DCHECK(storage_it != shared_storage_.end());
+    if (--storage_it->second.users == 0) {
+      shared_storage_size_ -= storage_it->second.size;
+      shared_storage_.erase(storage_it);
+    }
+    entry_shared_storage_.erase(entry_it);
+  }
+  if (!storage_id)
+    return;
+  entry_shared_storage_[entry_hash] = *storage_id;
+  auto result =
+      shared_storage_.emplace(*storage_id, SharedStorage{storage_size, 0});
+  if (result.second)
+    shared_storage_size_ += storage_size;
+  ++result.first->second.users;
+}
+
+uint64_t SimpleEvictionPolicy::GetChargedSize(
+    const SimpleIndex::EntrySet::value_type& entry) const {
+  uint64_t size = entry.second.GetEntrySize();
+  if (!entry_shared_storage_.empty()) {
+    auto entry_it = entry_shared_storage_.find(entry.first);
+    if (entry_it != entry_shared_storage_.end()) {
+      const SharedStorage& storage = shared_storage_.at(entry_it->second);
+      size += (storage.size + storage.users - 1) / storage.users;
+    }
+  }
+  return size;
+}
+
+SimpleRecencyEvictionPolicy::SimpleRecencyEvictionPolicy(
+    bool use_size_heuristic)
+    : use_size_heuristic_(use_size_heuristic) {}
+
+SimpleRecencyEvictionPolicy::~SimpleRecencyEvictionPolicy() = default;
+
+void SimpleRecencyEvictionPolicy::SelectEntriesToEvict(
+    const SimpleIndex::EntrySet& entries,
+    base::Time now,
+    uint64_t amount_to_evict,
+    std::vector<uint64_t>* entry_hashes) {
+  const uint32_t now_seconds = SecondsSinceEpoch(now);
+  uint64_t total_size = 0;
+  std::vector<std::pair<uint64_t, const Candidate*>> candidates;
+  candidates.reserve(entries.size());
+  for (const Candidate& entry : entries) {
+    const uint64_t size = GetChargedSize(entry);
+    total_size += size;
+    candidates.emplace_back(
+        RecencyRank(entry.second, size, now_seconds, use_size_heuristic_),
+        &entry);
+  }
+  SelectLowestRanked(*this, &candidates, total_size, amount_to_evict,
+                     entry_hashes);
+}
+
+SimpleFrequencyEvictionPolicy::SimpleFrequencyEvictionPolicy(
+    bool use_size_heuristic)
+    : use_size_heuristic_(use_size_heuristic), sketch_(kMinSketchCapacity) {}
+
+SimpleFrequencyEvictionPolicy::~SimpleFrequencyEvictionPolicy() = default;
+
+void SimpleFrequencyEvictionPolicy::SetMaxSize(uint64_t max_bytes) {
+  sketch_.SetCapacity(base::saturated_cast<size_t>(
+      std::clamp<uint64_t>(max_bytes / kSketchBytesPerEntry,
+                           kMinSketchCapacity, kMaxSketchCapacity)));
+}
+
+void SimpleFrequencyEvictionPolicy::RecordAccess(uint64_t entry_hash) {
+  sketch_.Increment(entry_hash);
+}
+
+void SimpleFrequencyEvictionPolicy::SelectEntriesToEvict(
+    const SimpleIndex::EntrySet& entries,
+    base::Time now,
+    uint64_t amount_to_evict,
+    std::vector<uint64_t>* entry_hashes) {
+  // Find the last used time that separates the candidates for admission from
+  // the main cache.
+  uint32_t window_start = std::numeric_limits<uint32_t>::max();
+  const size_t window_size = entries.size() / kRecentWindowDivisor;
+  if (window_size > 0) {
+    std::vector<uint32_t> last_used;
+    last_used.reserve(entries.size());
+    for (const Candidate& entry : entries)
+      last_used.push_back(entry.second.RawTimeForSorting());
+    std::nth_element(last_used.begin(), last_used.begin() + window_size,
+                     last_used.end(), std::greater<uint32_t>());
+    window_start = last_used[window_size];
+  }
+
+  // Taking the lowest of (frequency, is candidate, recency) is the same as
+  // repeatedly comparing the least popular candidate with the least popular
+  // victim: the candidate goes first only if it is less popular.
+  const uint32_t now_seconds = SecondsSinceEpoch(now);
+  uint64_t total_size = 0;
+  std::vector<std::pair<std::tuple<int, bool, uint64_t>, const Candidate*>>
+      candidates;
+  candidates.reserve(entries.size());
+  for (const Candidate& entry : entries) {
+    const uint64_t size = GetChargedSize(entry);
+    total_size += size;
+    candidates.emplace_back(
+        std::make_tuple(sketch_.Frequency(entry.first),
+                        entry.second.RawTimeForSorting() > window_start,
+                        RecencyRank(entry.second, size, now_seconds,
+                                    use_size_heuristic_)),
+        &entry);
+  }
+  SelectLowestRanked(*this, &candidates, total_size, amount_to_evict,
+                     entry_hashes);
+}
+
+}  // namespace disk_cache
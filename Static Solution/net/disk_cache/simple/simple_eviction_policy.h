@@ -0,0 +1,135 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_SIMPLE_EVICTION_POLICY_H_
+#define NET_DISK_CACHE_SIMPLE_SIMPLE_EVICTION_POLICY_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "base/feature_list.h"
+#include "base/time/time.h"
+#include "net/base/cache_type.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/frequency_sketch.h"
+#include "net/disk_cache/simple/simple_index.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace disk_cache {
+
+// When enabled, SimpleIndex uses SimpleFrequencyEvictionPolicy instead of
+// SimpleRecencyEvictionPolicy.
+NET_EXPORT_PRIVATE extern const base::Feature kSimpleCacheFrequencyEviction;
+
+// Picks the entries SimpleIndex evicts once the cache grows past its high
+// watermark. SimpleIndex tells the policy about every lookup, and asks it for
+// victims; the policy never changes the index itself.
+class NET_EXPORT_PRIVATE SimpleEvictionPolicy {
+ public:
+  // Returns the policy SimpleIndex should use for |cache_type|.
+  static std::unique_ptr<SimpleEvictionPolicy> Create(
+      net::CacheType cache_type);
+
+  virtual ~SimpleEvictionPolicy() = default;
+
+  // Called when the maximum size of the cache is set.
+  virtual void SetMaxSize(uint64_t max_bytes) {}
+
+  // Called on each open or create of |entry_hash|, whether or not an entry
+  // for it exists.
+  virtual void RecordAccess(uint64_t entry_hash) {}
+
+  // Records that |entry_hash| uses the shared storage |storage_id|, of
+  // |storage_size| bytes, or with an unset |storage_id| that it uses none; see
+  // SimpleIndex::UpdateSharedStorage().
+  void SetSharedStorage(uint64_t entry_hash,
+                        absl::optional<uint64_t> storage_id,
+                        uint64_t storage_size);
+
+  // The total size of the shared storage that entries use.
+  uint64_t shared_storage_size() const { return shared_storage_size_; }
+
+  // Returns the bytes evicting |entry| frees: its own size plus its share of
+  // any shared storage it uses, which is the storage's size divided by the
+  // number of entries using it, rounded up.
+  uint64_t GetChargedSize(const SimpleIndex::EntrySet::value_type& entry) const;
+
+  // Appends to |entry_hashes| entries of |entries| to evict, best victims
+  // first, until they add up to at least |amount_to_evict| bytes or all of
+  // |entries| has been picked. |now| is the current time.
+  virtual void SelectEntriesToEvict(const SimpleIndex::EntrySet& entries,
+                                    base::Time now,
+                                    uint64_t amount_to_evict,
+                                    std::vector<uint64_t>* entry_hashes) = 0;
+
+ private:
+  struct SharedStorage {
+    uint64_t size;
+    uint64_t users;
+  };
+
+  // The shared storage each entry that uses any uses, by ID.
+  std::unordered_map<uint64_t, uint64_t> entry_shared_storage_;
+  std::unordered_map<uint64_t, SharedStorage> shared_storage_;
+  uint64_t shared_storage_size_ = 0;
+};
+
+// Evicts the entries that have gone unused the longest first, weighted by
+// their size unless |use_size_heuristic| is false (see crbug.com/736437).
+class NET_EXPORT_PRIVATE SimpleRecencyEvictionPolicy
+    : public SimpleEvictionPolicy {
+ public:
+  explicit SimpleRecencyEvictionPolicy(bool use_size_heuristic);
+  ~SimpleRecencyEvictionPolicy() override;
+
+  void SelectEntriesToEvict(const SimpleIndex::EntrySet& entries,
+                            base::Time now,
+                            uint64_t amount_to_evict,
+                            std::vector<uint64_t>* entry_hashes) override;
+
+ private:
+  const bool use_size_heuristic_;
+};
+
+// Frequency-ranked eviction with TinyLFU admission. Accesses are counted in a
+// FrequencySketch. The most recently used entries form a window of candidates
+// for admission; the rest are the main cache. Evicting compares the least
+// popular candidate with the least popular entry of the main cache, the
+// victim, and rejects the candidate if the victim is more popular, or evicts
+// the victim otherwise. That way a burst of one-time accesses, like a scan,
+// is evicted before it can push out popular entries. Ties go to the candidate,
+// and otherwise entries are evicted as SimpleRecencyEvictionPolicy would.
+//
+// Entries are written before they are judged, since SimpleIndex only evicts
+// once the cache has grown past its high watermark; a rejected candidate is
+// simply evicted first.
+//
+// The sketch is only kept in memory, so after a restart this behaves like
+// SimpleRecencyEvictionPolicy until it has seen enough traffic.
+class NET_EXPORT_PRIVATE SimpleFrequencyEvictionPolicy
+    : public SimpleEvictionPolicy {
+ public:
+  explicit SimpleFrequencyEvictionPolicy(bool use_size_heuristic);
+  ~SimpleFrequencyEvictionPolicy() override;
+
+  void SetMaxSize(uint64_t max_bytes) override;
+  void RecordAccess(uint64_t entry_hash) override;
+  void SelectEntriesToEvict(const SimpleIndex::EntrySet& entries,
+                            base::Time now,
+                            uint64_t amount_to_evict,
+                            std::vector<uint64_t>* entry_hashes) override;
+
+  const FrequencySketch& sketch() const { return sketch_; }
+
+ private:
+  const bool use_size_heuristic_;
+  FrequencySketch sketch_;
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_SIMPLE_EVICTION_POLICY_H_
@@ -0,0 +1,157 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple/simple_eviction_policy.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/time/time.h"
+#include "net/disk_cache/simple/simple_index.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace disk_cache {
+namespace {
+
+const base::Time kNow = base::Time::UnixEpoch() + base::Days(20);
+const uint32_t kEntrySize = 4096;
+
+TEST(SimpleEvictionPolicyTest, RecencyEvictsOldestFirst) {
+  SimpleRecencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+  for (uint64_t hash = 1; hash <= 4; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Minutes(hash), kEntrySize);
+  }
+
+  std::vector<uint64_t> victims;
+  policy.SelectEntriesToEvict(entries, kNow, 2 * kEntrySize, &victims);
+  EXPECT_THAT(victims, testing::ElementsAre(4u, 3u));
+}
+
+// An entry's charge for shared storage counts towards what evicting it frees.
+TEST(SimpleEvictionPolicyTest, CountsSharedStorageCharges) {
+  SimpleRecencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+  for (uint64_t hash = 1; hash <= 4; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Minutes(hash), kEntrySize);
+  }
+
+  std::vector<uint64_t> victims;
+  policy.SetSharedStorage(4u, /*storage_id=*/1u, 2 * kEntrySize);
+  policy.SelectEntriesToEvict(entries, kNow, 2 * kEntrySize, &victims);
+  EXPECT_THAT(victims, testing::ElementsAre(4u));
+}
+
+// Shared storage is charged in equal parts to the entries that use it, and
+// counted once towards the total.
+TEST(SimpleEvictionPolicyTest, SplitsSharedStorageCharges) {
+  SimpleRecencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+  for (uint64_t hash = 1; hash <= 4; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Minutes(hash), kEntrySize);
+  }
+
+  policy.SetSharedStorage(3u, /*storage_id=*/1u, 2 * kEntrySize);
+  policy.SetSharedStorage(4u, /*storage_id=*/1u, 2 * kEntrySize);
+  EXPECT_EQ(2 * kEntrySize, policy.shared_storage_size());
+  std::vector<uint64_t> victims;
+  policy.SelectEntriesToEvict(entries, kNow, 3 * kEntrySize, &victims);
+  EXPECT_THAT(victims, testing::ElementsAre(4u, 3u));
+
+  // Once 3 stops using it, 4 is charged for all of it again.
+  policy.SetSharedStorage(3u, absl::nullopt, 0);
+  EXPECT_EQ(2 * kEntrySize, policy.shared_storage_size());
+  victims.clear();
+  policy.SelectEntriesToEvict(entries, kNow, 3 * kEntrySize, &victims);
+  EXPECT_THAT(victims, testing::ElementsAre(4u));
+
+  policy.SetSharedStorage(4u, absl::nullopt, 0);
+  EXPECT_EQ(0u, policy.shared_storage_size());
+}
+
+// A scan of entries that are used once should be evicted ahead of older
+// entries that are used often.
+TEST(SimpleEvictionPolicyTest, FrequencyResistsScans) {
+  SimpleFrequencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+
+  const uint64_t kNumPopular = 100;
+  for (uint64_t hash = 1; hash <= kNumPopular; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Hours(1), kEntrySize);
+    for (int i = 0; i < 3; ++i)
+      policy.RecordAccess(hash);
+  }
+  const uint64_t kNumScanned = 200;
+  for (uint64_t hash = 1000; hash < 1000 + kNumScanned; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Minutes(1), kEntrySize);
+    policy.RecordAccess(hash);
+  }
+
+  std::vector<uint64_t> victims;
+  policy.SelectEntriesToEvict(entries, kNow, 100 * kEntrySize, &victims);
+  ASSERT_EQ(100u, victims.size());
+  for (uint64_t victim : victims)
+    EXPECT_GE(victim, 1000u);
+
+  // The recency policy would have evicted the popular entries instead.
+  SimpleRecencyEvictionPolicy recency_policy(/*use_size_heuristic=*/false);
+  victims.clear();
+  recency_policy.SelectEntriesToEvict(entries, kNow, 100 * kEntrySize,
+                                      &victims);
+  ASSERT_EQ(100u, victims.size());
+  for (uint64_t victim : victims)
+    EXPECT_LE(victim, kNumPopular);
+}
+
+// A recently used entry is admitted over older entries that are no more
+// popular than it.
+TEST(SimpleEvictionPolicyTest, FrequencyAdmitsRecentEntries) {
+  SimpleFrequencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+  for (uint64_t hash = 1; hash <= 200; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Hours(1), kEntrySize);
+    policy.RecordAccess(hash);
+    policy.RecordAccess(hash);
+  }
+  entries[1000] = EntryMetadata(kNow, kEntrySize);
+  policy.RecordAccess(1000);
+  policy.RecordAccess(1000);
+
+  std::vector<uint64_t> victims;
+  policy.SelectEntriesToEvict(entries, kNow, 200 * kEntrySize, &victims);
+  ASSERT_EQ(200u, victims.size());
+  EXPECT_THAT(victims, testing::Not(testing::Contains(1000u)));
+}
+
+// Entries seen once are not admitted at the expense of popular ones, even when
+// they are the most recently used.
+TEST(SimpleEvictionPolicyTest, FrequencyAdmissionRejectsOneHitScan) {
+  SimpleFrequencyEvictionPolicy policy(/*use_size_heuristic=*/false);
+  SimpleIndex::EntrySet entries;
+  const uint64_t kNumPopular = 1000;
+  for (uint64_t hash = 1; hash <= kNumPopular; ++hash) {
+    entries[hash] = EntryMetadata(kNow - base::Hours(1), kEntrySize);
+    for (int i = 0; i < 3; ++i)
+      policy.RecordAccess(hash);
+  }
+  // Few enough to all be candidates for admission.
+  const uint64_t kNumScanned = 5;
+  for (uint64_t hash = 2000; hash < 2000 + kNumScanned; ++hash) {
+    entries[hash] = EntryMetadata(kNow, kEntrySize);
+    policy.RecordAccess(hash);
+  }
+
+  std::vector<uint64_t> victims;
+  policy.SelectEntriesToEvict(entries, kNow, kNumScanned * kEntrySize,
+                              &victims);
+  ASSERT_EQ(kNumScanned, victims.size());
+  for (uint64_t victim : victims)
+    EXPECT_GE(victim, 2000u);
+}
+
+}  // namespace
+}  // namespace disk_cache
@@ -11,6 +11,7 @@
 
 #include "base/bind.h"
 #include "base/check_op.h"
+#include "base/feature_list.h"
 #include "base/files/file_util.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/pickle.h"
@@ -23,6 +24,7 @@
 #include "net/base/net_errors.h"
 #include "net/disk_cache/backend_cleanup_tracker.h"
 #include "net/disk_cache/simple/simple_entry_format.h"
+#include "net/disk_cache/simple/simple_eviction_policy.h"
 #include "net/disk_cache/simple/simple_histogram_macros.h"
 #include "net/disk_cache/simple/simple_index_delegate.h"
 #include "net/disk_cache/simple/simple_index_file.h"
@@ -47,12 +49,9 @@ const uint32_t kEvictionMarginDivisor = 20;
 
 const uint32_t kBytesInKb = 1024;
 
-// This is added to the size of each entry before using the size
-// to determine which entries to evict first. It's basically an
-// estimate of the filesystem overhead, but it also serves to flatten
-// the curve so that 1-byte entries and 2-byte entries are basically
-// treated the same.
-static const int kEstimatedEntryOverhead = 512;
+// SimpleIndex keeps track of at least this many changed entries for the index
+// log, however small the index is.
+static const size_t kMinChangedEntriesToTrack = 1024;
 
 }  // namespace
 
@@ -138,6 +137,22 @@ void EntryMetadata::Serialize(net::CacheType cache_type,
   pickle->WriteUInt64(packed_entry_info);
 }
 
+uint64_t EntryMetadata::ToFixedWidth() const {
+  uint32_t packed_entry_info = (entry_size_256b_chunks_ << 8) | in_memory_data_;
+  return (static_cast<uint64_t>(last_used_time_seconds_since_epoch_) << 32) |
+         packed_entry_info;
+}
+
+// static
+EntryMetadata EntryMetadata::FromFixedWidth(uint64_t value) {
+  EntryMetadata metadata;
+  metadata.last_used_time_seconds_since_epoch_ =
+      static_cast<uint32_t>(value >> 32);
+  metadata.entry_size_256b_chunks_ = (value >> 8) & 0xFFFFFF;
+  metadata.in_memory_data_ = value & 0xFF;
+  return metadata;
+}
+
 bool EntryMetadata::Deserialize(net::CacheType cache_type,
                                 base::PickleIterator* it,
                                 bool has_entry_in_memory_data,
@@ -181,8 +196,11 @@ SimpleIndex::SimpleIndex(
     : cleanup_tracker_(std::move(cleanup_tracker)),
       delegate_(delegate),
       cache_type_(cache_type),
+      eviction_policy_(SimpleEvictionPolicy::Create(cache_type)),
       index_file_(std::move(index_file)),
       task_runner_(task_runner),
+      track_changed_entries_(
+          base::FeatureList::IsEnabled(kSimpleCacheMappedIndex)),
       // Creating the callback once so it is reused every time
       // write_to_disk_timer_.Start() is called.
       write_to_disk_cb_(base::BindRepeating(&SimpleIndex::WriteToDisk,
@@ -198,6 +216,7 @@ SimpleIndex::~SimpleIndex() {
        it != end; ++it) {
     std::move(*it).Run(net::ERR_ABORTED);
   }
+  ReleaseMappedIndex();
 }
 
 void SimpleIndex::Initialize(base::Time cache_mtime) {
@@ -215,6 +234,8 @@ void SimpleIndex::Initialize(base::Time cache_mtime) {
   }
 #endif
 
+  index_file_->set_index_mapped_callback(
+      base::BindOnce(&SimpleIndex::OnIndexMapped, AsWeakPtr()));
   SimpleIndexLoadResult* load_result = new SimpleIndexLoadResult();
   std::unique_ptr<SimpleIndexLoadResult> load_result_scoped(load_result);
   base::OnceClosure reply =
@@ -229,6 +250,7 @@ void SimpleIndex::SetMaxSize(uint64_t max_bytes) {
     max_size_ = max_bytes;
     high_watermark_ = max_size_ - max_size_ / kEvictionMarginDivisor;
     low_watermark_ = max_size_ - 2 * (max_size_ / kEvictionMarginDivisor);
+    eviction_policy_->SetMaxSize(max_size_);
   }
 }
 
@@ -279,7 +301,7 @@ int32_t SimpleIndex::GetEntryCount() const {
 
 uint64_t SimpleIndex::GetCacheSize() const {
   DCHECK(initialized_);
-  return cache_size_;
+  return cache_size_ + eviction_policy_->shared_storage_size();
 }
 
 uint64_t SimpleIndex::GetCacheSizeBetween(base::Time initial_time,
@@ -339,8 +361,10 @@ void SimpleIndex::Insert(uint64_t entry_hash) {
   }
   if (!initialized_)
     removed_entries_.erase(entry_hash);
-  if (inserted)
+  if (inserted) {
+    MarkEntryChanged(entry_hash);
     PostponeWritingToDisk();
+  }
 }
 
 void SimpleIndex::Remove(uint64_t entry_hash) {
@@ -356,14 +380,21 @@ void SimpleIndex::Remove(uint64_t entry_hash) {
   if (!initialized_)
     removed_entries_.insert(entry_hash);
 
-  if (need_write)
+  if (need_write) {
+    MarkEntryChanged(entry_hash);
     PostponeWritingToDisk();
+  }
 }
 
 bool SimpleIndex::Has(uint64_t hash) const {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  // If not initialized, always return true, forcing it to go to the disk.
-  return !initialized_ || entries_set_.count(hash) > 0;
+  if (entries_set_.count(hash) > 0)
+    return true;
+  if (initialized_)
+    return false;
+  // If not initialized, and there is no fresh index on disk to say otherwise,
+  // always return true, forcing it to go to the disk.
+  return !mapped_index_ || mapped_index_->MayContain(hash);
 }
 
 uint8_t SimpleIndex::GetEntryInMemoryData(uint64_t entry_hash) const {
@@ -379,7 +410,8 @@ void SimpleIndex::SetEntryInMemoryData(uint64_t entry_hash, uint8_t value) {
   auto it = entries_set_.find(entry_hash);
   if (it == entries_set_.end())
     return;
-  return it->second.SetInMemoryData(value);
+  it->second.SetInMemoryData(value);
+  MarkEntryChanged(entry_hash);
 }
 
 bool SimpleIndex::UseIfExists(uint64_t entry_hash) {
@@ -394,50 +426,24 @@ bool SimpleIndex::UseIfExists(uint64_t entry_hash) {
   if (cache_type_ == net::APP_CACHE)
     return true;
   it->second.SetLastUsedTime(base::Time::Now());
+  MarkEntryChanged(entry_hash);
   PostponeWritingToDisk();
   return true;
 }
 
 void SimpleIndex::StartEvictionIfNeeded() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  if (eviction_in_progress_ || cache_size_ <= high_watermark_)
+  const uint64_t total_size =
+      cache_size_ + eviction_policy_->shared_storage_size();
+  if (eviction_in_progress_ || total_size <= high_watermark_)
     return;
-  // Take all live key hashes from the index and sort them by time.
   eviction_in_progress_ = true;
   eviction_start_time_ = base::TimeTicks::Now();
 
-  bool use_size_heuristic =
-      (cache_type_ != net::GENERATED_BYTE_CODE_CACHE &&
-       cache_type_ != net::GENERATED_WEBUI_BYTE_CODE_CACHE);
-
-  // Flatten for sorting.
-  std::vector<std::pair<uint64_t, const EntrySet::value_type*>> entries;
-  entries.reserve(entries_set_.size());
-  uint32_t now = (base::Time::Now() - base::Time::UnixEpoch()).InSeconds();
-  for (EntrySet::const_iterator i = entries_set_.begin();
-       i != entries_set_.end(); ++i) {
-    uint64_t sort_value = now - i->second.RawTimeForSorting();
-    // See crbug.com/736437 for context.
-    //
-    // Will not overflow since we're multiplying two 32-bit values and storing
-    // them in a 64-bit variable.
-    if (use_size_heuristic)
-      sort_value *= i->second.GetEntrySize() + kEstimatedEntryOverhead;
-    // Subtract so we don't need a custom comparator.
-    entries.emplace_back(std::numeric_limits<uint64_t>::max() - sort_value,
-                         &*i);
-  }
-
-  uint64_t evicted_so_far_size = 0;
-  const uint64_t amount_to_evict = cache_size_ - low_watermark_;
   std::vector<uint64_t> entry_hashes;
-  std::sort(entries.begin(), entries.end());
-  for (const auto& score_metadata_pair : entries) {
-    if (evicted_so_far_size >= amount_to_evict)
-      break;
-    evicted_so_far_size += score_metadata_pair.second->second.GetEntrySize();
-    entry_hashes.push_back(score_metadata_pair.second->first);
-  }
+  eviction_policy_->SelectEntriesToEvict(entries_set_, base::Time::Now(),
+                                         total_size - low_watermark_,
+                                         &entry_hashes);
 
   SIMPLE_CACHE_UMA(COUNTS_1M,
                    "Eviction.EntryCount", cache_type_, entry_hashes.size());
@@ -466,8 +472,10 @@ void SimpleIndex::SetTrailerPrefetchSize(uint64_t entry_hash, int32_t size) {
     return;
   int32_t original_size = it->second.GetTrailerPrefetchSize();
   it->second.SetTrailerPrefetchSize(size);
-  if (original_size != it->second.GetTrailerPrefetchSize())
+  if (original_size != it->second.GetTrailerPrefetchSize()) {
+    MarkEntryChanged(entry_hash);
     PostponeWritingToDisk();
+  }
 }
 
 bool SimpleIndex::UpdateEntrySize(uint64_t entry_hash,
@@ -482,11 +490,29 @@ bool SimpleIndex::UpdateEntrySize(uint64_t entry_hash,
   if (!UpdateEntryIteratorSize(&it, entry_size))
     return true;
 
+  MarkEntryChanged(entry_hash);
   PostponeWritingToDisk();
   StartEvictionIfNeeded();
   return true;
 }
 
+void SimpleIndex::RecordAccess(uint64_t entry_hash) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  eviction_policy_->RecordAccess(entry_hash);
+}
+
+void SimpleIndex::UpdateSharedStorage(
+    const std::vector<SharedStorageChange>& changes) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  for (const SharedStorageChange& change : changes) {
+    eviction_policy_->SetSharedStorage(change.entry_hash, change.storage_id,
+                                       change.storage_size);
+  }
+  // Until the entries are loaded there is nothing to pick victims from.
+  if (initialized_)
+    StartEvictionIfNeeded();
+}
+
 void SimpleIndex::EvictionDone(int result) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
@@ -524,6 +550,32 @@ void SimpleIndex::PostponeWritingToDisk() {
                              write_to_disk_cb_);
 }
 
+void SimpleIndex::MarkEntryChanged(uint64_t entry_hash) {
+  if (!track_changed_entries_ || all_entries_changed_)
+    return;
+  // Past this point appending to the log costs about as much as writing out
+  // a new snapshot, so stop keeping track.
+  if (changed_entries_.size() >=
+      std::max(entries_set_.size() / 2, kMinChangedEntriesToTrack)) {
+    changed_entries_.clear();
+    all_entries_changed_ = true;
+    return;
+  }
+  changed_entries_.insert(entry_hash);
+}
+
+void SimpleIndex::OnIndexMapped(
+    scoped_refptr<const MappedSimpleIndex> mapped_index) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (!initialized_)
+    mapped_index_ = std::move(mapped_index);
+}
+
+void SimpleIndex::ReleaseMappedIndex() {
+  if (mapped_index_)
+    SimpleIndexFile::ReleaseMappedIndex(std::move(mapped_index_));
+}
+
 bool SimpleIndex::UpdateEntryIteratorSize(
     EntrySet::iterator* it,
     base::StrictNumeric<uint32_t> entry_size) {
@@ -571,6 +623,7 @@ void SimpleIndex::MergeInitializingSet(
   cache_size_ = merged_cache_size;
   initialized_ = true;
   init_method_ = load_result->init_method;
+  ReleaseMappedIndex();
 
   // The actual IO is asynchronous, so calling WriteToDisk() shouldn't slow the
   // merge down much.
@@ -627,8 +680,19 @@ void SimpleIndex::WriteToDisk(IndexWriteToDiskReason reason) {
                                  cleanup_tracker_);
   }
 
-  index_file_->WriteToDisk(cache_type_, reason, entries_set_, cache_size_,
-                           std::move(after_write));
+  // A startup merge may have replaced the loaded index with a restored one,
+  // so it is always written in full.
+  if (track_changed_entries_ && !all_entries_changed_ &&
+      reason != INDEX_WRITE_REASON_STARTUP_MERGE) {
+    index_file_->WriteChangesToDisk(cache_type_, reason, entries_set_,
+                                    changed_entries_, cache_size_,
+                                    std::move(after_write));
+  } else {
+    index_file_->WriteToDisk(cache_type_, reason, entries_set_, cache_size_,
+                             std::move(after_write));
+  }
+  changed_entries_.clear();
+  all_entries_changed_ = false;
 }
 
 }  // namespace disk_cache
@@ -28,6 +28,7 @@
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_export.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 #if BUILDFLAG(IS_ANDROID)
 #include "base/android/application_status_listener.h"
@@ -41,6 +42,8 @@ class PickleIterator;
 namespace disk_cache {
 
 class BackendCleanupTracker;
+class MappedSimpleIndex;
+class SimpleEvictionPolicy;
 class SimpleIndexDelegate;
 class SimpleIndexFile;
 struct SimpleIndexLoadResult;
@@ -71,6 +74,13 @@ class NET_EXPORT_PRIVATE EntryMetadata {
 
   // Serialize the data into the provided pickle.
   void Serialize(net::CacheType cache_type, base::Pickle* pickle) const;
+
+  // Fixed-width encoding used by the mapped index snapshot and the index log
+  // (see SimpleIndexFile): the last used time, or the trailer prefetch size in
+  // APP_CACHE mode, in the high 32 bits, and the entry size and in-memory data
+  // packed as in Serialize() in the low 32 bits.
+  uint64_t ToFixedWidth() const;
+  static EntryMetadata FromFixedWidth(uint64_t value);
   bool Deserialize(net::CacheType cache_type,
                    base::PickleIterator* it,
                    bool has_entry_in_memory_data,
@@ -147,13 +157,19 @@ class NET_EXPORT_PRIVATE SimpleIndex
   void Insert(uint64_t entry_hash);
   void Remove(uint64_t entry_hash);
 
-  // Check whether the index has the entry given the hash of its key.
+  // Check whether the index has the entry given the hash of its key. Before
+  // the index is initialized this is answered from the mapped on-disk index
+  // if there is a fresh one, and is true otherwise.
   bool Has(uint64_t entry_hash) const;
 
   // Update the last used time of the entry with the given key and return true
   // iff the entry exist in the index.
   bool UseIfExists(uint64_t entry_hash);
 
+  // Tells the eviction policy that |entry_hash| was looked up, which happens
+  // once per open or create whether or not the entry exists.
+  void RecordAccess(uint64_t entry_hash);
+
   uint8_t GetEntryInMemoryData(uint64_t entry_hash) const;
   void SetEntryInMemoryData(uint64_t entry_hash, uint8_t value);
 
@@ -170,6 +186,19 @@ class NET_EXPORT_PRIVATE SimpleIndex
 
   using EntrySet = std::unordered_map<uint64_t, EntryMetadata>;
 
+  // A change to the storage shared between entries that an entry uses.
+  struct SharedStorageChange {
+    uint64_t entry_hash;
+    // Identifies the storage; unset if the entry no longer uses any.
+    absl::optional<uint64_t> storage_id;
+    uint64_t storage_size = 0;
+  };
+
+  // Applies |changes|, in order, to the storage shared between entries. That
+  // storage is not part of any entry's size but counts towards the cache size,
+  // and eviction counts an entry's share of it as freed along with it.
+  void UpdateSharedStorage(const std::vector<SharedStorageChange>& changes);
+
   // Insert an entry in the given set if there is not already entry present.
   // Returns true if the set was modified.
   static bool InsertInEntrySet(uint64_t entry_hash,
@@ -247,6 +276,17 @@ class NET_EXPORT_PRIVATE SimpleIndex
 
   void PostponeWritingToDisk();
 
+  // Records that the on-disk copy of |entry_hash| is out of date, for the
+  // next incremental write.
+  void MarkEntryChanged(uint64_t entry_hash);
+
+  // Called with a view of the on-disk index as soon as it is known to be
+  // fresh, ahead of MergeInitializingSet().
+  void OnIndexMapped(scoped_refptr<const MappedSimpleIndex> mapped_index);
+
+  // Drops |mapped_index_|; see SimpleIndexFile::ReleaseMappedIndex().
+  void ReleaseMappedIndex();
+
   // Update the size of the entry pointed to by the given iterator.  Return
   // true if the new size actually results in a change.
   bool UpdateEntryIteratorSize(EntrySet::iterator* it,
@@ -276,6 +316,7 @@ class NET_EXPORT_PRIVATE SimpleIndex
   uint64_t max_size_ = 0;
   uint64_t high_watermark_ = 0;
   uint64_t low_watermark_ = 0;
+  const std::unique_ptr<SimpleEvictionPolicy> eviction_policy_;
   bool eviction_in_progress_ = false;
   base::TimeTicks eviction_start_time_;
 
@@ -285,6 +326,17 @@ class NET_EXPORT_PRIVATE SimpleIndex
   bool initialized_ = false;
   IndexInitMethod init_method_ = INITIALIZE_METHOD_MAX;
 
+  // Used by Has() until initialization completes.
+  scoped_refptr<const MappedSimpleIndex> mapped_index_;
+
+  // With kSimpleCacheMappedIndex, the hashes of entries inserted, modified or
+  // removed since the index was last written, so that only those need to be
+  // appended to the index log. If this grows too large it is dropped, and
+  // |all_entries_changed_| makes the next write a full one instead.
+  const bool track_changed_entries_;
+  std::unordered_set<uint64_t> changed_entries_;
+  bool all_entries_changed_ = false;
+
   std::unique_ptr<SimpleIndexFile> index_file_;
 
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
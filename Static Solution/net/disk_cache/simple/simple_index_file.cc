@@ -4,17 +4,22 @@
 
 #include "net/disk_cache/simple/simple_index_file.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 #include <vector>
 
 #include "base/bind.h"
 #include "base/files/file.h"
 #include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/pickle.h"
+#include "base/rand_util.h"
 #include "base/strings/string_util.h"
 #include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
@@ -40,6 +45,152 @@ const int kMaxEntriesInIndex = 1000000;
 const int64_t kMaxIndexFileSizeBytes =
     kMaxEntriesInIndex * (8 + EntryMetadata::kOnDiskSizeBytes);
 
+// Once the log holds this many records, or half as many as there are entries
+// in the snapshot if that is more, the next write compacts it into a new
+// snapshot.
+const size_t kMinLogRecordsBeforeCompaction = 4096;
+
+const uint64_t kSnapshotMagicNumber = UINT64_C(0x736e617073686f74);
+const uint32_t kSnapshotVersion = 2;
+const uint32_t kLogBatchMagicNumber = 0x6c6f6762;
+
+// The number of records covered by each checksum in a snapshot. A block is
+// 1 KiB, so checking one is cheap next to the page fault that reads it.
+const size_t kRecordsPerSnapshotBlock = 64;
+
+// Header of the index snapshot, followed by a CRC of each block of
+// kRecordsPerSnapshotBlock records, padded to the alignment of the records,
+// and |entry_count| SimpleIndexRecords sorted by hash.
+struct SnapshotHeader {
+  uint64_t magic_number;
+  uint32_t version;
+  uint32_t reason;
+  uint64_t generation;
+  uint64_t entry_count;
+  uint64_t cache_size;
+  int64_t cache_last_modified;
+  uint32_t crc;  // Of this header with |crc| zeroed, and the block CRCs.
+  uint32_t padding;
+};
+static_assert(sizeof(SnapshotHeader) % alignof(SimpleIndexRecord) == 0,
+              "snapshot records must be aligned");
+
+// Header of a batch in the index log, followed by |updated_count|
+// SimpleIndexRecords and |removed_count| hashes.
+struct LogBatchHeader {
+  uint32_t magic_number;
+  uint32_t crc;  // Of this header with |crc| zeroed, and the payload.
+  uint64_t generation;
+  int64_t cache_last_modified;
+  uint32_t reason;
+  uint32_t updated_count;
+  uint32_t removed_count;
+  uint32_t padding;
+};
+
+// A batch read back from the index log. |payload| points into the log
+// buffer, which may not be suitably aligned for the records it holds.
+struct LogBatch {
+  SimpleIndexRecord GetUpdatedRecord(uint32_t i) const {
+    DCHECK_LT(i, header.updated_count);
+    SimpleIndexRecord record;
+    memcpy(&record, payload + i * sizeof(SimpleIndexRecord), sizeof(record));
+    return record;
+  }
+
+  uint64_t GetRemovedHash(uint32_t i) const {
+    DCHECK_LT(i, header.removed_count);
+    uint64_t hash;
+    memcpy(&hash,
+           payload + header.updated_count * sizeof(SimpleIndexRecord) +
+               i * sizeof(uint64_t),
+           sizeof(hash));
+    return hash;
+  }
+
+  LogBatchHeader header;
+  const char* payload = nullptr;
+};
+
+size_t GetSnapshotBlockCount(size_t entry_count) {
+  return (entry_count + kRecordsPerSnapshotBlock - 1) /
+         kRecordsPerSnapshotBlock;
+}
+
+// The size of the block CRCs in a snapshot, with their padding.
+size_t GetSnapshotBlockCRCsSize(size_t entry_count) {
+  const size_t size = GetSnapshotBlockCount(entry_count) * sizeof(uint32_t);
+  const size_t alignment = alignof(SimpleIndexRecord);
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+uint32_t CalculateSnapshotCRC(const SnapshotHeader& header,
+                              const char* block_crcs,
+                              size_t block_crcs_size) {
+  SnapshotHeader header_without_crc = header;
+  header_without_crc.crc = 0;
+  uint32_t crc = simple_util::Crc32(
+      reinterpret_cast<const char*>(&header_without_crc), sizeof(header));
+  if (!block_crcs_size)
+    return crc;
+  return simple_util::IncrementalCrc32(
+      crc, block_crcs, base::checked_cast<int>(block_crcs_size));
+}
+
+uint32_t CalculateLogBatchCRC(const LogBatchHeader& header,
+                              const char* payload,
+                              size_t payload_size) {
+  LogBatchHeader header_without_crc = header;
+  header_without_crc.crc = 0;
+  uint32_t crc = simple_util::Crc32(
+      reinterpret_cast<const char*>(&header_without_crc), sizeof(header));
+  if (!payload_size)
+    return crc;
+  return simple_util::IncrementalCrc32(crc, payload,
+                                       base::checked_cast<int>(payload_size));
+}
+
+bool HashLess(const SimpleIndexRecord& a, const SimpleIndexRecord& b) {
+  return a.hash < b.hash;
+}
+
+// Returns the block CRCs and records of the snapshot in |data| if its header
+// and block CRCs are intact. The records themselves are not read.
+bool ParseSnapshot(const uint8_t* data,
+                   size_t length,
+                   SnapshotHeader* out_header,
+                   base::span<const uint32_t>* out_block_crcs,
+                   base::span<const SimpleIndexRecord>* out_records) {
+  if (length < sizeof(SnapshotHeader))
+    return false;
+  memcpy(out_header, data, sizeof(SnapshotHeader));
+  if (out_header->magic_number != kSnapshotMagicNumber ||
+      out_header->version != kSnapshotVersion ||
+      out_header->reason >= SimpleIndex::INDEX_WRITE_REASON_MAX ||
+      out_header->entry_count > kMaxEntriesInIndex) {
+    return false;
+  }
+  const size_t entry_count = static_cast<size_t>(out_header->entry_count);
+  const size_t block_crcs_size = GetSnapshotBlockCRCsSize(entry_count);
+  if (length != sizeof(SnapshotHeader) + block_crcs_size +
+                    entry_count * sizeof(SimpleIndexRecord)) {
+    return false;
+  }
+  const char* block_crcs =
+      reinterpret_cast<const char*>(data) + sizeof(SnapshotHeader);
+  if (out_header->crc !=
+      CalculateSnapshotCRC(*out_header, block_crcs, block_crcs_size)) {
+    return false;
+  }
+  *out_block_crcs =
+      base::make_span(reinterpret_cast<const uint32_t*>(block_crcs),
+                      GetSnapshotBlockCount(entry_count));
+  *out_records = base::make_span(
+      reinterpret_cast<const SimpleIndexRecord*>(block_crcs + block_crcs_size),
+      entry_count);
+  return true;
+}
+
 uint32_t CalculatePickleCRC(const base::Pickle& pickle) {
   return simple_util::Crc32(pickle.payload(), pickle.payload_size());
 }
@@ -224,6 +375,59 @@ void ProcessEntryFile(BackendFileOperations* file_operations,
 
 }  // namespace
 
+const base::Feature kSimpleCacheMappedIndex = {
+    "SimpleCacheMappedIndex", base::FEATURE_DISABLED_BY_DEFAULT};
+
+uint32_t CalculateSimpleIndexBlockCRC(
+    base::span<const SimpleIndexRecord> records,
+    size_t block) {
+  const size_t begin = block * kRecordsPerSnapshotBlock;
+  DCHECK_LT(begin, records.size());
+  const size_t count =
+      std::min(kRecordsPerSnapshotBlock, records.size() - begin);
+  return simple_util::Crc32(
+      reinterpret_cast<const char*>(records.data() + begin),
+      base::checked_cast<int>(count * sizeof(SimpleIndexRecord)));
+}
+
+MappedSimpleIndex::MappedSimpleIndex(
+    std::unique_ptr<base::MemoryMappedFile> file,
+    base::span<const SimpleIndexRecord> records,
+    base::span<const uint32_t> block_crcs,
+    std::vector<uint64_t> logged_hashes)
+    : file_(std::move(file)),
+      records_(records),
+      block_crcs_(block_crcs),
+      logged_hashes_(std::move(logged_hashes)) {
+  DCHECK_EQ(GetSnapshotBlockCount(records_.size()), block_crcs_.size());
+  DCHECK(std::is_sorted(logged_hashes_.begin(), logged_hashes_.end()));
+}
+
+MappedSimpleIndex::~MappedSimpleIndex() = default;
+
+bool MappedSimpleIndex::MayContain(uint64_t entry_hash) const {
+  if (std::binary_search(logged_hashes_.begin(), logged_hashes_.end(),
+                         entry_hash)) {
+    return true;
+  }
+  // The answer rests on the record found, or on the two that would surround
+  // it. If those are intact, a corrupt record elsewhere can only have made
+  // the search take a longer path.
+  const auto it = std::lower_bound(records_.begin(), records_.end(),
+                                   SimpleIndexRecord{entry_hash, 0}, &HashLess);
+  const size_t i = static_cast<size_t>(it - records_.begin());
+  if ((i < records_.size() && !IsBlockIntact(i)) ||
+      (i > 0 && !IsBlockIntact(i - 1))) {
+    return true;
+  }
+  return it != records_.end() && it->hash == entry_hash;
+}
+
+bool MappedSimpleIndex::IsBlockIntact(size_t i) const {
+  const size_t block = i / kRecordsPerSnapshotBlock;
+  return block_crcs_[block] == CalculateSimpleIndexBlockCRC(records_, block);
+}
+
 SimpleIndexLoadResult::SimpleIndexLoadResult() = default;
 
 SimpleIndexLoadResult::~SimpleIndexLoadResult() = default;
@@ -232,6 +436,9 @@ void SimpleIndexLoadResult::Reset() {
   did_load = false;
   index_write_reason = SimpleIndex::INDEX_WRITE_REASON_MAX;
   flush_required = false;
+  snapshot_generation = 0;
+  snapshot_entry_count = 0;
+  log_record_count = 0;
   entries.clear();
 }
 
@@ -241,6 +448,10 @@ const char SimpleIndexFile::kIndexFileName[] = "the-real-index";
 const char SimpleIndexFile::kIndexDirectory[] = "index-dir";
 // static
 const char SimpleIndexFile::kTempIndexFileName[] = "temp-index";
+// static
+const char SimpleIndexFile::kSnapshotFileName[] = "index-snapshot";
+// static
+const char SimpleIndexFile::kLogFileName[] = "index-log";
 
 SimpleIndexFile::IndexMetadata::IndexMetadata()
     : reason_(SimpleIndex::INDEX_WRITE_REASON_MAX),
@@ -356,10 +567,23 @@ SimpleIndexFile::SimpleIndexFile(
       index_file_(cache_directory_.AppendASCII(kIndexDirectory)
                       .AppendASCII(kIndexFileName)),
       temp_index_file_(cache_directory_.AppendASCII(kIndexDirectory)
-                           .AppendASCII(kTempIndexFileName)) {}
+                           .AppendASCII(kTempIndexFileName)),
+      snapshot_file_(cache_directory_.AppendASCII(kIndexDirectory)
+                         .AppendASCII(kSnapshotFileName)),
+      log_file_(cache_directory_.AppendASCII(kIndexDirectory)
+                    .AppendASCII(kLogFileName)) {}
 
 SimpleIndexFile::~SimpleIndexFile() = default;
 
+// static
+void SimpleIndexFile::ReleaseMappedIndex(
+    scoped_refptr<const MappedSimpleIndex> mapped_index) {
+  base::ThreadPool::PostTask(
+      FROM_HERE, SimpleBackendImpl::kWorkerPoolTaskTraits,
+      base::BindOnce([](scoped_refptr<const MappedSimpleIndex>) {},
+                     std::move(mapped_index)));
+}
+
 void SimpleIndexFile::LoadIndexEntries(base::Time cache_last_modified,
                                        base::OnceClosure callback,
                                        SimpleIndexLoadResult* out_result) {
@@ -368,9 +592,23 @@ void SimpleIndexFile::LoadIndexEntries(base::Time cache_last_modified,
   base::OnceClosure task = base::BindOnce(
       &SimpleIndexFile::SyncLoadIndexEntries,
       file_operations_factory_->Create(task_runner), cache_type_,
-      cache_last_modified, cache_directory_, index_file_, out_result);
-  task_runner->PostTaskAndReply(FROM_HERE, std::move(task),
-                                std::move(callback));
+      cache_last_modified, cache_directory_, index_file_, snapshot_file_,
+      log_file_, base::SequencedTaskRunnerHandle::Get(),
+      std::move(index_mapped_callback_), out_result);
+  task_runner->PostTaskAndReply(
+      FROM_HERE, std::move(task),
+      base::BindOnce(&SimpleIndexFile::OnLoadIndexEntriesDone,
+                     weak_ptr_factory_.GetWeakPtr(), out_result,
+                     std::move(callback)));
+}
+
+void SimpleIndexFile::OnLoadIndexEntriesDone(
+    SimpleIndexLoadResult* load_result,
+    base::OnceClosure callback) {
+  snapshot_generation_ = load_result->snapshot_generation;
+  snapshot_entry_count_ = load_result->snapshot_entry_count;
+  log_record_count_ = load_result->log_record_count;
+  std::move(callback).Run();
 }
 
 void SimpleIndexFile::WriteToDisk(net::CacheType cache_type,
@@ -378,14 +616,74 @@ void SimpleIndexFile::WriteToDisk(net::CacheType cache_type,
                                   const SimpleIndex::EntrySet& entry_set,
                                   uint64_t cache_size,
                                   base::OnceClosure callback) {
-  IndexMetadata index_metadata(reason, entry_set.size(), cache_size);
-  std::unique_ptr<base::Pickle> pickle =
-      Serialize(cache_type, index_metadata, entry_set);
   auto file_operations = file_operations_factory_->Create(cache_runner_);
-  base::OnceClosure task =
-      base::BindOnce(&SimpleIndexFile::SyncWriteToDisk,
-                     std::move(file_operations), cache_type_, cache_directory_,
-                     index_file_, temp_index_file_, std::move(pickle));
+  base::OnceClosure task;
+  if (base::FeatureList::IsEnabled(kSimpleCacheMappedIndex)) {
+    std::vector<SimpleIndexRecord> records;
+    records.reserve(entry_set.size());
+    for (const auto& entry : entry_set)
+      records.push_back({entry.first, entry.second.ToFixedWidth()});
+
+    // Zero means there is no snapshot.
+    do {
+      snapshot_generation_ = base::RandUint64();
+    } while (snapshot_generation_ == 0);
+    snapshot_entry_count_ = records.size();
+    log_record_count_ = 0;
+    task = base::BindOnce(&SimpleIndexFile::SyncWriteSnapshot,
+                          std::move(file_operations), cache_directory_,
+                          snapshot_file_, temp_index_file_, log_file_,
+                          index_file_, reason, snapshot_generation_,
+                          cache_size, std::move(records));
+  } else {
+    IndexMetadata index_metadata(reason, entry_set.size(), cache_size);
+    std::unique_ptr<base::Pickle> pickle =
+        Serialize(cache_type, index_metadata, entry_set);
+    task = base::BindOnce(&SimpleIndexFile::SyncWriteToDisk,
+                          std::move(file_operations), cache_type_,
+                          cache_directory_, index_file_, temp_index_file_,
+                          std::move(pickle));
+  }
+  if (callback.is_null())
+    cache_runner_->PostTask(FROM_HERE, std::move(task));
+  else
+    cache_runner_->PostTaskAndReply(FROM_HERE, std::move(task),
+                                    std::move(callback));
+}
+
+void SimpleIndexFile::WriteChangesToDisk(
+    net::CacheType cache_type,
+    SimpleIndex::IndexWriteToDiskReason reason,
+    const SimpleIndex::EntrySet& entry_set,
+    const std::unordered_set<uint64_t>& changed_entries,
+    uint64_t cache_size,
+    base::OnceClosure callback) {
+  if (!base::FeatureList::IsEnabled(kSimpleCacheMappedIndex) ||
+      snapshot_generation_ == 0 ||
+      log_record_count_ + changed_entries.size() >
+          std::max(snapshot_entry_count_ / 2,
+                   kMinLogRecordsBeforeCompaction)) {
+    WriteToDisk(cache_type, reason, entry_set, cache_size,
+                std::move(callback));
+    return;
+  }
+
+  std::vector<SimpleIndexRecord> updated_records;
+  std::vector<uint64_t> removed_hashes;
+  for (uint64_t entry_hash : changed_entries) {
+    auto it = entry_set.find(entry_hash);
+    if (it == entry_set.end())
+      removed_hashes.push_back(entry_hash);
+    else
+      updated_records.push_back({entry_hash, it->second.ToFixedWidth()});
+  }
+  log_record_count_ += changed_entries.size();
+
+  base::OnceClosure task = base::BindOnce(
+      &SimpleIndexFile::SyncAppendToLog,
+      file_operations_factory_->Create(cache_runner_), cache_directory_,
+      log_file_, snapshot_generation_, reason, std::move(updated_records),
+      std::move(removed_hashes));
   if (callback.is_null())
     cache_runner_->PostTask(FROM_HERE, std::move(task));
   else
@@ -400,14 +698,38 @@ void SimpleIndexFile::SyncLoadIndexEntries(
     base::Time cache_last_modified,
     const base::FilePath& cache_directory,
     const base::FilePath& index_file_path,
+    const base::FilePath& snapshot_file_path,
+    const base::FilePath& log_file_path,
+    scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+    IndexMappedCallback index_mapped_callback,
     SimpleIndexLoadResult* out_result) {
   // Load the index and find its age.
   base::Time last_cache_seen_by_index;
-  SyncLoadFromDisk(file_operations.get(), cache_type, index_file_path,
-                   &last_cache_seen_by_index, out_result);
+  bool index_file_existed = false;
+  if (base::FeatureList::IsEnabled(kSimpleCacheMappedIndex)) {
+    SyncLoadSnapshot(file_operations.get(), cache_last_modified,
+                     snapshot_file_path, log_file_path,
+                     std::move(reply_task_runner),
+                     std::move(index_mapped_callback),
+                     &last_cache_seen_by_index, out_result);
+    index_file_existed = file_operations->PathExists(snapshot_file_path);
+    // Carry over an index in the old format, if that is all there is.
+    if (!out_result->did_load && !index_file_existed) {
+      SyncLoadFromDisk(file_operations.get(), cache_type, index_file_path,
+                       &last_cache_seen_by_index, out_result);
+      index_file_existed = file_operations->PathExists(index_file_path);
+    }
+  } else {
+    // A snapshot left behind while kSimpleCacheMappedIndex was enabled would
+    // not be kept up to date from here on.
+    file_operations->DeleteFile(snapshot_file_path);
+    file_operations->DeleteFile(log_file_path);
+    SyncLoadFromDisk(file_operations.get(), cache_type, index_file_path,
+                     &last_cache_seen_by_index, out_result);
+    index_file_existed = file_operations->PathExists(index_file_path);
+  }
 
   // Consider the index loaded if it is fresh.
-  const bool index_file_existed = file_operations->PathExists(index_file_path);
   if (!out_result->did_load) {
     if (index_file_existed)
       UmaRecordIndexFileState(INDEX_STATE_CORRUPT, cache_type);
@@ -510,6 +832,160 @@ void SimpleIndexFile::SyncLoadFromDisk(BackendFileOperations* file_operations,
   }
 }
 
+// static
+void SimpleIndexFile::SyncLoadSnapshot(
+    BackendFileOperations* file_operations,
+    base::Time cache_last_modified,
+    const base::FilePath& snapshot_file_path,
+    const base::FilePath& log_file_path,
+    scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+    IndexMappedCallback index_mapped_callback,
+    base::Time* out_last_cache_seen_by_index,
+    SimpleIndexLoadResult* out_result) {
+  out_result->Reset();
+
+  base::File file = file_operations->OpenFile(
+      snapshot_file_path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                              base::File::FLAG_WIN_SHARE_DELETE);
+  if (!file.IsValid())
+    return;
+
+  auto discard_snapshot = [&]() {
+    LOG(WARNING) << "Corrupt Simple Index snapshot.";
+    out_result->Reset();
+    file_operations->DeleteFile(
+        snapshot_file_path,
+        BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+    file_operations->DeleteFile(
+        log_file_path,
+        BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+  };
+
+  auto mapped_file = std::make_unique<base::MemoryMappedFile>();
+  SnapshotHeader header;
+  base::span<const uint32_t> block_crcs;
+  base::span<const SimpleIndexRecord> records;
+  if (!mapped_file->Initialize(std::move(file)) ||
+      !ParseSnapshot(mapped_file->data(), mapped_file->length(), &header,
+                     &block_crcs, &records)) {
+    mapped_file.reset();
+    discard_snapshot();
+    return;
+  }
+
+  // The log is small next to the snapshot, so it is simply read in full.
+  // Batches for another generation were left behind by an interrupted
+  // compaction and are skipped; anything after a batch that does not check
+  // out was never completely written.
+  std::vector<char> log;
+  bool log_intact = true;
+  base::File log_file = file_operations->OpenFile(
+      log_file_path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                         base::File::FLAG_WIN_SHARE_DELETE);
+  if (log_file.IsValid()) {
+    int64_t log_length = log_file.GetLength();
+    if (log_length < 0 || log_length > kMaxIndexFileSizeBytes) {
+      log_intact = false;
+    } else {
+      log.resize(log_length);
+      if (log_file.Read(0, log.data(), static_cast<int>(log_length)) !=
+          log_length) {
+        log.clear();
+        log_intact = false;
+      }
+    }
+  }
+  // Batches are copied out of |log| rather than cast in place, as a
+  // std::vector<char> makes no alignment guarantee.
+  std::vector<LogBatch> batches;
+  std::vector<uint64_t> logged_hashes;
+  int64_t last_cache_seen = header.cache_last_modified;
+  uint32_t reason = header.reason;
+  size_t log_record_count = 0;
+  size_t offset = 0;
+  while (offset < log.size()) {
+    if (log.size() - offset < sizeof(LogBatchHeader)) {
+      log_intact = false;
+      break;
+    }
+    LogBatch batch;
+    memcpy(&batch.header, log.data() + offset, sizeof(LogBatchHeader));
+    batch.payload = log.data() + offset + sizeof(LogBatchHeader);
+    const size_t payload_size =
+        static_cast<size_t>(batch.header.updated_count) *
+            sizeof(SimpleIndexRecord) +
+        static_cast<size_t>(batch.header.removed_count) * sizeof(uint64_t);
+    if (batch.header.magic_number != kLogBatchMagicNumber ||
+        payload_size > log.size() - offset - sizeof(LogBatchHeader) ||
+        batch.header.reason >= SimpleIndex::INDEX_WRITE_REASON_MAX ||
+        batch.header.crc !=
+            CalculateLogBatchCRC(batch.header, batch.payload, payload_size)) {
+      log_intact = false;
+      break;
+    }
+    offset += sizeof(LogBatchHeader) + payload_size;
+    if (batch.header.generation != header.generation)
+      continue;
+    for (uint32_t i = 0; i < batch.header.updated_count; ++i)
+      logged_hashes.push_back(batch.GetUpdatedRecord(i).hash);
+    last_cache_seen = batch.header.cache_last_modified;
+    reason = batch.header.reason;
+    log_record_count +=
+        batch.header.updated_count + batch.header.removed_count;
+    batches.push_back(batch);
+  }
+  std::sort(logged_hashes.begin(), logged_hashes.end());
+  logged_hashes.erase(std::unique(logged_hashes.begin(), logged_hashes.end()),
+                      logged_hashes.end());
+
+  *out_last_cache_seen_by_index =
+      base::Time::FromInternalValue(last_cache_seen);
+  auto mapped_index = base::MakeRefCounted<MappedSimpleIndex>(
+      std::move(mapped_file), records, block_crcs, std::move(logged_hashes));
+  if (index_mapped_callback &&
+      cache_last_modified <= *out_last_cache_seen_by_index) {
+    reply_task_runner->PostTask(
+        FROM_HERE, base::BindOnce(std::move(index_mapped_callback),
+                                  mapped_index));
+  }
+
+  // The records are read here for the first time, so this is where their
+  // checksums and order are checked.
+  SimpleIndex::EntrySet* entries = &out_result->entries;
+  entries->reserve(records.size() + kExtraSizeForMerge);
+  for (size_t i = 0; i < records.size(); ++i) {
+    if ((i % kRecordsPerSnapshotBlock == 0 &&
+         block_crcs[i / kRecordsPerSnapshotBlock] !=
+             CalculateSimpleIndexBlockCRC(records,
+                                          i / kRecordsPerSnapshotBlock)) ||
+        (i > 0 && records[i - 1].hash >= records[i].hash)) {
+      discard_snapshot();
+      return;
+    }
+    entries->emplace(records[i].hash,
+                     EntryMetadata::FromFixedWidth(records[i].metadata));
+  }
+  for (const LogBatch& batch : batches) {
+    for (uint32_t i = 0; i < batch.header.updated_count; ++i) {
+      const SimpleIndexRecord record = batch.GetUpdatedRecord(i);
+      (*entries)[record.hash] = EntryMetadata::FromFixedWidth(record.metadata);
+    }
+    for (uint32_t i = 0; i < batch.header.removed_count; ++i)
+      entries->erase(batch.GetRemovedHash(i));
+  }
+
+  out_result->index_write_reason =
+      static_cast<SimpleIndex::IndexWriteToDiskReason>(reason);
+  out_result->did_load = true;
+  // Appending after a damaged batch would be lost on the next load, so in that
+  // case the next write starts over with a new snapshot.
+  if (log_intact) {
+    out_result->snapshot_generation = header.generation;
+    out_result->snapshot_entry_count = records.size();
+    out_result->log_record_count = log_record_count;
+  }
+}
+
 // static
 std::unique_ptr<base::Pickle> SimpleIndexFile::Serialize(
     net::CacheType cache_type,
@@ -590,6 +1066,152 @@ void SimpleIndexFile::Deserialize(net::CacheType cache_type,
   out_result->did_load = true;
 }
 
+// static
+void SimpleIndexFile::SyncWriteSnapshot(
+    std::unique_ptr<BackendFileOperations> file_operations,
+    const base::FilePath& cache_directory,
+    const base::FilePath& snapshot_file_path,
+    const base::FilePath& temp_index_filename,
+    const base::FilePath& log_file_path,
+    const base::FilePath& index_filename,
+    SimpleIndex::IndexWriteToDiskReason reason,
+    uint64_t generation,
+    uint64_t cache_size,
+    std::vector<SimpleIndexRecord> records) {
+  base::FilePath index_file_directory = temp_index_filename.DirName();
+  if (!file_operations->DirectoryExists(index_file_directory) &&
+      !file_operations->CreateDirectory(index_file_directory)) {
+    LOG(ERROR) << "Could not create a directory to hold the index file";
+    return;
+  }
+
+  // See SyncWriteToDisk() regarding the cache directory mtime.
+  absl::optional<base::File::Info> file_info =
+      file_operations->GetFileInfo(cache_directory);
+  if (!file_info) {
+    LOG(ERROR) << "Could not obtain information about cache age";
+    return;
+  }
+
+  std::sort(records.begin(), records.end(), &HashLess);
+  const char* records_data = reinterpret_cast<const char*>(records.data());
+  const size_t records_size = records.size() * sizeof(SimpleIndexRecord);
+  // Zero-filled past the CRCs, for the padding.
+  std::vector<uint32_t> block_crcs(GetSnapshotBlockCRCsSize(records.size()) /
+                                   sizeof(uint32_t));
+  for (size_t block = 0; block < GetSnapshotBlockCount(records.size());
+       ++block) {
+    block_crcs[block] = CalculateSimpleIndexBlockCRC(records, block);
+  }
+  const char* block_crcs_data =
+      reinterpret_cast<const char*>(block_crcs.data());
+  const size_t block_crcs_size = block_crcs.size() * sizeof(uint32_t);
+  SnapshotHeader header = {};
+  header.magic_number = kSnapshotMagicNumber;
+  header.version = kSnapshotVersion;
+  header.reason = reason;
+  header.generation = generation;
+  header.entry_count = records.size();
+  header.cache_size = cache_size;
+  header.cache_last_modified = file_info->last_modified.ToInternalValue();
+  header.crc = CalculateSnapshotCRC(header, block_crcs_data, block_crcs_size);
+
+  base::File file = file_operations->OpenFile(
+      temp_index_filename, base::File::FLAG_CREATE_ALWAYS |
+                               base::File::FLAG_WRITE |
+                               base::File::FLAG_WIN_SHARE_DELETE);
+  if (!file.IsValid()) {
+    LOG(ERROR) << "Failed to write the temporary index file";
+    return;
+  }
+  if (file.Write(0, reinterpret_cast<const char*>(&header), sizeof(header)) !=
+          static_cast<int>(sizeof(header)) ||
+      file.Write(sizeof(header), block_crcs_data,
+                 base::checked_cast<int>(block_crcs_size)) !=
+          static_cast<int>(block_crcs_size) ||
+      file.Write(sizeof(header) + block_crcs_size, records_data,
+                 base::checked_cast<int>(records_size)) !=
+          static_cast<int>(records_size)) {
+    file.Close();
+    file_operations->DeleteFile(
+        temp_index_filename,
+        BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+    LOG(ERROR) << "Failed to write the temporary index file";
+    return;
+  }
+  file.Close();
+
+  // Atomically rename the temporary index file to become the real one.
+  if (!file_operations->ReplaceFile(temp_index_filename, snapshot_file_path,
+                                    nullptr)) {
+    return;
+  }
+  file_operations->DeleteFile(
+      log_file_path,
+      BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+  file_operations->DeleteFile(index_filename);
+}
+
+// static
+void SimpleIndexFile::SyncAppendToLog(
+    std::unique_ptr<BackendFileOperations> file_operations,
+    const base::FilePath& cache_directory,
+    const base::FilePath& log_file_path,
+    uint64_t generation,
+    SimpleIndex::IndexWriteToDiskReason reason,
+    std::vector<SimpleIndexRecord> updated_records,
+    std::vector<uint64_t> removed_hashes) {
+  absl::optional<base::File::Info> file_info =
+      file_operations->GetFileInfo(cache_directory);
+  if (!file_info) {
+    LOG(ERROR) << "Could not obtain information about cache age";
+    return;
+  }
+
+  // The batch goes out in a single write, so that a crash is unlikely to
+  // leave part of one behind.
+  const size_t updated_size =
+      updated_records.size() * sizeof(SimpleIndexRecord);
+  const size_t removed_size = removed_hashes.size() * sizeof(uint64_t);
+  std::vector<char> batch(sizeof(LogBatchHeader) + updated_size +
+                          removed_size);
+  char* payload = batch.data() + sizeof(LogBatchHeader);
+  if (updated_size)
+    memcpy(payload, updated_records.data(), updated_size);
+  if (removed_size)
+    memcpy(payload + updated_size, removed_hashes.data(), removed_size);
+  LogBatchHeader header = {};
+  header.magic_number = kLogBatchMagicNumber;
+  header.generation = generation;
+  header.cache_last_modified = file_info->last_modified.ToInternalValue();
+  header.reason = reason;
+  header.updated_count = base::checked_cast<uint32_t>(updated_records.size());
+  header.removed_count = base::checked_cast<uint32_t>(removed_hashes.size());
+  header.crc =
+      CalculateLogBatchCRC(header, payload, updated_size + removed_size);
+  memcpy(batch.data(), &header, sizeof(header));
+
+  base::File file = file_operations->OpenFile(
+      log_file_path, base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND |
+                         base::File::FLAG_WIN_SHARE_DELETE);
+  if (file.IsValid() &&
+      file.WriteAtCurrentPos(batch.data(),
+                             base::checked_cast<int>(batch.size())) ==
+          base::checked_cast<int>(batch.size())) {
+    return;
+  }
+  // Without this batch the index on disk is out of date. Drop it, so that the
+  // next startup rebuilds it rather than trusting it.
+  LOG(ERROR) << "Failed to append to the index log";
+  file.Close();
+  file_operations->DeleteFile(
+      log_file_path,
+      BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+  file_operations->DeleteFile(
+      log_file_path.DirName().AppendASCII(kSnapshotFileName),
+      BackendFileOperations::DeleteFileMode::kEnsureImmediateAvailability);
+}
+
 // static
 void SimpleIndexFile::SyncRestoreFromDisk(
     BackendFileOperations* file_operations,
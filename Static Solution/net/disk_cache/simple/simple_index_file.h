@@ -8,10 +8,16 @@
 #include <stdint.h>
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
+#include "base/callback.h"
+#include "base/containers/span.h"
+#include "base/feature_list.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "base/pickle.h"
 #include "net/base/cache_type.h"
 #include "net/base/net_export.h"
@@ -19,6 +25,7 @@
 #include "net/disk_cache/simple/simple_index.h"
 
 namespace base {
+class MemoryMappedFile;
 class SequencedTaskRunner;
 }
 
@@ -28,6 +35,61 @@ class BackendFileOperationsFactory;
 
 const uint64_t kSimpleIndexMagicNumber = UINT64_C(0x656e74657220796f);
 
+// When enabled, the index is written as a snapshot of fixed-width records
+// that is mapped rather than parsed on load, plus a log of the entries that
+// changed since, instead of as a pickle rewritten in full on every write.
+NET_EXPORT_PRIVATE extern const base::Feature kSimpleCacheMappedIndex;
+
+// One entry in an index snapshot or index log.
+struct SimpleIndexRecord {
+  uint64_t hash;
+  uint64_t metadata;  // EntryMetadata::ToFixedWidth().
+};
+static_assert(sizeof(SimpleIndexRecord) == 16, "incorrect record size");
+
+// Snapshot records are checksummed in blocks, so that a lookup only has to
+// check the records it reads. Returns the checksum of block |block| of
+// |records|.
+NET_EXPORT_PRIVATE uint32_t
+CalculateSimpleIndexBlockCRC(base::span<const SimpleIndexRecord> records,
+                             size_t block);
+
+// An index snapshot mapped into memory, together with the hashes of the
+// entries that its log adds. Snapshot records are sorted by hash, so this can
+// answer lookups straight from the mapping while the EntrySet for SimpleIndex
+// is still being built. Nothing is read from the mapping up front; each lookup
+// checks the blocks of the records its answer rests on.
+class NET_EXPORT_PRIVATE MappedSimpleIndex
+    : public base::RefCountedThreadSafe<MappedSimpleIndex> {
+ public:
+  MappedSimpleIndex(std::unique_ptr<base::MemoryMappedFile> file,
+                    base::span<const SimpleIndexRecord> records,
+                    base::span<const uint32_t> block_crcs,
+                    std::vector<uint64_t> logged_hashes);
+
+  MappedSimpleIndex(const MappedSimpleIndex&) = delete;
+  MappedSimpleIndex& operator=(const MappedSimpleIndex&) = delete;
+
+  // Returns false only if |entry_hash| was not in the cache when the index
+  // was last written. Also returns true if the records that would tell are
+  // corrupt.
+  bool MayContain(uint64_t entry_hash) const;
+
+  base::span<const SimpleIndexRecord> records() const { return records_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<MappedSimpleIndex>;
+  ~MappedSimpleIndex();
+
+  // Returns whether the block holding |records_[i]| matches its checksum.
+  bool IsBlockIntact(size_t i) const;
+
+  const std::unique_ptr<base::MemoryMappedFile> file_;
+  const base::span<const SimpleIndexRecord> records_;  // Points into |file_|.
+  const base::span<const uint32_t> block_crcs_;        // Points into |file_|.
+  const std::vector<uint64_t> logged_hashes_;          // Sorted.
+};
+
 struct NET_EXPORT_PRIVATE SimpleIndexLoadResult {
   SimpleIndexLoadResult();
   ~SimpleIndexLoadResult();
@@ -39,6 +101,12 @@ struct NET_EXPORT_PRIVATE SimpleIndexLoadResult {
       SimpleIndex::INDEX_WRITE_REASON_MAX;
   SimpleIndex::IndexInitMethod init_method;
   bool flush_required = false;
+
+  // Set when the entries were loaded from a snapshot whose log can be
+  // appended to; see kSimpleCacheMappedIndex.
+  uint64_t snapshot_generation = 0;
+  size_t snapshot_entry_count = 0;
+  size_t log_record_count = 0;
 };
 
 // Simple Index File format is a pickle of IndexMetadata and EntryMetadata
@@ -47,6 +115,16 @@ struct NET_EXPORT_PRIVATE SimpleIndexLoadResult {
 // the format see |SimpleIndexFile::Serialize()| and
 // |SimpleIndexFile::LoadFromDisk()|.
 //
+// With kSimpleCacheMappedIndex the index is instead kept in two files. The
+// snapshot is a fixed header, a checksum for each block of records, and the
+// |SimpleIndexRecord|s sorted by hash, and is mapped into memory to load it.
+// Only the header and checksums are checked before the mapping is used; each
+// block is checked when it is read. The log is a sequence of batches, each
+// holding the records updated and the hashes removed by one write. Batches are
+// stamped with the generation of the snapshot they apply to, so a log left
+// behind by an interrupted compaction is ignored. See SyncWriteSnapshot() and
+// SyncAppendToLog().
+//
 // The non-static methods must run on the source creation sequence. All the real
 // work is done in the static methods, which are run on the cache thread
 // or in worker threads. Synchronization between methods is the
@@ -113,6 +191,32 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
                            uint64_t cache_size,
                            base::OnceClosure callback);
 
+  // Like WriteToDisk(), given the hashes of the entries inserted, modified or
+  // removed since the previous write. With kSimpleCacheMappedIndex, only those
+  // are appended to the log unless it is time to compact it into a new
+  // snapshot.
+  virtual void WriteChangesToDisk(
+      net::CacheType cache_type,
+      SimpleIndex::IndexWriteToDiskReason reason,
+      const SimpleIndex::EntrySet& entry_set,
+      const std::unordered_set<uint64_t>& changed_entries,
+      uint64_t cache_size,
+      base::OnceClosure callback);
+
+  // Sets a callback for the next LoadIndexEntries() to run on this sequence
+  // as soon as it has mapped an index that is fresh, before it goes on to
+  // build the EntrySet.
+  using IndexMappedCallback =
+      base::OnceCallback<void(scoped_refptr<const MappedSimpleIndex>)>;
+  void set_index_mapped_callback(IndexMappedCallback callback) {
+    index_mapped_callback_ = std::move(callback);
+  }
+
+  // Drops a reference to |mapped_index| on a worker thread, since unmapping
+  // closes the file.
+  static void ReleaseMappedIndex(
+      scoped_refptr<const MappedSimpleIndex> mapped_index);
+
  private:
   friend class WrappedSimpleIndexFile;
 
@@ -135,6 +239,23 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
       base::Time cache_last_modified,
       const base::FilePath& cache_directory,
       const base::FilePath& index_file_path,
+      const base::FilePath& snapshot_file_path,
+      const base::FilePath& log_file_path,
+      scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+      IndexMappedCallback index_mapped_callback,
+      SimpleIndexLoadResult* out_result);
+
+  // Loads the snapshot and replays the log on top of it. If the result is
+  // fresh relative to |cache_last_modified|, |index_mapped_callback| is posted
+  // to |reply_task_runner| before the EntrySet is built.
+  static void SyncLoadSnapshot(
+      BackendFileOperations* file_operations,
+      base::Time cache_last_modified,
+      const base::FilePath& snapshot_file_path,
+      const base::FilePath& log_file_path,
+      scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+      IndexMappedCallback index_mapped_callback,
+      base::Time* out_last_cache_seen_by_index,
       SimpleIndexLoadResult* out_result);
 
   // Load the index file from disk returning an EntrySet.
@@ -178,6 +299,34 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
       const base::FilePath& temp_index_filename,
       std::unique_ptr<base::Pickle> pickle);
 
+  // Writes |records| as a new snapshot atomically, then deletes the log and
+  // any index file in the old format.
+  static void SyncWriteSnapshot(
+      std::unique_ptr<BackendFileOperations> file_operations,
+      const base::FilePath& cache_directory,
+      const base::FilePath& snapshot_file_path,
+      const base::FilePath& temp_index_filename,
+      const base::FilePath& log_file_path,
+      const base::FilePath& index_filename,
+      SimpleIndex::IndexWriteToDiskReason reason,
+      uint64_t generation,
+      uint64_t cache_size,
+      std::vector<SimpleIndexRecord> records);
+
+  // Appends one batch to the log.
+  static void SyncAppendToLog(
+      std::unique_ptr<BackendFileOperations> file_operations,
+      const base::FilePath& cache_directory,
+      const base::FilePath& log_file_path,
+      uint64_t generation,
+      SimpleIndex::IndexWriteToDiskReason reason,
+      std::vector<SimpleIndexRecord> updated_records,
+      std::vector<uint64_t> removed_hashes);
+
+  // Records where the log that was loaded left off, then runs |callback|.
+  void OnLoadIndexEntriesDone(SimpleIndexLoadResult* load_result,
+                              base::OnceClosure callback);
+
   // Scan the index directory for entries, returning an EntrySet of all entries
   // found.
   static void SyncRestoreFromDisk(BackendFileOperations* file_operations,
@@ -200,10 +349,25 @@ class NET_EXPORT_PRIVATE SimpleIndexFile {
   const base::FilePath cache_directory_;
   const base::FilePath index_file_;
   const base::FilePath temp_index_file_;
+  const base::FilePath snapshot_file_;
+  const base::FilePath log_file_;
+
+  IndexMappedCallback index_mapped_callback_;
+
+  // The snapshot that writes with kSimpleCacheMappedIndex append to, and how
+  // far its log has grown. Zero until a snapshot has been loaded or written,
+  // which makes the next write a new snapshot.
+  uint64_t snapshot_generation_ = 0;
+  size_t snapshot_entry_count_ = 0;
+  size_t log_record_count_ = 0;
 
   static const char kIndexDirectory[];
   static const char kIndexFileName[];
   static const char kTempIndexFileName[];
+  static const char kSnapshotFileName[];
+  static const char kLogFileName[];
+
+  base::WeakPtrFactory<SimpleIndexFile> weak_ptr_factory_{this};
 };
 
 }  // namespace disk_cache
@@ -5,7 +5,10 @@
 #include "net/disk_cache/simple/simple_index_file.h"
 
 #include <memory>
+#include <string>
+#include <unordered_set>
 
+#include "base/bind.h"
 #include "base/callback.h"
 #include "base/check.h"
 #include "base/files/file.h"
@@ -16,6 +19,7 @@
 #include "base/pickle.h"
 #include "base/run_loop.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
@@ -171,6 +175,10 @@ class WrappedSimpleIndexFile : public SimpleIndexFile {
     return temp_index_file_;
   }
 
+  const base::FilePath& GetSnapshotFilePath() const { return snapshot_file_; }
+
+  const base::FilePath& GetLogFilePath() const { return log_file_; }
+
   bool CreateIndexFileDirectory() const {
     return base::CreateDirectory(index_file_.DirName());
   }
@@ -631,6 +639,256 @@ TEST_F(SimpleIndexFileTest, SimpleCacheUpgrade) {
   EXPECT_TRUE(deserialize_result.did_load);
 }
 
+class SimpleIndexFileMappedTest : public SimpleIndexFileTest {
+ public:
+  SimpleIndexFileMappedTest() {
+    scoped_feature_list_.InitAndEnableFeature(kSimpleCacheMappedIndex);
+  }
+
+  void SetUp() override {
+    ASSERT_TRUE(cache_dir_.CreateUniqueTempDir());
+    index_file_ =
+        std::make_unique<WrappedSimpleIndexFile>(cache_dir_.GetPath());
+  }
+
+  void Write(const SimpleIndex::EntrySet& entries) {
+    net::TestClosure closure;
+    index_file_->WriteToDisk(net::DISK_CACHE,
+                            SimpleIndex::INDEX_WRITE_REASON_SHUTDOWN, entries,
+                            /*cache_size=*/0, closure.closure());
+    closure.WaitForResult();
+  }
+
+  void WriteChanges(const SimpleIndex::EntrySet& entries,
+                    const std::unordered_set<uint64_t>& changed_entries) {
+    net::TestClosure closure;
+    index_file_->WriteChangesToDisk(
+        net::DISK_CACHE, SimpleIndex::INDEX_WRITE_REASON_IDLE, entries,
+        changed_entries, /*cache_size=*/0, closure.closure());
+    closure.WaitForResult();
+  }
+
+  // Loads the index with a fresh SimpleIndexFile, as on the next startup.
+  void Load(SimpleIndexLoadResult* load_result,
+            scoped_refptr<const MappedSimpleIndex>* mapped_index = nullptr) {
+    WrappedSimpleIndexFile index_file(cache_dir_.GetPath());
+    if (mapped_index) {
+      index_file.set_index_mapped_callback(base::BindOnce(
+          [](scoped_refptr<const MappedSimpleIndex>* out,
+             scoped_refptr<const MappedSimpleIndex> mapped_index) {
+            *out = std::move(mapped_index);
+          },
+          mapped_index));
+    }
+    base::File::Info file_info;
+    ASSERT_TRUE(base::GetFileInfo(cache_dir_.GetPath(), &file_info));
+    net::TestClosure closure;
+    index_file.LoadIndexEntries(file_info.last_modified, closure.closure(),
+                                load_result);
+    closure.WaitForResult();
+  }
+
+ protected:
+  base::test::ScopedFeatureList scoped_feature_list_;
+  base::ScopedTempDir cache_dir_;
+  std::unique_ptr<WrappedSimpleIndexFile> index_file_;
+};
+
+TEST_F(SimpleIndexFileMappedTest, WriteThenLoadSnapshot) {
+  SimpleIndex::EntrySet entries;
+  static const uint64_t kHashes[] = {33, 11, 22};
+  for (uint64_t hash : kHashes) {
+    SimpleIndex::InsertInEntrySet(
+        hash, EntryMetadata(Time::Now(), static_cast<uint32_t>(hash * 1000)),
+        &entries);
+  }
+  Write(entries);
+  EXPECT_TRUE(base::PathExists(index_file_->GetSnapshotFilePath()));
+  EXPECT_FALSE(base::PathExists(index_file_->GetIndexFilePath()));
+
+  SimpleIndexLoadResult load_result;
+  scoped_refptr<const MappedSimpleIndex> mapped_index;
+  Load(&load_result, &mapped_index);
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_FALSE(load_result.flush_required);
+  EXPECT_NE(0u, load_result.snapshot_generation);
+  EXPECT_EQ(std::size(kHashes), load_result.snapshot_entry_count);
+  ASSERT_EQ(std::size(kHashes), load_result.entries.size());
+  for (uint64_t hash : kHashes) {
+    EXPECT_TRUE(CompareTwoEntryMetadata(entries[hash],
+                                        load_result.entries[hash]));
+  }
+
+  // The mapped index was handed over before the entries were built.
+  ASSERT_TRUE(mapped_index);
+  ASSERT_EQ(std::size(kHashes), mapped_index->records().size());
+  for (uint64_t hash : kHashes)
+    EXPECT_TRUE(mapped_index->MayContain(hash));
+  EXPECT_FALSE(mapped_index->MayContain(44));
+}
+
+TEST_F(SimpleIndexFileMappedTest, AppendsChangesToLog) {
+  SimpleIndex::EntrySet entries;
+  for (uint64_t hash : {11, 22, 33})
+    SimpleIndex::InsertInEntrySet(hash, EntryMetadata(Time(), 100u), &entries);
+  Write(entries);
+
+  // Remove one entry, resize another and add a third.
+  entries.erase(11);
+  entries[22].SetEntrySize(2000u);
+  SimpleIndex::InsertInEntrySet(44, EntryMetadata(Time(), 3000u), &entries);
+  WriteChanges(entries, {11, 22, 44});
+  EXPECT_TRUE(base::PathExists(index_file_->GetLogFilePath()));
+
+  SimpleIndexLoadResult load_result;
+  scoped_refptr<const MappedSimpleIndex> mapped_index;
+  Load(&load_result, &mapped_index);
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_EQ(3u, load_result.snapshot_entry_count);
+  EXPECT_EQ(3u, load_result.log_record_count);
+  EXPECT_EQ(SimpleIndex::INDEX_WRITE_REASON_IDLE,
+            load_result.index_write_reason);
+  ASSERT_EQ(3u, load_result.entries.size());
+  EXPECT_EQ(0u, load_result.entries.count(11));
+  EXPECT_EQ(RoundSize(2000u), load_result.entries[22].GetEntrySize());
+  EXPECT_EQ(RoundSize(100u), load_result.entries[33].GetEntrySize());
+  EXPECT_EQ(RoundSize(3000u), load_result.entries[44].GetEntrySize());
+
+  ASSERT_TRUE(mapped_index);
+  EXPECT_TRUE(mapped_index->MayContain(44));
+}
+
+TEST_F(SimpleIndexFileMappedTest, CompactsLargeLog) {
+  SimpleIndex::EntrySet entries;
+  SimpleIndex::InsertInEntrySet(1, EntryMetadata(Time(), 100u), &entries);
+  Write(entries);
+
+  // Changing more entries than the log is allowed to hold writes a new
+  // snapshot instead.
+  std::unordered_set<uint64_t> changed_entries;
+  for (uint64_t hash = 2; hash < 10000; ++hash) {
+    SimpleIndex::InsertInEntrySet(hash, EntryMetadata(Time(), 100u), &entries);
+    changed_entries.insert(hash);
+  }
+  WriteChanges(entries, changed_entries);
+  EXPECT_FALSE(base::PathExists(index_file_->GetLogFilePath()));
+
+  SimpleIndexLoadResult load_result;
+  Load(&load_result);
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_EQ(entries.size(), load_result.snapshot_entry_count);
+  EXPECT_EQ(0u, load_result.log_record_count);
+  EXPECT_EQ(entries.size(), load_result.entries.size());
+}
+
+TEST_F(SimpleIndexFileMappedTest, IgnoresDamagedLogTail) {
+  SimpleIndex::EntrySet entries;
+  SimpleIndex::InsertInEntrySet(11, EntryMetadata(Time(), 100u), &entries);
+  Write(entries);
+  SimpleIndex::InsertInEntrySet(22, EntryMetadata(Time(), 100u), &entries);
+  WriteChanges(entries, {22});
+
+  // Simulate a batch that was cut short.
+  const std::string kDummyData = "nothing to be seen here";
+  ASSERT_TRUE(base::AppendToFile(index_file_->GetLogFilePath(), kDummyData));
+
+  SimpleIndexLoadResult load_result;
+  Load(&load_result);
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_EQ(2u, load_result.entries.size());
+  // Appending after the damage would be lost, so the next write has to start
+  // a new snapshot.
+  EXPECT_EQ(0u, load_result.snapshot_generation);
+}
+
+// A corrupt record only affects lookups that read its block, and is caught
+// when the entries are loaded.
+TEST_F(SimpleIndexFileMappedTest, LoadSnapshotWithCorruptRecord) {
+  const uint64_t kNumEntries = 200;
+  SimpleIndex::EntrySet entries;
+  for (uint64_t i = 1; i <= kNumEntries; ++i) {
+    SimpleIndex::InsertInEntrySet(2 * i, EntryMetadata(Time(), 100u),
+                                  &entries);
+  }
+  Write(entries);
+
+  // The records are at the end of the snapshot, sorted by hash. Damage the
+  // metadata of the 101st, for hash 202.
+  const base::FilePath snapshot_path = index_file_->GetSnapshotFilePath();
+  int64_t snapshot_size;
+  ASSERT_TRUE(base::GetFileSize(snapshot_path, &snapshot_size));
+  const int64_t record_offset =
+      snapshot_size -
+      static_cast<int64_t>((kNumEntries - 100) * sizeof(SimpleIndexRecord));
+  {
+    base::File file(snapshot_path,
+                    base::File::FLAG_OPEN | base::File::FLAG_READ |
+                        base::File::FLAG_WRITE);
+    uint64_t hash = 0;
+    ASSERT_EQ(static_cast<int>(sizeof(hash)),
+              file.Read(record_offset, reinterpret_cast<char*>(&hash),
+                        sizeof(hash)));
+    ASSERT_EQ(202u, hash);
+    const char kGarbage[] = "garbage";
+    ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+              file.Write(record_offset + sizeof(hash), kGarbage,
+                         sizeof(kGarbage)));
+  }
+
+  SimpleIndexLoadResult load_result;
+  scoped_refptr<const MappedSimpleIndex> mapped_index;
+  Load(&load_result, &mapped_index);
+
+  // Lookups that rest on intact blocks are still answered exactly, and those
+  // that do not say the entry may be there.
+  ASSERT_TRUE(mapped_index);
+  EXPECT_TRUE(mapped_index->MayContain(2));
+  EXPECT_FALSE(mapped_index->MayContain(3));
+  EXPECT_FALSE(mapped_index->MayContain(2 * kNumEntries + 1));
+  EXPECT_TRUE(mapped_index->MayContain(202));
+  EXPECT_TRUE(mapped_index->MayContain(203));
+
+  // The snapshot is not trusted for the entries themselves.
+  EXPECT_FALSE(base::PathExists(snapshot_path));
+  EXPECT_TRUE(load_result.flush_required);
+}
+
+TEST_F(SimpleIndexFileMappedTest, LoadCorruptSnapshot) {
+  ASSERT_TRUE(index_file_->CreateIndexFileDirectory());
+  const std::string kDummyData = "nothing to be seen here";
+  ASSERT_TRUE(base::WriteFile(index_file_->GetSnapshotFilePath(), kDummyData));
+
+  SimpleIndexLoadResult load_result;
+  Load(&load_result);
+  EXPECT_FALSE(base::PathExists(index_file_->GetSnapshotFilePath()));
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_TRUE(load_result.flush_required);
+}
+
+// An index in the old format is still picked up, and replaced on the next
+// write.
+TEST_F(SimpleIndexFileMappedTest, LoadsPickledIndex) {
+  SimpleIndex::EntrySet entries;
+  SimpleIndex::InsertInEntrySet(11, EntryMetadata(Time(), 100u), &entries);
+  {
+    base::test::ScopedFeatureList disable_mapped_index;
+    disable_mapped_index.InitAndDisableFeature(kSimpleCacheMappedIndex);
+    Write(entries);
+  }
+  ASSERT_TRUE(base::PathExists(index_file_->GetIndexFilePath()));
+
+  SimpleIndexLoadResult load_result;
+  Load(&load_result);
+  EXPECT_TRUE(load_result.did_load);
+  EXPECT_FALSE(load_result.flush_required);
+  EXPECT_EQ(1u, load_result.entries.size());
+  EXPECT_EQ(0u, load_result.snapshot_generation);
+
+  Write(entries);
+  EXPECT_TRUE(base::PathExists(index_file_->GetSnapshotFilePath()));
+  EXPECT_FALSE(base::PathExists(index_file_->GetIndexFilePath()));
+}
+
 TEST_F(SimpleIndexFileTest, OverwritesStaleTempFile) {
   base::ScopedTempDir cache_dir;
   ASSERT_TRUE(cache_dir.CreateUniqueTempDir());
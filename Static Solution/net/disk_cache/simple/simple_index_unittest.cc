@@ -8,6 +8,7 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/files/scoped_temp_dir.h"
@@ -158,6 +159,10 @@ class SimpleIndexTest : public net::TestWithTaskEnvironment,
                                 base::checked_cast<uint32_t>(entry_size))));
   }
 
+  void SetMappedIndex(scoped_refptr<const MappedSimpleIndex> mapped_index) {
+    index_->OnIndexMapped(std::move(mapped_index));
+  }
+
   void ReturnIndexFile() {
     index_file_->load_result()->did_load = true;
     index_file_->TakeLoadCallback().Run();
@@ -451,6 +456,36 @@ TEST_F(SimpleIndexTest, RemoveBeforeInit) {
   EXPECT_FALSE(index()->Has(kHash1));
 }
 
+// Has() answers from the mapped snapshot and its log until the index is
+// initialized, then from the loaded entries.
+TEST_F(SimpleIndexTest, HasBeforeInitWithMappedIndex) {
+  std::vector<SimpleIndexRecord> records = {{hashes_.at<1>(), 0},
+                                            {hashes_.at<2>(), 0}};
+  std::sort(records.begin(), records.end(),
+            [](const SimpleIndexRecord& a, const SimpleIndexRecord& b) {
+              return a.hash < b.hash;
+            });
+  const uint32_t block_crcs[] = {CalculateSimpleIndexBlockCRC(records, 0)};
+  SetMappedIndex(base::MakeRefCounted<MappedSimpleIndex>(
+      /*file=*/nullptr, records, block_crcs,
+      std::vector<uint64_t>{hashes_.at<3>()}));
+
+  // Entries in the snapshot or its log may be there; anything else is not.
+  EXPECT_TRUE(index()->Has(hashes_.at<1>()));
+  EXPECT_TRUE(index()->Has(hashes_.at<2>()));
+  EXPECT_TRUE(index()->Has(hashes_.at<3>()));
+  EXPECT_FALSE(index()->Has(hashes_.at<4>()));
+  index()->Insert(hashes_.at<4>());
+  EXPECT_TRUE(index()->Has(hashes_.at<4>()));
+
+  // Once initialized, the loaded entries take over.
+  InsertIntoIndexFileReturn(hashes_.at<1>(), base::Time::Now(), 10u);
+  ReturnIndexFile();
+  EXPECT_TRUE(index()->Has(hashes_.at<1>()));
+  EXPECT_FALSE(index()->Has(hashes_.at<2>()));
+  EXPECT_TRUE(index()->Has(hashes_.at<4>()));
+}
+
 // Insert something that's going to come in from the loaded index; correct
 // result?
 TEST_F(SimpleIndexTest, InsertBeforeInit) {
@@ -658,6 +693,44 @@ TEST_F(SimpleIndexTest, EvictBySize2) {
   ASSERT_EQ(2u, last_doom_entry_hashes().size());
 }
 
+// Evicts several hundred entries from a larger index, where the entries that
+// get evicted are much smaller than the average entry, so they are picked
+// over several selection batches.
+TEST_F(SimpleIndexTest, EvictManySmallEntries) {
+  const int kNumSmallEntries = 1000;
+  const int kNumLargeEntries = 10;
+  base::Time now(base::Time::Now());
+  index()->SetMaxSize(1200000);
+  // Old small entries, where entry |i| was last used |i + 1| days ago...
+  for (int i = 0; i < kNumSmallEntries; ++i) {
+    InsertIntoIndexFileReturn(HashesInitializer(i), now - base::Days(i + 1),
+                              256u);
+  }
+  // ...and recently used large ones, which score lower despite their size.
+  for (int i = 0; i < kNumLargeEntries; ++i) {
+    InsertIntoIndexFileReturn(HashesInitializer(kNumSmallEntries + i),
+                              now - base::Minutes(1), 102400u);
+  }
+  ReturnIndexFile();
+  WaitForTimeChange();
+
+  const uint64_t new_entry_hash =
+      HashesInitializer(kNumSmallEntries + kNumLargeEntries);
+  index()->Insert(new_entry_hash);
+  EXPECT_EQ(0, doom_entries_calls());
+
+  // 1280256 bytes against a low watermark of 1080000 means evicting 783 of
+  // the small entries, oldest first.
+  index()->UpdateEntrySize(new_entry_hash, 256u);
+  EXPECT_EQ(1, doom_entries_calls());
+  ASSERT_EQ(783u, last_doom_entry_hashes().size());
+  for (int i = 0; i < kNumSmallEntries; ++i)
+    EXPECT_EQ(i < kNumSmallEntries - 783, index()->Has(HashesInitializer(i)));
+  for (int i = 0; i < kNumLargeEntries; ++i)
+    EXPECT_TRUE(index()->Has(HashesInitializer(kNumSmallEntries + i)));
+  EXPECT_TRUE(index()->Has(new_entry_hash));
+}
+
 // Confirm all the operations queue a disk write at some point in the
 // future.
 TEST_F(SimpleIndexTest, DiskWriteQueued) {
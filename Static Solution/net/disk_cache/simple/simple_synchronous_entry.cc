@@ -30,6 +30,7 @@
 #include "net/base/net_errors.h"
 #include "net/disk_cache/cache_util.h"
 #include "net/disk_cache/simple/simple_backend_version.h"
+#include "net/disk_cache/simple/simple_blob_store.h"
 #include "net/disk_cache/simple/simple_histogram_enums.h"
 #include "net/disk_cache/simple/simple_histogram_macros.h"
 #include "net/disk_cache/simple/simple_util.h"
@@ -110,6 +111,54 @@ int FileIndexForSubFile(SimpleFileTracker::SubFile sub_file) {
   return sub_file == SimpleFileTracker::SubFile::FILE_0 ? 0 : 1;
 }
 
+// Copies |length| bytes at |from_offset| in |from| to |to_offset| in |to|.
+bool CopyFileRange(base::File* from,
+                   int64_t from_offset,
+                   base::File* to,
+                   int64_t to_offset,
+                   int64_t length) {
+  const int kCopyBufferSize = 64 * 1024;
+  std::unique_ptr<char[]> buffer(
+      new char[std::min<int64_t>(std::max<int64_t>(length, 1),
+                                 kCopyBufferSize)]);
+  while (length > 0) {
+    const int chunk = static_cast<int>(
+        std::min<int64_t>(length, kCopyBufferSize));
+    if (from->Read(from_offset, buffer.get(), chunk) != chunk ||
+        to->Write(to_offset, buffer.get(), chunk) != chunk) {
+      return false;
+    }
+    from_offset += chunk;
+    to_offset += chunk;
+    length -= chunk;
+  }
+  return true;
+}
+
+// Computes the SHA-256 of |length| bytes at |offset| in |file|.
+bool HashFileRange(base::File* file,
+                   int64_t offset,
+                   int64_t length,
+                   net::SHA256HashValue* out_hash) {
+  const int kHashBufferSize = 64 * 1024;
+  std::unique_ptr<char[]> buffer(
+      new char[std::min<int64_t>(std::max<int64_t>(length, 1),
+                                 kHashBufferSize)]);
+  std::unique_ptr<crypto::SecureHash> hash =
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256);
+  while (length > 0) {
+    const int chunk =
+        static_cast<int>(std::min<int64_t>(length, kHashBufferSize));
+    if (file->Read(offset, buffer.get(), chunk) != chunk)
+      return false;
+    hash->Update(buffer.get(), chunk);
+    offset += chunk;
+    length -= chunk;
+  }
+  hash->Finish(out_hash->data, sizeof(out_hash->data));
+  return true;
+}
+
 }  // namespace
 
 // Helper class to track a range of data prefetched from a file.
@@ -228,6 +277,14 @@ constexpr base::FeatureParam<int> kSimpleCacheTrailerPrefetchSpeculativeBytes{
     &kSimpleCachePrefetchExperiment,
     kSimpleCacheTrailerPrefetchSpeculativeBytesParam, 0};
 
+const base::Feature kSimpleCacheSequentialReadAhead = {
+    "SimpleCacheSequentialReadAhead", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const char kSimpleCacheSequentialReadAheadMinBytesParam[] = "MinStreamBytes";
+constexpr base::FeatureParam<int> kSimpleCacheSequentialReadAheadMinBytes{
+    &kSimpleCacheSequentialReadAhead,
+    kSimpleCacheSequentialReadAheadMinBytesParam, 1024 * 1024};
+
 int GetSimpleCacheFullPrefetchSize() {
   return kSimpleCacheFullPrefetchSize.Get();
 }
@@ -342,6 +399,7 @@ void SimpleSynchronousEntry::OpenEntry(
     const std::string& key,
     const uint64_t entry_hash,
     SimpleFileTracker* file_tracker,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> file_operations,
     int32_t trailer_prefetch_size,
     SimpleEntryCreationResults* out_results) {
@@ -350,6 +408,7 @@ void SimpleSynchronousEntry::OpenEntry(
   auto sync_entry = std::make_unique<SimpleSynchronousEntry>(
       cache_type, path, key, entry_hash, file_tracker,
       std::move(file_operations), trailer_prefetch_size);
+  sync_entry->blob_store_ = std::move(blob_store);
   {
     BackendFileOperations* bound_file_operations = nullptr;
     ScopedFileOperationsBinding binding(sync_entry.get(),
@@ -370,6 +429,7 @@ void SimpleSynchronousEntry::OpenEntry(
   }
   SIMPLE_CACHE_UMA(TIMES, "DiskOpenLatency", cache_type,
                    base::TimeTicks::Now() - start_sync_open_entry);
+  out_results->stream_1_in_blob = sync_entry->stream_1_in_blob_;
   out_results->sync_entry = sync_entry.release();
   out_results->computed_trailer_prefetch_size =
       out_results->sync_entry->computed_trailer_prefetch_size();
@@ -382,6 +442,7 @@ void SimpleSynchronousEntry::CreateEntry(
     const std::string& key,
     const uint64_t entry_hash,
     SimpleFileTracker* file_tracker,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> file_operations,
     SimpleEntryCreationResults* out_results) {
   DCHECK_EQ(entry_hash, GetEntryHashKey(key));
@@ -390,6 +451,7 @@ void SimpleSynchronousEntry::CreateEntry(
   auto sync_entry = std::make_unique<SimpleSynchronousEntry>(
       cache_type, path, key, entry_hash, file_tracker,
       std::move(file_operations), -1);
+  sync_entry->blob_store_ = std::move(blob_store);
   {
     BackendFileOperations* bound_file_operations = nullptr;
     ScopedFileOperationsBinding binding(sync_entry.get(),
@@ -421,6 +483,7 @@ void SimpleSynchronousEntry::OpenOrCreateEntry(
     OpenEntryIndexEnum index_state,
     bool optimistic_create,
     SimpleFileTracker* file_tracker,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> file_operations,
     int32_t trailer_prefetch_size,
     SimpleEntryCreationResults* out_results) {
@@ -430,6 +493,7 @@ void SimpleSynchronousEntry::OpenOrCreateEntry(
     auto sync_entry = std::make_unique<SimpleSynchronousEntry>(
         cache_type, path, key, entry_hash, file_tracker,
         std::move(file_operations), trailer_prefetch_size);
+    sync_entry->blob_store_ = blob_store;
     {
       BackendFileOperations* bound_file_operations = nullptr;
       ScopedFileOperationsBinding binding(sync_entry.get(),
@@ -453,7 +517,8 @@ void SimpleSynchronousEntry::OpenOrCreateEntry(
           file_operations = std::move(sync_entry->unbound_file_operations_);
           sync_entry = nullptr;
           CreateEntry(cache_type, path, key, entry_hash, file_tracker,
-                      std::move(file_operations), out_results);
+                      std::move(blob_store), std::move(file_operations),
+                      out_results);
           return;
         }
         // Otherwise can just try opening.
@@ -471,14 +536,14 @@ void SimpleSynchronousEntry::OpenOrCreateEntry(
 
   DCHECK(file_operations);
   // Try open, then if that fails create.
-  OpenEntry(cache_type, path, key, entry_hash, file_tracker,
+  OpenEntry(cache_type, path, key, entry_hash, file_tracker, blob_store,
             std::move(file_operations), trailer_prefetch_size, out_results);
   if (out_results->sync_entry)
     return;
   file_operations = std::move(out_results->unbound_file_operations);
   DCHECK(file_operations);
   CreateEntry(cache_type, path, key, entry_hash, file_tracker,
-              std::move(file_operations), out_results);
+              std::move(blob_store), std::move(file_operations), out_results);
 }
 
 // static
@@ -486,11 +551,12 @@ int SimpleSynchronousEntry::DeleteEntryFiles(
     const FilePath& path,
     net::CacheType cache_type,
     uint64_t entry_hash,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> unbound_file_operations) {
   auto file_operations =
       unbound_file_operations->Bind(base::SequencedTaskRunnerHandle::Get());
   return DeleteEntryFilesInternal(path, cache_type, entry_hash,
-                                  file_operations.get());
+                                  blob_store.get(), file_operations.get());
 }
 
 // static
@@ -498,10 +564,13 @@ int SimpleSynchronousEntry::DeleteEntryFilesInternal(
     const FilePath& path,
     net::CacheType cache_type,
     uint64_t entry_hash,
+    SimpleBlobStore* blob_store,
     BackendFileOperations* file_operations) {
   base::TimeTicks start = base::TimeTicks::Now();
   const bool deleted_well =
       DeleteFilesForEntryHash(path, entry_hash, file_operations);
+  if (blob_store)
+    blob_store->ReleaseReference(file_operations, entry_hash);
   SIMPLE_CACHE_UMA(TIMES, "DiskDoomLatency", cache_type,
                    base::TimeTicks::Now() - start);
   return deleted_well ? net::OK : net::ERR_FAILED;
@@ -537,6 +606,11 @@ int SimpleSynchronousEntry::DoomInternal(
       }
     }
 
+    // The blob, if any, stays readable through |stream_1_blob_file_|, but
+    // belongs to the entry's name, which may soon be used by a new entry.
+    if (blob_store_)
+      blob_store_->ReleaseReference(file_operations, orig_key.entry_hash);
+
     if (sparse_file_open()) {
       base::File::Error out_error;
       FilePath old_name =
@@ -553,8 +627,9 @@ int SimpleSynchronousEntry::DoomInternal(
   } else {
     // No one has ever called Create or Open on us, so we don't have to worry
     // about being accessible to other ops after doom.
-    return DeleteEntryFilesInternal(
-        path_, cache_type_, entry_file_key_.entry_hash, file_operations);
+    return DeleteEntryFilesInternal(path_, cache_type_,
+                                    entry_file_key_.entry_hash,
+                                    blob_store_.get(), file_operations);
   }
 }
 
@@ -562,11 +637,14 @@ int SimpleSynchronousEntry::DoomInternal(
 int SimpleSynchronousEntry::TruncateEntryFiles(
     const base::FilePath& path,
     uint64_t entry_hash,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> unbound_file_operations) {
   auto file_operations =
       unbound_file_operations->Bind(base::SequencedTaskRunnerHandle::Get());
   const bool deleted_well =
       TruncateFilesForEntryHash(path, entry_hash, file_operations.get());
+  if (blob_store)
+    blob_store->ReleaseReference(file_operations.get(), entry_hash);
   return deleted_well ? net::OK : net::ERR_FAILED;
 }
 
@@ -574,15 +652,19 @@ int SimpleSynchronousEntry::TruncateEntryFiles(
 int SimpleSynchronousEntry::DeleteEntrySetFiles(
     const std::vector<uint64_t>* key_hashes,
     const FilePath& path,
+    scoped_refptr<SimpleBlobStore> blob_store,
     std::unique_ptr<UnboundBackendFileOperations> unbound_file_operations) {
   auto file_operations =
       unbound_file_operations->Bind(base::SequencedTaskRunnerHandle::Get());
-  const size_t did_delete_count =
-      std::count_if(key_hashes->begin(), key_hashes->end(),
-                    [&path, &file_operations](const uint64_t& key_hash) {
-                      return SimpleSynchronousEntry::DeleteFilesForEntryHash(
-                          path, key_hash, file_operations.get());
-                    });
+  const size_t did_delete_count = std::count_if(
+      key_hashes->begin(), key_hashes->end(),
+      [&path, &blob_store, &file_operations](const uint64_t& key_hash) {
+        const bool deleted = SimpleSynchronousEntry::DeleteFilesForEntryHash(
+            path, key_hash, file_operations.get());
+        if (blob_store)
+          blob_store->ReleaseReference(file_operations.get(), key_hash);
+        return deleted;
+      });
   return (did_delete_count == key_hashes->size()) ? net::OK : net::ERR_FAILED;
 }
 
@@ -605,14 +687,27 @@ void SimpleSynchronousEntry::ReadData(const ReadRequest& in_entry_op,
     DoomInternal(file_operations);
     return;
   }
-  const int64_t file_offset = entry_stat->GetOffsetInFile(
+  base::File* data_file = file.get();
+  int64_t file_offset = entry_stat->GetOffsetInFile(
       key_.size(), in_entry_op.offset, in_entry_op.index);
+  if (in_entry_op.index == 1 && stream_1_in_blob_) {
+    data_file = &stream_1_blob_file_;
+    file_offset = in_entry_op.offset;
+  }
   // Zero-length reads and reads to the empty streams of omitted files should
   // be handled in the SimpleEntryImpl.
   DCHECK_GT(in_entry_op.buf_len, 0);
   DCHECK(!empty_file_omitted_[file_index]);
+  // A read from the start of a large stream is most likely the first of a
+  // series covering all of it, e.g. a media file being played back.
+  if (in_entry_op.offset == 0 &&
+      base::FeatureList::IsEnabled(kSimpleCacheSequentialReadAhead) &&
+      entry_stat->data_size(in_entry_op.index) >=
+          kSimpleCacheSequentialReadAheadMinBytes.Get()) {
+    simple_util::SimpleCacheAdviseSequentialRead(data_file);
+  }
   int bytes_read =
-      file->Read(file_offset, out_buf->data(), in_entry_op.buf_len);
+      data_file->Read(file_offset, out_buf->data(), in_entry_op.buf_len);
   if (bytes_read > 0) {
     entry_stat->set_last_used(Time::Now());
     if (in_entry_op.request_update_crc) {
@@ -707,6 +802,19 @@ void SimpleSynchronousEntry::WriteData(const WriteRequest& in_entry_op,
     return;
   }
 
+  if (index == 1 && stream_1_in_blob_) {
+    // Only what the write leaves in place needs to come back from the blob.
+    const int keep_size =
+        truncate ? std::min(offset, out_entry_stat->data_size(1))
+                 : out_entry_stat->data_size(1);
+    if (!MoveStream1OutOfBlob(file_operations, file.get(), keep_size)) {
+      RecordWriteResult(cache_type_, SYNC_WRITE_RESULT_WRITE_FAILURE);
+      DoomInternal(file_operations);
+      out_write_result->result = net::ERR_CACHE_WRITE_FAILURE;
+      return;
+    }
+  }
+
   if (extending_by_write) {
     // The EOF record and the eventual stream afterward need to be zeroed out.
     const int64_t file_eof_offset =
@@ -747,6 +855,9 @@ void SimpleSynchronousEntry::WriteData(const WriteRequest& in_entry_op,
     out_write_result->crc_updated = true;
   }
 
+  if (index == 1 && blob_store_)
+    UpdateStream1Hash(offset, buf_len > 0 ? in_buf->data() : nullptr, buf_len);
+
   SIMPLE_CACHE_UMA(TIMES, "DiskWriteLatency", cache_type_,
                    write_time.Elapsed());
   RecordWriteResult(cache_type_, SYNC_WRITE_RESULT_SUCCESS);
@@ -1003,7 +1114,8 @@ int SimpleSynchronousEntry::CheckEOFRecord(
     uint32_t expected_crc32) {
   DCHECK(initialized_);
   SimpleFileEOF eof_record;
-  int file_offset = entry_stat.GetEOFOffsetInFile(key_.size(), stream_index);
+  int file_offset =
+      GetFileLayout(entry_stat).GetEOFOffsetInFile(key_.size(), stream_index);
   int file_index = GetFileIndexFromStreamIndex(stream_index);
   int rv =
       GetEOFRecordData(file, nullptr, file_index, file_offset, &eof_record);
@@ -1067,6 +1179,21 @@ void SimpleSynchronousEntry::Close(
   base::ElapsedTimer close_time;
   DCHECK(stream_0_data);
 
+  // Stream 1 moving to a blob changes where stream 0 goes, which is fine since
+  // writing stream 1 always has stream 0 rewritten as well.
+  const bool stream_1_written = std::any_of(
+      crc32s_to_write->begin(), crc32s_to_write->end(),
+      [](const CRCRecord& record) { return record.index == 1; });
+  if (stream_1_written) {
+    MaybeMoveStream1ToBlob(file_operations.get(), entry_stat,
+                           &out_results->first_copy_entry_hash);
+  } else if (!stream_1_in_blob_) {
+    MaybeMoveFirstCopyToBlob(file_operations.get(), entry_stat,
+                             crc32s_to_write.get());
+  }
+  out_results->stream_1_in_blob = stream_1_in_blob_;
+  const SimpleEntryStat file_layout = GetFileLayout(entry_stat);
+
   for (auto it = crc32s_to_write->begin(); it != crc32s_to_write->end(); ++it) {
     const int stream_index = it->index;
     const int file_index = GetFileIndexFromStreamIndex(stream_index);
@@ -1083,7 +1210,7 @@ void SimpleSynchronousEntry::Close(
 
     if (stream_index == 0) {
       // Write stream 0 data.
-      int stream_0_offset = entry_stat.GetOffsetInFile(key_.size(), 0, 0);
+      int stream_0_offset = file_layout.GetOffsetInFile(key_.size(), 0, 0);
       if (file->Write(stream_0_offset, stream_0_data->data(),
                       entry_stat.data_size(0)) != entry_stat.data_size(0)) {
         RecordCloseResult(cache_type_, CLOSE_RESULT_WRITE_FAILURE);
@@ -1113,6 +1240,21 @@ void SimpleSynchronousEntry::Close(
           entry_stat.data_size(0) + sizeof(hash_value) + sizeof(SimpleFileEOF);
     }
 
+    if (stream_index == 1 && stream_1_in_blob_) {
+      // Write the reference to the blob in place of the data.
+      const int stream_1_offset =
+          file_layout.GetOffsetInFile(key_.size(), 0, 1);
+      if (file->Write(stream_1_offset,
+                      reinterpret_cast<const char*>(stream_1_blob_hash_.data),
+                      sizeof(stream_1_blob_hash_)) !=
+          sizeof(stream_1_blob_hash_)) {
+        RecordCloseResult(cache_type_, CLOSE_RESULT_WRITE_FAILURE);
+        DVLOG(1) << "Could not write stream 1 blob reference.";
+        DoomInternal(file_operations.get());
+        break;
+      }
+    }
+
     SimpleFileEOF eof_record;
     eof_record.stream_size = entry_stat.data_size(stream_index);
     eof_record.final_magic_number = kSimpleFinalMagicNumber;
@@ -1121,8 +1263,10 @@ void SimpleSynchronousEntry::Close(
       eof_record.flags |= SimpleFileEOF::FLAG_HAS_CRC32;
     if (stream_index == 0)
       eof_record.flags |= SimpleFileEOF::FLAG_HAS_KEY_SHA256;
+    if (stream_index == 1 && stream_1_in_blob_)
+      eof_record.flags |= SimpleFileEOF::FLAG_STREAM_IN_BLOB;
     eof_record.data_crc32 = it->data_crc32;
-    int eof_offset = entry_stat.GetEOFOffsetInFile(key_.size(), stream_index);
+    int eof_offset = file_layout.GetEOFOffsetInFile(key_.size(), stream_index);
     // If stream 0 changed size, the file needs to be resized, otherwise the
     // next open will yield wrong stream sizes. On stream 1 and stream 2 proper
     // resizing of the file is handled in SimpleSynchronousEntry::WriteData().
@@ -1661,13 +1805,32 @@ int SimpleSynchronousEntry::ReadAndValidateStream0AndMaybe1(
   computed_trailer_prefetch_size_ =
       prefetch_data.GetDesiredTrailerPrefetchSize();
 
+  // A stream 1 the size of a SHA-256 may be a reference to a blob, which
+  // its EOF record tells.
+  if (has_key_sha256 &&
+      stream1_size == static_cast<int32_t>(sizeof(net::SHA256HashValue))) {
+    SimpleFileEOF stream_1_eof;
+    rv = GetEOFRecordData(
+        file.get(), &prefetch_data, /* file_index = */ 0,
+        out_entry_stat->GetEOFOffsetInFile(key_.size(), /* stream_index = */ 1),
+        &stream_1_eof);
+    if (rv != net::OK)
+      return rv;
+    if (stream_1_eof.flags & SimpleFileEOF::FLAG_STREAM_IN_BLOB) {
+      rv = OpenStream1Blob(file_operations, file.get(), &prefetch_data,
+                           stream_1_eof, out_entry_stat);
+      if (rv != net::OK)
+        return rv;
+    }
+  }
+
   // If prefetch buffer is available, and we have sha256(key) (so we don't need
   // to look at the header), extract out stream 1 info as well.
   int stream_1_offset = out_entry_stat->GetOffsetInFile(
       key_.size(), /* offset= */ 0, /* stream_index = */ 1);
   int stream_1_read_size =
       sizeof(SimpleFileEOF) + out_entry_stat->data_size(/* stream_index = */ 1);
-  if (has_key_sha256 &&
+  if (has_key_sha256 && !stream_1_in_blob_ &&
       prefetch_data.HasData(stream_1_offset, stream_1_read_size)) {
     SimpleFileEOF stream_1_eof;
     int stream_1_eof_offset =
@@ -1762,6 +1925,191 @@ int SimpleSynchronousEntry::GetEOFRecordData(base::File* file,
   return net::OK;
 }
 
+SimpleEntryStat SimpleSynchronousEntry::GetFileLayout(
+    const SimpleEntryStat& entry_stat) const {
+  SimpleEntryStat file_layout = entry_stat;
+  if (stream_1_in_blob_)
+    file_layout.set_data_size(1, sizeof(net::SHA256HashValue));
+  return file_layout;
+}
+
+void SimpleSynchronousEntry::UpdateStream1Hash(int offset,
+                                               const char* buf,
+                                               int buf_len) {
+  // A write at the start replaces whatever was hashed so far.
+  if (offset == 0) {
+    stream_1_hash_ = crypto::SecureHash::Create(crypto::SecureHash::SHA256);
+    stream_1_hashed_size_ = 0;
+  }
+  if (!stream_1_hash_)
+    return;
+  if (offset != stream_1_hashed_size_) {
+    stream_1_hash_.reset();
+    return;
+  }
+  if (buf_len > 0)
+    stream_1_hash_->Update(buf, buf_len);
+  stream_1_hashed_size_ += buf_len;
+}
+
+bool SimpleSynchronousEntry::MaybeMoveStream1ToBlob(
+    BackendFileOperations* file_operations,
+    const SimpleEntryStat& entry_stat,
+    absl::optional<uint64_t>* out_first_copy_entry_hash) {
+  DCHECK(!stream_1_in_blob_);
+  const int32_t stream_1_size = entry_stat.data_size(1);
+  if (!blob_store_ || !stream_1_hash_ ||
+      stream_1_hashed_size_ != stream_1_size ||
+      stream_1_size < GetSimpleCacheDeduplicationMinBytes() ||
+      entry_file_key_.doom_generation != 0u) {
+    return false;
+  }
+
+  net::SHA256HashValue hash;
+  stream_1_hash_->Finish(hash.data, sizeof(hash.data));
+  stream_1_hash_.reset();
+
+  const uint64_t entry_hash = entry_file_key_.entry_hash;
+  switch (blob_store_->AddReference(file_operations, entry_hash, hash)) {
+    case SimpleBlobStore::Disposition::kKeepInline:
+      return false;
+    case SimpleBlobStore::Disposition::kReferenced:
+      break;
+    case SimpleBlobStore::Disposition::kCreateBlob: {
+      SimpleFileTracker::FileHandle file =
+          file_tracker_->Acquire(file_operations, this, SubFileForFileIndex(0));
+      const base::FilePath temp_path = blob_store_->GetTempFilePath(entry_hash);
+      base::File blob = file_operations->OpenFile(
+          temp_path, base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE |
+                         base::File::FLAG_WIN_SHARE_DELETE);
+      const bool copied =
+          file.IsOK() && blob.IsValid() &&
+          CopyFileRange(file.get(),
+                        entry_stat.GetOffsetInFile(key_.size(), 0, 1), &blob,
+                        0, stream_1_size);
+      blob.Close();
+      if (!copied) {
+        file_operations->DeleteFile(temp_path);
+        return false;
+      }
+      if (!blob_store_->CommitBlob(file_operations, entry_hash, hash,
+                                   stream_1_size, out_first_copy_entry_hash)) {
+        return false;
+      }
+      break;
+    }
+  }
+
+  stream_1_in_blob_ = true;
+  stream_1_blob_hash_ = hash;
+  return true;
+}
+
+bool SimpleSynchronousEntry::MaybeMoveFirstCopyToBlob(
+    BackendFileOperations* file_operations,
+    const SimpleEntryStat& entry_stat,
+    std::vector<CRCRecord>* crc32s_to_write) {
+  DCHECK(!stream_1_in_blob_);
+  if (!blob_store_ || entry_file_key_.doom_generation != 0u)
+    return false;
+  const uint64_t entry_hash = entry_file_key_.entry_hash;
+  const absl::optional<net::SHA256HashValue> hash =
+      blob_store_->TakePendingMove(entry_hash);
+  const int32_t stream_1_size = entry_stat.data_size(1);
+  if (!hash || stream_1_size < GetSimpleCacheDeduplicationMinBytes())
+    return false;
+
+  // The store only knows what stream 1 held when it was last written, so
+  // check that it still does.
+  SimpleFileTracker::FileHandle file =
+      file_tracker_->Acquire(file_operations, this, SubFileForFileIndex(0));
+  if (!file.IsOK())
+    return false;
+  SimpleFileEOF stream_1_eof;
+  if (GetEOFRecordData(file.get(), /* prefetch_data = */ nullptr,
+                       /* file_index = */ 0,
+                       entry_stat.GetEOFOffsetInFile(key_.size(), 1),
+                       &stream_1_eof) != net::OK) {
+    return false;
+  }
+  net::SHA256HashValue contents_hash;
+  if (!HashFileRange(file.get(), entry_stat.GetOffsetInFile(key_.size(), 0, 1),
+                     stream_1_size, &contents_hash) ||
+      !(contents_hash == *hash)) {
+    return false;
+  }
+  // The blob may be gone already, if all the entries using it were.
+  if (blob_store_->AddReference(file_operations, entry_hash, *hash) !=
+      SimpleBlobStore::Disposition::kReferenced) {
+    return false;
+  }
+
+  stream_1_in_blob_ = true;
+  stream_1_blob_hash_ = *hash;
+  // Stream 1 is replaced by the blob reference, and stream 0 moves up.
+  if (std::none_of(crc32s_to_write->begin(), crc32s_to_write->end(),
+                   [](const CRCRecord& record) { return record.index == 0; })) {
+    crc32s_to_write->push_back(CRCRecord(0, false, 0));
+  }
+  crc32s_to_write->push_back(CRCRecord(
+      1, (stream_1_eof.flags & SimpleFileEOF::FLAG_HAS_CRC32) != 0,
+      stream_1_eof.data_crc32));
+  return true;
+}
+
+bool SimpleSynchronousEntry::MoveStream1OutOfBlob(
+    BackendFileOperations* file_operations,
+    base::File* file,
+    int keep_size) {
+  DCHECK(stream_1_in_blob_);
+  DCHECK(blob_store_);
+  const int64_t stream_1_offset = sizeof(SimpleFileHeader) + key_.size();
+  if (!CopyFileRange(&stream_1_blob_file_, 0, file, stream_1_offset,
+                     keep_size)) {
+    return false;
+  }
+  stream_1_blob_file_.Close();
+  stream_1_in_blob_ = false;
+  // A doomed entry already gave up the reference, which may by now belong to
+  // a new entry with the same name.
+  if (entry_file_key_.doom_generation == 0u) {
+    blob_store_->ReleaseReference(file_operations,
+                                  entry_file_key_.entry_hash);
+  }
+  return true;
+}
+
+int SimpleSynchronousEntry::OpenStream1Blob(
+    BackendFileOperations* file_operations,
+    base::File* file,
+    PrefetchData* prefetch_data,
+    const SimpleFileEOF& stream_1_eof,
+    SimpleEntryStat* out_entry_stat) {
+  // Without a blob store, e.g. after deduplication got turned off, the data
+  // is out of reach.
+  if (!blob_store_)
+    return net::ERR_FAILED;
+
+  net::SHA256HashValue hash;
+  if (!ReadFromFileOrPrefetched(
+          file, prefetch_data, /* file_index = */ 0,
+          out_entry_stat->GetOffsetInFile(key_.size(), /* offset = */ 0,
+                                          /* stream_index = */ 1),
+          sizeof(hash.data), reinterpret_cast<char*>(hash.data))) {
+    return net::ERR_FAILED;
+  }
+  base::File blob = blob_store_->OpenBlob(file_operations,
+                                          entry_file_key_.entry_hash, hash);
+  if (!blob.IsValid() || blob.GetLength() != stream_1_eof.stream_size)
+    return net::ERR_FAILED;
+
+  stream_1_blob_file_ = std::move(blob);
+  stream_1_blob_hash_ = hash;
+  stream_1_in_blob_ = true;
+  out_entry_stat->set_data_size(1, stream_1_eof.stream_size);
+  return net::OK;
+}
+
 // static
 bool SimpleSynchronousEntry::DeleteFileForEntryHash(
     const FilePath& path,
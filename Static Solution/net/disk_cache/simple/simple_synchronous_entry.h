@@ -23,11 +23,17 @@
 #include "base/strings/string_piece_forward.h"
 #include "base/time/time.h"
 #include "net/base/cache_type.h"
+#include "net/base/hash_value.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/disk_cache/simple/simple_entry_format.h"
 #include "net/disk_cache/simple/simple_file_tracker.h"
 #include "net/disk_cache/simple/simple_histogram_enums.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace crypto {
+class SecureHash;
+}
 
 namespace net {
 class GrowableIOBuffer;
@@ -39,6 +45,7 @@ FORWARD_DECLARE_TEST(DiskCacheBackendTest, SimpleCacheEnumerationLongKeys);
 namespace disk_cache {
 
 class BackendFileOperations;
+class SimpleBlobStore;
 class UnboundBackendFileOperations;
 
 NET_EXPORT_PRIVATE extern const base::Feature kSimpleCachePrefetchExperiment;
@@ -46,6 +53,12 @@ NET_EXPORT_PRIVATE extern const char kSimpleCacheFullPrefetchBytesParam[];
 NET_EXPORT_PRIVATE extern const char
     kSimpleCacheTrailerPrefetchSpeculativeBytesParam[];
 
+// When enabled, reading a stream of at least MinStreamBytes from its start
+// tells the OS to read the entry file ahead aggressively.
+NET_EXPORT_PRIVATE extern const base::Feature kSimpleCacheSequentialReadAhead;
+NET_EXPORT_PRIVATE extern const char
+    kSimpleCacheSequentialReadAheadMinBytesParam[];
+
 // Returns how large a file would get prefetched on reading the entry.
 // If the experiment is disabled, returns 0.
 NET_EXPORT_PRIVATE int GetSimpleCachePrefetchSize();
@@ -115,10 +128,17 @@ struct SimpleEntryCreationResults {
   int32_t computed_trailer_prefetch_size = -1;
   int result = net::OK;
   bool created = false;
+  // True if stream 1 is kept in a SimpleBlobStore blob.
+  bool stream_1_in_blob = false;
 };
 
 struct SimpleEntryCloseResults {
   int32_t estimated_trailer_prefetch_size = -1;
+  // True if stream 1 is kept in a SimpleBlobStore blob.
+  bool stream_1_in_blob = false;
+  // Set if stream 1 went into a new blob, and another entry has a copy of it
+  // that should move there too. See SimpleBlobStore::CommitBlob().
+  absl::optional<uint64_t> first_copy_entry_hash;
 };
 
 // Worker thread interface to the very simple cache. This interface is not
@@ -208,6 +228,7 @@ class SimpleSynchronousEntry {
       const std::string& key,
       uint64_t entry_hash,
       SimpleFileTracker* file_tracker,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> file_operations,
       int32_t trailer_prefetch_size,
       SimpleEntryCreationResults* out_results);
@@ -218,6 +239,7 @@ class SimpleSynchronousEntry {
       const std::string& key,
       uint64_t entry_hash,
       SimpleFileTracker* file_tracker,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> file_operations,
       SimpleEntryCreationResults* out_results);
 
@@ -229,6 +251,7 @@ class SimpleSynchronousEntry {
       OpenEntryIndexEnum index_state,
       bool optimistic_create,
       SimpleFileTracker* file_tracker,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> file_operations,
       int32_t trailer_prefetch_size,
       SimpleEntryCreationResults* out_results);
@@ -241,11 +264,13 @@ class SimpleSynchronousEntry {
 
   // Deletes an entry from the file system.  This variant should only be used
   // if there is no actual open instance around, as it doesn't account for
-  // possibility of it having been renamed to a non-standard name.
+  // possibility of it having been renamed to a non-standard name. Also drops
+  // the entry's reference in |blob_store|, which may be null.
   static int DeleteEntryFiles(
       const base::FilePath& path,
       net::CacheType cache_type,
       uint64_t entry_hash,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> unbound_file_operations);
 
   // Like |DeleteEntryFiles()| above, except that it truncates the entry files
@@ -255,6 +280,7 @@ class SimpleSynchronousEntry {
   static int TruncateEntryFiles(
       const base::FilePath& path,
       uint64_t entry_hash,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> file_operations);
 
   // Like |DeleteEntryFiles()| above. Deletes all entries corresponding to the
@@ -263,6 +289,7 @@ class SimpleSynchronousEntry {
   static int DeleteEntrySetFiles(
       const std::vector<uint64_t>* key_hashes,
       const base::FilePath& path,
+      scoped_refptr<SimpleBlobStore> blob_store,
       std::unique_ptr<UnboundBackendFileOperations> unbound_file_operations);
 
   // N.B. ReadData(), WriteData(), CheckEOFRecord(), ReadSparseData(),
@@ -471,9 +498,50 @@ class SimpleSynchronousEntry {
                          int len,
                          const char* buf);
 
+  // Returns |entry_stat| as it applies to the layout of file 0, where stream 1
+  // may be just a reference to a blob.
+  SimpleEntryStat GetFileLayout(const SimpleEntryStat& entry_stat) const;
+
+  // Keeps |stream_1_hash_| up to date with a write of |buf_len| bytes of |buf|
+  // at |offset| of stream 1.
+  void UpdateStream1Hash(int offset, const char* buf, int buf_len);
+
+  // Looks up stream 1 in |blob_store_|, once it has been written completely
+  // and sequentially, and if it duplicates other entries switches to
+  // referencing a shared blob. Returns true if stream 1 is now in a blob; the
+  // caller still has to rewrite the rest of file 0 to match.
+  bool MaybeMoveStream1ToBlob(
+      BackendFileOperations* file_operations,
+      const SimpleEntryStat& entry_stat,
+      absl::optional<uint64_t>* out_first_copy_entry_hash);
+
+  // Switches stream 1 to referencing a blob if another entry has since found
+  // it to be a duplicate, and it still has the same contents; see
+  // SimpleBlobStore::TakePendingMove(). Appends what Close() then needs to
+  // rewrite to |crc32s_to_write|. Returns true if stream 1 is now in a blob.
+  bool MaybeMoveFirstCopyToBlob(BackendFileOperations* file_operations,
+                                const SimpleEntryStat& entry_stat,
+                                std::vector<CRCRecord>* crc32s_to_write);
+
+  // Copies the first |keep_size| bytes of the blob stream 1 is in back into
+  // file 0, and drops the reference to the blob. Used before writing to
+  // stream 1, since blobs are shared and immutable.
+  bool MoveStream1OutOfBlob(BackendFileOperations* file_operations,
+                            base::File* file,
+                            int keep_size);
+
+  // Opens the blob that stream 1 is in according to |stream_1_eof|, and sets
+  // the stream's size from it.
+  int OpenStream1Blob(BackendFileOperations* file_operations,
+                      base::File* file,
+                      PrefetchData* prefetch_data,
+                      const SimpleFileEOF& stream_1_eof,
+                      SimpleEntryStat* out_entry_stat);
+
   static int DeleteEntryFilesInternal(const base::FilePath& path,
                                       net::CacheType cache_type,
                                       uint64_t entry_hash,
+                                      SimpleBlobStore* blob_store,
                                       BackendFileOperations* file_operations);
 
   static bool DeleteFileForEntryHash(const base::FilePath& path,
@@ -540,6 +608,20 @@ class SimpleSynchronousEntry {
   // Offset of the end of the sparse file (where the next sparse range will be
   // written).
   int64_t sparse_tail_offset_;
+
+  // Null unless kSimpleCacheDeduplication is on.
+  scoped_refptr<SimpleBlobStore> blob_store_;
+
+  // If true, stream 1 is not in file 0 but in |stream_1_blob_file_|, the blob
+  // for |stream_1_blob_hash_|.
+  bool stream_1_in_blob_ = false;
+  net::SHA256HashValue stream_1_blob_hash_;
+  base::File stream_1_blob_file_;
+
+  // SHA-256 of the first |stream_1_hashed_size_| bytes of stream 1, kept
+  // while stream 1 is written sequentially from its start. Null otherwise.
+  std::unique_ptr<crypto::SecureHash> stream_1_hash_;
+  int32_t stream_1_hashed_size_ = 0;
 };
 
 }  // namespace disk_cache
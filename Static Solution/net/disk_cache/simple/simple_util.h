@@ -14,6 +14,7 @@
 #include "net/disk_cache/simple/simple_file_tracker.h"
 
 namespace base {
+class File;
 class FilePath;
 }
 
@@ -77,6 +78,11 @@ NET_EXPORT_PRIVATE int GetFileIndexFromStreamIndex(int stream_index);
 // file, it is possible to immediately create a new file with the same name.
 NET_EXPORT_PRIVATE bool SimpleCacheDeleteFile(const base::FilePath& path);
 
+// Tells the OS that |file| is about to be read through from start to end, so
+// that it can read ahead further than it would for random access. This is
+// only a hint, and does nothing on platforms that lack a way to give it.
+void SimpleCacheAdviseSequentialRead(base::File* file);
+
 uint32_t Crc32(const char* data, int length);
 
 uint32_t IncrementalCrc32(uint32_t previous_crc, const char* data, int length);
@@ -4,7 +4,11 @@
 
 #include "net/disk_cache/simple/simple_util.h"
 
+#include <fcntl.h>
+
+#include "base/files/file.h"
 #include "base/files/file_util.h"
+#include "build/build_config.h"
 
 namespace disk_cache::simple_util {
 
@@ -12,4 +16,11 @@ bool SimpleCacheDeleteFile(const base::FilePath& path) {
   return base::DeleteFile(path);
 }
 
+void SimpleCacheAdviseSequentialRead(base::File* file) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  // A failure here only loses the hint, so the result is ignored.
+  posix_fadvise(file->GetPlatformFile(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
 }  // namespace disk_cache::simple_util
@@ -6,6 +6,7 @@
 
 #include <windows.h>
 
+#include "base/files/file.h"
 #include "base/files/file_util.h"
 #include "base/format_macros.h"
 #include "base/rand_util.h"
@@ -41,5 +42,10 @@ bool SimpleCacheDeleteFile(const base::FilePath& path) {
   return base::DeleteFile(path);
 }
 
+void SimpleCacheAdviseSequentialRead(base::File* file) {
+  // Windows only takes this hint when the file is opened, with
+  // FILE_FLAG_SEQUENTIAL_SCAN, and entry files are opened for random access.
+}
+
 }  // namespace simple_util
 }  // namespace disk_cache
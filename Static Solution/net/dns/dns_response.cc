@@ -124,11 +124,12 @@ DnsRecordParser::DnsRecordParser(const void* packet,
   DCHECK_LE(offset, length);
 }
 
-unsigned DnsRecordParser::ReadName(const void* const vpos,
-                                   std::string* out) const {
+template <typename LabelVisitor>
+unsigned DnsRecordParser::WalkName(const char* const pos,
+                                   bool stop_at_pointer,
+                                   LabelVisitor visitor) const {
   static const char kAbortMsg[] = "Abort parsing of noncompliant DNS record.";
 
-  const char* const pos = reinterpret_cast<const char*>(vpos);
   DCHECK(packet_);
   DCHECK_LE(packet_, pos);
   DCHECK_LE(pos, packet_ + length_);
@@ -149,11 +150,6 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
   if (pos >= end)
     return 0;
 
-  if (out) {
-    out->clear();
-    out->reserve(dns_protocol::kMaxCharNameLength);
-  }
-
   for (;;) {
     // The first two bits of the length give the type of the length. It's
     // either a direct length or a pointer to the remainder of the name.
@@ -165,7 +161,7 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
         }
         if (consumed == 0) {
           consumed = p - pos + sizeof(uint16_t);
-          if (!out)
+          if (stop_at_pointer)
             return consumed;  // If name is not stored, that's all we need.
         }
         seen += sizeof(uint16_t);
@@ -205,12 +201,7 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
           VLOG(1) << kAbortMsg << " Truncated or missing label.";
           return 0;  // Truncated or missing label.
         }
-        if (out) {
-          if (!out->empty())
-            out->append(".");
-          out->append(p, label_len);
-          DCHECK_LE(out->size(), dns_protocol::kMaxCharNameLength);
-        }
+        visitor(p, label_len);
         p += label_len;
         seen += 1 + label_len;
         break;
@@ -223,6 +214,55 @@ unsigned DnsRecordParser::ReadName(const void* const vpos,
   }
 }
 
+unsigned DnsRecordParser::ReadName(const void* const vpos,
+                                   std::string* out) const {
+  const char* const pos = reinterpret_cast<const char*>(vpos);
+  if (out && pos < packet_ + length_) {
+    out->clear();
+    out->reserve(dns_protocol::kMaxCharNameLength);
+  }
+
+  return WalkName(pos, /*stop_at_pointer=*/!out,
+                  [out](const char* label, uint8_t label_len) {
+                    if (out) {
+                      if (!out->empty())
+                        out->append(".");
+                      out->append(label, label_len);
+                      DCHECK_LE(out->size(), dns_protocol::kMaxCharNameLength);
+                    }
+                  });
+}
+
+bool DnsRecordParser::NameEquals(const void* pos,
+                                 base::StringPiece dotted_name) const {
+  base::StringPiece remaining = dotted_name;
+  bool first_label = true;
+  bool equal = true;
+  unsigned consumed = WalkName(
+      reinterpret_cast<const char*>(pos), /*stop_at_pointer=*/false,
+      [&](const char* label, uint8_t label_len) {
+        if (!equal)
+          return;
+        if (!first_label) {
+          if (remaining.empty() || remaining.front() != '.') {
+            equal = false;
+            return;
+          }
+          remaining.remove_prefix(1);
+        }
+        first_label = false;
+        if (remaining.size() < label_len ||
+            !base::EqualsCaseInsensitiveASCII(
+                base::StringPiece(label, label_len),
+                remaining.substr(0, label_len))) {
+          equal = false;
+          return;
+        }
+        remaining.remove_prefix(label_len);
+      });
+  return consumed && equal && remaining.empty();
+}
+
 bool DnsRecordParser::ReadRecord(DnsResourceRecord* out) {
   DCHECK(packet_);
 
@@ -233,15 +273,40 @@ bool DnsRecordParser::ReadRecord(DnsResourceRecord* out) {
   size_t consumed = ReadName(cur_, &out->name);
   if (!consumed)
     return false;
+  return ReadRecordFields(consumed, &out->type, &out->klass, &out->ttl,
+                          &out->rdata);
+}
+
+bool DnsRecordParser::ReadRecordView(DnsRecordView* out) {
+  DCHECK(packet_);
+
+  // Disallow parsing any more than the claimed number of records.
+  if (num_records_parsed_ >= num_records_)
+    return false;
+
+  // Walk the whole name rather than stop at the first pointer, so that the
+  // name is validated the same way as by ReadRecord() whichever section the
+  // record is in, even if the caller never decodes it.
+  size_t consumed = WalkName(cur_, /*stop_at_pointer=*/false,
+                             [](const char*, uint8_t) {});
+  if (!consumed)
+    return false;
+  out->name = cur_;
+  return ReadRecordFields(consumed, &out->type, &out->klass, &out->ttl,
+                          &out->rdata);
+}
+
+bool DnsRecordParser::ReadRecordFields(size_t name_len,
+                                       uint16_t* type,
+                                       uint16_t* klass,
+                                       uint32_t* ttl,
+                                       base::StringPiece* rdata) {
   base::BigEndianReader reader(
-      reinterpret_cast<const uint8_t*>(cur_ + consumed),
-      packet_ + length_ - (cur_ + consumed));
+      reinterpret_cast<const uint8_t*>(cur_ + name_len),
+      packet_ + length_ - (cur_ + name_len));
   uint16_t rdlen;
-  if (reader.ReadU16(&out->type) &&
-      reader.ReadU16(&out->klass) &&
-      reader.ReadU32(&out->ttl) &&
-      reader.ReadU16(&rdlen) &&
-      reader.ReadPiece(&out->rdata, rdlen)) {
+  if (reader.ReadU16(type) && reader.ReadU16(klass) && reader.ReadU32(ttl) &&
+      reader.ReadU16(&rdlen) && reader.ReadPiece(rdata, rdlen)) {
     cur_ = reinterpret_cast<const char*>(reader.ptr());
     ++num_records_parsed_;
     return true;
@@ -63,6 +63,19 @@ struct NET_EXPORT_PRIVATE DnsResourceRecord {
   std::string owned_rdata;
 };
 
+// A resource record as it appears in a DNS response packet. Unlike
+// DnsResourceRecord, the owner name is left encoded in the packet, so reading
+// one does not allocate. All pointers are into the packet.
+struct NET_EXPORT_PRIVATE DnsRecordView {
+  // Start of the (possibly compressed) owner name. Can be compared with
+  // DnsRecordParser::NameEquals() or decoded with DnsRecordParser::ReadName().
+  const char* name = nullptr;
+  uint16_t type = 0;
+  uint16_t klass = 0;
+  uint32_t ttl = 0;
+  base::StringPiece rdata;
+};
+
 // Iterator to walk over resource records of the DNS response packet.
 class NET_EXPORT_PRIVATE DnsRecordParser {
  public:
@@ -97,15 +110,41 @@ class NET_EXPORT_PRIVATE DnsRecordParser {
   // See RFC 1035 section 4.1.4.
   unsigned ReadName(const void* pos, std::string* out) const;
 
+  // Returns true if the (possibly compressed) DNS name at |pos| is well-formed
+  // and equal to |dotted_name|, ignoring ASCII case. Equivalent to decoding
+  // the name with ReadName() and comparing it, but does not allocate.
+  bool NameEquals(const void* pos, base::StringPiece dotted_name) const;
+
   // Parses the next resource record into |record|. Returns true if succeeded.
   bool ReadRecord(DnsResourceRecord* record);
 
+  // Like ReadRecord(), but leaves the owner name encoded in the packet. The
+  // name, including its compression pointers, is still validated.
+  bool ReadRecordView(DnsRecordView* record);
+
   // Read a question section, returns true if succeeded. In `DnsResponse`,
   // expected to be called during parse, after which the current offset will be
   // after all questions.
   bool ReadQuestion(std::string& out_dotted_qname, uint16_t& out_qtype);
 
  private:
+  // Walks the DNS name at |pos|, calling |visitor| with each label, and
+  // returns the number of bytes consumed, or 0 on failure. If
+  // |stop_at_pointer|, returns as soon as the bytes consumed are known,
+  // without following label pointers.
+  template <typename LabelVisitor>
+  unsigned WalkName(const char* pos,
+                    bool stop_at_pointer,
+                    LabelVisitor visitor) const;
+
+  // Reads the fields that follow the |name_len| bytes of an owner name at the
+  // current position, and advances past the record.
+  bool ReadRecordFields(size_t name_len,
+                        uint16_t* type,
+                        uint16_t* klass,
+                        uint32_t* ttl,
+                        base::StringPiece* rdata);
+
   const char* packet_ = nullptr;
   size_t length_ = 0;
   size_t num_records_ = 0;
@@ -138,12 +138,11 @@ std::vector<HostPortPair> SortServiceTargets(
   return sorted_targets;
 }
 
-ExtractionError ValidateNamesAndAliases(
-    base::StringPiece query_name,
-    const AliasMap& aliases,
-    const std::vector<std::unique_ptr<const RecordParsed>>& results) {
-  // Validate that all aliases form a single non-looping chain, starting from
-  // `query_name`.
+// Validates that all aliases form a single non-looping chain, starting from
+// `query_name`, and sets `out_final_chain_name` to the end of the chain.
+ExtractionError FollowAliasChain(base::StringPiece query_name,
+                                 const AliasMap& aliases,
+                                 base::StringPiece* out_final_chain_name) {
   size_t aliases_in_chain = 0;
   base::StringPiece final_chain_name = query_name;
   auto alias = aliases.find(std::string(query_name));
@@ -156,6 +155,20 @@ ExtractionError ValidateNamesAndAliases(
   if (aliases_in_chain != aliases.size())
     return ExtractionError::kBadAliasChain;
 
+  *out_final_chain_name = final_chain_name;
+  return ExtractionError::kOk;
+}
+
+ExtractionError ValidateNamesAndAliases(
+    base::StringPiece query_name,
+    const AliasMap& aliases,
+    const std::vector<std::unique_ptr<const RecordParsed>>& results) {
+  base::StringPiece final_chain_name;
+  ExtractionError alias_chain_error =
+      FollowAliasChain(query_name, aliases, &final_chain_name);
+  if (alias_chain_error != ExtractionError::kOk)
+    return alias_chain_error;
+
   // All results must match final alias name.
   for (const auto& result : results) {
     DCHECK_NE(result->type(), dns_protocol::kTypeCNAME);
@@ -167,6 +180,71 @@ ExtractionError ValidateNamesAndAliases(
   return ExtractionError::kOk;
 }
 
+// Reads the authority and additional sections of `response`, which `parser`
+// must be positioned at. For negative responses, sets `response_ttl` from the
+// SOA record, if any, or resets it otherwise.
+void ReadTrailingSections(const DnsResponse& response,
+                          uint16_t result_qtype,
+                          DnsRecordParser* parser,
+                          absl::optional<base::TimeDelta>* response_ttl) {
+  // For NXDOMAIN or NODATA (NOERROR with 0 answers), attempt to find a TTL
+  // via an SOA record.
+  if (response.rcode() == dns_protocol::kRcodeNXDOMAIN ||
+      (response.answer_count() == 0 &&
+       response.rcode() == dns_protocol::kRcodeNOERROR)) {
+    bool soa_found = false;
+    for (unsigned i = 0; i < response.authority_count(); ++i) {
+      DnsRecordView record;
+      if (parser->ReadRecordView(&record) &&
+          record.type == dns_protocol::kTypeSOA) {
+        soa_found = true;
+        base::TimeDelta ttl = base::Seconds(record.ttl);
+        *response_ttl =
+            std::min(response_ttl->value_or(base::TimeDelta::Max()), ttl);
+      }
+    }
+
+    // Per RFC2308, section 5, never cache negative results unless an SOA
+    // record is found.
+    if (!soa_found)
+      response_ttl->reset();
+  }
+
+  // Only HTTPS records are parsed, to record metrics about them.
+  for (unsigned i = 0; i < response.additional_answer_count(); ++i) {
+    DnsRecordParser record_parser = *parser;
+    DnsRecordView record;
+    if (!parser->ReadRecordView(&record) ||
+        record.klass != dns_protocol::kClassIN ||
+        record.type != dns_protocol::kTypeHttps) {
+      continue;
+    }
+    std::unique_ptr<const RecordParsed> parsed =
+        RecordParsed::CreateFrom(&record_parser, base::Time::Now());
+    if (parsed) {
+      bool is_unsolicited = result_qtype != dns_protocol::kTypeHttps;
+      SaveMetricsForAdditionalHttpsRecord(*parsed, is_unsolicited);
+    }
+  }
+}
+
+void CollectAliases(const DnsResponse& response,
+                    const AliasMap& aliases,
+                    std::set<std::string>* out_aliases) {
+  out_aliases->clear();
+  for (const auto& alias : aliases) {
+    std::string canonicalized_alias =
+        dns_alias_utility::ValidateAndCanonicalizeAlias(alias.second);
+    if (!canonicalized_alias.empty())
+      out_aliases->insert(std::move(canonicalized_alias));
+  }
+  std::string canonicalized_query =
+      dns_alias_utility::ValidateAndCanonicalizeAlias(
+          response.GetSingleDottedName());
+  if (!canonicalized_query.empty())
+    out_aliases->insert(std::move(canonicalized_query));
+}
+
 ExtractionError ExtractResponseRecords(
     const DnsResponse& response,
     uint16_t result_qtype,
@@ -225,56 +303,116 @@ ExtractionError ExtractResponseRecords(
   if (name_and_alias_validation_error != ExtractionError::kOk)
     return name_and_alias_validation_error;
 
-  // For NXDOMAIN or NODATA (NOERROR with 0 answers), attempt to find a TTL
-  // via an SOA record.
-  if (response.rcode() == dns_protocol::kRcodeNXDOMAIN ||
-      (response.answer_count() == 0 &&
-       response.rcode() == dns_protocol::kRcodeNOERROR)) {
-    bool soa_found = false;
-    for (unsigned i = 0; i < response.authority_count(); ++i) {
-      DnsResourceRecord record;
-      if (parser.ReadRecord(&record) && record.type == dns_protocol::kTypeSOA) {
-        soa_found = true;
-        base::TimeDelta ttl = base::Seconds(record.ttl);
-        response_ttl =
-            std::min(response_ttl.value_or(base::TimeDelta::Max()), ttl);
-      }
+  ReadTrailingSections(response, result_qtype, &parser, &response_ttl);
+
+  *out_records = std::move(records);
+  *out_response_ttl = response_ttl;
+
+  if (out_aliases)
+    CollectAliases(response, aliases, out_aliases);
+
+  return ExtractionError::kOk;
+}
+
+// Like ExtractResponseRecords(), for A and AAAA responses, which are by far
+// the most common. Address records are read straight from the response
+// buffer, and their owner names are compared in place, so that only the
+// resulting endpoints are allocated. Other records, such as CNAMEs, are rare
+// and are parsed as ExtractResponseRecords() does.
+ExtractionError ExtractAddressRecords(
+    const DnsResponse& response,
+    uint16_t address_qtype,
+    std::vector<IPEndPoint>* out_ip_endpoints,
+    absl::optional<base::TimeDelta>* out_response_ttl,
+    std::set<std::string>* out_aliases) {
+  DCHECK_EQ(response.question_count(), 1u);
+  DCHECK(out_ip_endpoints);
+  DCHECK(out_response_ttl);
+  DCHECK(out_aliases);
+
+  std::vector<IPEndPoint> ip_endpoints;
+  // Owner names of the address records in `ip_endpoints`.
+  std::vector<const char*> names;
+  absl::optional<base::TimeDelta> response_ttl;
+
+  DnsRecordParser parser = response.Parser();
+
+  // Expected to be validated by DnsTransaction.
+  DCHECK_EQ(address_qtype, response.GetSingleQType());
+  const size_t address_size = address_qtype == dns_protocol::kTypeA
+                                  ? IPAddress::kIPv4AddressSize
+                                  : IPAddress::kIPv6AddressSize;
+
+  AliasMap aliases;
+  for (unsigned i = 0; i < response.answer_count(); ++i) {
+    DnsRecordParser record_parser = parser;
+    DnsRecordView record;
+    if (!parser.ReadRecordView(&record))
+      return ExtractionError::kMalformedRecord;
+
+    if (record.klass == dns_protocol::kClassIN &&
+        record.type == address_qtype) {
+      if (record.rdata.size() != address_size)
+        return ExtractionError::kMalformedRecord;
+
+      base::TimeDelta ttl = base::Seconds(record.ttl);
+      response_ttl =
+          std::min(response_ttl.value_or(base::TimeDelta::Max()), ttl);
+
+      names.push_back(record.name);
+      ip_endpoints.emplace_back(
+          IPAddress(reinterpret_cast<const uint8_t*>(record.rdata.data()),
+                    record.rdata.size()),
+          /*port=*/0);
+      continue;
     }
 
-    // Per RFC2308, section 5, never cache negative results unless an SOA
-    // record is found.
-    if (!soa_found)
-      response_ttl.reset();
-  }
+    std::unique_ptr<const RecordParsed> parsed =
+        RecordParsed::CreateFrom(&record_parser, base::Time::Now());
+    if (!parsed)
+      return ExtractionError::kMalformedRecord;
 
-  for (unsigned i = 0; i < response.additional_answer_count(); ++i) {
-    std::unique_ptr<const RecordParsed> record =
-        RecordParsed::CreateFrom(&parser, base::Time::Now());
-    if (record && record->klass() == dns_protocol::kClassIN &&
-        record->type() == dns_protocol::kTypeHttps) {
-      bool is_unsolicited = result_qtype != dns_protocol::kTypeHttps;
-      SaveMetricsForAdditionalHttpsRecord(*record, is_unsolicited);
+    if (parsed->klass() == dns_protocol::kClassIN &&
+        parsed->type() == dns_protocol::kTypeCNAME) {
+      // Per RFC2181, multiple CNAME records are not allowed for the same name.
+      if (aliases.find(parsed->name()) != aliases.end())
+        return ExtractionError::kMultipleCnames;
+
+      const CnameRecordRdata* cname_data = parsed->rdata<CnameRecordRdata>();
+      if (!cname_data)
+        return ExtractionError::kMalformedCname;
+
+      base::TimeDelta ttl = base::Seconds(parsed->ttl());
+      response_ttl =
+          std::min(response_ttl.value_or(base::TimeDelta::Max()), ttl);
+
+      bool added = aliases.emplace(parsed->name(), cname_data->cname()).second;
+      DCHECK(added);
     }
   }
 
-  *out_records = std::move(records);
-  *out_response_ttl = response_ttl;
+  base::StringPiece final_chain_name;
+  ExtractionError alias_chain_error = FollowAliasChain(
+      response.GetSingleDottedName(), aliases, &final_chain_name);
+  if (alias_chain_error != ExtractionError::kOk)
+    return alias_chain_error;
 
-  if (out_aliases) {
-    out_aliases->clear();
-    for (const auto& alias : aliases) {
-      std::string canonicalized_alias =
-          dns_alias_utility::ValidateAndCanonicalizeAlias(alias.second);
-      if (!canonicalized_alias.empty())
-        out_aliases->insert(std::move(canonicalized_alias));
+  // All results must match final alias name.
+  for (const char* name : names) {
+    if (!parser.NameEquals(name, final_chain_name)) {
+      std::string decoded_name;
+      if (!parser.ReadName(name, &decoded_name))
+        return ExtractionError::kMalformedRecord;
+      return ExtractionError::kNameMismatch;
     }
-    std::string canonicalized_query =
-        dns_alias_utility::ValidateAndCanonicalizeAlias(
-            response.GetSingleDottedName());
-    if (!canonicalized_query.empty())
-      out_aliases->insert(std::move(canonicalized_query));
   }
 
+  ReadTrailingSections(response, address_qtype, &parser, &response_ttl);
+
+  *out_ip_endpoints = std::move(ip_endpoints);
+  *out_response_ttl = response_ttl;
+  CollectAliases(response, aliases, out_aliases);
+
   return ExtractionError::kOk;
 }
 
@@ -286,11 +424,11 @@ ExtractionError ExtractAddressResults(const DnsResponse& response,
          address_qtype == dns_protocol::kTypeAAAA);
   DCHECK(out_results);
 
-  std::vector<std::unique_ptr<const RecordParsed>> records;
+  std::vector<IPEndPoint> ip_endpoints;
   absl::optional<base::TimeDelta> response_ttl;
   std::set<std::string> aliases;
-  ExtractionError extraction_error = ExtractResponseRecords(
-      response, address_qtype, &records, &response_ttl, &aliases);
+  ExtractionError extraction_error = ExtractAddressRecords(
+      response, address_qtype, &ip_endpoints, &response_ttl, &aliases);
 
   if (extraction_error != ExtractionError::kOk) {
     *out_results = HostCache::Entry(ERR_DNS_MALFORMED_RESPONSE,
@@ -298,32 +436,6 @@ ExtractionError ExtractAddressResults(const DnsResponse& response,
     return extraction_error;
   }
 
-  std::vector<IPEndPoint> ip_endpoints;
-  std::string canonical_name;
-  for (const auto& record : records) {
-    if (ip_endpoints.empty())
-      canonical_name = record->name();
-
-    // Expect that ExtractResponseRecords validates that all results correctly
-    // have the same name.
-    DCHECK(base::EqualsCaseInsensitiveASCII(canonical_name, record->name()))
-        << "canonical_name: " << canonical_name
-        << "\nrecord->name(): " << record->name();
-
-    IPAddress address;
-    if (address_qtype == dns_protocol::kTypeA) {
-      const ARecordRdata* rdata = record->rdata<ARecordRdata>();
-      address = rdata->address();
-      DCHECK(address.IsIPv4());
-    } else {
-      DCHECK_EQ(address_qtype, dns_protocol::kTypeAAAA);
-      const AAAARecordRdata* rdata = record->rdata<AAAARecordRdata>();
-      address = rdata->address();
-      DCHECK(address.IsIPv6());
-    }
-    ip_endpoints.emplace_back(address, /*port=*/0);
-  }
-
   HostCache::Entry results(ip_endpoints.empty() ? ERR_NAME_NOT_RESOLVED : OK,
                            std::move(ip_endpoints),
                            HostCache::Entry::SOURCE_DNS, response_ttl);
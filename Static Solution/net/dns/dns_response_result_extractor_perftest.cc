@@ -0,0 +1,86 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/dns_response_result_extractor.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/ip_address.h"
+#include "net/base/net_errors.h"
+#include "net/dns/dns_response.h"
+#include "net/dns/dns_test_util.h"
+#include "net/dns/host_cache.h"
+#include "net/dns/public/dns_protocol.h"
+#include "net/dns/public/dns_query_type.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixExtractor[] = "DnsResponseResultExtractor.";
+static constexpr char kMetricExtractionRate[] = "extractions_per_second";
+
+constexpr char kName[] = "www.example.test";
+
+// Builds an A response for `kName` with `num_addresses` addresses, reached
+// through a chain of `num_aliases` CNAMEs.
+DnsResponse BuildResponse(int num_addresses, int num_aliases) {
+  std::vector<DnsResourceRecord> answers;
+  std::string name = kName;
+  for (int i = 0; i < num_aliases; ++i) {
+    std::string alias = base::StringPrintf("alias%d.cdn.example.test", i);
+    answers.push_back(BuildTestCnameRecord(name, alias));
+    name = alias;
+  }
+  for (int i = 0; i < num_addresses; ++i) {
+    answers.push_back(
+        BuildTestAddressRecord(name, IPAddress(192, 0, 2, 1 + i % 254)));
+  }
+  return BuildTestDnsResponse(kName, dns_protocol::kTypeA, answers);
+}
+
+void RunExtractions(int num_addresses,
+                    int num_aliases,
+                    const std::string& story) {
+  const int kExtractions = 100000;
+  const DnsResponse response = BuildResponse(num_addresses, num_aliases);
+  DnsResponseResultExtractor extractor(&response);
+
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kExtractions; ++i) {
+    HostCache::Entry results(ERR_FAILED, HostCache::Entry::SOURCE_UNKNOWN);
+    ASSERT_EQ(DnsResponseResultExtractor::ExtractionError::kOk,
+              extractor.ExtractDnsResults(DnsQueryType::A,
+                                          /*original_domain_name=*/kName,
+                                          /*request_port=*/0, &results));
+    ASSERT_EQ(static_cast<size_t>(num_addresses),
+              results.ip_endpoints()->size());
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  perf_test::PerfResultReporter reporter(kMetricPrefixExtractor, story);
+  reporter.RegisterImportantMetric(kMetricExtractionRate, "runs/s");
+  reporter.AddResult(kMetricExtractionRate,
+                     kExtractions / elapsed.InSecondsF());
+}
+
+TEST(DnsResponseResultExtractorPerfTest, Addresses_1) {
+  RunExtractions(1, 0, "1_address");
+}
+
+TEST(DnsResponseResultExtractorPerfTest, Addresses_8) {
+  RunExtractions(8, 0, "8_addresses");
+}
+
+TEST(DnsResponseResultExtractorPerfTest, AddressesWithAliases_4_3) {
+  RunExtractions(4, 3, "4_addresses_3_aliases");
+}
+
+}  // namespace
+}  // namespace net
@@ -165,6 +165,42 @@ std::vector<uint8_t> BuildRfc1034Name(const size_t name_len,
   return data;
 }
 
+TEST(DnsRecordParserTest, NameEquals) {
+  const uint8_t data[] = {
+      // all labels "foo.example.com"
+      0x03, 'f', 'o', 'o', 0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c',
+      'o', 'm',
+      // byte 0x10
+      0x00,
+      // byte 0x11
+      // part label, part pointer, "bar.example.com"
+      0x03, 'b', 'a', 'r', 0xc0, 0x04,
+      // byte 0x17
+      // pointer loop
+      0xc0, 0x19, 0xc0, 0x17,
+      // byte 0x1b
+  };
+
+  DnsRecordParser parser(data, sizeof(data), 0, /*num_records=*/0);
+  ASSERT_TRUE(parser.IsValid());
+
+  EXPECT_TRUE(parser.NameEquals(data + 0x00, "foo.example.com"));
+  EXPECT_TRUE(parser.NameEquals(data + 0x00, "FOO.Example.COM"));
+  EXPECT_TRUE(parser.NameEquals(data + 0x10, ""));
+  EXPECT_TRUE(parser.NameEquals(data + 0x11, "bar.example.com"));
+  EXPECT_TRUE(parser.NameEquals(data + 0x04, "example.com"));
+
+  EXPECT_FALSE(parser.NameEquals(data + 0x00, "foo.example.co"));
+  EXPECT_FALSE(parser.NameEquals(data + 0x00, "foo.example.com.org"));
+  EXPECT_FALSE(parser.NameEquals(data + 0x00, "foo.example.com."));
+  EXPECT_FALSE(parser.NameEquals(data + 0x00, "fooexample.com"));
+  EXPECT_FALSE(parser.NameEquals(data + 0x11, "foo.example.com"));
+  EXPECT_FALSE(parser.NameEquals(data + 0x10, "com"));
+
+  // Malformed names never match.
+  EXPECT_FALSE(parser.NameEquals(data + 0x17, ""));
+}
+
 TEST(DnsRecordParserTest, ReadNameGoodLength) {
   const size_t name_len_cases[] = {2, 10, 40, 250, 254, 255};
 
@@ -350,6 +386,54 @@ TEST(DnsRecordParserTest, ReadRecord) {
   EXPECT_FALSE(parser.ReadRecord(&record));
 }
 
+TEST(DnsRecordParserTest, ReadRecordView) {
+  const uint8_t data[] = {
+      // Type A record.
+      0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00, 0x00,
+      0x01,                    // TYPE is A.
+      0x00, 0x01,              // CLASS is IN.
+      0x00, 0x01, 0x24, 0x74,  // TTL is 0x00012474.
+      0x00, 0x04,              // RDLENGTH is 4 bytes.
+      0x7f, 0x02, 0x04, 0x01,  // IP is 127.2.4.1
+      // Type AAAA record.
+      0x03, 'b', 'a', 'r',     // compressed owner name
+      0xc0, 0x00, 0x00, 0x1c,  // TYPE is AAAA.
+      0x00, 0x01,              // CLASS is IN.
+      0x00, 0x20, 0x13, 0x55,  // TTL is 0x00201355.
+      0x00, 0x10,              // RDLENGTH is 16 bytes.
+      0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x01,
+  };
+
+  DnsRecordParser parser(data, sizeof(data), 0, /*num_records=*/2);
+
+  DnsRecordView record;
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_EQ(reinterpret_cast<const char*>(data), record.name);
+  EXPECT_TRUE(parser.NameEquals(record.name, "example.com"));
+  EXPECT_EQ(dns_protocol::kTypeA, record.type);
+  EXPECT_EQ(dns_protocol::kClassIN, record.klass);
+  EXPECT_EQ(0x00012474u, record.ttl);
+  EXPECT_EQ(base::StringPiece("\x7f\x02\x04\x01"), record.rdata);
+  EXPECT_FALSE(parser.AtEnd());
+
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  std::string name;
+  EXPECT_EQ(6u, parser.ReadName(record.name, &name));
+  EXPECT_EQ("bar.example.com", name);
+  EXPECT_EQ(dns_protocol::kTypeAAAA, record.type);
+  EXPECT_EQ(dns_protocol::kClassIN, record.klass);
+  EXPECT_EQ(0x00201355u, record.ttl);
+  EXPECT_EQ(16u, record.rdata.length());
+  EXPECT_TRUE(parser.AtEnd());
+  EXPECT_FALSE(parser.ReadRecordView(&record));
+
+  // Test truncated record.
+  parser = DnsRecordParser(data, sizeof(data) - 2, 0, /*num_records=*/2);
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_FALSE(parser.ReadRecordView(&record));
+}
+
 TEST(DnsRecordParserTest, ReadsRecordWithLongName) {
   std::string dotted_name;
   const std::vector<uint8_t> dns_name =
@@ -1165,6 +1249,47 @@ TEST(DnsResponseTest, ParserLimitedToNumClaimedRecords) {
   EXPECT_FALSE(parser2.ReadRecord(&record));
 }
 
+// Test that a record whose owner name points outside the packet is rejected
+// when read as a view, even in the authority section, where the name is never
+// decoded.
+TEST(DnsResponseTest, ReadRecordViewRejectsBadAuthorityPointer) {
+  const char kResponse[] =
+      "\x02\x45"  // ID
+      "\x81\x80"  // Standard query response, RA, no error
+      "\x00\x01"  // 1 question
+      "\x00\x01"  // 1 answers
+      "\x00\x01"  // 1 authority records
+      "\x00\x00"  // 0 additional records
+      "\003www\006google\004test\000"
+      "\x00\x01"          // TYPE=A
+      "\x00\x01"          // CLASS=IN
+      "\xc0\x0c"          // NAME=www.google.test
+      "\x00\x01"          // TYPE=A
+      "\x00\x01"          // CLASS=IN
+      "\x00\x01\x51\x80"  // TTL=1 day
+      "\x00\x04"          // RDLENGTH=4 bytes
+      "\xc0\xa8\x00\x01"  // 192.168.0.1
+      "\003foo\xc0\xff"   // NAME=foo, then a pointer past the end
+      "\x00\x06"          // TYPE=SOA
+      "\x00\x01"          // CLASS=IN
+      "\x00\x01\x51\x80"  // TTL=1 day
+      "\x00\x00";         // RDLENGTH=0 bytes
+
+  DnsResponse resp;
+  memcpy(resp.io_buffer()->data(), kResponse, sizeof(kResponse) - 1);
+  ASSERT_TRUE(resp.InitParseWithoutQuery(sizeof(kResponse) - 1));
+
+  DnsRecordParser parser = resp.Parser();
+  DnsRecordView record;
+  EXPECT_TRUE(parser.ReadRecordView(&record));
+  EXPECT_FALSE(parser.ReadRecordView(&record));
+
+  parser = resp.Parser();
+  DnsResourceRecord full_record;
+  EXPECT_TRUE(parser.ReadRecord(&full_record));
+  EXPECT_FALSE(parser.ReadRecord(&full_record));
+}
+
 // Test that a parsed DnsResponse does not allow parsing past the end of the
 // input, even if more records are claimed in the response header.
 // Tests against incorrect record count field validation, which is anti-pattern
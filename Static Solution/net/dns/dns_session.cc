@@ -10,7 +10,9 @@
 #include <utility>
 
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/rand_util.h"
+#include "net/base/features.h"
 #include "net/dns/dns_config.h"
 #include "net/log/net_log.h"
 
@@ -23,7 +25,15 @@ DnsSession::DnsSession(const DnsConfig& config,
       rand_callback_(base::BindRepeating(rand_int_callback,
                                          0,
                                          std::numeric_limits<uint16_t>::max())),
-      net_log_(net_log) {}
+      net_log_(net_log) {
+  if (base::FeatureList::IsEnabled(features::kDnsUdpPacing) &&
+      !config_.nameservers.empty()) {
+    udp_pacer_ = std::make_unique<DnsUdpPacer>(
+        config_.nameservers.size(),
+        features::kDnsUdpPacingQueriesPerSecond.Get(),
+        features::kDnsUdpPacingBurst.Get());
+  }
+}
 
 DnsSession::~DnsSession() = default;
 
@@ -7,12 +7,15 @@
 
 #include <stdint.h>
 
+#include <memory>
+
 #include "base/memory/raw_ptr.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
 #include "net/base/net_export.h"
 #include "net/base/rand_callback.h"
 #include "net/dns/dns_config.h"
+#include "net/dns/dns_udp_pacer.h"
 #include "net/dns/dns_udp_tracker.h"
 
 namespace net {
@@ -41,6 +44,8 @@ class NET_EXPORT_PRIVATE DnsSession : public base::RefCounted<DnsSession> {
 
   const DnsConfig& config() const { return config_; }
   DnsUdpTracker* udp_tracker() { return &udp_tracker_; }
+  // Null unless features::kDnsUdpPacing is enabled.
+  DnsUdpPacer* udp_pacer() { return udp_pacer_.get(); }
   NetLog* net_log() const { return net_log_; }
 
   // Return the next random query ID.
@@ -63,6 +68,7 @@ class NET_EXPORT_PRIVATE DnsSession : public base::RefCounted<DnsSession> {
 
   const DnsConfig config_;
   DnsUdpTracker udp_tracker_;
+  std::unique_ptr<DnsUdpPacer> udp_pacer_;
   RandCallback rand_callback_;
   raw_ptr<NetLog> net_log_;
 
@@ -17,6 +17,7 @@
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/containers/circular_deque.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/memory/ptr_util.h"
 #include "base/memory/raw_ptr.h"
@@ -38,6 +39,7 @@
 #include "net/base/backoff_entry.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/elements_upload_data_stream.h"
+#include "net/base/features.h"
 #include "net/base/idempotency.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_address.h"
@@ -51,6 +53,7 @@
 #include "net/dns/dns_response_result_extractor.h"
 #include "net/dns/dns_server_iterator.h"
 #include "net/dns/dns_session.h"
+#include "net/dns/dns_udp_pacer.h"
 #include "net/dns/dns_udp_tracker.h"
 #include "net/dns/dns_util.h"
 #include "net/dns/host_cache.h"
@@ -194,26 +197,37 @@ class DnsAttempt {
 
 class DnsUDPAttempt : public DnsAttempt {
  public:
+  // The query is sent `send_delay` after the attempt is started. If
+  // `udp_pacer` is non-null, it reserved the slot the query is sent in, and
+  // gets the slot back if the attempt is destroyed before sending it.
   DnsUDPAttempt(size_t server_index,
                 std::unique_ptr<DatagramClientSocket> socket,
                 const IPEndPoint& server,
                 std::unique_ptr<DnsQuery> query,
-                DnsUdpTracker* udp_tracker)
+                DnsUdpTracker* udp_tracker,
+                DnsUdpPacer* udp_pacer,
+                base::TimeDelta send_delay)
       : DnsAttempt(server_index),
         socket_(std::move(socket)),
         server_(server),
         query_(std::move(query)),
-        udp_tracker_(udp_tracker) {}
+        udp_tracker_(udp_tracker),
+        udp_pacer_(udp_pacer),
+        send_delay_(send_delay) {}
 
   DnsUDPAttempt(const DnsUDPAttempt&) = delete;
   DnsUDPAttempt& operator=(const DnsUDPAttempt&) = delete;
 
+  ~DnsUDPAttempt() override {
+    if (udp_pacer_)
+      udp_pacer_->ReleaseSendSlot(server_index());
+  }
+
   // DnsAttempt methods.
 
   int Start(CompletionOnceCallback callback) override {
     DCHECK_EQ(STATE_NONE, next_state_);
     callback_ = std::move(callback);
-    start_time_ = base::TimeTicks::Now();
     next_state_ = STATE_SEND_QUERY;
 
     int rv = socket_->Connect(server_);
@@ -227,6 +241,13 @@ class DnsUDPAttempt : public DnsAttempt {
     if (socket_->GetLocalAddress(&local_address) == OK)
       udp_tracker_->RecordQuery(local_address.port(), query_->id());
 
+    if (send_delay_.is_positive()) {
+      send_timer_.Start(FROM_HERE, send_delay_,
+                        base::BindOnce(&DnsUDPAttempt::OnIOComplete,
+                                       base::Unretained(this), OK));
+      return ERR_IO_PENDING;
+    }
+
     return DoLoop(OK);
   }
 
@@ -293,6 +314,9 @@ class DnsUDPAttempt : public DnsAttempt {
 
   int DoSendQuery() {
     next_state_ = STATE_SEND_QUERY_COMPLETE;
+    // The pacing delay, if any, is over, and the reserved slot is used.
+    start_time_ = base::TimeTicks::Now();
+    udp_pacer_ = nullptr;
     return socket_->Write(
         query_->io_buffer(), query_->io_buffer()->size(),
         base::BindOnce(&DnsUDPAttempt::OnIOComplete, base::Unretained(this)),
@@ -359,6 +383,13 @@ class DnsUDPAttempt : public DnsAttempt {
   // reference.
   const raw_ptr<DnsUdpTracker> udp_tracker_;
 
+  // Owned by the DnsSession, like |udp_tracker_|. Null once the query is sent.
+  raw_ptr<DnsUdpPacer> udp_pacer_;
+
+  // Delay imposed by DnsUdpPacer before the query is sent.
+  const base::TimeDelta send_delay_;
+  base::OneShotTimer send_timer_;
+
   std::unique_ptr<DnsResponse> response_;
 
   CompletionOnceCallback callback_;
@@ -912,6 +943,13 @@ const net::BackoffEntry::Policy kProbeBackoffPolicy = {
 // Probe runner that continually sends test queries (with backoff) to DoH
 // servers to determine availability.
 //
+// With features::kDohKeepSessionWarm, the runner keeps going once a server is
+// available: while the server keeps answering real queries, it sends a probe
+// query at IDLE priority every so often, so that the HTTP/2 session that all
+// DoH queries to the server are multiplexed over is not closed for being idle
+// between bursts of lookups. If the server becomes unavailable, probing
+// resumes.
+//
 // Expected to be contained in request classes owned externally to HostResolver,
 // so no assumptions are made regarding cancellation compared to the DnsSession
 // or ResolveContext. Instead, uses WeakPtrs to gracefully clean itself up and
@@ -930,6 +968,7 @@ class DnsOverHttpsProbeRunner : public DnsProbeRunner {
     for (size_t i = 0; i < session_->config().doh_config.servers().size();
          i++) {
       probe_stats_list_.push_back(nullptr);
+      keep_warm_list_.push_back(nullptr);
     }
   }
 
@@ -972,6 +1011,12 @@ class DnsOverHttpsProbeRunner : public DnsProbeRunner {
     base::WeakPtrFactory<ProbeStats> weak_factory{this};
   };
 
+  struct KeepWarmState {
+    // At most one keep-warm query per server is in flight at a time.
+    std::vector<std::unique_ptr<DnsAttempt>> attempts;
+    base::WeakPtrFactory<KeepWarmState> weak_factory{this};
+  };
+
   void ContinueProbe(size_t doh_server_index,
                      base::WeakPtr<ProbeStats> probe_stats,
                      bool network_change,
@@ -992,6 +1037,8 @@ class DnsOverHttpsProbeRunner : public DnsProbeRunner {
     // available.
     if (context_->GetDohServerAvailability(doh_server_index, session_.get())) {
       probe_stats_list_[doh_server_index] = nullptr;
+      if (base::FeatureList::IsEnabled(features::kDohKeepSessionWarm))
+        StartKeepWarm(doh_server_index);
       return;
     }
 
@@ -1076,6 +1123,69 @@ class DnsOverHttpsProbeRunner : public DnsProbeRunner {
         base::TimeTicks::Now() - sequence_start_time);
   }
 
+  // Replaces any keep-warm sequence for |doh_server_index| with a new one.
+  void StartKeepWarm(size_t doh_server_index) {
+    auto& keep_warm = keep_warm_list_[doh_server_index];
+    keep_warm = std::make_unique<KeepWarmState>();
+    ScheduleKeepWarm(doh_server_index, keep_warm->weak_factory.GetWeakPtr());
+  }
+
+  void ScheduleKeepWarm(size_t doh_server_index,
+                        base::WeakPtr<KeepWarmState> keep_warm) {
+    base::SequencedTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&DnsOverHttpsProbeRunner::KeepWarm,
+                       weak_ptr_factory_.GetWeakPtr(), doh_server_index,
+                       std::move(keep_warm)),
+        features::kDohKeepSessionWarmInterval.Get());
+  }
+
+  void KeepWarm(size_t doh_server_index,
+                base::WeakPtr<KeepWarmState> keep_warm) {
+    if (!session_ || !context_) {
+      probe_stats_list_.clear();
+      keep_warm_list_.clear();
+      return;
+    }
+
+    if (!keep_warm)
+      return;
+
+    // Go back to probing a server that has stopped working. The probe sequence
+    // starts keeping it warm again once it recovers.
+    if (!context_->GetDohServerAvailability(doh_server_index, session_.get())) {
+      keep_warm_list_[doh_server_index] = nullptr;
+      if (!probe_stats_list_[doh_server_index]) {
+        probe_stats_list_[doh_server_index] = std::make_unique<ProbeStats>();
+        ContinueProbe(
+            doh_server_index,
+            probe_stats_list_[doh_server_index]->weak_factory.GetWeakPtr(),
+            false /* network_change */,
+            base::TimeTicks::Now() /* sequence_start_time */);
+      }
+      return;
+    }
+
+    // Let the session close once the server is no longer being used. Only
+    // real queries count as uses: probes don't, and the result of the
+    // keep-warm query is ignored and not recorded in the server's stats, so
+    // that the runner cannot keep a server in use by itself.
+    base::TimeTicks last_success = context_->GetDohServerLastQuerySuccess(
+        doh_server_index, session_.get());
+    if (base::TimeTicks::Now() - last_success <=
+        features::kDohKeepSessionWarmIdleTimeout.Get()) {
+      keep_warm->attempts.clear();
+      ConstructDnsHTTPAttempt(
+          session_.get(), doh_server_index, formatted_probe_hostname_,
+          dns_protocol::kTypeA, nullptr /* opt_rdata */, &keep_warm->attempts,
+          context_->url_request_context(), context_->isolation_info(),
+          RequestPriority::IDLE);
+      keep_warm->attempts.back()->Start(base::DoNothing());
+    }
+
+    ScheduleKeepWarm(doh_server_index, std::move(keep_warm));
+  }
+
   base::WeakPtr<DnsSession> session_;
   base::WeakPtr<ResolveContext> context_;
   std::string formatted_probe_hostname_;
@@ -1084,6 +1194,10 @@ class DnsOverHttpsProbeRunner : public DnsProbeRunner {
   // config index.
   std::vector<std::unique_ptr<ProbeStats>> probe_stats_list_;
 
+  // Keep-warm sequences, one for each DoH server that is being kept warm,
+  // indexed by the DoH server config index.
+  std::vector<std::unique_ptr<KeepWarmState>> keep_warm_list_;
+
   base::WeakPtrFactory<DnsOverHttpsProbeRunner> weak_ptr_factory_{this};
 };
 
@@ -1294,19 +1408,23 @@ class DnsTransactionImpl : public DnsTransaction,
 
     size_t attempt_number = attempts_.size();
     AttemptResult result;
+    base::TimeDelta send_delay;
     if (session_->udp_tracker()->low_entropy()) {
       result = MakeTcpAttempt(server_index, std::move(query));
       RecordAttemptUma(DnsAttemptType::kTcpLowEntropy);
     } else {
-      result = MakeUdpAttempt(server_index, std::move(query));
+      if (session_->udp_pacer())
+        send_delay = session_->udp_pacer()->ReserveSendSlot(server_index);
+      result = MakeUdpAttempt(server_index, std::move(query), send_delay);
       RecordAttemptUma(DnsAttemptType::kUdp);
     }
 
     if (result.rv == ERR_IO_PENDING) {
+      // The fallback period starts once the query is actually sent.
       base::TimeDelta fallback_period =
           resolve_context_->NextClassicFallbackPeriod(
               server_index, attempt_number, session_.get());
-      timer_.Start(FROM_HERE, fallback_period, this,
+      timer_.Start(FROM_HERE, send_delay + fallback_period, this,
                    &DnsTransactionImpl::OnFallbackPeriodExpired);
     }
 
@@ -1314,9 +1432,10 @@ class DnsTransactionImpl : public DnsTransaction,
   }
 
   // Makes another attempt at the current name, |qnames_.front()|, using the
-  // next nameserver.
+  // next nameserver. The query is sent after |send_delay|.
   AttemptResult MakeUdpAttempt(size_t server_index,
-                               std::unique_ptr<DnsQuery> query) {
+                               std::unique_ptr<DnsQuery> query,
+                               base::TimeDelta send_delay) {
     DCHECK(!secure_);
     DCHECK(!session_->udp_tracker()->low_entropy());
 
@@ -1333,16 +1452,19 @@ class DnsTransactionImpl : public DnsTransaction,
 
     attempts_.push_back(std::make_unique<DnsUDPAttempt>(
         server_index, std::move(socket), config.nameservers[server_index],
-        std::move(query), session_->udp_tracker()));
+        std::move(query), session_->udp_tracker(), session_->udp_pacer(),
+        send_delay));
     ++attempts_count_;
 
     DnsAttempt* attempt = attempts_.back().get();
     net_log_.AddEventReferencingSource(NetLogEventType::DNS_TRANSACTION_ATTEMPT,
                                        attempt->GetSocketNetLog().source());
 
+    // Leave the pacing delay out of the server's RTT.
     int rv = attempt->Start(base::BindOnce(
         &DnsTransactionImpl::OnAttemptComplete, base::Unretained(this),
-        attempt_number, true /* record_rtt */, base::TimeTicks::Now()));
+        attempt_number, true /* record_rtt */,
+        base::TimeTicks::Now() + send_delay));
     return AttemptResult(rv, attempt);
   }
 
@@ -1494,6 +1616,15 @@ class DnsTransactionImpl : public DnsTransaction,
     return dns_server_iterator_->AttemptAvailable();
   }
 
+  // Records that |server_index| answered a query of this transaction.
+  void RecordServerSuccess(size_t server_index) {
+    resolve_context_->RecordServerSuccess(
+        server_index, secure_ /* is_doh_server */, session_.get());
+    if (secure_)
+      resolve_context_->RecordDohServerQuerySuccess(server_index,
+                                                    session_.get());
+  }
+
   // Resolves the result of a DnsAttempt until a terminal result is reached
   // or it will complete asynchronously (ERR_IO_PENDING).
   AttemptResult ProcessAttemptResult(AttemptResult result) {
@@ -1504,18 +1635,14 @@ class DnsTransactionImpl : public DnsTransaction,
 
       switch (result.rv) {
         case OK:
-          resolve_context_->RecordServerSuccess(result.attempt->server_index(),
-                                                secure_ /* is_doh_server */,
-                                                session_.get());
+          RecordServerSuccess(result.attempt->server_index());
           net_log_.EndEventWithNetErrorCode(
               NetLogEventType::DNS_TRANSACTION_QUERY, result.rv);
           DCHECK(result.attempt);
           DCHECK(result.attempt->GetResponse());
           return result;
         case ERR_NAME_NOT_RESOLVED:
-          resolve_context_->RecordServerSuccess(result.attempt->server_index(),
-                                                secure_ /* is_doh_server */,
-                                                session_.get());
+          RecordServerSuccess(result.attempt->server_index());
           net_log_.EndEventWithNetErrorCode(
               NetLogEventType::DNS_TRANSACTION_QUERY, result.rv);
           // Try next suffix. Check that qnames_ isn't already empty first,
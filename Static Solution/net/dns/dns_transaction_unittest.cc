@@ -23,9 +23,11 @@
 #include "base/sys_byteorder.h"
 #include "base/test/bind.h"
 #include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
 #include "base/values.h"
+#include "net/base/features.h"
 #include "net/base/idempotency.h"
 #include "net/base/ip_address.h"
 #include "net/base/port_util.h"
@@ -1231,6 +1233,43 @@ TEST_F(DnsTransactionTestWithMockTime, Timeout_FastTimeout) {
   EXPECT_TRUE(helper0.has_completed());
 }
 
+TEST_F(DnsTransactionTestWithMockTime, UdpPacing) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsUdpPacing, {{"queries_per_second", "1"}, {"burst", "1"}});
+  ConfigureFactory();
+
+  AddHangingQuery(kT0HostName, kT0Qtype);
+  // Never sent, as its transaction is cancelled while waiting for a slot.
+  AddHangingQuery(kT1HostName, kT1Qtype);
+  AddAsyncQueryAndResponse(0 /* id */, kT1HostName, kT1Qtype,
+                           kT1ResponseDatagram, std::size(kT1ResponseDatagram));
+
+  // Uses up the burst.
+  TransactionHelper helper0(ERR_DNS_TIMED_OUT);
+  helper0.StartTransaction(transaction_factory_.get(), kT0HostName, kT0Qtype,
+                           false /* secure */, resolve_context_.get());
+  base::RunLoop().RunUntilIdle();
+
+  // Cancelling a query waiting for a slot gives the slot back.
+  TransactionHelper cancelled_helper(ERR_UNEXPECTED);
+  cancelled_helper.StartTransaction(transaction_factory_.get(), kT1HostName,
+                                    kT1Qtype, false /* secure */,
+                                    resolve_context_.get());
+  base::RunLoop().RunUntilIdle();
+  cancelled_helper.Cancel();
+
+  // Waits for a single slot, rather than behind the cancelled query.
+  TransactionHelper helper1(kT1RecordCount);
+  helper1.StartTransaction(transaction_factory_.get(), kT1HostName, kT1Qtype,
+                           false /* secure */, resolve_context_.get());
+  FastForwardBy(base::Seconds(1) - base::Milliseconds(1));
+  EXPECT_FALSE(helper1.has_completed());
+  FastForwardBy(base::Milliseconds(1));
+  EXPECT_TRUE(helper1.has_completed());
+  EXPECT_FALSE(cancelled_helper.has_completed());
+}
+
 TEST_F(DnsTransactionTestWithMockTime, ServerFallbackAndRotate) {
   // Test that we fallback on both server failure and fallback period
   // expiration.
@@ -3495,6 +3534,55 @@ TEST_F(DnsTransactionTestWithMockTime, ProbeMultipleServers) {
   EXPECT_EQ(runner->GetDelayUntilNextProbeForTest(1u), base::TimeDelta());
 }
 
+TEST_F(DnsTransactionTestWithMockTime, ProbeKeepsSessionWarm) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDohKeepSessionWarm,
+      {{"interval", "10s"}, {"idle_timeout", "15s"}});
+  ConfigureDohServers(true /* use_post */, 1 /* num_doh_servers */,
+                      false /* make_available */);
+  for (int i = 0; i < 3; ++i) {
+    AddQueryAndResponse(0 /* id */, kT4HostName, kT4Qtype, kT4ResponseDatagram,
+                        std::size(kT4ResponseDatagram), ASYNC,
+                        Transport::HTTPS, nullptr /* opt_rdata */,
+                        DnsQuery::PaddingStrategy::BLOCK_LENGTH_128,
+                        false /* enqueue_transaction_id */);
+  }
+  int requests_started = 0;
+  SetUrlRequestStartedCallback(
+      base::BindLambdaForTesting([&] { ++requests_started; }));
+
+  std::unique_ptr<DnsProbeRunner> runner =
+      transaction_factory_->CreateDohProbeRunner(resolve_context_.get());
+  runner->Start(false /* network_change */);
+  RunUntilIdle();
+  ASSERT_TRUE(resolve_context_->GetDohServerAvailability(
+      0u /* doh_server_index */, session_.get()));
+  EXPECT_EQ(1, requests_started);
+
+  // The probe sequence ends, and keeping the server warm starts. The
+  // successful probe does not count as a use of the server, so there is
+  // nothing to keep warm yet.
+  FastForwardBy(runner->GetDelayUntilNextProbeForTest(0));
+  EXPECT_EQ(runner->GetDelayUntilNextProbeForTest(0), base::TimeDelta());
+  FastForwardBy(base::Seconds(10));
+  EXPECT_EQ(1, requests_started);
+
+  TransactionHelper helper(kT4RecordCount);
+  helper.StartTransaction(transaction_factory_.get(), kT4HostName, kT4Qtype,
+                          true /* secure */, resolve_context_.get());
+  helper.RunUntilComplete();
+  EXPECT_EQ(2, requests_started);
+
+  FastForwardBy(base::Seconds(10));
+  EXPECT_EQ(3, requests_started);
+
+  // Keep-warm queries do not count as uses of the server, so the server is no
+  // longer kept warm once it has been idle for `idle_timeout`.
+  FastForwardBy(base::Seconds(30));
+  EXPECT_EQ(3, requests_started);
+}
+
 TEST_F(DnsTransactionTestWithMockTime, MultipleProbeRunners) {
   ConfigureDohServers(true /* use_post */, 1 /* num_doh_servers */,
                       false /* make_available */);
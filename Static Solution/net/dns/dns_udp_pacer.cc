@@ -0,0 +1,53 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/dns_udp_pacer.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/time/tick_clock.h"
+
+namespace net {
+
+DnsUdpPacer::DnsUdpPacer(size_t num_servers,
+                         double queries_per_second,
+                         int burst)
+    : queries_per_second_(queries_per_second),
+      burst_(burst),
+      buckets_(num_servers, Bucket{static_cast<double>(burst)}) {
+  DCHECK_GT(queries_per_second_, 0);
+  DCHECK_GT(burst_, 0);
+}
+
+DnsUdpPacer::~DnsUdpPacer() = default;
+
+base::TimeDelta DnsUdpPacer::ReserveSendSlot(size_t server_index) {
+  Bucket& bucket = RefillBucket(server_index);
+  bucket.tokens -= 1;
+  if (bucket.tokens >= 0)
+    return base::TimeDelta();
+  return base::Seconds(-bucket.tokens / queries_per_second_);
+}
+
+void DnsUdpPacer::ReleaseSendSlot(size_t server_index) {
+  Bucket& bucket = RefillBucket(server_index);
+  bucket.tokens = std::min(burst_, bucket.tokens + 1);
+}
+
+DnsUdpPacer::Bucket& DnsUdpPacer::RefillBucket(size_t server_index) {
+  DCHECK_LT(server_index, buckets_.size());
+  Bucket& bucket = buckets_[server_index];
+
+  base::TimeTicks now = tick_clock_->NowTicks();
+  if (!bucket.last_refill.is_null()) {
+    double refill =
+        (now - bucket.last_refill).InSecondsF() * queries_per_second_;
+    bucket.tokens = std::min(burst_, bucket.tokens + refill);
+  }
+  bucket.last_refill = now;
+  return bucket;
+}
+
+}  // namespace net
@@ -0,0 +1,73 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DNS_DNS_UDP_PACER_H_
+#define NET_DNS_DNS_UDP_PACER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/memory/raw_ptr.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/time.h"
+#include "net/base/net_export.h"
+
+namespace base {
+class TickClock;
+}  // namespace base
+
+namespace net {
+
+// Paces classic DNS queries sent over UDP with a token bucket per nameserver,
+// so that a burst of resolutions does not flood a server with queries, and get
+// them dropped by its rate limiting. Intended to be owned by a DnsSession, and
+// thus to pace queries session-wide.
+class NET_EXPORT_PRIVATE DnsUdpPacer {
+ public:
+  // Allows bursts of up to `burst` queries to each of `num_servers` servers,
+  // and `queries_per_second` sustained queries per server beyond that.
+  DnsUdpPacer(size_t num_servers, double queries_per_second, int burst);
+
+  DnsUdpPacer(const DnsUdpPacer&) = delete;
+  DnsUdpPacer& operator=(const DnsUdpPacer&) = delete;
+
+  ~DnsUdpPacer();
+
+  // Reserves a slot to send a query to `server_index`, and returns how long the
+  // query must wait before it is sent. Zero if it can be sent right away.
+  // Queries to a server are spaced out in the order their slots are reserved.
+  base::TimeDelta ReserveSendSlot(size_t server_index);
+
+  // Gives back a slot reserved for `server_index` whose query was not sent,
+  // e.g. because it was cancelled while waiting, so that a backlog of
+  // abandoned queries does not delay later ones.
+  void ReleaseSendSlot(size_t server_index);
+
+  void set_tick_clock_for_testing(base::TickClock* tick_clock) {
+    tick_clock_ = tick_clock;
+  }
+
+ private:
+  struct Bucket {
+    // Negative when queries are waiting for a slot.
+    double tokens;
+    base::TimeTicks last_refill;
+  };
+
+  // Refills `server_index`'s bucket for the time elapsed since it was last
+  // refilled, and returns it.
+  Bucket& RefillBucket(size_t server_index);
+
+  double queries_per_second_;
+  double burst_;
+  std::vector<Bucket> buckets_;
+
+  raw_ptr<const base::TickClock> tick_clock_ =
+      base::DefaultTickClock::GetInstance();
+};
+
+}  // namespace net
+
+#endif  // NET_DNS_DNS_UDP_PACER_H_
@@ -0,0 +1,84 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/dns_udp_pacer.h"
+
+#include "base/test/simple_test_tick_clock.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+class DnsUdpPacerTest : public testing::Test {
+ public:
+  DnsUdpPacerTest() : pacer_(2 /* num_servers */, 4 /* qps */, 3 /* burst */) {
+    test_tick_clock_.Advance(base::Days(1));
+    pacer_.set_tick_clock_for_testing(&test_tick_clock_);
+  }
+
+ protected:
+  base::SimpleTestTickClock test_tick_clock_;
+  DnsUdpPacer pacer_;
+};
+
+TEST_F(DnsUdpPacerTest, AllowsBurst) {
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(base::TimeDelta(), pacer_.ReserveSendSlot(0));
+}
+
+TEST_F(DnsUdpPacerTest, SpacesOutQueriesBeyondBurst) {
+  for (int i = 0; i < 3; ++i)
+    pacer_.ReserveSendSlot(0);
+
+  EXPECT_EQ(base::Milliseconds(250), pacer_.ReserveSendSlot(0));
+  EXPECT_EQ(base::Milliseconds(500), pacer_.ReserveSendSlot(0));
+
+  // Waiting queries have used up the refilled slots.
+  test_tick_clock_.Advance(base::Milliseconds(375));
+  EXPECT_EQ(base::Milliseconds(375), pacer_.ReserveSendSlot(0));
+}
+
+TEST_F(DnsUdpPacerTest, RefillsUpToBurst) {
+  for (int i = 0; i < 3; ++i)
+    pacer_.ReserveSendSlot(0);
+
+  test_tick_clock_.Advance(base::Minutes(1));
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(base::TimeDelta(), pacer_.ReserveSendSlot(0));
+  EXPECT_EQ(base::Milliseconds(250), pacer_.ReserveSendSlot(0));
+}
+
+TEST_F(DnsUdpPacerTest, PacesServersSeparately) {
+  for (int i = 0; i < 3; ++i)
+    pacer_.ReserveSendSlot(0);
+  EXPECT_GT(pacer_.ReserveSendSlot(0), base::TimeDelta());
+
+  EXPECT_EQ(base::TimeDelta(), pacer_.ReserveSendSlot(1));
+}
+
+TEST_F(DnsUdpPacerTest, ReleasedSlotsShortenBacklog) {
+  for (int i = 0; i < 5; ++i)
+    pacer_.ReserveSendSlot(0);
+
+  // The two waiting queries were cancelled.
+  pacer_.ReleaseSendSlot(0);
+  pacer_.ReleaseSendSlot(0);
+  EXPECT_EQ(base::Milliseconds(250), pacer_.ReserveSendSlot(0));
+}
+
+TEST_F(DnsUdpPacerTest, ReleasedSlotsDoNotExceedBurst) {
+  pacer_.ReserveSendSlot(0);
+  test_tick_clock_.Advance(base::Minutes(1));
+  pacer_.ReleaseSendSlot(0);
+
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(base::TimeDelta(), pacer_.ReserveSendSlot(0));
+  EXPECT_EQ(base::Milliseconds(250), pacer_.ReserveSendSlot(0));
+}
+
+}  // namespace
+
+}  // namespace net
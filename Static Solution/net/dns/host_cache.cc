@@ -16,9 +16,11 @@
 
 #include "base/bind.h"
 #include "base/check_op.h"
+#include "base/hash/hash.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/pickle.h"
 #include "base/stl_util.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
@@ -28,6 +30,7 @@
 #include "net/base/address_family.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/trace_constants.h"
+#include "net/dns/host_cache_snapshot.h"
 #include "net/dns/host_resolver.h"
 #include "net/dns/https_record_rdata.h"
 #include "net/dns/public/dns_protocol.h"
@@ -205,6 +208,67 @@ const std::string& GetHostname(
   return *hostname;
 }
 
+void WriteIPEndPoint(const IPEndPoint& endpoint, base::Pickle* pickle) {
+  pickle->WriteData(
+      reinterpret_cast<const char*>(endpoint.address().bytes().data()),
+      base::checked_cast<int>(endpoint.address().size()));
+  pickle->WriteUInt16(endpoint.port());
+}
+
+bool ReadIPEndPoint(base::PickleIterator* iter, IPEndPoint* endpoint) {
+  const char* data;
+  int length;
+  uint16_t port;
+  if (!iter->ReadData(&data, &length) || !iter->ReadUInt16(&port))
+    return false;
+  IPAddress address(reinterpret_cast<const uint8_t*>(data), length);
+  if (!address.IsValid())
+    return false;
+  *endpoint = IPEndPoint(address, port);
+  return true;
+}
+
+void WriteIPEndPoints(const std::vector<IPEndPoint>& endpoints,
+                      base::Pickle* pickle) {
+  pickle->WriteInt(base::checked_cast<int>(endpoints.size()));
+  for (const IPEndPoint& endpoint : endpoints)
+    WriteIPEndPoint(endpoint, pickle);
+}
+
+bool ReadIPEndPoints(base::PickleIterator* iter,
+                     std::vector<IPEndPoint>* endpoints) {
+  size_t count;
+  if (!iter->ReadLength(&count))
+    return false;
+  for (size_t i = 0; i < count; ++i) {
+    IPEndPoint endpoint;
+    if (!ReadIPEndPoint(iter, &endpoint))
+      return false;
+    endpoints->push_back(std::move(endpoint));
+  }
+  return true;
+}
+
+template <typename Container>
+void WriteStrings(const Container& strings, base::Pickle* pickle) {
+  pickle->WriteInt(base::checked_cast<int>(strings.size()));
+  for (const std::string& string : strings)
+    pickle->WriteString(string);
+}
+
+bool ReadStrings(base::PickleIterator* iter, std::vector<std::string>* out) {
+  size_t count;
+  if (!iter->ReadLength(&count))
+    return false;
+  for (size_t i = 0; i < count; ++i) {
+    std::string string;
+    if (!iter->ReadString(&string))
+      return false;
+    out->push_back(std::move(string));
+  }
+  return true;
+}
+
 }  // namespace
 
 // Used in histograms; do not modify existing values.
@@ -253,6 +317,9 @@ HostCache::Key::Key(Key&& key) = default;
 
 HostCache::Key::~Key() = default;
 
+HostCache::Key& HostCache::Key::operator=(const Key& key) = default;
+HostCache::Key& HostCache::Key::operator=(Key&& key) = default;
+
 HostCache::Entry::Entry(int error,
                         Source source,
                         absl::optional<base::TimeDelta> ttl)
@@ -734,10 +801,17 @@ HostCache::LookupInternalIgnoringFields(const Key& initial_key,
 
 std::pair<const HostCache::Key, HostCache::Entry>* HostCache::LookupInternal(
     const Key& key) {
-  auto it = entries_.find(key);
+  auto it = FindEntry(key);
   return (it != entries_.end()) ? &*it : nullptr;
 }
 
+HostCache::EntryMap::iterator HostCache::FindEntry(const Key& key) {
+  if (snapshot_)
+    RestoreFromSnapshotForHostname(GetHostname(key.host));
+  auto it = lookup_index_.find(&key);
+  return (it != lookup_index_.end()) ? it->second : entries_.end();
+}
+
 void HostCache::Set(const Key& key,
                     const Entry& entry,
                     base::TimeTicks now,
@@ -749,21 +823,21 @@ void HostCache::Set(const Key& key,
 
   bool has_active_pin = false;
   bool result_changed = false;
-  auto it = entries_.find(key);
+  auto it = FindEntry(key);
   if (it != entries_.end()) {
     has_active_pin = HasActivePin(it->second);
 
     // TODO(juliatuttle): Remember some old metadata (hit count or frequency or
     // something like that) if it's useful for better eviction algorithms?
     result_changed = entry.error() == OK && !it->second.ContentsEqual(entry);
-    entries_.erase(it);
+    EraseEntry(it);
   } else {
     result_changed = true;
     // This loop almost always runs at most once, for total runtime
-    // O(max_entries_).  It only runs more than once if the cache was over-full
-    // due to pinned entries, and this is the first call to Set() after
-    // Invalidate().  The amortized cost remains O(size()) per call to Set().
-    while (size() >= max_entries_ && EvictOneEntry(now)) {
+    // O(log(max_entries_)).  It only runs more than once if the cache was
+    // over-full due to pinned entries, and this is the first call to Set()
+    // after Invalidate().
+    while (size() >= max_entries_ && EvictOneEntry()) {
     }
   }
 
@@ -798,11 +872,29 @@ const HostCache::Key* HostCache::GetMatchingKeyForTesting(
 void HostCache::AddEntry(const Key& key, Entry&& entry) {
   DCHECK_EQ(0u, entries_.count(key));
   DCHECK(entry.pinning().has_value());
-  entries_.emplace(key, std::move(entry));
+  auto it = entries_.emplace(key, std::move(entry)).first;
+  lookup_index_.emplace(&it->first, it);
+  if (HasActivePin(it->second)) {
+    pinned_entries_.insert(it);
+  } else {
+    eviction_order_.insert(it);
+  }
+  DCHECK_EQ(entries_.size(), lookup_index_.size());
+  DCHECK_EQ(entries_.size(), eviction_order_.size() + pinned_entries_.size());
+}
+
+void HostCache::EraseEntry(EntryMap::iterator it) {
+  if (!eviction_order_.erase(it))
+    pinned_entries_.erase(it);
+  lookup_index_.erase(&it->first);
+  entries_.erase(it);
 }
 
 void HostCache::Invalidate() {
   ++network_changes_;
+  // All pins are obsolete now.
+  eviction_order_.insert(pinned_entries_.begin(), pinned_entries_.end());
+  pinned_entries_.clear();
 }
 
 void HostCache::set_persistence_delegate(PersistenceDelegate* delegate) {
@@ -815,10 +907,19 @@ void HostCache::set_persistence_delegate(PersistenceDelegate* delegate) {
 void HostCache::clear() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
+  bool had_snapshot = !!snapshot_;
+  snapshot_.reset();
+
   // Don't bother scheduling a write if there's nothing to clear.
-  if (size() == 0)
+  if (size() == 0) {
+    if (delegate_ && had_snapshot)
+      delegate_->ScheduleWrite();
     return;
+  }
 
+  eviction_order_.clear();
+  pinned_entries_.clear();
+  lookup_index_.clear();
   entries_.clear();
   if (delegate_)
     delegate_->ScheduleWrite();
@@ -834,11 +935,28 @@ void HostCache::ClearForHosts(
   }
 
   bool changed = false;
+  if (snapshot_) {
+    // Malformed records are dropped along the way.
+    for (size_t i = 0; i < snapshot_->record_count(); ++i) {
+      Key key;
+      Entry entry(ERR_FAILED, Entry::SOURCE_UNKNOWN);
+      if (snapshot_->IsTaken(i) ||
+          (ReadSnapshotRecord(snapshot_->GetRecord(i), &key, &entry) &&
+           !host_filter.Run(GetHostname(key.host)))) {
+        continue;
+      }
+      snapshot_->Take(i);
+      changed = true;
+    }
+    if (snapshot_->remaining_count() == 0)
+      snapshot_.reset();
+  }
+
   for (auto it = entries_.begin(); it != entries_.end();) {
     auto next_it = std::next(it);
 
     if (host_filter.Run(GetHostname(it->first.host))) {
-      entries_.erase(it);
+      EraseEntry(it);
       changed = true;
     }
 
@@ -854,15 +972,12 @@ void HostCache::GetList(base::Value::List& entry_list,
                         SerializationType serialization_type) const {
   entry_list.clear();
 
-  for (const auto& pair : entries_) {
-    const Key& key = pair.first;
-    const Entry& entry = pair.second;
-
+  auto append_entry = [&](const Key& key, const Entry& entry) {
     base::Value network_isolation_key_value;
     if (serialization_type == SerializationType::kRestorable) {
       // Don't save entries associated with ephemeral NetworkIsolationKeys.
       if (!key.network_isolation_key.ToValue(&network_isolation_key_value))
-        continue;
+        return;
     } else {
       // ToValue() fails for transient NIKs, since they should never be
       // serialized to disk in a restorable format, so use ToDebugString() when
@@ -892,6 +1007,22 @@ void HostCache::GetList(base::Value::List& entry_list,
     entry_dict.Set(kSecureKey, key.secure);
 
     entry_list.Append(std::move(entry_dict));
+  };
+
+  for (const auto& pair : entries_)
+    append_entry(pair.first, pair.second);
+
+  // Entries of the restored snapshot that have not been looked up yet.
+  if (!snapshot_)
+    return;
+  for (size_t i = 0; i < snapshot_->record_count(); ++i) {
+    Key key;
+    Entry entry(ERR_FAILED, Entry::SOURCE_UNKNOWN);
+    if (!snapshot_->IsTaken(i) &&
+        ReadSnapshotRecord(snapshot_->GetRecord(i), &key, &entry) &&
+        !entries_.count(key)) {
+      append_entry(key, entry);
+    }
   }
 }
 
@@ -1088,7 +1219,7 @@ bool HostCache::RestoreFromListValue(const base::Value::List& old_cache) {
 
     // If the key is already in the cache, assume it's more recent and don't
     // replace the entry.
-    auto found = entries_.find(key);
+    auto found = FindEntry(key);
     if (found == entries_.end()) {
       Entry entry(error, std::move(ip_endpoints), std::move(endpoint_metadatas),
                   std::move(aliases), legacy_address_value,
@@ -1103,6 +1234,309 @@ bool HostCache::RestoreFromListValue(const base::Value::List& old_cache) {
   return true;
 }
 
+std::string HostCache::SerializeSnapshot() const {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  HostCacheSnapshot::Builder builder;
+  for (const auto& pair : entries_) {
+    base::Pickle pickle;
+    if (!WriteSnapshotRecord(pair.first, pair.second, &pickle))
+      continue;
+    builder.AddRecord(
+        GetHostname(pair.first.host),
+        base::make_span(static_cast<const uint8_t*>(pickle.data()),
+                        pickle.size()));
+  }
+  // Records that have not been looked up are copied without being decoded.
+  if (snapshot_)
+    snapshot_->AddRemainingRecordsTo(&builder);
+  return builder.Finish();
+}
+
+void HostCache::RestoreFromSnapshot(
+    std::unique_ptr<HostCacheSnapshot> snapshot) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK(snapshot);
+
+  restore_size_ = 0;
+  snapshot_.reset();
+  if (caching_is_disabled() || snapshot->remaining_count() == 0)
+    return;
+  restore_size_ = snapshot->remaining_count();
+  snapshot_ = std::move(snapshot);
+  snapshot_network_changes_ = network_changes_ - 1;
+}
+
+void HostCache::RestoreFromSnapshotForHostname(base::StringPiece hostname) {
+  TRACE_EVENT0(NetTracingCategory(), "HostCache::RestoreFromSnapshot");
+
+  const std::pair<size_t, size_t> range = snapshot_->FindRecords(hostname);
+  for (size_t i = range.first; i < range.second; ++i) {
+    if (snapshot_->IsTaken(i))
+      continue;
+    Key key;
+    Entry entry(ERR_FAILED, Entry::SOURCE_UNKNOWN);
+    if (!ReadSnapshotRecord(snapshot_->GetRecord(i), &key, &entry)) {
+      // Keep other hostnames with the same hash for their own lookups.
+      snapshot_->Take(i);
+      continue;
+    }
+    if (GetHostname(key.host) != hostname)
+      continue;
+    snapshot_->Take(i);
+
+    // Entries set since the snapshot was restored are more recent.
+    if (lookup_index_.count(&key))
+      continue;
+    // As when restoring from a list, don't bother prioritizing what to evict
+    // for restored entries.
+    if (size() >= max_entries_)
+      continue;
+    AddEntry(key, std::move(entry));
+  }
+
+  if (snapshot_->remaining_count() == 0)
+    snapshot_.reset();
+}
+
+// static
+bool HostCache::WriteSnapshotRecord(const Key& key,
+                                    const Entry& entry,
+                                    base::Pickle* pickle) {
+  // Don't save entries associated with ephemeral NetworkIsolationKeys.
+  base::Value network_isolation_key_value;
+  if (!key.network_isolation_key.ToValue(&network_isolation_key_value))
+    return false;
+
+  const auto* host = absl::get_if<url::SchemeHostPort>(&key.host);
+  if (host) {
+    pickle->WriteString(host->scheme());
+    pickle->WriteString(host->host());
+    pickle->WriteUInt16(host->port());
+  } else {
+    pickle->WriteString(std::string());
+    pickle->WriteString(absl::get<std::string>(key.host));
+    pickle->WriteUInt16(0);
+  }
+  pickle->WriteInt(base::strict_cast<int>(key.dns_query_type));
+  pickle->WriteInt(key.host_resolver_flags);
+  pickle->WriteInt(base::strict_cast<int>(key.host_resolver_source));
+  pickle->WriteBool(key.secure);
+  pickle->WriteInt(
+      base::checked_cast<int>(network_isolation_key_value.GetList().size()));
+  for (const base::Value& part : network_isolation_key_value.GetList())
+    pickle->WriteString(part.GetString());
+
+  base::Time expiration_time =
+      base::Time::Now() - (base::TimeTicks::Now() - entry.expires());
+  pickle->WriteInt(entry.error());
+  pickle->WriteInt64(expiration_time.ToInternalValue());
+  pickle->WriteBool(entry.pinning().value_or(false));
+
+  pickle->WriteBool(entry.ip_endpoints_.has_value());
+  if (entry.ip_endpoints_)
+    WriteIPEndPoints(*entry.ip_endpoints_, pickle);
+
+  pickle->WriteBool(entry.endpoint_metadatas_.has_value());
+  if (entry.endpoint_metadatas_) {
+    pickle->WriteInt(
+        base::checked_cast<int>(entry.endpoint_metadatas_->size()));
+    for (const auto& pair : *entry.endpoint_metadatas_) {
+      pickle->WriteUInt16(pair.first);
+      WriteStrings(pair.second.supported_protocol_alpns, pickle);
+      pickle->WriteData(
+          reinterpret_cast<const char*>(pair.second.ech_config_list.data()),
+          base::checked_cast<int>(pair.second.ech_config_list.size()));
+    }
+  }
+
+  pickle->WriteBool(entry.aliases_.has_value());
+  if (entry.aliases_)
+    WriteStrings(*entry.aliases_, pickle);
+
+  pickle->WriteBool(entry.legacy_addresses_.has_value());
+  if (entry.legacy_addresses_) {
+    WriteIPEndPoints(entry.legacy_addresses_->endpoints(), pickle);
+    WriteStrings(entry.legacy_addresses_->dns_aliases(), pickle);
+  }
+
+  pickle->WriteBool(entry.text_records_.has_value());
+  if (entry.text_records_)
+    WriteStrings(*entry.text_records_, pickle);
+
+  pickle->WriteBool(entry.hostnames_.has_value());
+  if (entry.hostnames_) {
+    pickle->WriteInt(base::checked_cast<int>(entry.hostnames_->size()));
+    for (const HostPortPair& hostname : *entry.hostnames_) {
+      pickle->WriteString(hostname.host());
+      pickle->WriteUInt16(hostname.port());
+    }
+  }
+  return true;
+}
+
+bool HostCache::ReadSnapshotRecord(base::span<const uint8_t> record,
+                                   Key* key,
+                                   Entry* entry) const {
+  if (record.empty())
+    return false;
+  base::Pickle pickle(reinterpret_cast<const char*>(record.data()),
+                      record.size());
+  base::PickleIterator iter(pickle);
+
+  std::string scheme;
+  std::string hostname;
+  uint16_t port;
+  int dns_query_type;
+  int flags;
+  int host_resolver_source;
+  bool secure;
+  std::vector<std::string> network_isolation_key_parts;
+  if (!iter.ReadString(&scheme) || !iter.ReadString(&hostname) ||
+      !iter.ReadUInt16(&port) || !iter.ReadInt(&dns_query_type) ||
+      !iter.ReadInt(&flags) || !iter.ReadInt(&host_resolver_source) ||
+      !iter.ReadBool(&secure) ||
+      !ReadStrings(&iter, &network_isolation_key_parts)) {
+    return false;
+  }
+  if (!IsValidHostname(hostname) || dns_query_type < 0 ||
+      dns_query_type > base::strict_cast<int>(DnsQueryType::MAX) ||
+      host_resolver_source < 0 ||
+      host_resolver_source > base::strict_cast<int>(HostResolverSource::MAX)) {
+    return false;
+  }
+
+  absl::variant<url::SchemeHostPort, std::string> host;
+  if (!scheme.empty()) {
+    url::SchemeHostPort scheme_host_port(scheme, hostname, port);
+    if (!scheme_host_port.IsValid())
+      return false;
+    host = std::move(scheme_host_port);
+  } else {
+    host = std::move(hostname);
+  }
+
+  base::Value::List network_isolation_key_list;
+  for (std::string& part : network_isolation_key_parts)
+    network_isolation_key_list.Append(std::move(part));
+  NetworkIsolationKey network_isolation_key;
+  if (!NetworkIsolationKey::FromValue(
+          base::Value(std::move(network_isolation_key_list)),
+          &network_isolation_key)) {
+    return false;
+  }
+
+  int error;
+  int64_t time_internal;
+  bool pinned;
+  if (!iter.ReadInt(&error) || !iter.ReadInt64(&time_internal) ||
+      !iter.ReadBool(&pinned)) {
+    return false;
+  }
+
+  bool present;
+  absl::optional<std::vector<IPEndPoint>> ip_endpoints;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    ip_endpoints.emplace();
+    if (!ReadIPEndPoints(&iter, &ip_endpoints.value()))
+      return false;
+  }
+
+  absl::optional<std::multimap<HttpsRecordPriority, ConnectionEndpointMetadata>>
+      endpoint_metadatas;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    endpoint_metadatas.emplace();
+    size_t count;
+    if (!iter.ReadLength(&count))
+      return false;
+    for (size_t i = 0; i < count; ++i) {
+      HttpsRecordPriority priority;
+      ConnectionEndpointMetadata metadata;
+      const char* ech_config_list;
+      int ech_config_list_length;
+      if (!iter.ReadUInt16(&priority) ||
+          !ReadStrings(&iter, &metadata.supported_protocol_alpns) ||
+          !iter.ReadData(&ech_config_list, &ech_config_list_length)) {
+        return false;
+      }
+      metadata.ech_config_list.assign(
+          ech_config_list, ech_config_list + ech_config_list_length);
+      endpoint_metadatas->emplace(priority, std::move(metadata));
+    }
+  }
+
+  absl::optional<std::set<std::string>> aliases;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    std::vector<std::string> alias_list;
+    if (!ReadStrings(&iter, &alias_list))
+      return false;
+    aliases.emplace(alias_list.begin(), alias_list.end());
+  }
+
+  absl::optional<AddressList> legacy_addresses;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    legacy_addresses.emplace();
+    std::vector<std::string> dns_aliases;
+    if (!ReadIPEndPoints(&iter, &legacy_addresses->endpoints()) ||
+        !ReadStrings(&iter, &dns_aliases)) {
+      return false;
+    }
+    legacy_addresses->SetDnsAliases(std::move(dns_aliases));
+  }
+
+  absl::optional<std::vector<std::string>> text_records;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    text_records.emplace();
+    if (!ReadStrings(&iter, &text_records.value()))
+      return false;
+  }
+
+  absl::optional<std::vector<HostPortPair>> hostnames;
+  if (!iter.ReadBool(&present))
+    return false;
+  if (present) {
+    hostnames.emplace();
+    size_t count;
+    if (!iter.ReadLength(&count))
+      return false;
+    for (size_t i = 0; i < count; ++i) {
+      std::string hostname_result;
+      uint16_t hostname_port;
+      if (!iter.ReadString(&hostname_result) ||
+          !iter.ReadUInt16(&hostname_port)) {
+        return false;
+      }
+      hostnames->emplace_back(std::move(hostname_result), hostname_port);
+    }
+  }
+
+  base::TimeTicks expiration_time =
+      tick_clock_->NowTicks() -
+      (base::Time::Now() - base::Time::FromInternalValue(time_internal));
+
+  *key = Key(std::move(host), static_cast<DnsQueryType>(dns_query_type), flags,
+             static_cast<HostResolverSource>(host_resolver_source),
+             network_isolation_key);
+  key->secure = secure;
+  *entry = Entry(error, std::move(ip_endpoints), std::move(endpoint_metadatas),
+                 std::move(aliases), legacy_addresses, std::move(text_records),
+                 std::move(hostnames), /*https_record_compatibility=*/{},
+                 Entry::SOURCE_UNKNOWN, expiration_time,
+                 snapshot_network_changes_);
+  entry->set_pinning(pinned);
+  return true;
+}
+
 size_t HostCache::size() const {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   return entries_.size();
@@ -1123,34 +1557,41 @@ std::unique_ptr<HostCache> HostCache::CreateDefaultCache() {
   return std::make_unique<HostCache>(kDefaultMaxEntries);
 }
 
-bool HostCache::EvictOneEntry(base::TimeTicks now) {
-  DCHECK_LT(0u, entries_.size());
-
-  absl::optional<net::HostCache::EntryMap::iterator> oldest_it;
-  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
-    const Entry& entry = it->second;
-    if (HasActivePin(entry)) {
-      continue;
-    }
-
-    if (!oldest_it) {
-      oldest_it = it;
-      continue;
-    }
+bool HostCache::EvictionOrderLess::operator()(
+    const EntryMap::iterator& a,
+    const EntryMap::iterator& b) const {
+  const Entry& entry_a = a->second;
+  const Entry& entry_b = b->second;
+  // Entries from before a network change are stale whatever their expiration
+  // time, and within the current network the entries that expire first are
+  // either already stale or the closest to becoming so.
+  if (entry_a.network_changes() != entry_b.network_changes())
+    return entry_a.network_changes() < entry_b.network_changes();
+  if (entry_a.expires() != entry_b.expires())
+    return entry_a.expires() < entry_b.expires();
+  return a->first < b->first;
+}
 
-    const Entry& oldest = (*oldest_it)->second;
-    if ((entry.expires() < oldest.expires()) &&
-        (entry.IsStale(now, network_changes_) ||
-         !oldest.IsStale(now, network_changes_))) {
-      oldest_it = it;
-    }
+size_t HostCache::KeyPtrHash::operator()(const Key* key) const {
+  uint64_t fields = static_cast<uint64_t>(key->dns_query_type);
+  fields = (fields << 8) | static_cast<uint64_t>(key->host_resolver_source);
+  fields = (fields << 1) | (key->secure ? 1 : 0);
+  fields = (fields << 32) | static_cast<uint32_t>(key->host_resolver_flags);
+  size_t hash = base::HashInts(base::FastHash(GetHostname(key->host)), fields);
+  if (absl::holds_alternative<url::SchemeHostPort>(key->host)) {
+    hash = base::HashInts(hash,
+                          absl::get<url::SchemeHostPort>(key->host).port());
   }
+  return hash;
+}
 
-  if (oldest_it) {
-    entries_.erase(*oldest_it);
-    return true;
-  }
-  return false;
+bool HostCache::EvictOneEntry() {
+  DCHECK_LT(0u, entries_.size());
+
+  if (eviction_order_.empty())
+    return false;
+  EraseEntry(*eviction_order_.begin());
+  return true;
 }
 
 bool HostCache::HasActivePin(const Entry& entry) {
@@ -14,14 +14,17 @@
 #include <set>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "base/check.h"
+#include "base/containers/span.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/raw_ptr.h"
 #include "base/numerics/clamped_math.h"
 #include "base/stl_util.h"
+#include "base/strings/string_piece.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
 #include "base/values.h"
@@ -43,11 +46,14 @@
 #include "url/scheme_host_port.h"
 
 namespace base {
+class Pickle;
 class TickClock;
 }  // namespace base
 
 namespace net {
 
+class HostCacheSnapshot;
+
 // Cache used by HostResolver to map hostnames to their resolved result.
 class NET_EXPORT HostCache {
  public:
@@ -65,6 +71,9 @@ class NET_EXPORT HostCache {
     Key(Key&& key);
     ~Key();
 
+    Key& operator=(const Key& key);
+    Key& operator=(Key&& key);
+
     // This is a helper used in comparing keys. The order of comparisons of
     // `Key` fields is arbitrary, but the tuple is constructed with
     // `dns_query_type` and `host_resolver_flags` before `host` under the
@@ -470,9 +479,19 @@ class NET_EXPORT HostCache {
   // false on failure.
   bool RestoreFromListValue(const base::Value::List& old_cache);
   // Returns the number of entries that were restored in the last call to
-  // RestoreFromListValue().
+  // RestoreFromListValue() or RestoreFromSnapshot().
   size_t last_restore_size() const { return restore_size_; }
 
+  // Serializes the restorable entries of the cache, along with the entries of
+  // a restored snapshot that have not been looked up yet, into a
+  // HostCacheSnapshot.
+  std::string SerializeSnapshot() const;
+  // Restores the entries of |snapshot| lazily: each hostname's entries are
+  // decoded and added to the cache the first time the hostname is looked up
+  // or set, unless an entry was set for the same key in the meantime.
+  // Replaces any snapshot previously restored.
+  void RestoreFromSnapshot(std::unique_ptr<HostCacheSnapshot> snapshot);
+
   // Returns the number of entries in the cache.
   size_t size() const;
 
@@ -512,24 +531,78 @@ class NET_EXPORT HostCache {
   // match for |key| is required.
   std::pair<const Key, Entry>* LookupInternal(const Key& key);
 
+  // Returns the entry of |entries_| for |key|, or entries_.end().
+  EntryMap::iterator FindEntry(const Key& key);
+
+  // Adds the entries of |snapshot_| for |hostname| to the cache.
+  void RestoreFromSnapshotForHostname(base::StringPiece hostname);
+  // Encodes |key| and |entry| as a HostCacheSnapshot record. Returns false
+  // if the entry must not be persisted.
+  static bool WriteSnapshotRecord(const Key& key,
+                                  const Entry& entry,
+                                  base::Pickle* pickle);
+  // Decodes a record written by WriteSnapshotRecord(). Returns false if
+  // |record| is malformed.
+  bool ReadSnapshotRecord(base::span<const uint8_t> record,
+                          Key* key,
+                          Entry* entry) const;
+
   // Returns true if this HostCache can contain no entries.
   bool caching_is_disabled() const { return max_entries_ == 0; }
 
+  // Orders entries from the first to the last to be evicted: entries cached
+  // before the latest network change first, then by expiration time. Entries
+  // must not be modified in a way that changes their order while indexed.
+  struct EvictionOrderLess {
+    bool operator()(const EntryMap::iterator& a,
+                    const EntryMap::iterator& b) const;
+  };
+  using EvictionOrder = std::set<EntryMap::iterator, EvictionOrderLess>;
+
+  // Hashes the host, query type, flags, source and secure fields of a Key.
+  // The NetworkIsolationKey is left out, as it is comparatively expensive to
+  // hash and a hostname is usually cached under only a few of them.
+  struct KeyPtrHash {
+    size_t operator()(const Key* key) const;
+  };
+  struct KeyPtrEqual {
+    bool operator()(const Key* a, const Key* b) const { return *a == *b; }
+  };
+  // Points into the keys of |entries_|, which are stable.
+  using LookupIndex = std::
+      unordered_map<const Key*, EntryMap::iterator, KeyPtrHash, KeyPtrEqual>;
+
   // Returns true if an entry was removed.
-  bool EvictOneEntry(base::TimeTicks now);
+  bool EvictOneEntry();
   // Helper to check if an Entry is currently pinned in the cache.
   bool HasActivePin(const Entry& entry);
   // Helper to insert an Entry into the cache.
   void AddEntry(const Key& key, Entry&& entry);
+  // Helper to remove an entry from the cache.
+  void EraseEntry(EntryMap::iterator it);
 
   // Map from hostname (presumably in lowercase canonicalized format) to
   // a resolved result entry.
   EntryMap entries_;
+  // Hashed index of |entries_|, used for lookups by exact key. |entries_|
+  // stays ordered, for serialization and the net-internals UI.
+  LookupIndex lookup_index_;
+  // Every entry of |entries_| is in exactly one of these. Entries with an
+  // active pin can't be evicted, so they are kept out of |eviction_order_|
+  // until the next network change makes their pin obsolete.
+  EvictionOrder eviction_order_;
+  EvictionOrder pinned_entries_;
   size_t max_entries_;
   int network_changes_ = 0;
   // Number of cache entries that were restored in the last call to
-  // RestoreFromListValue(). Used in histograms.
+  // RestoreFromListValue() or RestoreFromSnapshot(). Used in histograms.
   size_t restore_size_ = 0;
+  // Entries of the last restored snapshot that have not been added to the
+  // cache yet. Reset once they all have been.
+  std::unique_ptr<HostCacheSnapshot> snapshot_;
+  // |network_changes_| of the entries restored from |snapshot_|, so that they
+  // are stale as of the RestoreFromSnapshot() call.
+  int snapshot_network_changes_ = 0;
 
   raw_ptr<PersistenceDelegate> delegate_ = nullptr;
   // Shared tick clock, overridden for testing.
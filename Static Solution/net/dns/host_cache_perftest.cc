@@ -0,0 +1,205 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/host_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/values.h"
+#include "net/base/address_list.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/schemeful_site.h"
+#include "net/dns/host_cache_snapshot.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixHostCache[] = "HostCache.";
+static constexpr char kMetricFillTimeUs[] = "fill_time_per_entry";
+static constexpr char kMetricInsertTimeUs[] = "insert_when_full_time";
+static constexpr char kMetricLookupRate[] = "lookups_per_second";
+static constexpr char kMetricRestoreTimeUs[] = "restore_time";
+static constexpr char kMetricSnapshotRestoreTimeUs[] = "snapshot_restore_time";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHostCache, story);
+  reporter.RegisterImportantMetric(kMetricFillTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricInsertTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricLookupRate, "runs/s");
+  reporter.RegisterImportantMetric(kMetricRestoreTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricSnapshotRestoreTimeUs, "us");
+  return reporter;
+}
+
+std::vector<HostCache::Key> MakeKeys(int count, int first) {
+  std::vector<HostCache::Key> keys;
+  keys.reserve(count);
+  for (int i = first; i < first + count; ++i) {
+    keys.emplace_back(
+        url::SchemeHostPort(url::kHttpsScheme,
+                            base::StringPrintf("host%d.example.test", i), 443),
+        DnsQueryType::UNSPECIFIED, 0, HostResolverSource::ANY,
+        NetworkIsolationKey());
+  }
+  return keys;
+}
+
+// Fills a cache of |max_entries| to capacity, then measures inserting new
+// hosts into it, each of which evicts an existing entry.
+void RunInsertWhenFull(int max_entries, const std::string& story) {
+  const int kInserts = 20000;
+  HostCache cache(max_entries);
+  const HostCache::Entry entry(OK, AddressList(),
+                               HostCache::Entry::SOURCE_DNS);
+  const std::vector<HostCache::Key> fill_keys = MakeKeys(max_entries, 0);
+  const std::vector<HostCache::Key> insert_keys =
+      MakeKeys(kInserts, max_entries);
+  base::TimeTicks now;
+
+  // TTLs vary, so that eviction has to pick the entry that expires first
+  // rather than the oldest one.
+  base::ElapsedTimer fill_timer;
+  for (int i = 0; i < max_entries; ++i)
+    cache.Set(fill_keys[i], entry, now, base::Seconds(60 + (i * 7919) % 3600));
+  base::TimeDelta fill_time = fill_timer.Elapsed();
+  ASSERT_EQ(static_cast<size_t>(max_entries), cache.size());
+
+  base::ElapsedTimer insert_timer;
+  for (int i = 0; i < kInserts; ++i) {
+    now += base::Milliseconds(10);
+    cache.Set(insert_keys[i], entry, now,
+              base::Seconds(60 + (i * 7919) % 3600));
+  }
+  base::TimeDelta insert_time = insert_timer.Elapsed();
+  ASSERT_EQ(static_cast<size_t>(max_entries), cache.size());
+
+  perf_test::PerfResultReporter reporter = SetUpReporter(story);
+  reporter.AddResult(kMetricFillTimeUs,
+                     fill_time.InMicrosecondsF() / max_entries);
+  reporter.AddResult(kMetricInsertTimeUs,
+                     insert_time.InMicrosecondsF() / kInserts);
+}
+
+// Measures Lookup() hits and misses in a cache of |num_entries| hosts, spread
+// over a few NetworkIsolationKeys.
+void RunLookups(int num_entries, const std::string& story) {
+  const int kLookups = 1000000;
+  const int kNumSites = 4;
+  HostCache cache(num_entries);
+  const HostCache::Entry entry(OK, AddressList(),
+                               HostCache::Entry::SOURCE_DNS);
+  base::TimeTicks now;
+
+  std::vector<HostCache::Key> keys = MakeKeys(num_entries, 0);
+  for (int i = 0; i < num_entries; ++i) {
+    const SchemefulSite site(
+        GURL(base::StringPrintf("https://site%d.test", i % kNumSites)));
+    keys[i].network_isolation_key = NetworkIsolationKey(site, site);
+    cache.Set(keys[i], entry, now, base::Hours(1));
+  }
+  ASSERT_EQ(static_cast<size_t>(num_entries), cache.size());
+  // Every other lookup misses.
+  const std::vector<HostCache::Key> missing_keys =
+      MakeKeys(num_entries, num_entries);
+
+  int hits = 0;
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kLookups; ++i) {
+    // Step through the keys with a stride, to defeat the CPU caches.
+    const int index = static_cast<int>((i * 7919LL) % num_entries);
+    const HostCache::Key& key = i % 2 ? missing_keys[index] : keys[index];
+    if (cache.Lookup(key, now))
+      ++hits;
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  EXPECT_EQ(kLookups / 2, hits);
+
+  perf_test::PerfResultReporter reporter = SetUpReporter(story);
+  reporter.AddResult(kMetricLookupRate, kLookups / elapsed.InSecondsF());
+}
+
+// Measures restoring a cache of |num_entries| hosts from a value list and
+// from a snapshot. Snapshot records are only checked and decoded when looked
+// up, so its restore time includes looking up a tenth of the hosts.
+void RunRestore(int num_entries, const std::string& story) {
+  HostCache cache(num_entries);
+  const HostCache::Entry entry(
+      OK, AddressList(IPEndPoint(IPAddress(192, 0, 2, 1), 0)),
+      HostCache::Entry::SOURCE_DNS);
+  base::TimeTicks now;
+  const std::vector<HostCache::Key> keys = MakeKeys(num_entries, 0);
+  for (const HostCache::Key& key : keys)
+    cache.Set(key, entry, now, base::Hours(1));
+
+  base::Value::List list;
+  cache.GetList(list, false /* include_staleness */,
+                HostCache::SerializationType::kRestorable);
+  const std::string data = cache.SerializeSnapshot();
+
+  HostCache list_cache(num_entries);
+  base::ElapsedTimer list_timer;
+  ASSERT_TRUE(list_cache.RestoreFromListValue(list));
+  base::TimeDelta list_time = list_timer.Elapsed();
+  EXPECT_EQ(static_cast<size_t>(num_entries), list_cache.size());
+
+  HostCache snapshot_cache(num_entries);
+  HostCache::EntryStaleness stale;
+  int hits = 0;
+  base::ElapsedTimer snapshot_timer;
+  snapshot_cache.RestoreFromSnapshot(HostCacheSnapshot::Create(data));
+  for (int i = 0; i < num_entries; i += 10) {
+    if (snapshot_cache.LookupStale(keys[i], now, &stale))
+      ++hits;
+  }
+  base::TimeDelta snapshot_time = snapshot_timer.Elapsed();
+  EXPECT_EQ((num_entries + 9) / 10, hits);
+
+  perf_test::PerfResultReporter reporter = SetUpReporter(story);
+  reporter.AddResult(kMetricRestoreTimeUs, list_time.InMicrosecondsF());
+  reporter.AddResult(kMetricSnapshotRestoreTimeUs,
+                     snapshot_time.InMicrosecondsF());
+}
+
+TEST(HostCachePerfTest, InsertWhenFull_1000) {
+  RunInsertWhenFull(1000, "1000_entries");
+}
+
+TEST(HostCachePerfTest, InsertWhenFull_50000) {
+  RunInsertWhenFull(50000, "50000_entries");
+}
+
+TEST(HostCachePerfTest, Lookup_1000) {
+  RunLookups(1000, "1000_entries");
+}
+
+TEST(HostCachePerfTest, Lookup_10000) {
+  RunLookups(10000, "10000_entries");
+}
+
+TEST(HostCachePerfTest, Lookup_100000) {
+  RunLookups(100000, "100000_entries");
+}
+
+TEST(HostCachePerfTest, Restore_1000) {
+  RunRestore(1000, "1000_entries");
+}
+
+TEST(HostCachePerfTest, Restore_50000) {
+  RunRestore(50000, "50000_entries");
+}
+
+}  // namespace
+}  // namespace net
@@ -0,0 +1,216 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/host_cache_snapshot.h"
+
+#include <algorithm>
+
+#include "base/big_endian.h"
+#include "base/check_op.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/hash/hash.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace net {
+
+namespace {
+
+const uint32_t kMagic = 0x48435331;  // "HCS1"
+const uint16_t kVersion = 2;
+const size_t kHeaderSize = 12;
+const size_t kIndexEntrySize = 16;
+const size_t kRecordAlignment = 4;
+
+uint32_t HashHostname(base::StringPiece hostname) {
+  return base::PersistentHash(hostname);
+}
+
+uint32_t ChecksumRecord(base::span<const uint8_t> record) {
+  return base::PersistentHash(record.data(), record.size());
+}
+
+uint32_t ReadU32(const uint8_t* pos) {
+  uint32_t value;
+  base::ReadBigEndian(pos, &value);
+  return value;
+}
+
+size_t AlignRecordSize(size_t size) {
+  return (size + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+}  // namespace
+
+HostCacheSnapshot::Builder::Builder() = default;
+
+HostCacheSnapshot::Builder::~Builder() = default;
+
+void HostCacheSnapshot::Builder::AddRecord(base::StringPiece hostname,
+                                           base::span<const uint8_t> record) {
+  records_.emplace_back(
+      HashHostname(hostname),
+      std::string(reinterpret_cast<const char*>(record.data()), record.size()));
+}
+
+std::string HostCacheSnapshot::Builder::Finish() {
+  std::stable_sort(
+      records_.begin(), records_.end(),
+      [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  size_t size = kHeaderSize + records_.size() * kIndexEntrySize;
+  for (const auto& record : records_)
+    size += AlignRecordSize(record.second.size());
+
+  std::string data(size, '\0');
+  base::BigEndianWriter header(data.data(), kHeaderSize);
+  header.WriteU32(kMagic);
+  header.WriteU16(kVersion);
+  header.WriteU16(0);
+  header.WriteU32(base::checked_cast<uint32_t>(records_.size()));
+
+  base::BigEndianWriter index(data.data() + kHeaderSize,
+                              records_.size() * kIndexEntrySize);
+  size_t offset = kHeaderSize + records_.size() * kIndexEntrySize;
+  for (const auto& record : records_) {
+    index.WriteU32(record.first);
+    index.WriteU32(base::checked_cast<uint32_t>(offset));
+    index.WriteU32(base::checked_cast<uint32_t>(record.second.size()));
+    index.WriteU32(
+        ChecksumRecord(base::as_bytes(base::make_span(record.second))));
+    std::copy(record.second.begin(), record.second.end(),
+              data.begin() + offset);
+    offset += AlignRecordSize(record.second.size());
+  }
+  DCHECK_EQ(size, offset);
+
+  records_.clear();
+  return data;
+}
+
+// static
+std::unique_ptr<HostCacheSnapshot> HostCacheSnapshot::Create(
+    std::string data) {
+  std::unique_ptr<HostCacheSnapshot> snapshot(
+      new HostCacheSnapshot(nullptr, std::move(data)));
+  if (!snapshot->Init())
+    return nullptr;
+  return snapshot;
+}
+
+// static
+std::unique_ptr<HostCacheSnapshot> HostCacheSnapshot::CreateFromFile(
+    const base::FilePath& path) {
+  auto file = std::make_unique<base::MemoryMappedFile>();
+  if (!file->Initialize(path))
+    return nullptr;
+  std::unique_ptr<HostCacheSnapshot> snapshot(
+      new HostCacheSnapshot(std::move(file), std::string()));
+  if (!snapshot->Init())
+    return nullptr;
+  return snapshot;
+}
+
+HostCacheSnapshot::HostCacheSnapshot(
+    std::unique_ptr<base::MemoryMappedFile> file,
+    std::string data)
+    : file_(std::move(file)), data_(std::move(data)) {
+  if (file_) {
+    bytes_ = base::make_span(file_->data(), file_->length());
+  } else {
+    bytes_ = base::as_bytes(base::make_span(data_));
+  }
+}
+
+HostCacheSnapshot::~HostCacheSnapshot() = default;
+
+bool HostCacheSnapshot::Init() {
+  if (bytes_.size() < kHeaderSize)
+    return false;
+
+  base::BigEndianReader header(bytes_.data(), kHeaderSize);
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+  if (!header.ReadU32(&magic) || !header.ReadU16(&version) ||
+      !header.ReadU16(&reserved) || !header.ReadU32(&count)) {
+    return false;
+  }
+  if (magic != kMagic || version != kVersion)
+    return false;
+  if ((bytes_.size() - kHeaderSize) / kIndexEntrySize < count)
+    return false;
+
+  taken_.assign(count, false);
+  remaining_count_ = count;
+  return true;
+}
+
+std::pair<size_t, size_t> HostCacheSnapshot::FindRecords(
+    base::StringPiece hostname) const {
+  const uint32_t hash = HashHostname(hostname);
+
+  // Lower bound of |hash| in the index.
+  size_t begin = 0;
+  size_t count = record_count();
+  while (count > 0) {
+    size_t step = count / 2;
+    if (GetRecordHash(begin + step) < hash) {
+      begin += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+
+  size_t end = begin;
+  while (end < record_count() && GetRecordHash(end) == hash)
+    ++end;
+  return {begin, end};
+}
+
+base::span<const uint8_t> HostCacheSnapshot::GetRecord(size_t index) const {
+  DCHECK_LT(index, record_count());
+  const uint8_t* entry = bytes_.data() + kHeaderSize + index * kIndexEntrySize;
+  const size_t offset = ReadU32(entry + 4);
+  const size_t length = ReadU32(entry + 8);
+  const size_t records_begin = kHeaderSize + record_count() * kIndexEntrySize;
+  if (offset < records_begin || offset % kRecordAlignment != 0 ||
+      offset > bytes_.size() || length > bytes_.size() - offset) {
+    return base::span<const uint8_t>();
+  }
+  base::span<const uint8_t> record = bytes_.subspan(offset, length);
+  if (ChecksumRecord(record) != ReadU32(entry + 12))
+    return base::span<const uint8_t>();
+  return record;
+}
+
+void HostCacheSnapshot::Take(size_t index) {
+  DCHECK(!taken_[index]);
+  taken_[index] = true;
+  --remaining_count_;
+}
+
+void HostCacheSnapshot::AddRemainingRecordsTo(Builder* builder) const {
+  for (size_t i = 0; i < record_count(); ++i) {
+    if (taken_[i])
+      continue;
+    // Corrupt records are dropped.
+    base::span<const uint8_t> record = GetRecord(i);
+    if (record.empty())
+      continue;
+    builder->records_.emplace_back(
+        GetRecordHash(i),
+        std::string(reinterpret_cast<const char*>(record.data()),
+                    record.size()));
+  }
+}
+
+uint32_t HostCacheSnapshot::GetRecordHash(size_t index) const {
+  DCHECK_LT(index, record_count());
+  return ReadU32(bytes_.data() + kHeaderSize + index * kIndexEntrySize);
+}
+
+}  // namespace net
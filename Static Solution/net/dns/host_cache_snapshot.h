@@ -0,0 +1,119 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DNS_HOST_CACHE_SNAPSHOT_H_
+#define NET_DNS_HOST_CACHE_SNAPSHOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "net/base/net_export.h"
+
+namespace base {
+class FilePath;
+class MemoryMappedFile;
+}  // namespace base
+
+namespace net {
+
+// A HostCache serialized in a compact binary form that can be restored
+// lazily: only the header is checked when the snapshot is opened, and a record
+// is only checked and decoded when its hostname is first looked up.
+//
+// Layout, with fixed-size fields in network byte order:
+//   header:  magic (4) | version (2) | reserved (2) | record count (4)
+//   index:   one (hash of the hostname (4) | offset (4) | length (4) |
+//            checksum (4), a PersistentHash of the payload) per record,
+//            sorted by hash
+//   records: opaque payloads, each starting on a 4 byte boundary
+//
+// HostCache alone knows how to encode and decode the payloads.
+class NET_EXPORT HostCacheSnapshot {
+ public:
+  class NET_EXPORT Builder {
+   public:
+    Builder();
+
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+
+    ~Builder();
+
+    void AddRecord(base::StringPiece hostname,
+                   base::span<const uint8_t> record);
+
+    // Returns the serialized snapshot.
+    std::string Finish();
+
+   private:
+    friend class HostCacheSnapshot;
+
+    // Hashes of the hostnames, and records.
+    std::vector<std::pair<uint32_t, std::string>> records_;
+  };
+
+  // Returns nullptr if |data| is not a valid snapshot.
+  static std::unique_ptr<HostCacheSnapshot> Create(std::string data);
+
+  // Maps the snapshot at |path| into memory. Returns nullptr if the file
+  // can't be mapped or is not a valid snapshot.
+  static std::unique_ptr<HostCacheSnapshot> CreateFromFile(
+      const base::FilePath& path);
+
+  HostCacheSnapshot(const HostCacheSnapshot&) = delete;
+  HostCacheSnapshot& operator=(const HostCacheSnapshot&) = delete;
+
+  ~HostCacheSnapshot();
+
+  size_t record_count() const { return taken_.size(); }
+
+  // Number of records not taken yet.
+  size_t remaining_count() const { return remaining_count_; }
+
+  // Returns the range of record indices whose hostname hashes like
+  // |hostname|. The range may include records of other hostnames.
+  std::pair<size_t, size_t> FindRecords(base::StringPiece hostname) const;
+
+  // Returns the payload of record |index|, or an empty span if the index
+  // entry points outside of the snapshot or the payload does not match its
+  // checksum.
+  base::span<const uint8_t> GetRecord(size_t index) const;
+
+  bool IsTaken(size_t index) const { return taken_[index]; }
+
+  // Marks record |index| as consumed, so it is skipped from then on.
+  void Take(size_t index);
+
+  // Adds the records that have not been taken to |builder|, except corrupt
+  // ones.
+  void AddRemainingRecordsTo(Builder* builder) const;
+
+ private:
+  HostCacheSnapshot(std::unique_ptr<base::MemoryMappedFile> file,
+                    std::string data);
+
+  // Checks the header, and that the index fits in the snapshot.
+  bool Init();
+
+  uint32_t GetRecordHash(size_t index) const;
+
+  // Exactly one of these holds the snapshot.
+  const std::unique_ptr<base::MemoryMappedFile> file_;
+  const std::string data_;
+
+  base::span<const uint8_t> bytes_;
+  std::vector<bool> taken_;
+  size_t remaining_count_ = 0;
+};
+
+}  // namespace net
+
+#endif  // NET_DNS_HOST_CACHE_SNAPSHOT_H_
@@ -12,6 +12,9 @@
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/format_macros.h"
 #include "base/json/json_writer.h"
 #include "base/strings/strcat.h"
@@ -24,6 +27,7 @@
 #include "net/base/connection_endpoint_metadata.h"
 #include "net/base/network_isolation_key.h"
 #include "net/base/schemeful_site.h"
+#include "net/dns/host_cache_snapshot.h"
 #include "net/dns/host_resolver_results.h"
 #include "net/dns/host_resolver_results_test_util.h"
 #include "net/dns/https_record_rdata.h"
@@ -751,6 +755,32 @@ TEST(HostCacheTest, Evict) {
   EXPECT_TRUE(cache.Lookup(key3, now));
 }
 
+// Replacing an entry should reorder it for eviction by its new expiration.
+TEST(HostCacheTest, EvictReplaced) {
+  HostCache cache(2);
+
+  base::TimeTicks now;
+
+  HostCache::Key key1 = Key("foobar.com");
+  HostCache::Key key2 = Key("foobar2.com");
+  HostCache::Key key3 = Key("foobar3.com");
+  HostCache::Entry entry =
+      HostCache::Entry(OK, AddressList(), HostCache::Entry::SOURCE_UNKNOWN);
+
+  cache.Set(key1, entry, now, base::Seconds(5));
+  cache.Set(key2, entry, now, base::Seconds(10));
+
+  // |key1| now expires after |key2|.
+  cache.Set(key1, entry, now, base::Seconds(20));
+  EXPECT_EQ(2u, cache.size());
+
+  cache.Set(key3, entry, now, base::Seconds(10));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Lookup(key1, now));
+  EXPECT_FALSE(cache.Lookup(key2, now));
+  EXPECT_TRUE(cache.Lookup(key3, now));
+}
+
 // Try to retrieve stale entries from the cache. They should be returned by
 // |LookupStale()| but not |Lookup()|, with correct |EntryStaleness| data.
 TEST(HostCacheTest, Stale) {
@@ -1752,6 +1782,236 @@ TEST(HostCacheTest, SerializeAndDeserializeEndpointResult) {
   EXPECT_THAT(result->second.aliases(), Pointee(aliases));
 }
 
+TEST(HostCacheTest, SerializeAndRestoreSnapshot) {
+  base::TimeTicks now;
+  base::TimeDelta ttl = base::Seconds(99);
+  const SchemefulSite site(GURL("https://site.test/"));
+
+  HostCache::Key key1(url::SchemeHostPort(url::kHttpsScheme, "a.test", 443),
+                      DnsQueryType::A, 0, HostResolverSource::DNS,
+                      NetworkIsolationKey(site, site));
+  HostCache::Key key2("b.test", DnsQueryType::TXT, 0, HostResolverSource::ANY,
+                      NetworkIsolationKey());
+  HostCache::Key transient_key("c.test", DnsQueryType::A, 0,
+                               HostResolverSource::ANY,
+                               NetworkIsolationKey::CreateTransient());
+
+  std::vector<IPEndPoint> ip_endpoints = {
+      IPEndPoint(IPAddress(1, 1, 1, 1), 443),
+      IPEndPoint(IPAddress(1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4),
+                 443)};
+  HostCache::Entry entry1(OK, ip_endpoints, HostCache::Entry::SOURCE_DNS, ttl);
+  entry1.set_aliases({"alias.test"});
+  ConnectionEndpointMetadata metadata;
+  metadata.supported_protocol_alpns = {"h3", "h2"};
+  metadata.ech_config_list = {'f', 'o', 'o'};
+  entry1 = HostCache::Entry::MergeEntries(
+      entry1,
+      HostCache::Entry(
+          OK,
+          std::multimap<HttpsRecordPriority, ConnectionEndpointMetadata>{
+              {1u, metadata}},
+          HostCache::Entry::SOURCE_DNS));
+  HostCache::Entry entry2(OK, std::vector<std::string>{"text"},
+                          HostCache::Entry::SOURCE_DNS, ttl);
+
+  HostCache cache(kMaxCacheEntries);
+  cache.Set(key1, entry1, now, ttl);
+  cache.Set(key2, entry2, now, ttl);
+  cache.Set(transient_key, entry2, now, ttl);
+
+  std::unique_ptr<HostCacheSnapshot> snapshot =
+      HostCacheSnapshot::Create(cache.SerializeSnapshot());
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(2u, snapshot->record_count());
+
+  HostCache restored_cache(kMaxCacheEntries);
+  restored_cache.RestoreFromSnapshot(std::move(snapshot));
+  EXPECT_EQ(2u, restored_cache.last_restore_size());
+
+  // Entries are only added to the cache when looked up.
+  EXPECT_EQ(0u, restored_cache.size());
+  base::Value::List serialized_cache;
+  restored_cache.GetList(serialized_cache, false /* include_staleness */,
+                         HostCache::SerializationType::kRestorable);
+  EXPECT_EQ(2u, serialized_cache.size());
+
+  HostCache::EntryStaleness stale;
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      restored_cache.LookupStale(key1, now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result, Pointee(Pair(key1, EntryContentsEqual(entry1))));
+  EXPECT_EQ(HostCache::Entry::SOURCE_UNKNOWN, result->second.source());
+  EXPECT_TRUE(stale.is_stale());
+  EXPECT_EQ(1u, restored_cache.size());
+
+  // Entries that were not looked up are carried over to the next snapshot.
+  HostCache next_cache(kMaxCacheEntries);
+  next_cache.RestoreFromSnapshot(
+      HostCacheSnapshot::Create(restored_cache.SerializeSnapshot()));
+  EXPECT_EQ(2u, next_cache.last_restore_size());
+  result = next_cache.LookupStale(key2, now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result, Pointee(Pair(key2, EntryContentsEqual(entry2))));
+  EXPECT_FALSE(next_cache.LookupStale(transient_key, now, &stale));
+}
+
+TEST(HostCacheTest, SnapshotDoesNotReplaceNewerEntries) {
+  base::TimeTicks now;
+  base::TimeDelta ttl = base::Seconds(99);
+  HostCache::Key key("a.test", DnsQueryType::A, 0, HostResolverSource::ANY,
+                     NetworkIsolationKey());
+  HostCache::Entry old_entry(OK,
+                             std::vector<IPEndPoint>{
+                                 IPEndPoint(IPAddress(1, 1, 1, 1), 0)},
+                             HostCache::Entry::SOURCE_DNS, ttl);
+  HostCache::Entry new_entry(OK,
+                             std::vector<IPEndPoint>{
+                                 IPEndPoint(IPAddress(2, 2, 2, 2), 0)},
+                             HostCache::Entry::SOURCE_DNS, ttl);
+
+  HostCache cache(kMaxCacheEntries);
+  cache.Set(key, old_entry, now, ttl);
+  std::string data = cache.SerializeSnapshot();
+
+  HostCache restored_cache(kMaxCacheEntries);
+  restored_cache.RestoreFromSnapshot(HostCacheSnapshot::Create(data));
+  restored_cache.Set(key, new_entry, now, ttl);
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      restored_cache.Lookup(key, now);
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result, Pointee(Pair(key, EntryContentsEqual(new_entry))));
+
+  // Clearing the cache drops the entries of the snapshot as well.
+  HostCache cleared_cache(kMaxCacheEntries);
+  cleared_cache.RestoreFromSnapshot(HostCacheSnapshot::Create(data));
+  cleared_cache.ClearForHosts(base::BindRepeating(
+      [](const std::string& hostname) { return hostname == "a.test"; }));
+  HostCache::EntryStaleness stale;
+  EXPECT_FALSE(cleared_cache.LookupStale(key, now, &stale));
+}
+
+TEST(HostCacheTest, SnapshotClearForHosts) {
+  base::TimeTicks now;
+  base::TimeDelta ttl = base::Seconds(99);
+  HostCache::Key key1("a.test", DnsQueryType::A, 0, HostResolverSource::ANY,
+                      NetworkIsolationKey());
+  HostCache::Key key2("b.test", DnsQueryType::A, 0, HostResolverSource::ANY,
+                      NetworkIsolationKey());
+  HostCache::Entry entry(OK,
+                         std::vector<IPEndPoint>{
+                             IPEndPoint(IPAddress(1, 1, 1, 1), 0)},
+                         HostCache::Entry::SOURCE_DNS, ttl);
+
+  HostCache cache(kMaxCacheEntries);
+  cache.Set(key1, entry, now, ttl);
+  cache.Set(key2, entry, now, ttl);
+
+  HostCache restored_cache(kMaxCacheEntries);
+  MockPersistenceDelegate delegate;
+  restored_cache.set_persistence_delegate(&delegate);
+  restored_cache.RestoreFromSnapshot(
+      HostCacheSnapshot::Create(cache.SerializeSnapshot()));
+
+  // Records that were never looked up are cleared as well.
+  restored_cache.ClearForHosts(base::BindRepeating(
+      [](const std::string& hostname) { return hostname == "a.test"; }));
+  EXPECT_EQ(1, delegate.num_changes());
+  EXPECT_EQ(0u, restored_cache.size());
+
+  std::unique_ptr<HostCacheSnapshot> snapshot =
+      HostCacheSnapshot::Create(restored_cache.SerializeSnapshot());
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(1u, snapshot->record_count());
+
+  HostCache::EntryStaleness stale;
+  EXPECT_FALSE(restored_cache.LookupStale(key1, now, &stale));
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      restored_cache.LookupStale(key2, now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result, Pointee(Pair(key2, EntryContentsEqual(entry))));
+
+  // Clearing hosts that have no pending records changes nothing.
+  restored_cache.ClearForHosts(base::BindRepeating(
+      [](const std::string& hostname) { return hostname == "c.test"; }));
+  EXPECT_EQ(1, delegate.num_changes());
+}
+
+TEST(HostCacheTest, SnapshotFromFile) {
+  base::TimeTicks now;
+  base::TimeDelta ttl = base::Seconds(99);
+  HostCache::Key key("a.test", DnsQueryType::A, 0, HostResolverSource::ANY,
+                     NetworkIsolationKey());
+  HostCache::Entry entry(OK,
+                         std::vector<IPEndPoint>{
+                             IPEndPoint(IPAddress(1, 1, 1, 1), 0)},
+                         HostCache::Entry::SOURCE_DNS, ttl);
+  HostCache cache(kMaxCacheEntries);
+  cache.Set(key, entry, now, ttl);
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.GetPath().AppendASCII("host_cache");
+  EXPECT_FALSE(HostCacheSnapshot::CreateFromFile(path));
+
+  ASSERT_TRUE(base::WriteFile(path, cache.SerializeSnapshot()));
+  std::unique_ptr<HostCacheSnapshot> snapshot =
+      HostCacheSnapshot::CreateFromFile(path);
+  ASSERT_TRUE(snapshot);
+
+  HostCache restored_cache(kMaxCacheEntries);
+  restored_cache.RestoreFromSnapshot(std::move(snapshot));
+  HostCache::EntryStaleness stale;
+  const std::pair<const HostCache::Key, HostCache::Entry>* result =
+      restored_cache.LookupStale(key, now, &stale);
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result, Pointee(Pair(key, EntryContentsEqual(entry))));
+
+  ASSERT_TRUE(base::WriteFile(path, "not a snapshot"));
+  EXPECT_FALSE(HostCacheSnapshot::CreateFromFile(path));
+}
+
+TEST(HostCacheTest, RejectsCorruptSnapshot) {
+  base::TimeTicks now;
+  base::TimeDelta ttl = base::Seconds(99);
+  HostCache::Key key("a.test", DnsQueryType::A, 0, HostResolverSource::ANY,
+                     NetworkIsolationKey());
+  HostCache cache(kMaxCacheEntries);
+  cache.Set(key,
+            HostCache::Entry(OK,
+                             std::vector<IPEndPoint>{
+                                 IPEndPoint(IPAddress(1, 1, 1, 1), 0)},
+                             HostCache::Entry::SOURCE_DNS, ttl),
+            now, ttl);
+
+  std::string data = cache.SerializeSnapshot();
+  ASSERT_TRUE(HostCacheSnapshot::Create(data));
+  EXPECT_FALSE(HostCacheSnapshot::Create(data.substr(0, 11)));
+  EXPECT_FALSE(HostCacheSnapshot::Create(std::string()));
+
+  // Records are only checked when looked up, and corrupt or truncated ones
+  // are dropped.
+  std::string corrupt = data;
+  corrupt.back() ^= 1;
+  for (const std::string& bad_data :
+       {corrupt, data.substr(0, data.size() - 1)}) {
+    std::unique_ptr<HostCacheSnapshot> snapshot =
+        HostCacheSnapshot::Create(bad_data);
+    ASSERT_TRUE(snapshot);
+    EXPECT_TRUE(snapshot->GetRecord(0).empty());
+
+    HostCache restored_cache(kMaxCacheEntries);
+    restored_cache.RestoreFromSnapshot(std::move(snapshot));
+    std::unique_ptr<HostCacheSnapshot> next_snapshot =
+        HostCacheSnapshot::Create(restored_cache.SerializeSnapshot());
+    ASSERT_TRUE(next_snapshot);
+    EXPECT_EQ(0u, next_snapshot->record_count());
+
+    HostCache::EntryStaleness stale;
+    EXPECT_FALSE(restored_cache.LookupStale(key, now, &stale));
+  }
+}
+
 TEST(HostCacheTest, PersistenceDelegate) {
   const base::TimeDelta kTTL = base::Seconds(10);
   HostCache cache(kMaxCacheEntries);
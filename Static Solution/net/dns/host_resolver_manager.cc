@@ -8,6 +8,7 @@
 #include <cmath>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <set>
@@ -468,6 +469,19 @@ base::Value NetLogResults(const HostCache::Entry& results) {
   return base::Value(std::move(dict));
 }
 
+base::Value NetLogCacheHitParams(const HostCache::Entry& results,
+                                 const HostCache::EntryStaleness& staleness) {
+  base::Value::Dict dict;
+  dict.Set("results", results.NetLogParams());
+  dict.Set("total_hits", results.total_hits());
+  if (staleness.is_stale()) {
+    dict.Set("expired_by_ms",
+             base::saturated_cast<int>(staleness.expired_by.InMilliseconds()));
+    dict.Set("network_changes", staleness.network_changes);
+  }
+  return base::Value(std::move(dict));
+}
+
 base::Value ToLogStringValue(const HostResolver::Host& host) {
   if (absl::holds_alternative<url::SchemeHostPort>(host))
     return base::Value(absl::get<url::SchemeHostPort>(host).Serialize());
@@ -990,6 +1004,235 @@ class HostResolverManager::ProbeRequestImpl
 
 //------------------------------------------------------------------------------
 
+// Runs the HostResolverProc lookups of ProcTask attempts on a ThreadPool task
+// runner, at most |max_concurrent_lookups| first attempts and
+// |max_concurrent_retries| retries at a time, so that retries of stalled
+// attempts can't tie up an unbounded number of worker threads. Retries have
+// their own slots so that stalled first attempts can't keep them from running.
+// Queued lookups are dropped once all the ProcTasks waiting on them are gone.
+//
+// If |deduplicate| is true, an attempt that asks for the same lookup as one
+// that is already queued or running is handed that lookup's results instead of
+// calling the HostResolverProc again. Jobs are deduplicated by JobKey, but jobs
+// that differ only in query types or NetworkIsolationKey often still map to
+// the same system lookup.
+class HostResolverManager::ProcLookupScheduler {
+ public:
+  using CompletionCallback = base::OnceCallback<
+      void(const AddressList& results, int error, const int os_error)>;
+
+  ProcLookupScheduler(scoped_refptr<base::TaskRunner> proc_task_runner,
+                      size_t max_concurrent_lookups,
+                      size_t max_concurrent_retries,
+                      bool deduplicate)
+      : proc_task_runner_(std::move(proc_task_runner)),
+        max_concurrent_lookups_(max_concurrent_lookups),
+        max_concurrent_retries_(max_concurrent_retries),
+        deduplicate_(deduplicate) {
+    DCHECK_GT(max_concurrent_lookups_, 0u);
+    DCHECK_GT(max_concurrent_retries_, 0u);
+  }
+
+  ProcLookupScheduler(const ProcLookupScheduler&) = delete;
+  ProcLookupScheduler& operator=(const ProcLookupScheduler&) = delete;
+
+  ~ProcLookupScheduler() = default;
+
+  // Resolves |hostname| with |resolver_proc| for |proc_task| and calls
+  // |callback| with the results. If |is_retry| is true, a new lookup is always
+  // started, and later attempts join it rather than the older ones, since an
+  // older lookup may be stalled.
+  void Lookup(const std::string& hostname,
+              AddressFamily address_family,
+              HostResolverFlags flags,
+              scoped_refptr<HostResolverProc> resolver_proc,
+              NetworkChangeNotifier::NetworkHandle network,
+              bool is_retry,
+              base::WeakPtr<ProcTask> proc_task,
+              CompletionCallback callback) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    LookupKey key(hostname, address_family, flags, resolver_proc.get(),
+                  network);
+
+    if (deduplicate_) {
+      auto joinable_it = joinable_lookups_.find(key);
+      bool joined = !is_retry && joinable_it != joinable_lookups_.end();
+      UMA_HISTOGRAM_BOOLEAN("Net.DNS.ProcTask.AttemptJoinedLookup", joined);
+      if (joined) {
+        lookups_[joinable_it->second].requests.push_back(
+            {std::move(proc_task), std::move(callback)});
+        return;
+      }
+    }
+
+    uint64_t id = next_lookup_id_++;
+    PendingLookup& lookup = lookups_[id];
+    lookup.key = key;
+    lookup.resolver_proc = std::move(resolver_proc);
+    lookup.is_retry = is_retry;
+    lookup.requests.push_back({std::move(proc_task), std::move(callback)});
+    if (deduplicate_)
+      joinable_lookups_[std::move(key)] = id;
+    (is_retry ? queued_retries_ : queued_lookups_).push_back(id);
+    StartQueuedLookups();
+  }
+
+  void set_task_runner(scoped_refptr<base::TaskRunner> proc_task_runner) {
+    proc_task_runner_ = std::move(proc_task_runner);
+  }
+
+ private:
+  // hostname, address family, flags, resolver proc and target network.
+  using LookupKey = std::tuple<std::string,
+                               AddressFamily,
+                               HostResolverFlags,
+                               const HostResolverProc*,
+                               NetworkChangeNotifier::NetworkHandle>;
+
+  // An attempt waiting on a lookup.
+  struct Request {
+    base::WeakPtr<ProcTask> proc_task;
+    CompletionCallback callback;
+  };
+
+  struct PendingLookup {
+    PendingLookup() = default;
+    PendingLookup(PendingLookup&&) = default;
+    PendingLookup& operator=(PendingLookup&&) = default;
+    ~PendingLookup() = default;
+
+    LookupKey key;
+    scoped_refptr<HostResolverProc> resolver_proc;
+    bool is_retry = false;
+    std::vector<Request> requests;
+  };
+
+  void StartQueuedLookups() {
+    StartLookupsFromQueue(&queued_lookups_, &running_lookups_,
+                          max_concurrent_lookups_);
+    StartLookupsFromQueue(&queued_retries_, &running_retries_,
+                          max_concurrent_retries_);
+  }
+
+  // Starts lookups from |queue| while fewer than |max_running| of its kind
+  // are running. Lookups that no ProcTask is waiting on anymore are dropped.
+  void StartLookupsFromQueue(base::circular_deque<uint64_t>* queue,
+                             size_t* running,
+                             size_t max_running) {
+    while (*running < max_running && !queue->empty()) {
+      uint64_t id = queue->front();
+      queue->pop_front();
+      auto it = lookups_.find(id);
+      DCHECK(it != lookups_.end());
+      if (!HasLiveRequest(it->second)) {
+        EraseLookup(it);
+        continue;
+      }
+      const PendingLookup& lookup = it->second;
+      ++*running;
+      proc_task_runner_->PostTask(
+          FROM_HERE,
+          base::BindOnce(
+              &ProcLookupScheduler::DoLookup, std::get<0>(lookup.key),
+              std::get<1>(lookup.key), std::get<2>(lookup.key),
+              lookup.resolver_proc, base::ThreadTaskRunnerHandle::Get(),
+              base::BindOnce(&ProcLookupScheduler::OnLookupComplete,
+                             weak_ptr_factory_.GetWeakPtr(), id),
+              std::get<4>(lookup.key)));
+    }
+  }
+
+  // WARNING: This code runs in ThreadPool with CONTINUE_ON_SHUTDOWN. The
+  // shutdown code cannot wait for it to finish, so this code must be very
+  // careful about using other objects (like MessageLoops, Singletons, etc).
+  // During shutdown these objects may no longer exist.
+  static void DoLookup(
+      std::string hostname,
+      AddressFamily address_family,
+      HostResolverFlags flags,
+      scoped_refptr<HostResolverProc> resolver_proc,
+      scoped_refptr<base::SingleThreadTaskRunner> network_task_runner,
+      CompletionCallback completion_callback,
+      NetworkChangeNotifier::NetworkHandle network) {
+    AddressList results;
+    int os_error = 0;
+    int error = resolver_proc->Resolve(hostname, address_family, flags,
+                                       &results, &os_error, network);
+
+    network_task_runner->PostTask(
+        FROM_HERE, base::BindOnce(std::move(completion_callback), results,
+                                  error, os_error));
+  }
+
+  static bool HasLiveRequest(const PendingLookup& lookup) {
+    for (const Request& request : lookup.requests) {
+      if (request.proc_task)
+        return true;
+    }
+    return false;
+  }
+
+  void EraseLookup(std::map<uint64_t, PendingLookup>::iterator it) {
+    auto joinable_it = joinable_lookups_.find(it->second.key);
+    if (joinable_it != joinable_lookups_.end() &&
+        joinable_it->second == it->first) {
+      joinable_lookups_.erase(joinable_it);
+    }
+    lookups_.erase(it);
+  }
+
+  void OnLookupComplete(uint64_t id,
+                        const AddressList& results,
+                        int error,
+                        const int os_error) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    auto it = lookups_.find(id);
+    DCHECK(it != lookups_.end());
+    PendingLookup lookup = std::move(it->second);
+    EraseLookup(it);
+    size_t& running = lookup.is_retry ? running_retries_ : running_lookups_;
+    DCHECK_GT(running, 0u);
+    --running;
+
+    // Completing an attempt may complete a Job, whose requests may in turn
+    // destroy the HostResolverManager that owns this scheduler.
+    base::WeakPtr<ProcLookupScheduler> self = weak_ptr_factory_.GetWeakPtr();
+    for (Request& request : lookup.requests) {
+      std::move(request.callback).Run(results, error, os_error);
+      if (!self)
+        return;
+    }
+
+    // Started once the attempts above are done, so that queued retries of the
+    // ProcTasks they completed are dropped rather than run.
+    StartQueuedLookups();
+  }
+
+  scoped_refptr<base::TaskRunner> proc_task_runner_;
+  const size_t max_concurrent_lookups_;
+  const size_t max_concurrent_retries_;
+  const bool deduplicate_;
+
+  // Queued and running lookups, by ID. IDs increase in the order lookups
+  // are started.
+  std::map<uint64_t, PendingLookup> lookups_;
+  // The most recently started lookup for each key.
+  std::map<LookupKey, uint64_t> joinable_lookups_;
+  // First attempts waiting for one of the |max_concurrent_lookups_| slots.
+  base::circular_deque<uint64_t> queued_lookups_;
+  size_t running_lookups_ = 0;
+  // Retries waiting for one of the |max_concurrent_retries_| slots.
+  base::circular_deque<uint64_t> queued_retries_;
+  size_t running_retries_ = 0;
+  uint64_t next_lookup_id_ = 0;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  base::WeakPtrFactory<ProcLookupScheduler> weak_ptr_factory_{this};
+};
+
+//------------------------------------------------------------------------------
+
 // Calls HostResolverProc in ThreadPool. Performs retries if necessary.
 //
 // In non-test code, the HostResolverProc is always SystemHostResolverProc,
@@ -1013,7 +1256,7 @@ class HostResolverManager::ProcTask {
            HostResolverFlags flags,
            const ProcTaskParams& params,
            Callback callback,
-           scoped_refptr<base::TaskRunner> proc_task_runner,
+           ProcLookupScheduler* lookup_scheduler,
            const NetLogWithSource& job_net_log,
            const base::TickClock* tick_clock,
            NetworkChangeNotifier::NetworkHandle network)
@@ -1023,7 +1266,7 @@ class HostResolverManager::ProcTask {
         params_(params),
         callback_(std::move(callback)),
         network_task_runner_(base::ThreadTaskRunnerHandle::Get()),
-        proc_task_runner_(std::move(proc_task_runner)),
+        lookup_scheduler_(lookup_scheduler),
         net_log_(job_net_log),
         tick_clock_(tick_clock),
         network_(network) {
@@ -1071,15 +1314,16 @@ class HostResolverManager::ProcTask {
     DCHECK(!was_completed());
     base::TimeTicks start_time = tick_clock_->NowTicks();
     ++attempt_number_;
-    // Dispatch the lookup attempt to a worker thread.
+    // Dispatch the lookup attempt to a worker thread. Retries start a new
+    // lookup, in case the one the first attempt got is stalled.
     AttemptCompletionCallback completion_callback = base::BindOnce(
         &ProcTask::OnLookupAttemptComplete, weak_ptr_factory_.GetWeakPtr(),
         start_time, attempt_number_, tick_clock_);
-    proc_task_runner_->PostTask(
-        FROM_HERE,
-        base::BindOnce(&ProcTask::DoLookup, hostname_, address_family_, flags_,
-                       params_.resolver_proc, network_task_runner_,
-                       std::move(completion_callback), network_));
+    lookup_scheduler_->Lookup(hostname_, address_family_, flags_,
+                              params_.resolver_proc, network_,
+                              /*is_retry=*/attempt_number_ > 1,
+                              weak_ptr_factory_.GetWeakPtr(),
+                              std::move(completion_callback));
 
     net_log_.AddEventWithIntParams(
         NetLogEventType::HOST_RESOLVER_MANAGER_ATTEMPT_STARTED,
@@ -1100,31 +1344,9 @@ class HostResolverManager::ProcTask {
     }
   }
 
-  // WARNING: This code runs in ThreadPool with CONTINUE_ON_SHUTDOWN. The
-  // shutdown code cannot wait for it to finish, so this code must be very
-  // careful about using other objects (like MessageLoops, Singletons, etc).
-  // During shutdown these objects may no longer exist.
-  static void DoLookup(
-      std::string hostname,
-      AddressFamily address_family,
-      HostResolverFlags flags,
-      scoped_refptr<HostResolverProc> resolver_proc,
-      scoped_refptr<base::SingleThreadTaskRunner> network_task_runner,
-      AttemptCompletionCallback completion_callback,
-      NetworkChangeNotifier::NetworkHandle network) {
-    AddressList results;
-    int os_error = 0;
-    int error = resolver_proc->Resolve(hostname, address_family, flags,
-                                       &results, &os_error, network);
-
-    network_task_runner->PostTask(
-        FROM_HERE, base::BindOnce(std::move(completion_callback), results,
-                                  error, os_error));
-  }
-
-  // Callback for when DoLookup() completes (runs on task runner thread). Now
-  // that we're back in the network thread, checks that |proc_task| is still
-  // valid, and if so, passes back to the object.
+  // Callback for when a lookup attempt completes. Now that we're back in the
+  // network thread, checks that |proc_task| is still valid, and if so, passes
+  // back to the object.
   static void OnLookupAttemptComplete(base::WeakPtr<ProcTask> proc_task,
                                       const base::TimeTicks& start_time,
                                       const uint32_t attempt_number,
@@ -1148,6 +1370,14 @@ class HostResolverManager::ProcTask {
     if (!proc_task)
       return;
 
+    // Includes time spent queued in the ProcLookupScheduler, or waiting on a
+    // lookup started by another ProcTask.
+    base::UmaHistogramMediumTimes(
+        base::StrCat({"Net.DNS.ProcTask.AttemptTime.",
+                      attempt_number == 1 ? "FirstAttempt" : "Retry",
+                      error == OK ? ".Success" : ".Failure"}),
+        tick_clock->NowTicks() - start_time);
+
     proc_task->OnLookupComplete(results, start_time, attempt_number, error,
                                 os_error);
   }
@@ -1198,8 +1428,9 @@ class HostResolverManager::ProcTask {
 
   // Used to post events onto the network thread.
   scoped_refptr<base::SingleThreadTaskRunner> network_task_runner_;
-  // Used to post blocking HostResolverProc tasks.
-  scoped_refptr<base::TaskRunner> proc_task_runner_;
+  // Runs the blocking HostResolverProc lookups. Owned by the
+  // HostResolverManager, which outlives its Jobs and their ProcTasks.
+  raw_ptr<ProcLookupScheduler> lookup_scheduler_;
 
   // Keeps track of the number of attempts we have made so far to resolve the
   // host. Whenever we start an attempt to resolve the host, we increase this
@@ -2173,7 +2404,6 @@ class HostResolverManager::Job : public PrioritizedDispatcher::Job,
       HostCache* host_cache,
       std::deque<TaskType> tasks,
       RequestPriority priority,
-      scoped_refptr<base::TaskRunner> proc_task_runner,
       const NetLogWithSource& source_net_log,
       const base::TickClock* tick_clock)
       : resolver_(resolver),
@@ -2182,7 +2412,6 @@ class HostResolverManager::Job : public PrioritizedDispatcher::Job,
         host_cache_(host_cache),
         tasks_(tasks),
         priority_tracker_(priority),
-        proc_task_runner_(std::move(proc_task_runner)),
         tick_clock_(tick_clock),
         net_log_(
             NetLogWithSource::Make(source_net_log.net_log(),
@@ -2606,7 +2835,8 @@ class HostResolverManager::Job : public PrioritizedDispatcher::Job,
         key_.flags, resolver_->proc_params_,
         base::BindOnce(&Job::OnProcTaskComplete, base::Unretained(this),
                        tick_clock_->NowTicks()),
-        proc_task_runner_, net_log_, tick_clock_, key_.GetTargetNetwork());
+        resolver_->proc_lookup_scheduler_.get(), net_log_, tick_clock_,
+        key_.GetTargetNetwork());
 
     // Start() could be called from within Resolve(), hence it must NOT directly
     // call OnProcTaskComplete, for example, on synchronous failure.
@@ -3054,9 +3284,6 @@ class HostResolverManager::Job : public PrioritizedDispatcher::Job,
   // Tracks the highest priority across |requests_|.
   PriorityTracker priority_tracker_;
 
-  // Task runner used for HostResolverProc.
-  scoped_refptr<base::TaskRunner> proc_task_runner_;
-
   bool had_non_speculative_request_ = false;
 
   // Number of slots occupied by this Job in |dispatcher_|. Should be 0 when
@@ -3130,6 +3357,19 @@ HostResolverManager::HostResolverManager(
   proc_task_runner_ = base::ThreadPool::CreateTaskRunner(
       {base::MayBlock(), priority_mode.Get(),
        base::TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN});
+  // Without deduplication, keep the historical behavior of letting retries
+  // exceed the dispatcher limits. With it, retries get a quarter as many slots
+  // as first attempts on top of them.
+  bool deduplicate_system_lookups =
+      base::FeatureList::IsEnabled(features::kDeduplicateSystemLookups);
+  const size_t kUnlimited = std::numeric_limits<size_t>::max();
+  proc_lookup_scheduler_ = std::make_unique<ProcLookupScheduler>(
+      proc_task_runner_,
+      deduplicate_system_lookups ? job_limits.total_jobs : kUnlimited,
+      deduplicate_system_lookups
+          ? std::max<size_t>(job_limits.total_jobs / 4, 1u)
+          : kUnlimited,
+      deduplicate_system_lookups);
 
 #if BUILDFLAG(IS_WIN)
   EnsureWinsockInit();
@@ -3380,6 +3620,7 @@ void HostResolverManager::SetLastIPv6ProbeResultForTesting(
 void HostResolverManager::SetTaskRunnerForTesting(
     scoped_refptr<base::TaskRunner> task_runner) {
   proc_task_runner_ = std::move(task_runner);
+  proc_lookup_scheduler_->set_task_runner(proc_task_runner_);
 }
 
 // static
@@ -3436,6 +3677,10 @@ int HostResolverManager::Resolve(RequestImpl* request) {
       request->set_results(
           results.CopyWithDefaultPort(GetPort(request->request_host())));
     }
+    if (stale_info && !stale_info->is_stale()) {
+      MaybeStartRefreshAhead(job_key, results, std::move(tasks),
+                             request->host_cache(), request->source_net_log());
+    }
     if (stale_info && !request->parameters().is_speculative)
       request->set_stale_info(std::move(stale_info).value());
     request->set_error_info(results.error(),
@@ -3517,8 +3762,10 @@ HostCache::Entry HostResolverManager::ResolveLocally(
         // |MaybeServeFromCache()| will update |*out_stale_info| as needed.
         DCHECK(out_stale_info->has_value());
         source_net_log.AddEvent(
-            NetLogEventType::HOST_RESOLVER_MANAGER_CACHE_HIT,
-            [&] { return NetLogResults(resolved.value()); });
+            NetLogEventType::HOST_RESOLVER_MANAGER_CACHE_HIT, [&] {
+              return NetLogCacheHitParams(resolved.value(),
+                                          out_stale_info->value());
+            });
 
         // TODO(crbug.com/1200908): Call StartBootstrapFollowup() if the Secure
         // DNS Policy is kBootstrap and the result is not secure.  Note: A naive
@@ -3583,7 +3830,7 @@ HostResolverManager::Job* HostResolverManager::AddJobWithoutRequest(
   auto new_job =
       std::make_unique<Job>(weak_ptr_factory_.GetWeakPtr(), key, cache_usage,
                             host_cache, std::move(tasks), priority,
-                            proc_task_runner_, source_net_log, tick_clock_);
+                            source_net_log, tick_clock_);
   auto insert_result = jobs_.emplace(std::move(key), std::move(new_job));
   auto& iterator = insert_result.first;
   bool is_new = insert_result.second;
@@ -3648,10 +3895,10 @@ absl::optional<HostCache::Entry> HostResolverManager::MaybeServeFromCache(
     staleness = HostCache::kNotStale;
   }
   if (cache_result) {
-    *out_stale_info = std::move(staleness);
     source_net_log.AddEvent(
         NetLogEventType::HOST_RESOLVER_MANAGER_CACHE_HIT,
-        [&] { return NetLogResults(cache_result->second); });
+        [&] { return NetLogCacheHitParams(cache_result->second, staleness); });
+    *out_stale_info = std::move(staleness);
     return cache_result->second;
   }
   return absl::nullopt;
@@ -3693,6 +3940,58 @@ void HostResolverManager::StartBootstrapFollowup(
   job->RunNextTask();
 }
 
+void HostResolverManager::MaybeStartRefreshAhead(
+    const JobKey& key,
+    const HostCache::Entry& entry,
+    std::deque<TaskType> tasks,
+    HostCache* host_cache,
+    const NetLogWithSource& source_net_log) {
+  if (!base::FeatureList::IsEnabled(features::kDnsRefreshAhead) || !host_cache)
+    return;
+  // Only results that came from DNS have a meaningful TTL to refresh ahead of.
+  if (entry.error() != OK || entry.source() != HostCache::Entry::SOURCE_DNS ||
+      !entry.has_ttl()) {
+    return;
+  }
+
+  const base::TimeTicks now = tick_clock_->NowTicks();
+  const base::TimeDelta remaining_ttl = entry.expires() - now;
+  if (remaining_ttl > entry.ttl() * features::kDnsRefreshAheadTtlFraction.Get())
+    return;
+  if (entry.total_hits() < features::kDnsRefreshAheadMinHits.Get())
+    return;
+
+  // The refresh must not be answered from the cache it is meant to update.
+  base::EraseIf(tasks, &IsLocalTask);
+  if (tasks.empty() || jobs_.count(key) != 0)
+    return;
+
+  if (now - refresh_ahead_budget_start_ >= base::Minutes(1)) {
+    refresh_ahead_budget_start_ = now;
+    refresh_ahead_budget_used_ = 0;
+  }
+  if (refresh_ahead_budget_used_ >=
+      features::kDnsRefreshAheadMaxPerMinute.Get()) {
+    source_net_log.AddEvent(
+        NetLogEventType::HOST_RESOLVER_MANAGER_REFRESH_AHEAD_BUDGET_EXHAUSTED);
+    return;
+  }
+  ++refresh_ahead_budget_used_;
+
+  source_net_log.AddEvent(
+      NetLogEventType::HOST_RESOLVER_MANAGER_REFRESH_AHEAD, [&] {
+        base::Value::Dict dict;
+        dict.Set("total_hits", entry.total_hits());
+        dict.Set("remaining_ttl_ms",
+                 base::saturated_cast<int>(remaining_ttl.InMilliseconds()));
+        return base::Value(std::move(dict));
+      });
+  Job* job = AddJobWithoutRequest(
+      key, ResolveHostParameters::CacheUsage::ALLOWED, host_cache,
+      std::move(tasks), RequestPriority::IDLE, source_net_log);
+  job->RunNextTask();
+}
+
 absl::optional<HostCache::Entry> HostResolverManager::ServeFromHosts(
     base::StringPiece hostname,
     DnsQueryTypeSet query_types,
@@ -260,6 +260,7 @@ class NET_EXPORT HostResolverManager
   friend class HostResolverManagerDnsTest;
   class Job;
   struct JobKey;
+  class ProcLookupScheduler;
   class ProcTask;
   class LoopbackProbeJob;
   class DnsTask;
@@ -352,6 +353,17 @@ class NET_EXPORT HostResolverManager
                               HostCache* host_cache,
                               const NetLogWithSource& source_net_log);
 
+  // Called when |entry| was served fresh from |host_cache| for |key|. If
+  // features::kDnsRefreshAhead is enabled and the entry is popular and close to
+  // expiring, re-resolves it at IDLE priority through the non-local |tasks|, so
+  // that the cache is updated before the entry expires. Refreshes are limited
+  // to features::kDnsRefreshAheadMaxPerMinute.
+  void MaybeStartRefreshAhead(const JobKey& key,
+                              const HostCache::Entry& entry,
+                              std::deque<TaskType> tasks,
+                              HostCache* host_cache,
+                              const NetLogWithSource& source_net_log);
+
   // Iff we have a DnsClient with a valid DnsConfig and we're not about to
   // attempt a system lookup, then try to resolve the query using the HOSTS
   // file.
@@ -528,6 +540,8 @@ class NET_EXPORT HostResolverManager
   // Task runner used for DNS lookups using the system resolver. Normally a
   // ThreadPool task runner, but can be overridden for tests.
   scoped_refptr<base::TaskRunner> proc_task_runner_;
+  // Runs the system resolver lookups of ProcTasks on |proc_task_runner_|.
+  std::unique_ptr<ProcLookupScheduler> proc_lookup_scheduler_;
 
   // Shared tick clock, overridden for testing.
   raw_ptr<const base::TickClock> tick_clock_;
@@ -545,6 +559,11 @@ class NET_EXPORT HostResolverManager
   // Helper for metrics associated with `features::kDnsHttpssvc`.
   HttpssvcExperimentDomainCache httpssvc_domain_cache_;
 
+  // Budget of refreshes started by MaybeStartRefreshAhead() for the minute
+  // starting at |refresh_ahead_budget_start_|.
+  base::TimeTicks refresh_ahead_budget_start_;
+  int refresh_ahead_budget_used_ = 0;
+
   THREAD_CHECKER(thread_checker_);
 
   base::WeakPtrFactory<HostResolverManager> weak_ptr_factory_{this};
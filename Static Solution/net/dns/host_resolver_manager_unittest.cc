@@ -3960,6 +3960,120 @@ TEST_F(HostResolverManagerTest, NetworkIsolationKeyWriteToHostCache) {
   }
 }
 
+// Jobs that differ only in NetworkIsolationKey share a system lookup.
+TEST_F(HostResolverManagerTest, DeduplicateSystemLookups) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitWithFeatures(
+      {features::kDeduplicateSystemLookups,
+       features::kSplitHostCacheByNetworkIsolationKey},
+      {});
+  CreateResolver();
+
+  const SchemefulSite kSite1(GURL("https://origin1.test/"));
+  const SchemefulSite kSite2(GURL("https://origin2.test/"));
+  proc_->AddRuleForAllFamilies("just.testing", "192.168.1.42");
+
+  ResolveHostResponseHelper response1(resolver_->CreateRequest(
+      HostPortPair("just.testing", 80), NetworkIsolationKey(kSite1, kSite1),
+      NetLogWithSource(), absl::nullopt, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  ResolveHostResponseHelper response2(resolver_->CreateRequest(
+      HostPortPair("just.testing", 80), NetworkIsolationKey(kSite2, kSite2),
+      NetLogWithSource(), absl::nullopt, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  ASSERT_TRUE(proc_->WaitFor(1u));
+  proc_->SignalMultiple(1u);
+
+  EXPECT_THAT(response1.result_error(), IsOk());
+  EXPECT_THAT(response2.result_error(), IsOk());
+  EXPECT_THAT(response2.request()->GetAddressResults()->endpoints(),
+              testing::ElementsAre(CreateExpected("192.168.1.42", 80)));
+  EXPECT_EQ(1u, proc_->GetCaptureList().size());
+}
+
+// A retry starts its own system lookup rather than joining the stalled one,
+// and later jobs join the retry's lookup.
+TEST_F(HostResolverManagerTest, DeduplicateSystemLookupsRetryStartsNewLookup) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitWithFeatures(
+      {features::kDeduplicateSystemLookups,
+       features::kSplitHostCacheByNetworkIsolationKey},
+      {});
+  ProcTaskParams params = DefaultParams(proc_.get());
+  CreateResolverWithLimitsAndParams(kMaxJobs, params, true /* ipv6_reachable */,
+                                    true /* check_ipv6_on_wifi */);
+
+  auto test_task_runner = base::MakeRefCounted<base::TestMockTimeTaskRunner>();
+  base::ThreadTaskRunnerHandleOverrideForTesting task_runner_handle_override(
+      test_task_runner);
+
+  const SchemefulSite kSite1(GURL("https://origin1.test/"));
+  const SchemefulSite kSite2(GURL("https://origin2.test/"));
+  ResolveHostResponseHelper response1(resolver_->CreateRequest(
+      HostPortPair("just.testing", 80), NetworkIsolationKey(kSite1, kSite1),
+      NetLogWithSource(), absl::nullopt, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  ASSERT_TRUE(proc_->WaitFor(1u));
+
+  test_task_runner->FastForwardBy(params.unresponsive_delay +
+                                  base::Milliseconds(1));
+  ASSERT_TRUE(proc_->WaitFor(2u));
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  ResolveHostResponseHelper response2(resolver_->CreateRequest(
+      HostPortPair("just.testing", 80), NetworkIsolationKey(kSite2, kSite2),
+      NetLogWithSource(), absl::nullopt, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  test_task_runner->RunUntilIdle();
+
+  proc_->SignalMultiple(2u);
+  base::ThreadPoolInstance::Get()->FlushForTesting();
+  test_task_runner->RunUntilIdle();
+  ASSERT_TRUE(response1.complete());
+  ASSERT_TRUE(response2.complete());
+  EXPECT_THAT(response1.result_error(), IsOk());
+  EXPECT_THAT(response2.result_error(), IsOk());
+
+  test_task_runner->FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+}
+
+// Retries of stalled lookups are bounded, and those still queued when their
+// job completes are dropped.
+TEST_F(HostResolverManagerTest, DeduplicateSystemLookupsBoundsRetries) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kDeduplicateSystemLookups);
+  // One job, so a single retry slot.
+  CreateResolverWithLimitsAndParams(1u, DefaultParams(proc_.get()),
+                                    true /* ipv6_reachable */,
+                                    true /* check_ipv6_on_wifi */);
+
+  auto test_task_runner = base::MakeRefCounted<base::TestMockTimeTaskRunner>();
+  base::ThreadTaskRunnerHandleOverrideForTesting task_runner_handle_override(
+      test_task_runner);
+
+  ResolveHostResponseHelper response(resolver_->CreateRequest(
+      HostPortPair("just.testing", 80), NetworkIsolationKey(),
+      NetLogWithSource(), absl::nullopt, resolve_context_.get(),
+      resolve_context_->host_cache()));
+  ASSERT_TRUE(proc_->WaitFor(1u));
+
+  // Every retry is due, but only the first one gets to run.
+  test_task_runner->FastForwardBy(base::Minutes(20));
+  ASSERT_TRUE(proc_->WaitFor(2u));
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  proc_->SignalMultiple(2u);
+  base::ThreadPoolInstance::Get()->FlushForTesting();
+  test_task_runner->RunUntilIdle();
+  ASSERT_TRUE(response.complete());
+  EXPECT_THAT(response.result_error(), IsOk());
+
+  test_task_runner->FastForwardUntilNoTasksRemain();
+  base::ThreadPoolInstance::Get()->FlushForTesting();
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+}
+
 // Check that entries are read to the cache with the right NIK.
 TEST_F(HostResolverManagerTest, NetworkIsolationKeyReadFromHostCache) {
   const SchemefulSite kSite1(GURL("https://origin1.test/"));
@@ -7545,6 +7659,88 @@ TEST_F(HostResolverManagerDnsTest, TtlNotSharedBetweenQtypes) {
   EXPECT_EQ(resolve_context_->host_cache()->size(), 0u);
 }
 
+TEST_F(HostResolverManagerDnsTest, RefreshAhead) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsRefreshAhead,
+      {{"ttl_fraction", "0.1"}, {"min_hits", "2"}});
+
+  CreateResolver();
+  set_allow_fallback_to_proctask(false);
+  ChangeDnsConfig(CreateValidDnsConfig());
+
+  const HostCache::Key key("ok", DnsQueryType::UNSPECIFIED,
+                           0 /* host_resolver_flags */, HostResolverSource::ANY,
+                           NetworkIsolationKey());
+  const base::TimeDelta kTtl = base::Seconds(100);
+  resolve_context_->host_cache()->Set(
+      key,
+      HostCache::Entry(OK, AddressList(CreateExpected("192.0.2.1", 0)),
+                       HostCache::Entry::SOURCE_DNS, kTtl),
+      base::TimeTicks::Now(), kTtl);
+  const base::TimeTicks original_expiration =
+      GetCacheHit(key)->second.expires();
+
+  auto resolve = [&]() {
+    ResolveHostResponseHelper response(resolver_->CreateRequest(
+        HostPortPair("ok", 80), NetworkIsolationKey(), NetLogWithSource(),
+        absl::nullopt, resolve_context_.get(), resolve_context_->host_cache()));
+    EXPECT_THAT(response.result_error(), IsOk());
+    RunUntilIdle();
+  };
+
+  // Not within the last 10% of the TTL yet.
+  resolve();
+  resolve();
+  EXPECT_EQ(original_expiration, GetCacheHit(key)->second.expires());
+
+  FastForwardBy(base::Seconds(95));
+
+  // The first hit within the refresh window is enough, since the entry already
+  // has the required number of hits.
+  resolve();
+  EXPECT_LT(original_expiration, GetCacheHit(key)->second.expires());
+}
+
+TEST_F(HostResolverManagerDnsTest, RefreshAhead_Budget) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kDnsRefreshAhead, {{"min_hits", "1"}, {"max_per_minute", "1"}});
+
+  CreateResolver();
+  set_allow_fallback_to_proctask(false);
+  ChangeDnsConfig(CreateValidDnsConfig());
+
+  const base::TimeDelta kTtl = base::Seconds(100);
+  std::vector<HostCache::Key> keys;
+  for (const char* host : {"ok", "4ok"}) {
+    keys.emplace_back(host, DnsQueryType::UNSPECIFIED,
+                      0 /* host_resolver_flags */, HostResolverSource::ANY,
+                      NetworkIsolationKey());
+    resolve_context_->host_cache()->Set(
+        keys.back(),
+        HostCache::Entry(OK, AddressList(CreateExpected("192.0.2.1", 0)),
+                         HostCache::Entry::SOURCE_DNS, kTtl),
+        base::TimeTicks::Now(), kTtl);
+  }
+  const base::TimeTicks original_expiration =
+      GetCacheHit(keys[0])->second.expires();
+
+  FastForwardBy(base::Seconds(95));
+
+  for (const char* host : {"ok", "4ok"}) {
+    ResolveHostResponseHelper response(resolver_->CreateRequest(
+        HostPortPair(host, 80), NetworkIsolationKey(), NetLogWithSource(),
+        absl::nullopt, resolve_context_.get(), resolve_context_->host_cache()));
+    EXPECT_THAT(response.result_error(), IsOk());
+  }
+  RunUntilIdle();
+
+  // Only the first hit fit in the budget.
+  EXPECT_LT(original_expiration, GetCacheHit(keys[0])->second.expires());
+  EXPECT_EQ(original_expiration, GetCacheHit(keys[1])->second.expires());
+}
+
 TEST_F(HostResolverManagerDnsTest, CanonicalName) {
   MockDnsClientRuleList rules;
   AddDnsRule(&rules, "alias", dns_protocol::kTypeA, IPAddress::IPv4Localhost(),
@@ -4,10 +4,10 @@
 
 #include "net/dns/mdns_cache.h"
 
-#include <algorithm>
 #include <tuple>
 #include <utility>
 
+#include "base/check_op.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "net/dns/public/dns_protocol.h"
@@ -78,56 +78,52 @@ MDnsCache::UpdateType MDnsCache::UpdateDnsRecord(
   if (record->ttl() == 0 && mdns_cache_.find(cache_key) == mdns_cache_.end())
     return NoChange;
 
-  base::Time new_expiration = GetEffectiveExpiration(record.get());
-  if (next_expiration_ != base::Time())
-    new_expiration = std::min(new_expiration, next_expiration_);
-
   std::pair<RecordMap::iterator, bool> insert_result =
       mdns_cache_.insert(std::make_pair(cache_key, nullptr));
   UpdateType type = NoChange;
   if (insert_result.second) {
     type = RecordAdded;
   } else {
-    if (record->ttl() != 0 &&
-        !record->IsEqual(insert_result.first->second.get(), true)) {
+    const RecordParsed* old_record = insert_result.first->second.get();
+    if (record->ttl() != 0 && !record->IsEqual(old_record, true))
       type = RecordChanged;
-    }
+    expirations_.erase(
+        std::make_pair(GetEffectiveExpiration(old_record), old_record));
   }
 
+  expirations_.insert(
+      std::make_pair(GetEffectiveExpiration(record.get()), record.get()));
   insert_result.first->second = std::move(record);
-  next_expiration_ = new_expiration;
   return type;
 }
 
 void MDnsCache::CleanupRecords(
     base::Time now,
     const RecordRemovedCallback& record_removed_callback) {
-  base::Time next_expiration;
-
   // TODO(crbug.com/946688): Make overfill pruning more intelligent than a bulk
   // clearing of everything.
-  bool clear_cache = IsCacheOverfilled();
-
-  // We are guaranteed that |next_expiration_| will be at or before the next
-  // expiration. This allows clients to eagrely call CleanupRecords with
-  // impunity.
-  if (now < next_expiration_ && !clear_cache)
-    return;
-
-  for (auto i = mdns_cache_.begin(); i != mdns_cache_.end();) {
-    base::Time expiration = GetEffectiveExpiration(i->second.get());
-    if (clear_cache || now >= expiration) {
+  if (IsCacheOverfilled()) {
+    expirations_.clear();
+    for (auto i = mdns_cache_.begin(); i != mdns_cache_.end();) {
       record_removed_callback.Run(i->second.get());
       i = mdns_cache_.erase(i);
-    } else {
-      if (next_expiration == base::Time() ||  expiration < next_expiration) {
-        next_expiration = expiration;
-      }
-      ++i;
     }
+    return;
   }
 
-  next_expiration_ = next_expiration;
+  // |expirations_| is ordered by expiration, so this stops at the first record
+  // that is still valid. This allows clients to eagerly call CleanupRecords
+  // with impunity.
+  while (!expirations_.empty() && expirations_.begin()->first <= now) {
+    const RecordParsed* record = expirations_.begin()->second;
+    expirations_.erase(expirations_.begin());
+
+    auto found = mdns_cache_.find(Key::CreateFor(record));
+    DCHECK(found != mdns_cache_.end());
+    DCHECK_EQ(record, found->second.get());
+    record_removed_callback.Run(record);
+    mdns_cache_.erase(found);
+  }
 }
 
 void MDnsCache::FindDnsRecords(unsigned type,
@@ -160,8 +156,10 @@ std::unique_ptr<const RecordParsed> MDnsCache::RemoveRecord(
   auto found = mdns_cache_.find(key);
 
   if (found != mdns_cache_.end() && found->second.get() == record) {
+    expirations_.erase(
+        std::make_pair(GetEffectiveExpiration(record), record));
     std::unique_ptr<const RecordParsed> result = std::move(found->second);
-    mdns_cache_.erase(key);
+    mdns_cache_.erase(found);
     return result;
   }
 
@@ -7,7 +7,9 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/callback.h"
@@ -83,14 +85,16 @@ class NET_EXPORT_PRIVATE MDnsCache {
                       base::Time now) const;
 
   // Remove expired records, call |record_removed_callback| for every removed
-  // record.
+  // record. Only the expired records are visited, unless the cache is
+  // overfilled, in which case everything is removed.
   void CleanupRecords(base::Time now,
                       const RecordRemovedCallback& record_removed_callback);
 
-  // Returns a time less than or equal to the next time a record will expire.
-  // Is updated when CleanupRecords or UpdateDnsRecord are called. Returns
-  // base::Time when the cache is empty.
-  base::Time next_expiration() const { return next_expiration_; }
+  // Returns the next time a record will expire, or base::Time when the cache
+  // is empty.
+  base::Time next_expiration() const {
+    return expirations_.empty() ? base::Time() : expirations_.begin()->first;
+  }
 
   // Remove a record from the cache.  Returns a scoped version of the pointer
   // passed in if it was removed, scoped null otherwise.
@@ -104,6 +108,7 @@ class NET_EXPORT_PRIVATE MDnsCache {
 
  private:
   typedef std::map<Key, std::unique_ptr<const RecordParsed>> RecordMap;
+  typedef std::set<std::pair<base::Time, const RecordParsed*>> ExpirationSet;
 
   // Get the effective expiration of a cache entry, based on its creation time
   // and TTL. Does adjustments so entries with a TTL of zero will have a
@@ -115,9 +120,13 @@ class NET_EXPORT_PRIVATE MDnsCache {
   // for the same name.
   static std::string GetOptionalFieldForRecord(const RecordParsed* record);
 
+  // Ordered by name, then type, so records of a name and type are adjacent.
   RecordMap mdns_cache_;
 
-  base::Time next_expiration_;
+  // Effective expiration of every record in |mdns_cache_|, so that cleanup
+  // only visits the records that have expired.
+  ExpirationSet expirations_;
+
   size_t entry_limit_;
 };
 
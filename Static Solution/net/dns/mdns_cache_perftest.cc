@@ -0,0 +1,162 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/mdns_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/check.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/ip_address.h"
+#include "net/dns/dns_response.h"
+#include "net/dns/dns_test_util.h"
+#include "net/dns/public/dns_protocol.h"
+#include "net/dns/record_parsed.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixMDnsCache[] = "MDnsCache.";
+static constexpr char kMetricUpdateTimeUs[] = "update_time";
+static constexpr char kMetricCleanupTimeUs[] = "cleanup_time";
+static constexpr char kMetricLookupRate[] = "lookups_per_second";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixMDnsCache, story);
+  reporter.RegisterImportantMetric(kMetricUpdateTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricCleanupTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricLookupRate, "runs/s");
+  return reporter;
+}
+
+std::string ServiceName(int i) {
+  return base::StringPrintf("service%d.local", i);
+}
+
+// Parses A records for services `first` to `first + count - 1`, as received at
+// `time_created`. TTLs vary from two minutes to an hour, and a service always
+// gets the same TTL.
+std::vector<std::unique_ptr<const RecordParsed>> BuildRecords(
+    int first,
+    int count,
+    base::Time time_created) {
+  // Keeps every response well below the maximum DNS message size.
+  const int kRecordsPerResponse = 500;
+
+  std::vector<std::unique_ptr<const RecordParsed>> records;
+  for (int begin = first; begin < first + count;
+       begin += kRecordsPerResponse) {
+    const int end = std::min(begin + kRecordsPerResponse, first + count);
+    std::vector<DnsResourceRecord> answers;
+    for (int i = begin; i < end; ++i) {
+      answers.push_back(BuildTestAddressRecord(
+          ServiceName(i), IPAddress(192, 0, 2, 1 + i % 254),
+          base::Seconds(120 + (i * 7919) % 3480)));
+    }
+    DnsResponse response =
+        BuildTestDnsResponse(ServiceName(begin), dns_protocol::kTypeA, answers);
+    DnsRecordParser parser = response.Parser();
+    for (int i = begin; i < end; ++i) {
+      records.push_back(RecordParsed::CreateFrom(&parser, time_created));
+      CHECK(records.back());
+    }
+  }
+  return records;
+}
+
+// Simulates ten minutes of chatty service discovery on a cache of
+// `num_services` records: every second, 1% of the services announce
+// themselves again, and the cache is cleaned up as MDnsClientImpl would. Then
+// measures lookups by name and type.
+void RunTraffic(int num_services, const std::string& story) {
+  const int kSeconds = 600;
+  const int kLookups = 100000;
+  const int refreshes_per_second = std::max(num_services / 100, 1);
+  const base::Time start = base::Time::FromDoubleT(1234.0);
+
+  MDnsCache cache;
+  for (auto& record : BuildRecords(0, num_services, start))
+    cache.UpdateDnsRecord(std::move(record));
+
+  // Built ahead of time, so that parsing is not measured.
+  std::vector<std::vector<std::unique_ptr<const RecordParsed>>> refreshes;
+  for (int second = 1; second <= kSeconds; ++second) {
+    int first = (second * refreshes_per_second) % num_services;
+    refreshes.push_back(BuildRecords(
+        first, std::min(refreshes_per_second, num_services - first),
+        start + base::Seconds(second)));
+  }
+
+  int updates = 0;
+  int removed = 0;
+  const MDnsCache::RecordRemovedCallback on_removed = base::BindRepeating(
+      [](int* removed, const RecordParsed* record) { ++*removed; }, &removed);
+  base::TimeDelta update_time;
+  base::TimeDelta cleanup_time;
+  for (int second = 1; second <= kSeconds; ++second) {
+    const base::Time now = start + base::Seconds(second);
+
+    base::ElapsedTimer update_timer;
+    for (auto& record : refreshes[second - 1]) {
+      cache.UpdateDnsRecord(std::move(record));
+      ++updates;
+    }
+    update_time += update_timer.Elapsed();
+
+    base::ElapsedTimer cleanup_timer;
+    cache.CleanupRecords(now, on_removed);
+    cleanup_time += cleanup_timer.Elapsed();
+  }
+  EXPECT_GT(removed, 0);
+
+  std::vector<std::string> names;
+  names.reserve(num_services);
+  for (int i = 0; i < num_services; ++i)
+    names.push_back(ServiceName(i));
+
+  const base::Time now = start + base::Seconds(kSeconds);
+  std::vector<const RecordParsed*> results;
+  int hits = 0;
+  base::ElapsedTimer lookup_timer;
+  for (int i = 0; i < kLookups; ++i) {
+    // Step through the names with a stride, to defeat the CPU caches.
+    const int index = static_cast<int>((i * 7919LL) % num_services);
+    cache.FindDnsRecords(dns_protocol::kTypeA, names[index], &results, now);
+    if (!results.empty())
+      ++hits;
+  }
+  base::TimeDelta lookup_time = lookup_timer.Elapsed();
+  EXPECT_GT(hits, 0);
+
+  perf_test::PerfResultReporter reporter = SetUpReporter(story);
+  reporter.AddResult(kMetricUpdateTimeUs,
+                     update_time.InMicrosecondsF() / updates);
+  reporter.AddResult(kMetricCleanupTimeUs,
+                     cleanup_time.InMicrosecondsF() / kSeconds);
+  reporter.AddResult(kMetricLookupRate, kLookups / lookup_time.InSecondsF());
+}
+
+TEST(MDnsCachePerfTest, Traffic_1000) {
+  RunTraffic(1000, "1000_services");
+}
+
+TEST(MDnsCachePerfTest, Traffic_10000) {
+  RunTraffic(10000, "10000_services");
+}
+
+TEST(MDnsCachePerfTest, Traffic_50000) {
+  RunTraffic(50000, "50000_services");
+}
+
+}  // namespace
+}  // namespace net
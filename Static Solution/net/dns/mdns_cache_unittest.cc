@@ -284,6 +284,36 @@ TEST_F(MDnsCacheTest, RecordPreemptExpirationTime) {
   EXPECT_EQ(default_time_ + ttl1, cache_.next_expiration());
 }
 
+// Test that refreshing a record with a longer TTL postpones the next expiration
+// time of the cache, and that cleanup then keeps the record.
+TEST_F(MDnsCacheTest, RecordRefreshPostponesExpirationTime) {
+  DnsRecordParser parser(kTestResponsesSameAnswers,
+                         sizeof(kTestResponsesSameAnswers), 0,
+                         /*num_records=*/2);
+
+  std::unique_ptr<const RecordParsed> record1 =
+      RecordParsed::CreateFrom(&parser, default_time_);
+  std::unique_ptr<const RecordParsed> record2 =
+      RecordParsed::CreateFrom(&parser, default_time_);
+  base::TimeDelta ttl1 = base::Seconds(record1->ttl());
+  base::TimeDelta ttl2 = base::Seconds(record2->ttl());
+  std::vector<const RecordParsed*> results;
+
+  EXPECT_EQ(MDnsCache::RecordAdded, cache_.UpdateDnsRecord(std::move(record1)));
+  EXPECT_EQ(default_time_ + ttl1, cache_.next_expiration());
+  EXPECT_EQ(MDnsCache::NoChange, cache_.UpdateDnsRecord(std::move(record2)));
+  EXPECT_EQ(default_time_ + ttl2, cache_.next_expiration());
+
+  // |record_removal_| is a StrictMock, so no record may be removed.
+  cache_.CleanupRecords(
+      default_time_ + ttl1,
+      base::BindRepeating(&RecordRemovalMock::OnRecordRemoved,
+                          base::Unretained(&record_removal_)));
+  cache_.FindDnsRecords(ARecordRdata::kType, "ghs.l.google.com", &results,
+                        default_time_ + ttl1);
+  EXPECT_EQ(1u, results.size());
+}
+
 // Test that the cache handles mDNS "goodbye" packets correctly, not adding the
 // records to the cache if they are not already there, and eventually removing
 // records from the cache if they are.
@@ -366,6 +396,7 @@ TEST_F(MDnsCacheTest, RemoveRecord) {
       cache_.RemoveRecord(results.front());
 
   EXPECT_EQ(record_out.get(), results.front());
+  EXPECT_EQ(base::Time(), cache_.next_expiration());
 
   cache_.FindDnsRecords(dns_protocol::kTypeCNAME, "codereview.chromium.org",
                         &results, default_time_);
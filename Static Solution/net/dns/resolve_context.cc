@@ -177,6 +177,16 @@ size_t ResolveContext::NumAvailableDohServers(const DnsSession* session) const {
                        &ServerStatsToDohAvailability);
 }
 
+base::TimeTicks ResolveContext::GetDohServerLastQuerySuccess(
+    size_t doh_server_index,
+    const DnsSession* session) const {
+  if (!IsCurrentSession(session))
+    return base::TimeTicks();
+
+  CHECK_LT(doh_server_index, doh_server_stats_.size());
+  return doh_server_stats_[doh_server_index].last_query_success;
+}
+
 void ResolveContext::RecordServerFailure(size_t server_index,
                                          bool is_doh_server,
                                          int rv,
@@ -238,6 +248,15 @@ void ResolveContext::RecordServerSuccess(size_t server_index,
     NetworkChangeNotifier::TriggerNonSystemDnsChange();
 }
 
+void ResolveContext::RecordDohServerQuerySuccess(size_t doh_server_index,
+                                                 const DnsSession* session) {
+  if (!IsCurrentSession(session))
+    return;
+
+  GetServerStats(doh_server_index, true /* is_doh_server */)
+      ->last_query_success = base::TimeTicks::Now();
+}
+
 void ResolveContext::RecordRtt(size_t server_index,
                                bool is_doh_server,
                                base::TimeDelta rtt,
@@ -92,6 +92,12 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
   // session.
   size_t NumAvailableDohServers(const DnsSession* session) const;
 
+  // Returns when |doh_server_index| last responded successfully to a query
+  // other than a probe, or a null TimeTicks if it never has. Always null if
+  // |session| is not the current session.
+  base::TimeTicks GetDohServerLastQuerySuccess(size_t doh_server_index,
+                                               const DnsSession* session) const;
+
   // Record failure to get a response from the server (e.g. SERVFAIL, connection
   // failures, or that the server failed to respond before the fallback period
   // elapsed. If |is_doh_server| and the number of failures has surpassed a
@@ -110,6 +116,12 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
                            bool is_doh_server,
                            const DnsSession* session);
 
+  // Record that DoH server |doh_server_index| responded successfully to a
+  // query other than a probe. Called in addition to RecordServerSuccess(). Noop
+  // if |session| is not the current session.
+  void RecordDohServerQuerySuccess(size_t doh_server_index,
+                                   const DnsSession* session);
+
   // Record how long it took to receive a response from the server. Noop if
   // |session| is not the current session.
   void RecordRtt(size_t server_index,
@@ -216,6 +228,9 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
     base::TimeTicks last_failure;
     // Last time when server returned success.
     base::TimeTicks last_success;
+    // Last time when server returned success to a query other than a probe.
+    // Only tracked for DoH servers.
+    base::TimeTicks last_query_success;
 
     // A histogram of observed RTT .
     std::unique_ptr<base::SampleVector> rtt_histogram;
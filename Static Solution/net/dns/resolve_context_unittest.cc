@@ -203,6 +203,36 @@ TEST_F(ResolveContextTest, DohServerAvailability_DifferentSession) {
   EXPECT_TRUE(context.GetDohServerAvailability(1u, session2.get()));
 }
 
+TEST_F(ResolveContextTest, DohServerLastQuerySuccess) {
+  DnsConfig config =
+      CreateDnsConfig(2 /* num_servers */, 2 /* num_doh_servers */);
+  scoped_refptr<DnsSession> session = CreateDnsSession(config);
+
+  auto request_context = CreateTestURLRequestContextBuilder()->Build();
+  ResolveContext context(request_context.get(), true /* enable_caching */);
+  context.InvalidateCachesAndPerSessionData(session.get(),
+                                            false /* network_change */);
+
+  // A probe success makes the server available, but is not a query success.
+  context.RecordServerSuccess(1u /* server_index */, true /* is_doh_server */,
+                              session.get());
+  ASSERT_TRUE(context.GetDohServerAvailability(1u, session.get()));
+  EXPECT_TRUE(
+      context.GetDohServerLastQuerySuccess(1u, session.get()).is_null());
+
+  context.RecordDohServerQuerySuccess(1u, session.get());
+  EXPECT_FALSE(
+      context.GetDohServerLastQuerySuccess(1u, session.get()).is_null());
+  EXPECT_TRUE(
+      context.GetDohServerLastQuerySuccess(0u, session.get()).is_null());
+
+  // Not recorded for a session that is not current.
+  scoped_refptr<DnsSession> other_session = CreateDnsSession(config);
+  context.RecordDohServerQuerySuccess(0u, other_session.get());
+  EXPECT_TRUE(
+      context.GetDohServerLastQuerySuccess(0u, session.get()).is_null());
+}
+
 TEST_F(ResolveContextTest, DohServerIndexToUse) {
   DnsConfig config =
       CreateDnsConfig(2 /* num_servers */, 2 /* num_doh_servers */);
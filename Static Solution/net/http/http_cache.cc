@@ -5,6 +5,8 @@
 #include "net/http/http_cache.h"
 
 #include <algorithm>
+#include <map>
+#include <set>
 #include <utility>
 
 #include "base/bind.h"
@@ -38,6 +40,7 @@
 #include "net/base/upload_data_stream.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_cache_lookup_manager.h"
+#include "net/http/http_cache_prefetch_predictor.h"
 #include "net/http/http_cache_transaction.h"
 #include "net/http/http_cache_writers.h"
 #include "net/http/http_network_layer.h"
@@ -46,6 +49,8 @@
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
 #include "net/http/http_util.h"
+#include "net/log/net_log_event_type.h"
+#include "net/log/net_log_source_type.h"
 #include "net/log/net_log_with_source.h"
 #include "net/quic/quic_server_info.h"
 
@@ -236,6 +241,202 @@ class HttpCache::WorkItem {
 
 //-----------------------------------------------------------------------------
 
+// Runs a conditional request for an entry that was served stale, reading and
+// discarding the response body so that the entry ends up updated. There is no
+// URLRequest behind it, so the request carries whatever cookies the request
+// that was served stale sent, and cookies set by the response are dropped
+// along with its body.
+class HttpCache::BackgroundRevalidation {
+ public:
+  BackgroundRevalidation(HttpCache* cache,
+                         const HttpRequestInfo& request,
+                         const std::string& key,
+                         const NetLogWithSource& request_net_log)
+      : cache_(cache),
+        request_(request),
+        key_(key),
+        net_log_(NetLogWithSource::Make(
+            request_net_log.net_log(),
+            NetLogSourceType::HTTP_CACHE_BACKGROUND_REVALIDATION)) {
+    // Force the conditional request, which is also what keeps this from
+    // starting another background revalidation.
+    request_.load_flags =
+        (request_.load_flags & ~LOAD_SUPPORT_ASYNC_REVALIDATION) |
+        LOAD_VALIDATE_CACHE;
+    net_log_.BeginEventReferencingSource(
+        NetLogEventType::HTTP_CACHE_BACKGROUND_REVALIDATION,
+        request_net_log.source());
+  }
+
+  BackgroundRevalidation(const BackgroundRevalidation&) = delete;
+  BackgroundRevalidation& operator=(const BackgroundRevalidation&) = delete;
+
+  ~BackgroundRevalidation() {
+    if (!done_)
+      net_log_.EndEvent(NetLogEventType::HTTP_CACHE_BACKGROUND_REVALIDATION);
+  }
+
+  void Start() {
+    cache_->CreateTransaction(IDLE, &transaction_);
+    static_cast<HttpCache::Transaction*>(transaction_.get())
+        ->SetIsBackgroundRevalidation();
+    int rv = transaction_->Start(
+        &request_,
+        base::BindOnce(&BackgroundRevalidation::OnStartComplete,
+                       base::Unretained(this)),
+        net_log_);
+    if (rv != ERR_IO_PENDING)
+      OnStartComplete(rv);
+  }
+
+ private:
+  static constexpr int kBufferSize = 32 * 1024;
+
+  void OnStartComplete(int rv) {
+    if (rv != OK) {
+      Done(rv);
+      return;
+    }
+    buf_ = base::MakeRefCounted<IOBuffer>(kBufferSize);
+    Read();
+  }
+
+  void Read() {
+    int rv;
+    do {
+      rv = transaction_->Read(
+          buf_.get(), kBufferSize,
+          base::BindOnce(&BackgroundRevalidation::OnReadComplete,
+                         base::Unretained(this)));
+    } while (rv > 0);
+    if (rv != ERR_IO_PENDING)
+      Done(rv);
+  }
+
+  void OnReadComplete(int rv) {
+    if (rv > 0) {
+      Read();
+      return;
+    }
+    Done(rv);
+  }
+
+  // Deletes |this|.
+  void Done(int rv) {
+    done_ = true;
+    net_log_.EndEventWithNetErrorCode(
+        NetLogEventType::HTTP_CACHE_BACKGROUND_REVALIDATION, rv);
+    cache_->OnBackgroundRevalidationComplete(key_);
+  }
+
+  const raw_ptr<HttpCache> cache_;
+  HttpRequestInfo request_;
+  const std::string key_;
+  const NetLogWithSource net_log_;
+  bool done_ = false;
+  std::unique_ptr<HttpTransaction> transaction_;
+  scoped_refptr<IOBuffer> buf_;
+};
+
+//-----------------------------------------------------------------------------
+
+// Warms up the entries predicted by an HttpCachePrefetchPredictor: opens them,
+// reads their headers and the start of their body, and keeps them open for a
+// little while so that the transaction that reads them next finds them ready
+// instead of waiting on the disk.
+class HttpCache::EntryPrefetcher : public HttpCachePrefetchPredictor::Delegate {
+ public:
+  explicit EntryPrefetcher(HttpCache* cache)
+      : cache_(cache),
+        predictor_(HttpCachePrefetchPredictor::Params(),
+                   this,
+                   &base::TimeTicks::Now) {}
+
+  EntryPrefetcher(const EntryPrefetcher&) = delete;
+  EntryPrefetcher& operator=(const EntryPrefetcher&) = delete;
+
+  ~EntryPrefetcher() override = default;
+
+  void OnEntryRead(const SchemefulSite& top_frame_site,
+                   const std::string& key) {
+    // The transaction reading the entry holds it open from now on.
+    held_entries_.erase(key);
+    predictor_.OnEntryRead(top_frame_site, key);
+  }
+
+  // HttpCachePrefetchPredictor::Delegate implementation:
+  bool PrefetchEntry(const std::string& key) override {
+    disk_cache::Backend* backend = cache_->disk_cache_.get();
+    if (!backend || backend->GetCacheType() == MEMORY_CACHE)
+      return false;
+    if (cache_->FindActiveEntry(key) || held_entries_.count(key) ||
+        opening_entries_.count(key) ||
+        held_entries_.size() + opening_entries_.size() >= kMaxEntries) {
+      return false;
+    }
+
+    opening_entries_.insert(key);
+    disk_cache::EntryResult result = backend->OpenEntry(
+        key, IDLE,
+        base::BindOnce(&EntryPrefetcher::OnEntryOpened,
+                       weak_factory_.GetWeakPtr(), key));
+    if (result.net_error() != ERR_IO_PENDING)
+      OnEntryOpened(key, std::move(result));
+    return true;
+  }
+
+ private:
+  // Maximum number of entries being opened or held open at a time.
+  static constexpr size_t kMaxEntries = 32;
+  // How much of the response body is read ahead.
+  static constexpr int kBodyReadAheadSize = 32 * 1024;
+  // How long an entry is held open if no transaction reads it.
+  static constexpr base::TimeDelta kHoldTime = base::Seconds(10);
+
+  void OnEntryOpened(const std::string& key, disk_cache::EntryResult result) {
+    opening_entries_.erase(key);
+    if (result.net_error() != OK)
+      return;
+
+    disk_cache::ScopedEntryPtr entry(result.ReleaseEntry());
+    ReadAhead(entry.get(), kResponseInfoIndex,
+              entry->GetDataSize(kResponseInfoIndex));
+    ReadAhead(entry.get(), kResponseContentIndex,
+              std::min(entry->GetDataSize(kResponseContentIndex),
+                       kBodyReadAheadSize));
+    base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&EntryPrefetcher::ReleaseEntry,
+                       weak_factory_.GetWeakPtr(), key, entry.get()),
+        kHoldTime);
+    held_entries_[key] = std::move(entry);
+  }
+
+  // The data read is dropped; what matters is that the backend and the OS
+  // have it at hand for the transaction that comes next.
+  static void ReadAhead(disk_cache::Entry* entry, int index, int len) {
+    if (len <= 0)
+      return;
+    auto buf = base::MakeRefCounted<IOBuffer>(len);
+    entry->ReadData(index, 0, buf.get(), len,
+                    base::BindOnce([](scoped_refptr<IOBuffer>, int) {}, buf));
+  }
+
+  void ReleaseEntry(const std::string& key, const disk_cache::Entry* entry) {
+    auto it = held_entries_.find(key);
+    if (it != held_entries_.end() && it->second.get() == entry)
+      held_entries_.erase(it);
+  }
+
+  const raw_ptr<HttpCache> cache_;
+  HttpCachePrefetchPredictor predictor_;
+  std::set<std::string> opening_entries_;
+  std::map<std::string, disk_cache::ScopedEntryPtr> held_entries_;
+  base::WeakPtrFactory<EntryPrefetcher> weak_factory_{this};
+};
+
+//-----------------------------------------------------------------------------
+
 HttpCache::HttpCache(std::unique_ptr<HttpTransactionFactory> network_layer,
                      std::unique_ptr<BackendFactory> backend_factory)
     : net_log_(nullptr),
@@ -244,6 +445,12 @@ HttpCache::HttpCache(std::unique_ptr<HttpTransactionFactory> network_layer,
       network_layer_(std::move(network_layer)),
       clock_(base::DefaultClock::GetInstance()) {
   g_init_cache = true;
+  if (base::FeatureList::IsEnabled(features::kHttpCacheLockTimeout))
+    cache_lock_timeout_ = features::kHttpCacheLockTimeoutDuration.Get();
+  if (base::FeatureList::IsEnabled(
+          features::kHttpCachePrefetchPredictedEntries)) {
+    entry_prefetcher_ = std::make_unique<EntryPrefetcher>(this);
+  }
   HttpNetworkSession* session = network_layer_->GetSession();
   // Session may be NULL in unittests.
   // TODO(mmenke): Seems like tests could be changed to provide a session,
@@ -259,6 +466,10 @@ HttpCache::HttpCache(std::unique_ptr<HttpTransactionFactory> network_layer,
 
 HttpCache::~HttpCache() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  // These own transactions and entries, so let them finish with those first.
+  background_revalidations_.clear();
+  entry_prefetcher_.reset();
+
   // Transactions should see an invalid cache after this point; otherwise they
   // could see an inconsistent object (half destroyed).
   weak_factory_.InvalidateWeakPtrs();
@@ -1267,6 +1478,32 @@ LoadState HttpCache::GetLoadStateForPendingTransaction(
   return !writers ? LOAD_STATE_WAITING_FOR_CACHE : writers->GetLoadState();
 }
 
+void HttpCache::RevalidateInBackground(const HttpRequestInfo& request,
+                                       const std::string& key,
+                                       const NetLogWithSource& net_log) {
+  auto result = background_revalidations_.emplace(key, nullptr);
+  if (!result.second)
+    return;
+  result.first->second =
+      std::make_unique<BackgroundRevalidation>(this, request, key, net_log);
+  result.first->second->Start();
+}
+
+void HttpCache::OnBackgroundRevalidationComplete(const std::string& key) {
+  background_revalidations_.erase(key);
+}
+
+void HttpCache::OnEntryRead(const NetworkIsolationKey& network_isolation_key,
+                            const std::string& key) {
+  if (!entry_prefetcher_)
+    return;
+  const absl::optional<SchemefulSite>& top_frame_site =
+      network_isolation_key.GetTopFrameSite();
+  if (!top_frame_site)
+    return;
+  entry_prefetcher_->OnEntryRead(*top_frame_site, key);
+}
+
 void HttpCache::RemovePendingTransaction(Transaction* transaction) {
   auto i = active_entries_.find(transaction->key());
   bool found = false;
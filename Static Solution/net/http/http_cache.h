@@ -28,6 +28,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/clock.h"
+#include "base/time/time.h"
 #include "build/build_config.h"
 #include "net/base/cache_type.h"
 #include "net/base/completion_once_callback.h"
@@ -55,6 +56,7 @@ namespace net {
 class HttpNetworkSession;
 class HttpResponseInfo;
 class NetLog;
+class NetLogWithSource;
 class NetworkIsolationKey;
 struct HttpRequestInfo;
 
@@ -221,6 +223,12 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory {
                           bool is_subframe_document_resource,
                           bool include_credentials);
 
+  // Returns how long a transaction waits for the lock on an entry that other
+  // transactions are using before it bypasses the cache. This is set by
+  // features::kHttpCacheLockTimeout. Range requests that wait on an exclusive
+  // writer time out much sooner regardless.
+  base::TimeDelta cache_lock_timeout() const { return cache_lock_timeout_; }
+
   // Causes all transactions created after this point to simulate lock timeout
   // and effectively bypass the cache lock whenever there is lock contention.
   void SimulateCacheLockTimeoutForTesting() { bypass_lock_for_test_ = true; }
@@ -299,6 +307,8 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory {
     kNumCacheEntryDataIndices
   };
 
+  class BackgroundRevalidation;
+  class EntryPrefetcher;
   class QuicServerInfoFactoryAdaptor;
   class Transaction;
   class WorkItem;
@@ -596,6 +606,22 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory {
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* transaction);
 
+  // Revalidates the entry |key| for |request| with a transaction of its own,
+  // unless a background revalidation of |key| is already running. Its NetLog
+  // source refers back to |net_log|, the source of |request|.
+  void RevalidateInBackground(const HttpRequestInfo& request,
+                              const std::string& key,
+                              const NetLogWithSource& net_log);
+
+  // Invoked by the BackgroundRevalidation of |key| when it is done.
+  void OnBackgroundRevalidationComplete(const std::string& key);
+
+  // Invoked when a transaction has read the response headers of the entry for
+  // |key| on behalf of |network_isolation_key|, to learn from and warm up the
+  // entries that tend to be read next.
+  void OnEntryRead(const NetworkIsolationKey& network_isolation_key,
+                   const std::string& key);
+
   // Removes the transaction |transaction|, from the pending list of an entry
   // (PendingOp, active or doomed entry).
   void RemovePendingTransaction(Transaction* transaction);
@@ -674,6 +700,15 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory {
   // The set of entries "under construction".
   PendingOpsMap pending_ops_;
 
+  // Revalidations started by RevalidateInBackground, indexed by cache key.
+  std::map<std::string, std::unique_ptr<BackgroundRevalidation>>
+      background_revalidations_;
+
+  base::TimeDelta cache_lock_timeout_ = base::Seconds(20);
+
+  // Set if features::kHttpCachePrefetchPredictedEntries is enabled.
+  std::unique_ptr<EntryPrefetcher> entry_prefetcher_;
+
   // A clock that can be swapped out for testing.
   raw_ptr<base::Clock> clock_;
 
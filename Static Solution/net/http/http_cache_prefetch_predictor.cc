@@ -0,0 +1,56 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache_prefetch_predictor.h"
+
+#include "base/check.h"
+#include "base/metrics/histogram_macros.h"
+
+namespace net {
+
+namespace {
+
+CoOccurrencePredictor<SchemefulSite, std::string>::Params ToPredictorParams(
+    const HttpCachePrefetchPredictor::Params& params) {
+  return {params.group_window, params.min_confidence,
+          params.max_followers_per_leader, params.max_leaders};
+}
+
+}  // namespace
+
+HttpCachePrefetchPredictor::HttpCachePrefetchPredictor(const Params& params,
+                                                       Delegate* delegate,
+                                                       TimeFunc time_func)
+    : delegate_(delegate),
+      predictor_(ToPredictorParams(params), this, time_func) {
+  DCHECK(delegate_);
+}
+
+HttpCachePrefetchPredictor::~HttpCachePrefetchPredictor() = default;
+
+void HttpCachePrefetchPredictor::OnEntryRead(
+    const SchemefulSite& top_frame_site,
+    const std::string& key) {
+  if (predictor_.OnKeySeen(top_frame_site, key))
+    ++stats_.hits;
+}
+
+bool HttpCachePrefetchPredictor::OnPrediction(const std::string& key) {
+  if (!delegate_->PrefetchEntry(key))
+    return false;
+  ++stats_.prefetches;
+  return true;
+}
+
+void HttpCachePrefetchPredictor::OnGroupEnded(size_t hits, size_t misses) {
+  stats_.misses += misses;
+  UMA_HISTOGRAM_COUNTS_100("Net.HttpCache.PrefetchPredictor.PrefetchesPerGroup",
+                           hits + misses);
+  if (misses > 0) {
+    UMA_HISTOGRAM_COUNTS_100("Net.HttpCache.PrefetchPredictor.MissesPerGroup",
+                             misses);
+  }
+}
+
+}  // namespace net
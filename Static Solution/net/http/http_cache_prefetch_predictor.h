@@ -0,0 +1,96 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_CACHE_PREFETCH_PREDICTOR_H_
+#define NET_HTTP_HTTP_CACHE_PREFETCH_PREDICTOR_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/memory/raw_ptr.h"
+#include "base/time/time.h"
+#include "net/base/co_occurrence_predictor.h"
+#include "net/base/net_export.h"
+#include "net/base/schemeful_site.h"
+
+namespace net {
+
+// Learns which HttpCache entries are read together under the same top-frame
+// site, and asks its Delegate to warm up the likely followers as soon as the
+// first entry of such a group is read, rather than in the order the consumer
+// discovers them.
+//
+// Reads are grouped by top-frame site, as described in CoOccurrencePredictor.
+// Leading keys are remembered per top-frame site too, since the same resource
+// is often the first one read by pages of unrelated sites.
+class NET_EXPORT_PRIVATE HttpCachePrefetchPredictor
+    : public CoOccurrencePredictor<SchemefulSite, std::string>::Delegate {
+ public:
+  class NET_EXPORT_PRIVATE Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    // Starts warming up the cache entry for |key|. Returns false if it was
+    // not started, e.g. because the entry is already in use, in which case
+    // the prediction counts as neither a hit nor a miss.
+    virtual bool PrefetchEntry(const std::string& key) = 0;
+  };
+
+  struct NET_EXPORT_PRIVATE Params {
+    // Reads made within this long of a group's first read belong to that
+    // group.
+    base::TimeDelta group_window = base::Seconds(5);
+    // A follower is prefetched once it has been read with its leader this
+    // many more times than it has been missed.
+    int min_confidence = 2;
+    // Maximum number of followers remembered, and prefetched, per leading
+    // key.
+    size_t max_followers_per_leader = 16;
+    // Maximum number of leading keys remembered.
+    size_t max_leaders = 512;
+  };
+
+  struct Stats {
+    // Prefetches issued.
+    size_t prefetches = 0;
+    // Prefetched keys that were read before their group ended.
+    size_t hits = 0;
+    // Prefetched keys that were not read before their group ended.
+    size_t misses = 0;
+  };
+
+  using TimeFunc = base::TimeTicks (*)();
+
+  HttpCachePrefetchPredictor(const Params& params,
+                             Delegate* delegate,
+                             TimeFunc time_func);
+
+  HttpCachePrefetchPredictor(const HttpCachePrefetchPredictor&) = delete;
+  HttpCachePrefetchPredictor& operator=(const HttpCachePrefetchPredictor&) =
+      delete;
+
+  ~HttpCachePrefetchPredictor() override;
+
+  // Called whenever the response headers of the entry for |key| are read from
+  // the cache on behalf of a page of |top_frame_site|. Must not be called for
+  // reads issued by the Delegate, nor for reads the cache makes on its own,
+  // such as background revalidations.
+  void OnEntryRead(const SchemefulSite& top_frame_site, const std::string& key);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // CoOccurrencePredictor::Delegate implementation:
+  bool OnPrediction(const std::string& key) override;
+  void OnGroupEnded(size_t hits, size_t misses) override;
+
+  const raw_ptr<Delegate> delegate_;
+  CoOccurrencePredictor<SchemefulSite, std::string> predictor_;
+  Stats stats_;
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_CACHE_PREFETCH_PREDICTOR_H_
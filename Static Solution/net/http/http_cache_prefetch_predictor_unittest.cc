@@ -0,0 +1,128 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache_prefetch_predictor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "net/base/schemeful_site.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace net {
+namespace {
+
+base::TimeTicks g_now;
+
+base::TimeTicks TestTimeFunc() {
+  return g_now;
+}
+
+class TestDelegate : public HttpCachePrefetchPredictor::Delegate {
+ public:
+  bool PrefetchEntry(const std::string& key) override {
+    if (!accept_prefetches_)
+      return false;
+    prefetches_.push_back(key);
+    return true;
+  }
+
+  void set_accept_prefetches(bool accept) { accept_prefetches_ = accept; }
+
+  const std::vector<std::string>& prefetches() const { return prefetches_; }
+
+ private:
+  bool accept_prefetches_ = true;
+  std::vector<std::string> prefetches_;
+};
+
+class HttpCachePrefetchPredictorTest : public testing::Test {
+ protected:
+  HttpCachePrefetchPredictorTest()
+      : site_(GURL("https://www.example.org")),
+        leader_("https://www.example.org/"),
+        follower1_("https://www.example.org/app.js"),
+        follower2_("https://cdn.example.org/style.css") {
+    g_now = base::TimeTicks() + base::Days(1);
+  }
+
+  void CreatePredictor(const HttpCachePrefetchPredictor::Params& params =
+                           HttpCachePrefetchPredictor::Params()) {
+    params_ = params;
+    predictor_ = std::make_unique<HttpCachePrefetchPredictor>(
+        params, &delegate_, &TestTimeFunc);
+  }
+
+  // Reads |leader| followed by |followers| under |site_| in a fresh group.
+  void RunGroup(const std::string& leader,
+                const std::vector<std::string>& followers) {
+    g_now += params_.group_window + base::Seconds(1);
+    predictor_->OnEntryRead(site_, leader);
+    for (const std::string& follower : followers)
+      predictor_->OnEntryRead(site_, follower);
+  }
+
+  const SchemefulSite site_;
+  const std::string leader_;
+  const std::string follower1_;
+  const std::string follower2_;
+  HttpCachePrefetchPredictor::Params params_;
+  TestDelegate delegate_;
+  std::unique_ptr<HttpCachePrefetchPredictor> predictor_;
+};
+
+TEST_F(HttpCachePrefetchPredictorTest, PrefetchesOnceConfident) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_, follower2_});
+  RunGroup(leader_, {follower1_});
+  EXPECT_TRUE(delegate_.prefetches().empty());
+
+  // Only |follower1_| has been read twice with the leader.
+  RunGroup(leader_, {});
+  ASSERT_EQ(1u, delegate_.prefetches().size());
+  EXPECT_EQ(follower1_, delegate_.prefetches()[0]);
+  EXPECT_EQ(1u, predictor_->stats().prefetches);
+}
+
+TEST_F(HttpCachePrefetchPredictorTest, CountsHitsAndMisses) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+
+  // Prefetched follower read within the window: a hit.
+  RunGroup(leader_, {follower1_});
+  EXPECT_EQ(1u, predictor_->stats().hits);
+
+  // Prefetched follower not read before the group ends: a miss.
+  RunGroup(leader_, {});
+  RunGroup(follower2_, {});
+  EXPECT_EQ(2u, predictor_->stats().prefetches);
+  EXPECT_EQ(1u, predictor_->stats().hits);
+  EXPECT_EQ(1u, predictor_->stats().misses);
+}
+
+TEST_F(HttpCachePrefetchPredictorTest, IgnoresPrefetchesNotStarted) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+
+  // The delegate does not start the prefetch, so it is neither a hit nor a
+  // miss.
+  delegate_.set_accept_prefetches(false);
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {});
+  RunGroup(follower2_, {});
+  EXPECT_EQ(0u, predictor_->stats().prefetches);
+  EXPECT_EQ(0u, predictor_->stats().hits);
+  EXPECT_EQ(0u, predictor_->stats().misses);
+}
+
+}  // namespace
+}  // namespace net
@@ -410,11 +410,15 @@ int HttpCache::Transaction::TransitionToReadingState() {
   // Full request.
   // If it's a writer and a full request then it may read from the cache if its
   // offset is behind the current offset else from the network.
-  int disk_entry_size = entry_->disk_entry->GetDataSize(kResponseContentIndex);
-  if (read_offset_ == disk_entry_size || entry_->writers->network_read_only()) {
+  if (entry_->writers->network_read_only()) {
+    next_state_ = STATE_NETWORK_READ_CACHE_WRITE;
+    return OK;
+  }
+  int64_t network_read_offset = entry_->writers->GetNetworkReadOffset();
+  if (read_offset_ == network_read_offset) {
     next_state_ = STATE_NETWORK_READ_CACHE_WRITE;
   } else {
-    DCHECK_LT(read_offset_, disk_entry_size);
+    DCHECK_LT(read_offset_, network_read_offset);
     next_state_ = STATE_CACHE_READ_DATA;
   }
   return OK;
@@ -1403,7 +1407,7 @@ void HttpCache::Transaction::AddCacheLockTimeoutHandler(ActiveEntry* entry) {
         base::BindOnce(&HttpCache::Transaction::OnCacheLockTimeout,
                        weak_factory_.GetWeakPtr(), entry_lock_waiting_since_));
   } else {
-    int timeout_milliseconds = 20 * 1000;
+    base::TimeDelta timeout = cache_->cache_lock_timeout();
     if (partial_ && entry->writers && !entry->writers->IsEmpty() &&
         entry->writers->IsExclusive()) {
       // Even though entry_->writers takes care of allowing multiple writers to
@@ -1423,13 +1427,13 @@ void HttpCache::Transaction::AddCacheLockTimeoutHandler(ActiveEntry* entry) {
       // Allow some timeout slack for the entry addition to complete in case
       // the writer lock is imminently released; we want to avoid skipping
       // the cache if at all possible. See http://crbug.com/408765
-      timeout_milliseconds = 25;
+      timeout = std::min(timeout, base::Milliseconds(25));
     }
     base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
         FROM_HERE,
         base::BindOnce(&HttpCache::Transaction::OnCacheLockTimeout,
                        weak_factory_.GetWeakPtr(), entry_lock_waiting_since_),
-        base::Milliseconds(timeout_milliseconds));
+        timeout);
   }
 }
 
@@ -1586,6 +1590,10 @@ int HttpCache::Transaction::DoCacheReadResponseComplete(int result) {
     }
   }
 
+  // Reads that the cache makes on its own say nothing about what pages read.
+  if (!is_background_revalidation_)
+    cache_->OnEntryRead(request_->network_isolation_key, cache_key_);
+
   // TODO(crbug.com/713354) Only get data size if there is no other transaction
   // currently writing the response body due to the data race mentioned in the
   // associated bug.
@@ -2470,6 +2478,14 @@ int HttpCache::Transaction::DoCacheReadData() {
                                read_buf_len_, io_callback_);
   }
 
+  // A writer that has fallen behind may find what it needs still in memory.
+  if (InWriters()) {
+    int rv = entry_->writers->ReadFromBroadcastBuffer(
+        read_offset_, read_buf_.get(), read_buf_len_);
+    if (rv != ERR_CACHE_MISS)
+      return rv;
+  }
+
   return entry_->disk_entry->ReadData(kResponseContentIndex, read_offset_,
                                       read_buf_.get(), read_buf_len_,
                                       io_callback_);
@@ -2725,6 +2741,7 @@ int HttpCache::Transaction::BeginCacheValidation() {
 
   bool skip_validation = (required_validation == VALIDATION_NONE);
   bool needs_stale_while_revalidate_cache_update = false;
+  bool revalidate_in_background = false;
 
   if ((effective_load_flags_ & LOAD_SUPPORT_ASYNC_REVALIDATION) &&
       required_validation == VALIDATION_ASYNCHRONOUS) {
@@ -2733,6 +2750,15 @@ int HttpCache::Transaction::BeginCacheValidation() {
     response_.async_revalidation_requested = true;
     needs_stale_while_revalidate_cache_update =
         response_.stale_revalidate_timeout.is_null();
+  } else if (required_validation == VALIDATION_ASYNCHRONOUS && !partial_ &&
+             base::FeatureList::IsEnabled(
+                 features::kHttpCacheBackgroundRevalidation)) {
+    // The consumer won't revalidate, so the cache does it instead.
+    DCHECK_EQ(request_->method, "GET");
+    skip_validation = true;
+    revalidate_in_background = true;
+    needs_stale_while_revalidate_cache_update =
+        response_.stale_revalidate_timeout.is_null();
   }
 
   if (method_ == "HEAD" && (truncated_ || response_.headers->response_code() ==
@@ -2783,6 +2809,8 @@ int HttpCache::Transaction::BeginCacheValidation() {
   if (skip_validation) {
     UpdateCacheEntryStatus(CacheEntryStatus::ENTRY_USED);
     DCHECK(!reading_);
+    if (revalidate_in_background)
+      cache_->RevalidateInBackground(*request_, cache_key_, net_log_);
     TransitionToState(needs_stale_while_revalidate_cache_update
                           ? STATE_CACHE_UPDATE_STALE_WHILE_REVALIDATE_TIMEOUT
                           : STATE_CONNECTED_CALLBACK);
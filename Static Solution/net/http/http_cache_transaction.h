@@ -177,6 +177,9 @@ class NET_EXPORT_PRIVATE HttpCache::Transaction : public HttpTransaction {
   // and this transaction needs to be restarted.
   void SetValidatingCannotProceed();
 
+  // Marks this transaction as a revalidation the cache started on its own.
+  void SetIsBackgroundRevalidation() { is_background_revalidation_ = true; }
+
   // Invoked to remove the association between a transaction waiting to be
   // added to an entry and the entry.
   void ResetCachePendingState() { cache_pending_ = false; }
@@ -662,6 +665,7 @@ class NET_EXPORT_PRIVATE HttpCache::Transaction : public HttpTransaction {
   bool vary_mismatch_ = false;  // The request doesn't match the stored vary
                                 // data.
   bool couldnt_conditionalize_request_ = false;
+  bool is_background_revalidation_ = false;  // Started by the cache itself.
   bool bypass_lock_for_test_ = false;  // A test is exercising the cache lock.
   bool bypass_lock_after_headers_for_test_ = false;  // A test is exercising the
                                                      // cache lock.
@@ -4715,6 +4715,88 @@ TEST_F(HttpCacheTest, SimpleGET_ParallelWritingVerifyNetworkBytes) {
                            kSimpleGET_Transaction);
 }
 
+// Starts two transactions for kSimpleGET_Transaction that share writing of
+// one entry, and reads |first_read_len| bytes with the first while the write
+// of those bytes to the entry is deferred. Then reads with the second, and
+// checks that both get the whole response body.
+static void RunBroadcastReadWhileWritePending(MockHttpCache* cache,
+                                              int first_read_len,
+                                              bool expect_synchronous_read) {
+  MockHttpRequest request(kSimpleGET_Transaction);
+  std::vector<std::unique_ptr<Context>> context_list;
+  for (int i = 0; i < 2; ++i) {
+    context_list.push_back(std::make_unique<Context>());
+    auto& c = context_list[i];
+    c->result = cache->CreateTransaction(&c->trans);
+    ASSERT_THAT(c->result, IsOk());
+    c->result =
+        c->trans->Start(&request, c->callback.callback(), NetLogWithSource());
+  }
+  base::RunLoop().RunUntilIdle();
+  std::string cache_key = request.CacheKey();
+  ASSERT_EQ(2, cache->GetCountWriterTransactions(cache_key));
+
+  scoped_refptr<MockDiskEntry> entry =
+      cache->disk_cache()->GetDiskEntryRef(cache_key);
+  entry->SetDefer(MockDiskEntry::DEFER_WRITE);
+  auto buffer = base::MakeRefCounted<IOBuffer>(first_read_len);
+  TestCompletionCallback first_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            context_list[0]->trans->Read(buffer.get(), first_read_len,
+                                         first_callback.callback()));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0, entry->GetDataSize(1));
+
+  // The second transaction is behind the network read. It can only be served
+  // right away from the broadcast buffer, since the entry does not have the
+  // data yet.
+  const int kSecondReadLen = 100;
+  auto second_buffer = base::MakeRefCounted<IOBuffer>(kSecondReadLen);
+  TestCompletionCallback second_callback;
+  int rv = context_list[1]->trans->Read(second_buffer.get(), kSecondReadLen,
+                                        second_callback.callback());
+  EXPECT_EQ(expect_synchronous_read, rv != ERR_IO_PENDING);
+
+  entry->ResumeDiskEntryOperation();
+  EXPECT_EQ(first_read_len, first_callback.WaitForResult());
+  rv = second_callback.GetResult(rv);
+  ASSERT_EQ(first_read_len, rv);
+
+  const std::string expected(kSimpleGET_Transaction.data);
+  std::string body(buffer->data(), first_read_len);
+  std::string rest;
+  EXPECT_THAT(ReadTransaction(context_list[0]->trans.get(), &rest), IsOk());
+  EXPECT_EQ(expected, body + rest);
+
+  body.assign(second_buffer->data(), rv);
+  rest.clear();
+  EXPECT_THAT(ReadTransaction(context_list[1]->trans.get(), &rest), IsOk());
+  EXPECT_EQ(expected, body + rest);
+}
+
+// Tests that a writer that falls behind is served from the broadcast buffer
+// while the data is still being written to the entry.
+TEST_F(HttpCacheTest, SimpleGET_ParallelWritingBroadcastCacheRead) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttpCacheWritersBroadcast, {{"buffer_size", "1024"}});
+  MockHttpCache cache;
+  RunBroadcastReadWhileWritePending(&cache, /*first_read_len=*/5,
+                                    /*expect_synchronous_read=*/true);
+}
+
+// Tests that a network read larger than the broadcast buffer makes the
+// writers that fall behind wait for the entry, rather than read past its end
+// and see the body end early.
+TEST_F(HttpCacheTest, SimpleGET_ParallelWritingBroadcastReadTooLarge) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttpCacheWritersBroadcast, {{"buffer_size", "4"}});
+  MockHttpCache cache;
+  RunBroadcastReadWhileWritePending(&cache, /*first_read_len=*/10,
+                                    /*expect_synchronous_read=*/false);
+}
+
 // Tests than extra Read from the consumer should not hang/crash the browser.
 TEST_F(HttpCacheTest, SimpleGET_ExtraRead) {
   MockHttpCache cache;
@@ -5510,6 +5592,36 @@ TEST_F(HttpCacheTest, SimpleGET_WriterTimeout) {
   ReadAndVerifyTransaction(c1.trans.get(), kSimpleGET_Transaction);
 }
 
+// Tests that a configured cache lock timeout lets a queued transaction bypass
+// the lock, and so the cache.
+TEST_F(HttpCacheTest, SimpleGET_ConfiguredLockTimeout) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHttpCacheLockTimeout, {{"timeout", "0s"}});
+  MockHttpCache cache;
+  EXPECT_EQ(base::TimeDelta(), cache.http_cache()->cache_lock_timeout());
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context c1, c2;
+  ASSERT_THAT(cache.CreateTransaction(&c1.trans), IsOk());
+  ASSERT_EQ(ERR_IO_PENDING, c1.trans->Start(&request, c1.callback.callback(),
+                                            NetLogWithSource()));
+  ASSERT_THAT(cache.CreateTransaction(&c2.trans), IsOk());
+  ASSERT_EQ(ERR_IO_PENDING, c2.trans->Start(&request, c2.callback.callback(),
+                                            NetLogWithSource()));
+
+  EXPECT_THAT(c2.callback.WaitForResult(), IsOk());
+  ReadAndVerifyTransaction(c2.trans.get(), kSimpleGET_Transaction);
+
+  EXPECT_THAT(c1.callback.WaitForResult(), IsOk());
+  ReadAndVerifyTransaction(c1.trans.get(), kSimpleGET_Transaction);
+
+  // Had the second transaction waited for the lock, it would have shared the
+  // network transaction of the first.
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
 // Tests that a (simulated) timeout allows transactions waiting on the cache
 // lock to continue but read only transactions to error out.
 TEST_F(HttpCacheTest, SimpleGET_WriterTimeoutReadOnlyError) {
@@ -12328,6 +12440,177 @@ TEST_F(HttpCacheTest, StaleContentUsedWhenLoadFlagSetAndUsableThenTimesout) {
   EXPECT_FALSE(response_info.async_revalidation_requested);
 }
 
+// Tests that with background revalidation the cache serves a stale entry
+// without the load flag, and revalidates it itself.
+TEST_F(HttpCacheTest, StaleContentRevalidatedInBackground) {
+  base::test::ScopedFeatureList feature_list(
+      features::kHttpCacheBackgroundRevalidation);
+  MockHttpCache cache;
+  base::SimpleTestClock clock;
+  cache.http_cache()->SetClockForTesting(&clock);
+  cache.network_layer()->SetClock(&clock);
+  clock.Advance(base::Seconds(10));
+
+  ScopedMockTransaction stale_while_revalidate_transaction(
+      kSimpleGET_Transaction);
+  stale_while_revalidate_transaction.response_headers =
+      "Last-Modified: Sat, 18 Apr 2007 01:10:43 GMT\n"
+      "Age: 10801\n"
+      "Cache-Control: max-age=0,stale-while-revalidate=86400\n";
+
+  // Write to the cache.
+  RunTransactionTest(cache.http_cache(), stale_while_revalidate_transaction);
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+
+  // The stale entry is used, and the consumer isn't asked to revalidate.
+  HttpResponseInfo response_info;
+  RunTransactionTestWithResponseInfo(
+      cache.http_cache(), stale_while_revalidate_transaction, &response_info);
+  EXPECT_TRUE(response_info.was_cached);
+  EXPECT_FALSE(response_info.async_revalidation_requested);
+
+  // The cache revalidates the entry on its own.
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+}
+
+class HttpCachePrefetchTest : public TestWithTaskEnvironment {
+ protected:
+  HttpCachePrefetchTest()
+      : TestWithTaskEnvironment(
+            base::test::TaskEnvironment::TimeSource::MOCK_TIME) {
+    feature_list_.InitAndEnableFeature(
+        features::kHttpCachePrefetchPredictedEntries);
+  }
+
+  // Stores in |cache| a response for a URL of its own, and returns the mock
+  // transaction that fetches it.
+  const MockTransaction& AddEntry(MockHttpCache* cache) {
+    urls_.push_back(std::make_unique<std::string>(
+        base::StringPrintf("http://www.example.org/%zu", urls_.size())));
+    MockTransaction transaction(kSimpleGET_Transaction);
+    transaction.url = urls_.back()->c_str();
+    transactions_.push_back(
+        std::make_unique<ScopedMockTransaction>(transaction));
+    RunTransactionTest(cache->http_cache(), *transactions_.back());
+    return *transactions_.back();
+  }
+
+  // Reads the entry of |transaction| from |cache| for a page of |site|.
+  void ReadEntry(MockHttpCache* cache,
+                 const MockTransaction& transaction,
+                 const SchemefulSite& site) {
+    MockHttpRequest request(transaction);
+    request.network_isolation_key = NetworkIsolationKey(site, site);
+    HttpResponseInfo response_info;
+    RunTransactionTestWithRequest(cache->http_cache(), transaction, request,
+                                  &response_info);
+    EXPECT_TRUE(response_info.was_cached);
+  }
+
+  // Reads |leader| and then |followers| for |site| twice, so that the
+  // followers are prefetched the next time |leader| is read.
+  void Teach(MockHttpCache* cache,
+             const SchemefulSite& site,
+             const MockTransaction& leader,
+             const std::vector<const MockTransaction*>& followers) {
+    for (int i = 0; i < 2; ++i) {
+      ReadEntry(cache, leader, site);
+      for (const MockTransaction* follower : followers)
+        ReadEntry(cache, *follower, site);
+      FastForwardBy(base::Seconds(6));
+    }
+  }
+
+  // Returns true if an entry other than the cache's own reference keeps the
+  // entry of |transaction| open.
+  static bool IsEntryOpen(MockHttpCache* cache,
+                          const MockTransaction& transaction) {
+    MockDiskEntry* entry =
+        cache->disk_cache()
+            ->GetDiskEntryRef(MockHttpRequest(transaction).CacheKey())
+            .get();
+    return !entry->HasOneRef();
+  }
+
+  base::test::ScopedFeatureList feature_list_;
+  std::vector<std::unique_ptr<std::string>> urls_;
+  std::vector<std::unique_ptr<ScopedMockTransaction>> transactions_;
+};
+
+// Tests that the entries that tend to be read after an entry are opened and
+// read ahead when it is read, and held open until they are read or for ten
+// seconds.
+TEST_F(HttpCachePrefetchTest, HoldsPredictedEntries) {
+  MockHttpCache cache;
+  const SchemefulSite site(GURL("https://site.test"));
+  const MockTransaction& leader = AddEntry(&cache);
+  const MockTransaction& follower1 = AddEntry(&cache);
+  const MockTransaction& follower2 = AddEntry(&cache);
+  Teach(&cache, site, leader, {&follower1, &follower2});
+  const int open_count = cache.disk_cache()->open_count();
+  const int read_count =
+      cache.disk_cache()
+          ->GetDiskEntryRef(MockHttpRequest(follower1).CacheKey())
+          ->read_count();
+
+  ReadEntry(&cache, leader, site);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(open_count + 3, cache.disk_cache()->open_count());
+  EXPECT_TRUE(IsEntryOpen(&cache, follower1));
+  EXPECT_TRUE(IsEntryOpen(&cache, follower2));
+  // Both the response headers and the body were read ahead.
+  EXPECT_EQ(read_count + 2,
+            cache.disk_cache()
+                ->GetDiskEntryRef(MockHttpRequest(follower1).CacheKey())
+                ->read_count());
+
+  // Reading an entry takes it over from the prefetcher.
+  ReadEntry(&cache, follower1, site);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(IsEntryOpen(&cache, follower1));
+
+  FastForwardBy(base::Seconds(9));
+  EXPECT_TRUE(IsEntryOpen(&cache, follower2));
+  FastForwardBy(base::Seconds(2));
+  EXPECT_FALSE(IsEntryOpen(&cache, follower2));
+}
+
+// Tests that no more than 32 entries are held open at a time.
+TEST_F(HttpCachePrefetchTest, LimitsHeldEntries) {
+  MockHttpCache cache;
+  const MockTransaction& leader = AddEntry(&cache);
+  // Each leader has at most 16 followers, so use three sites.
+  const SchemefulSite sites[] = {SchemefulSite(GURL("https://a.test")),
+                                 SchemefulSite(GURL("https://b.test")),
+                                 SchemefulSite(GURL("https://c.test"))};
+  std::vector<const MockTransaction*> all_followers;
+  for (const SchemefulSite& site : sites) {
+    std::vector<const MockTransaction*> followers;
+    for (int i = 0; i < 16; ++i)
+      followers.push_back(&AddEntry(&cache));
+    Teach(&cache, site, leader, followers);
+    all_followers.insert(all_followers.end(), followers.begin(),
+                         followers.end());
+  }
+  const int open_count = cache.disk_cache()->open_count();
+
+  for (const SchemefulSite& site : sites)
+    ReadEntry(&cache, leader, site);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(open_count + 3 + 32, cache.disk_cache()->open_count());
+  int held_entries = 0;
+  for (const MockTransaction* follower : all_followers) {
+    if (IsEntryOpen(&cache, *follower))
+      ++held_entries;
+  }
+  EXPECT_EQ(32, held_entries);
+
+  FastForwardBy(base::Seconds(11));
+  for (const MockTransaction* follower : all_followers)
+    EXPECT_FALSE(IsEntryOpen(&cache, *follower));
+}
+
 TEST_F(HttpCacheTest, StaleContentUsedWhenLoadFlagSetAndUsable) {
   MockHttpCache cache;
   base::SimpleTestClock clock;
@@ -12,11 +12,13 @@
 #include "base/callback_helpers.h"
 #include "base/debug/crash_logging.h"
 #include "base/debug/dump_without_crashing.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "crypto/secure_hash.h"
 #include "crypto/sha2.h"
+#include "net/base/features.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_cache_transaction.h"
@@ -69,7 +71,13 @@ HttpCache::Writers::TransactionInfo::TransactionInfo(const TransactionInfo&) =
     default;
 
 HttpCache::Writers::Writers(HttpCache* cache, HttpCache::ActiveEntry* entry)
-    : cache_(cache), entry_(entry) {
+    : cache_(cache),
+      entry_(entry),
+      broadcast_capacity_(
+          base::FeatureList::IsEnabled(features::kHttpCacheWritersBroadcast)
+              ? std::max(features::kHttpCacheWritersBroadcastBufferSize.Get(),
+                         0)
+              : 0) {
   DCHECK(cache_);
   DCHECK(entry_);
 }
@@ -327,6 +335,62 @@ bool HttpCache::Writers::ShouldTruncate() {
   return true;
 }
 
+int64_t HttpCache::Writers::GetNetworkReadOffset() const {
+  return std::max<int64_t>(
+      entry_->disk_entry->GetDataSize(kResponseContentIndex),
+      broadcast_end_offset_);
+}
+
+int HttpCache::Writers::ReadFromBroadcastBuffer(int64_t offset,
+                                                IOBuffer* buf,
+                                                int buf_len) const {
+  if (offset >= broadcast_end_offset_ ||
+      offset < broadcast_end_offset_ - static_cast<int64_t>(broadcast_size_)) {
+    return ERR_CACHE_MISS;
+  }
+
+  int len = static_cast<int>(
+      std::min<int64_t>(buf_len, broadcast_end_offset_ - offset));
+  size_t start = offset % broadcast_capacity_;
+  size_t first_len = std::min<size_t>(len, broadcast_capacity_ - start);
+  memcpy(buf->data(), broadcast_buffer_.data() + start, first_len);
+  memcpy(buf->data() + first_len, broadcast_buffer_.data(), len - first_len);
+  return len;
+}
+
+bool HttpCache::Writers::ShouldUseBroadcastBuffer() const {
+  // Partial requests are exclusive, so their offsets never need to be shared.
+  return broadcast_capacity_ > 0 && !is_exclusive_ && !network_read_only_ &&
+         (all_writers_.size() > 1 || !broadcast_buffer_.empty());
+}
+
+void HttpCache::Writers::AppendToBroadcastBuffer(int64_t offset,
+                                                 const char* data,
+                                                 int len) {
+  if (broadcast_buffer_.empty())
+    broadcast_buffer_.resize(broadcast_capacity_);
+  // Only the tail of a chunk larger than the buffer would fit. Readers need
+  // everything between the end of the entry and |broadcast_end_offset_|, so
+  // hold none of it; the chunk then reaches them through the entry.
+  if (static_cast<size_t>(len) > broadcast_capacity_) {
+    broadcast_end_offset_ = offset;
+    broadcast_size_ = 0;
+    return;
+  }
+  // Anything held before a gap is of no use.
+  if (offset != broadcast_end_offset_)
+    broadcast_size_ = 0;
+
+  size_t start = offset % broadcast_capacity_;
+  size_t first_len = std::min<size_t>(len, broadcast_capacity_ - start);
+  memcpy(broadcast_buffer_.data() + start, data, first_len);
+  memcpy(broadcast_buffer_.data(), data + first_len, len - first_len);
+
+  broadcast_end_offset_ = offset + len;
+  broadcast_size_ =
+      std::min(broadcast_size_ + static_cast<size_t>(len), broadcast_capacity_);
+}
+
 LoadState HttpCache::Writers::GetLoadState() const {
   if (network_transaction_)
     return network_transaction_->GetLoadState();
@@ -411,6 +475,7 @@ int HttpCache::Writers::DoLoop(int result) {
 int HttpCache::Writers::DoNetworkRead() {
   DCHECK(network_transaction_);
   next_state_ = State::NETWORK_READ_COMPLETE;
+  read_buf_broadcast_ = false;
 
   // TODO(https://crbug.com/778641): This is a partial mitigation and an attempt
   // to gather more info)
@@ -454,6 +519,20 @@ int HttpCache::Writers::DoNetworkReadComplete(int result) {
   }
 
   next_state_ = State::CACHE_WRITE_DATA;
+
+  if (result > 0 && ShouldUseBroadcastBuffer()) {
+    // Nothing else is writing to the entry, so the data goes at its end.
+    AppendToBroadcastBuffer(
+        entry_->disk_entry->GetDataSize(kResponseContentIndex),
+        read_buf_->data(), result);
+    // Hand the data to the waiting transactions now rather than after it is
+    // written. Until then it can be read back from the buffer, as long as all
+    // of it fits.
+    if (static_cast<size_t>(result) <= broadcast_capacity_) {
+      CompleteWaitingForReadTransactions(result);
+      read_buf_broadcast_ = true;
+    }
+  }
   return result;
 }
 
@@ -610,11 +689,24 @@ void HttpCache::Writers::OnDataReceived(int result) {
     return;
   }
 
+  active_transaction_ = nullptr;
+
+  if (read_buf_broadcast_) {
+    // The transactions waiting now already got this data and are waiting for
+    // the next network read, which the active transaction may never start.
+    read_buf_broadcast_ = false;
+    if (!waiting_for_read_.empty()) {
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE,
+          base::BindOnce(&HttpCache::Writers::ReadForWaitingTransaction,
+                         weak_factory_.GetWeakPtr()));
+    }
+    return;
+  }
+
   // Notify waiting_for_read_. Tasks will be posted for all the
   // transactions.
   CompleteWaitingForReadTransactions(write_len_);
-
-  active_transaction_ = nullptr;
 }
 
 void HttpCache::Writers::OnCacheWriteFailure() {
@@ -662,6 +754,24 @@ void HttpCache::Writers::CompleteWaitingForReadTransactions(int result) {
   }
 }
 
+void HttpCache::Writers::ReadForWaitingTransaction() {
+  // Another transaction may have started reading in the meantime.
+  if (next_state_ != State::NONE || waiting_for_read_.empty())
+    return;
+
+  auto it = waiting_for_read_.begin();
+  Transaction* transaction = it->first;
+  WaitingForRead read_info = std::move(it->second);
+  waiting_for_read_.erase(it);
+
+  auto split_callback = base::SplitOnceCallback(std::move(read_info.callback));
+  int rv = Read(std::move(read_info.read_buf), read_info.read_buf_len,
+                std::move(split_callback.first), transaction);
+  // |this| may have been destroyed if the read completed synchronously.
+  if (rv != ERR_IO_PENDING)
+    std::move(split_callback.second).Run(rv);
+}
+
 void HttpCache::Writers::RemoveIdleWriters(int result) {
   // Since this is only for idle transactions, waiting_for_read_
   // should be empty.
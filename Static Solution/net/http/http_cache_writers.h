@@ -5,8 +5,12 @@
 #ifndef NET_HTTP_HTTP_CACHE_WRITERS_H_
 #define NET_HTTP_HTTP_CACHE_WRITERS_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "base/memory/raw_ptr.h"
 #include "base/memory/weak_ptr.h"
@@ -159,6 +163,17 @@ class NET_EXPORT_PRIVATE HttpCache::Writers {
 
   int GetTransactionsCount() const { return all_writers_.size(); }
 
+  // Returns the offset in the response body up to which data has been read
+  // from the network. This is ahead of the size of the entry while data that
+  // was handed to waiting transactions early is still being written.
+  int64_t GetNetworkReadOffset() const;
+
+  // Copies response body data starting at |offset| into |buf| if it is still
+  // held in the ring buffer that is shared by the writers when
+  // features::kHttpCacheWritersBroadcast is enabled. Returns the number of
+  // bytes copied, or ERR_CACHE_MISS if the data has to be read from the entry.
+  int ReadFromBroadcastBuffer(int64_t offset, IOBuffer* buf, int buf_len) const;
+
  private:
   friend class WritersTest;
 
@@ -213,6 +228,19 @@ class NET_EXPORT_PRIVATE HttpCache::Writers {
   // callback with |result|.
   void CompleteWaitingForReadTransactions(int result);
 
+  // Returns true if data read from the network should be kept in
+  // |broadcast_buffer_|.
+  bool ShouldUseBroadcastBuffer() const;
+
+  // Appends |len| bytes of |data|, which start at |offset| in the response
+  // body, to |broadcast_buffer_|, overwriting its oldest data. If they do not
+  // all fit, empties |broadcast_buffer_| instead.
+  void AppendToBroadcastBuffer(int64_t offset, const char* data, int len);
+
+  // Starts the next network read on behalf of a transaction that invoked Read
+  // while data already handed to the waiting transactions was being written.
+  void ReadForWaitingTransaction();
+
   // Removes idle writers, passing |result| which is to be used for any
   // subsequent read transaction.
   void RemoveIdleWriters(int result);
@@ -295,6 +323,22 @@ class NET_EXPORT_PRIVATE HttpCache::Writers {
   // written.
   bool should_keep_entry_ = true;
 
+  // Ring buffer with the most recent response body data read from the
+  // network, so that waiting transactions don't need to wait for it to be
+  // written to the entry and transactions that fall behind don't need to read
+  // it back. It is only allocated once there is more than one transaction.
+  // Offset |o| in the response body is held at |o % broadcast_capacity_|.
+  // |broadcast_end_offset_| is the offset just past the newest byte, and
+  // |broadcast_size_| how many bytes before it are held.
+  const size_t broadcast_capacity_;
+  std::vector<char> broadcast_buffer_;
+  int64_t broadcast_end_offset_ = 0;
+  size_t broadcast_size_ = 0;
+
+  // True if the transactions waiting for the current network read have
+  // already been handed |read_buf_|, before it was written to the entry.
+  bool read_buf_broadcast_ = false;
+
   // Set if we are currently calculating a checksum of the resource to validate
   // it against the expected checksum for the single-keyed cache. Initialised
   // with selected headers and accumulates the body of the response.
@@ -12,7 +12,9 @@
 
 #include "base/bind.h"
 #include "base/run_loop.h"
+#include "base/test/scoped_feature_list.h"
 #include "crypto/secure_hash.h"
+#include "net/base/features.h"
 #include "net/http/http_cache.h"
 #include "net/http/http_cache_transaction.h"
 #include "net/http/http_response_info.h"
@@ -834,4 +836,63 @@ TEST_F(WritersTest, ContentEncodingShouldNotTruncate) {
   EXPECT_FALSE(ShouldKeepEntry());
 }
 
+// Tests that with a broadcast buffer multiple transactions read the same data,
+// and that the data can later be read back without going to the entry.
+TEST_F(WritersTest, BroadcastReadMultiple) {
+  base::test::ScopedFeatureList feature_list(
+      features::kHttpCacheWritersBroadcast);
+  CreateWritersAddTransaction();
+  AddTransactionToExistingWriters();
+  AddTransactionToExistingWriters();
+
+  ReadAll();
+  EXPECT_EQ(1, test_cache_.WritersDoneWritingToEntryCount());
+
+  std::string expected(kSimpleGET_Transaction.data);
+  scoped_refptr<IOBuffer> buf =
+      base::MakeRefCounted<IOBuffer>(kDefaultBufferSize);
+  int rv = writers_->ReadFromBroadcastBuffer(5, buf.get(), kDefaultBufferSize);
+  ASSERT_EQ(static_cast<int>(expected.size()) - 5, rv);
+  EXPECT_EQ(expected.substr(5), std::string(buf->data(), rv));
+  EXPECT_EQ(ERR_CACHE_MISS,
+            writers_->ReadFromBroadcastBuffer(expected.size(), buf.get(),
+                                              kDefaultBufferSize));
+}
+
+// Tests that a transaction that was handed data before it was written to the
+// entry gets the next data on its following Read, not the same data again.
+TEST_F(WritersTest, BroadcastReadAfterEarlyCompletion) {
+  base::test::ScopedFeatureList feature_list(
+      features::kHttpCacheWritersBroadcast);
+  CreateWritersAddTransaction();
+  AddTransactionToExistingWriters();
+
+  std::string expected(kSimpleGET_Transaction.data);
+  scoped_refptr<IOBuffer> active_buf =
+      base::MakeRefCounted<IOBuffer>(kDefaultBufferSize);
+  scoped_refptr<IOBuffer> waiting_buf =
+      base::MakeRefCounted<IOBuffer>(kDefaultBufferSize);
+  TestCompletionCallback active_callback;
+  TestCompletionCallback waiting_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            writers_->Read(active_buf.get(), kDefaultBufferSize,
+                           active_callback.callback(), transactions_[0].get()));
+  EXPECT_EQ(ERR_IO_PENDING, writers_->Read(waiting_buf.get(),
+                                           kDefaultBufferSize,
+                                           waiting_callback.callback(),
+                                           transactions_[1].get()));
+  ASSERT_EQ(static_cast<int>(expected.size()),
+            waiting_callback.WaitForResult());
+  EXPECT_EQ(expected, std::string(waiting_buf->data(), expected.size()));
+
+  TestCompletionCallback next_callback;
+  int rv = writers_->Read(waiting_buf.get(), kDefaultBufferSize,
+                          next_callback.callback(), transactions_[1].get());
+  EXPECT_EQ(0, next_callback.GetResult(rv));
+
+  ASSERT_EQ(static_cast<int>(expected.size()), active_callback.WaitForResult());
+  EXPECT_EQ(expected, std::string(active_buf->data(), expected.size()));
+  EXPECT_EQ(1, test_cache_.WritersDoneWritingToEntryCount());
+}
+
 }  // namespace net
@@ -44,6 +44,8 @@
 
 #include "net/http/http_chunked_decoder.h"
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/logging.h"
@@ -61,37 +63,44 @@ const size_t HttpChunkedDecoder::kMaxLineBufLen = 16384;
 HttpChunkedDecoder::HttpChunkedDecoder() = default;
 
 int HttpChunkedDecoder::FilterBuf(char* buf, int buf_len) {
+  // Decoded data is compacted towards the start of |buf| as chunk markers are
+  // removed. Rather than shifting the whole rest of the buffer down over each
+  // marker, keep separate read and write offsets, so that each run of chunk
+  // data (and any data after the final CRLF) is moved at most once.
   int result = 0;
+  int read_offset = 0;
 
-  while (buf_len > 0) {
+  while (read_offset < buf_len) {
+    const int available = buf_len - read_offset;
     if (chunk_remaining_ > 0) {
-      // Since |chunk_remaining_| is positive and |buf_len| an int, the minimum
-      // of the two must be an int.
+      // Since |chunk_remaining_| is positive and |available| an int, the
+      // minimum of the two must be an int.
       int num = static_cast<int>(
-          std::min(chunk_remaining_, static_cast<int64_t>(buf_len)));
+          std::min(chunk_remaining_, static_cast<int64_t>(available)));
 
-      buf_len -= num;
+      if (result != read_offset)
+        memmove(buf + result, buf + read_offset, num);
+      read_offset += num;
       chunk_remaining_ -= num;
-
       result += num;
-      buf += num;
 
       // After each chunk's data there should be a CRLF.
       if (chunk_remaining_ == 0)
         chunk_terminator_remaining_ = true;
       continue;
     } else if (reached_eof_) {
-      bytes_after_eof_ += buf_len;
+      // Callers expect the extra bytes to immediately follow the decoded data.
+      if (result != read_offset)
+        memmove(buf + result, buf + read_offset, available);
+      bytes_after_eof_ += available;
       break;  // Done!
     }
 
-    int bytes_consumed = ScanForChunkRemaining(buf, buf_len);
+    int bytes_consumed = ScanForChunkRemaining(buf + read_offset, available);
     if (bytes_consumed < 0)
       return bytes_consumed; // Error
 
-    buf_len -= bytes_consumed;
-    if (buf_len > 0)
-      memmove(buf, buf + bytes_consumed, buf_len);
+    read_offset += bytes_consumed;
   }
 
   return result;
@@ -103,12 +112,13 @@ int HttpChunkedDecoder::ScanForChunkRemaining(const char* buf, int buf_len) {
 
   int bytes_consumed = 0;
 
-  size_t index_of_lf = base::StringPiece(buf, buf_len).find('\n');
-  if (index_of_lf != base::StringPiece::npos) {
-    buf_len = static_cast<int>(index_of_lf);
+  const char* lf = static_cast<const char*>(memchr(buf, '\n', buf_len));
+  if (lf) {
+    int index_of_lf = static_cast<int>(lf - buf);
+    buf_len = index_of_lf;
     if (buf_len && buf[buf_len - 1] == '\r')  // Eliminate a preceding CR.
       buf_len--;
-    bytes_consumed = static_cast<int>(index_of_lf) + 1;
+    bytes_consumed = index_of_lf + 1;
 
     // Make buf point to the full line buffer to parse.
     if (!line_buf_.empty()) {
@@ -0,0 +1,91 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_chunked_decoder.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixHttpChunkedDecoder[] =
+    "HttpChunkedDecoder.";
+static constexpr char kMetricDecodeTimePerMbUs[] = "decode_time_per_mb";
+
+// Size of the decoded body.
+constexpr size_t kBodySize = 16 * 1024 * 1024;
+
+// Size of each buffer handed to FilterBuf(), as HttpStreamParser would for
+// a typical consumer read size.
+constexpr size_t kReadSize = 32 * 1024;
+
+constexpr int kIterations = 5;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHttpChunkedDecoder,
+                                         story);
+  reporter.RegisterImportantMetric(kMetricDecodeTimePerMbUs, "us");
+  return reporter;
+}
+
+std::string EncodeChunked(size_t chunk_size) {
+  std::string encoded;
+  encoded.reserve(kBodySize + kBodySize / chunk_size * 16);
+  for (size_t offset = 0; offset < kBodySize; offset += chunk_size) {
+    size_t len = std::min(chunk_size, kBodySize - offset);
+    encoded += base::StringPrintf("%zx\r\n", len);
+    encoded.append(len, static_cast<char>('a' + offset % 26));
+    encoded += "\r\n";
+  }
+  encoded += "0\r\n\r\n";
+  return encoded;
+}
+
+void RunTest(const std::string& story, size_t chunk_size) {
+  const std::string encoded = EncodeChunked(chunk_size);
+  auto reporter = SetUpReporter(story);
+
+  std::vector<char> buf(kReadSize);
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    HttpChunkedDecoder decoder;
+    size_t decoded = 0;
+    for (size_t offset = 0; offset < encoded.size(); offset += kReadSize) {
+      size_t len = std::min(kReadSize, encoded.size() - offset);
+      std::copy(encoded.begin() + offset, encoded.begin() + offset + len,
+                buf.begin());
+      int rv = decoder.FilterBuf(buf.data(), static_cast<int>(len));
+      CHECK_GE(rv, 0);
+      decoded += rv;
+    }
+    CHECK(decoder.reached_eof());
+    CHECK_EQ(kBodySize, decoded);
+  }
+  reporter.AddResult(kMetricDecodeTimePerMbUs,
+                     timer.Elapsed().InMicrosecondsF() /
+                         (kIterations * (kBodySize / (1024 * 1024))));
+}
+
+TEST(HttpChunkedDecoderPerfTest, SmallChunks) {
+  RunTest("SmallChunks", /*chunk_size=*/64);
+}
+
+TEST(HttpChunkedDecoderPerfTest, MediumChunks) {
+  RunTest("MediumChunks", /*chunk_size=*/1024);
+}
+
+TEST(HttpChunkedDecoderPerfTest, LargeChunks) {
+  RunTest("LargeChunks", /*chunk_size=*/16 * 1024);
+}
+
+}  // namespace
+}  // namespace net
@@ -4,7 +4,9 @@
 
 #include "net/http/http_chunked_decoder.h"
 
+#include <algorithm>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -421,6 +423,67 @@ TEST(HttpChunkedDecoderTest, LongLengthLengthLine) {
   RunTestUntilFailure(inputs, std::size(inputs), 1);
 }
 
+// Encodes many bodies with varied chunk sizes, extensions, line endings and
+// trailers, followed by extra bytes, and checks that decoding them in one
+// buffer and in randomly sized pieces both recover the body, and leave the
+// extra bytes right after the decoded data.
+TEST(HttpChunkedDecoderTest, RandomlySplitInputs) {
+  std::minstd_rand rand(42);
+  for (int iteration = 0; iteration < 500; ++iteration) {
+    std::string body;
+    std::string encoded;
+    const char* line_end = rand() % 2 ? "\r\n" : "\n";
+    const int num_chunks = rand() % 8;
+    for (int i = 0; i < num_chunks; ++i) {
+      std::string chunk(1 + rand() % 300, static_cast<char>('a' + i));
+      body += chunk;
+      encoded += base::StringPrintf("%zx", chunk.size());
+      if (rand() % 4 == 0)
+        encoded += ";name=value";
+      encoded += line_end + chunk + line_end;
+    }
+    encoded += std::string("0") + line_end;
+    if (rand() % 3 == 0)
+      encoded += std::string("Trailer: value") + line_end;
+    encoded += line_end;
+    const std::string extra = rand() % 2 ? "HTTP/1.1 200 OK" : "";
+    encoded += extra;
+
+    // All at once.
+    {
+      HttpChunkedDecoder decoder;
+      std::string buf = encoded;
+      int n = decoder.FilterBuf(&buf[0], static_cast<int>(buf.size()));
+      ASSERT_EQ(static_cast<int>(body.size()), n);
+      EXPECT_EQ(body, buf.substr(0, n));
+      EXPECT_TRUE(decoder.reached_eof());
+      ASSERT_EQ(static_cast<int>(extra.size()), decoder.bytes_after_eof());
+      EXPECT_EQ(extra, buf.substr(n, extra.size()));
+    }
+
+    // In randomly sized pieces.
+    {
+      HttpChunkedDecoder decoder;
+      std::string decoded;
+      std::string after_eof;
+      size_t offset = 0;
+      while (offset < encoded.size()) {
+        size_t len = std::min<size_t>(1 + rand() % 64, encoded.size() - offset);
+        std::string buf = encoded.substr(offset, len);
+        int bytes_after_eof = decoder.bytes_after_eof();
+        int n = decoder.FilterBuf(&buf[0], static_cast<int>(len));
+        ASSERT_GE(n, 0);
+        decoded.append(buf, 0, n);
+        after_eof.append(buf, n, decoder.bytes_after_eof() - bytes_after_eof);
+        offset += len;
+      }
+      EXPECT_EQ(body, decoded);
+      EXPECT_TRUE(decoder.reached_eof());
+      EXPECT_EQ(extra, after_eof);
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace net
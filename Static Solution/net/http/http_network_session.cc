@@ -21,6 +21,7 @@
 #include "net/base/features.h"
 #include "net/dns/host_resolver.h"
 #include "net/http/http_auth_handler_factory.h"
+#include "net/http/http_request_info.h"
 #include "net/http/http_response_body_drainer.h"
 #include "net/http/http_stream_factory.h"
 #include "net/http/url_security_manager.h"
@@ -38,6 +39,8 @@
 #include "net/third_party/quiche/src/quiche/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_tag.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_utils.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/gurl.h"
 
 namespace net {
 
@@ -47,6 +50,30 @@ const int32_t kSpdyStreamMaxRecvWindowSize = 6 * 1024 * 1024;    //  6 MB
 
 namespace {
 
+constexpr net::NetworkTrafficAnnotationTag kHttp2PreconnectTrafficAnnotation =
+    net::DefineNetworkTrafficAnnotation("http2_preconnect_predictor", R"(
+        semantics {
+          sender: "HTTP/2 Preconnect Predictor"
+          description:
+            "Opens a connection to a server that was previously requested "
+            "together with the server currently being requested, so that the "
+            "connection is ready by the time it is needed."
+          trigger:
+            "A request for a server whose connection has repeatedly been "
+            "followed by requests to other servers in the same network "
+            "partition."
+          data:
+            "No request is sent; only DNS, TCP and TLS handshakes are "
+            "performed."
+          destination: WEBSITE
+        }
+        policy {
+          cookies_allowed: NO
+          setting: "This feature cannot be disabled in settings."
+          policy_exception_justification:
+            "Only warms up connections the user's browsing would open anyway."
+        })");
+
 // Keep all HTTP2 parameters in |http2_settings|, even the ones that are not
 // implemented, to be sent to the server.
 // Set default values for settings that |http2_settings| does not specify.
@@ -206,6 +233,15 @@ HttpNetworkSession::HttpNetworkSession(const HttpNetworkSessionParams& params,
 
   next_protos_.push_back(kProtoHTTP11);
 
+  if (params_.enable_http2 && params_.enable_http2_preconnect_prediction) {
+    Http2PreconnectPredictor::Params predictor_params;
+    predictor_params.socket_budget = params_.http2_preconnect_socket_budget;
+    spdy_session_pool_.EnablePreconnectPrediction(
+        predictor_params,
+        base::BindRepeating(&HttpNetworkSession::PreconnectSpdySession,
+                            base::Unretained(this)));
+  }
+
   http_server_properties_->SetMaxServerConfigsStoredInProperties(
       context.quic_context->params()->max_server_configs_stored_in_properties);
   http_server_properties_->SetBrokenAlternativeServicesDelayParams(
@@ -383,6 +419,19 @@ CommonConnectJobParams HttpNetworkSession::CreateCommonConnectJobParams(
       for_websockets ? &websocket_endpoint_lock_manager_ : nullptr);
 }
 
+void HttpNetworkSession::PreconnectSpdySession(const SpdySessionKey& key) {
+  HttpRequestInfo request_info;
+  request_info.url = GURL("https://" + key.host_port_pair().ToString() + "/");
+  request_info.method = "GET";
+  request_info.privacy_mode = key.privacy_mode();
+  request_info.network_isolation_key = key.network_isolation_key();
+  request_info.secure_dns_policy = key.secure_dns_policy();
+  request_info.socket_tag = key.socket_tag();
+  request_info.traffic_annotation =
+      MutableNetworkTrafficAnnotationTag(kHttp2PreconnectTrafficAnnotation);
+  http_stream_factory_->PreconnectStreams(1, request_info);
+}
+
 ClientSocketPoolManager* HttpNetworkSession::GetSocketPoolManager(
     SocketPoolType pool_type) {
   switch (pool_type) {
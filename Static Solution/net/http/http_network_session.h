@@ -149,6 +149,14 @@ struct NET_EXPORT HttpNetworkSessionParams {
   // Enables 0-RTT support.
   bool enable_early_data;
 
+  // If true, the SpdySessionPool learns which HTTP/2 sessions are requested
+  // together per NetworkIsolationKey and preconnects the likely ones when
+  // the first one of a group is requested.
+  bool enable_http2_preconnect_prediction = false;
+  // Maximum number of predicted HTTP/2 preconnects not yet claimed by a
+  // request.
+  size_t http2_preconnect_socket_budget = 6;
+
   // Enables QUIC support.
   bool enable_quic = true;
 
@@ -319,6 +327,10 @@ class NET_EXPORT HttpNetworkSession {
 
   ClientSocketPoolManager* GetSocketPoolManager(SocketPoolType pool_type);
 
+  // Preconnects a session for |key|, on behalf of the SpdySessionPool's
+  // preconnect predictor.
+  void PreconnectSpdySession(const SpdySessionKey& key);
+
   // Flush sockets on low memory notifications callback.
   void OnMemoryPressure(
       base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level);
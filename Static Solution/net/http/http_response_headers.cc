@@ -9,6 +9,8 @@
 
 #include "net/http/http_response_headers.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <limits>
 #include <memory>
@@ -137,6 +139,22 @@ void CheckDoesNotHaveEmbeddedNulls(base::StringPiece str) {
   CHECK(!HasEmbeddedNulls(str));
 }
 
+// Marks the end of a ParsedHeader chain, and an empty HeaderIndexEntry.
+constexpr uint32_t kNoHeader = std::numeric_limits<uint32_t>::max();
+
+// Smallest non-empty size of HttpResponseHeaders::header_index_.
+constexpr size_t kMinHeaderIndexSize = 8;
+
+// Case-insensitive FNV-1a hash of a header name.
+uint32_t HashHeaderName(base::StringPiece name) {
+  uint32_t hash = 2166136261u;
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(base::ToLowerASCII(c));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
 }  // namespace
 
 const char HttpResponseHeaders::kContentRange[] = "Content-Range";
@@ -152,6 +170,10 @@ struct HttpResponseHeaders::ParsedHeader {
   std::string::const_iterator value_begin;
   std::string::const_iterator value_end;
 
+  // Index in |parsed_| of the next non-continuation header with the same
+  // (case-insensitive) name, or kNoHeader. Set by BuildHeaderIndex().
+  uint32_t next_with_same_name = kNoHeader;
+
   // Write a representation of this object into a tracing proto.
   void WriteIntoTrace(perfetto::TracedValue context) const {
     auto dict = std::move(context).WriteDictionary();
@@ -160,12 +182,75 @@ struct HttpResponseHeaders::ParsedHeader {
   }
 };
 
+struct HttpResponseHeaders::HeaderIndexEntry {
+  uint32_t hash = 0;
+  uint32_t first = kNoHeader;
+  uint32_t last = kNoHeader;
+};
+
 //-----------------------------------------------------------------------------
 
+HttpResponseHeaders::Builder::Builder(HttpVersion version,
+                                      base::StringPiece status)
+    : version_(version), status_(status) {
+  DCHECK(version == HttpVersion(1, 0) || version == HttpVersion(1, 1) ||
+         version == HttpVersion(2, 0));
+}
+
+HttpResponseHeaders::Builder::~Builder() = default;
+
+scoped_refptr<HttpResponseHeaders> HttpResponseHeaders::Builder::Build() {
+  return base::MakeRefCounted<HttpResponseHeaders>(BuilderPassKey(), version_,
+                                                   status_, headers_);
+}
+
 HttpResponseHeaders::HttpResponseHeaders(const std::string& raw_input)
     : response_code_(-1) {
   Parse(raw_input);
+  RecordResponseCodeHistogram();
+}
 
+HttpResponseHeaders::HttpResponseHeaders(
+    BuilderPassKey,
+    HttpVersion version,
+    base::StringPiece status,
+    const std::vector<std::pair<base::StringPiece, base::StringPiece>>&
+        headers)
+    : response_code_(-1) {
+  // This must produce the same result as Parse() would on the equivalent raw
+  // header string, but without materializing that string first.
+  DCHECK(!HasEmbeddedNulls(status));
+  std::string status_line = base::StringPrintf(
+      "HTTP/%d.%d ", version.major_value(), version.minor_value());
+  status_line.append(status.data(), status.size());
+
+  // Exact size of the header lines, plus the final NUL.
+  size_t lines_size = 1;
+  for (const auto& header : headers)
+    lines_size += header.first.size() + header.second.size() + 2;
+  // ParseStatusLine() may normalize the status line, e.g. by appending " OK"
+  // to a missing status, so leave a little slack for it.
+  raw_headers_.reserve(status_line.size() + 8 + lines_size);
+
+  ParseStatusLine(status_line.begin(), status_line.end(), !headers.empty());
+  raw_headers_.push_back('\0');
+  size_t status_line_len = raw_headers_.size();
+
+  for (const auto& header : headers) {
+    DCHECK(!HasEmbeddedNulls(header.first));
+    DCHECK(!HasEmbeddedNulls(header.second));
+    raw_headers_.append(header.first.data(), header.first.size());
+    raw_headers_.push_back(':');
+    raw_headers_.append(header.second.data(), header.second.size());
+    raw_headers_.push_back('\0');
+  }
+  raw_headers_.push_back('\0');
+
+  ParseHeaderLines(status_line_len);
+  RecordResponseCodeHistogram();
+}
+
+void HttpResponseHeaders::RecordResponseCodeHistogram() const {
   // The most important thing to do with this histogram is find out
   // the existence of unusual HTTP status codes.  As it happens
   // right now, there aren't double-constructions of response headers
@@ -472,6 +557,7 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
 
   if (line_end == raw_input.end()) {
     raw_headers_.push_back('\0');  // Ensure the headers end with a double null.
+    header_index_.clear();
 
     DCHECK_EQ('\0', raw_headers_[raw_headers_.size() - 2]);
     DCHECK_EQ('\0', raw_headers_[raw_headers_.size() - 1]);
@@ -492,15 +578,31 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
     raw_headers_.push_back('\0');
   }
 
-  // Adjust to point at the null byte following the status line
-  line_end = raw_headers_.begin() + status_line_len - 1;
+  ParseHeaderLines(status_line_len);
+}
 
-  HttpUtil::HeadersIterator headers(line_end + 1, raw_headers_.end(),
-                                    std::string(1, '\0'));
-  while (headers.GetNext()) {
-    AddHeader(headers.name_begin(), headers.name_end(), headers.values_begin(),
-              headers.values_end());
+void HttpResponseHeaders::ParseHeaderLines(size_t status_line_len) {
+  DCHECK_GE(raw_headers_.size(), status_line_len + 1);
+
+  // The header lines are NUL-terminated, so find them with memchr(), which is
+  // vectorized, rather than through the character-at-a-time tokenizer of
+  // HttpUtil::HeadersIterator. Empty lines are skipped, as the tokenizer does.
+  const char* const data = raw_headers_.data();
+  const size_t size = raw_headers_.size();
+  size_t line_start = status_line_len;
+  while (line_start < size) {
+    const void* nul = memchr(data + line_start, '\0', size - line_start);
+    size_t line_end = nul ? static_cast<const char*>(nul) - data : size;
+    std::string::const_iterator name_begin, name_end, values_begin, values_end;
+    if (line_end > line_start &&
+        HttpUtil::ParseHeaderLine(raw_headers_.cbegin() + line_start,
+                                  raw_headers_.cbegin() + line_end, &name_begin,
+                                  &name_end, &values_begin, &values_end)) {
+      AddHeader(name_begin, name_end, values_begin, values_end);
+    }
+    line_start = line_end + 1;
   }
+  BuildHeaderIndex();
 
   DCHECK_EQ('\0', raw_headers_[raw_headers_.size() - 2]);
   DCHECK_EQ('\0', raw_headers_[raw_headers_.size() - 1]);
@@ -745,18 +847,76 @@ void HttpResponseHeaders::ParseStatusLine(
   raw_headers_.append(p, line_end);
 }
 
-size_t HttpResponseHeaders::FindHeader(size_t from,
-                                       base::StringPiece search) const {
-  for (size_t i = from; i < parsed_.size(); ++i) {
+void HttpResponseHeaders::BuildHeaderIndex() {
+  header_index_.clear();
+
+  size_t num_names = 0;
+  for (const ParsedHeader& header : parsed_) {
+    if (!header.is_continuation())
+      ++num_names;
+  }
+  if (num_names == 0)
+    return;
+  CHECK_LT(parsed_.size(), kNoHeader);
+
+  // Keep the table at most half full so that probe sequences stay short and
+  // always reach an empty slot.
+  size_t capacity = kMinHeaderIndexSize;
+  while (capacity < 2 * num_names)
+    capacity *= 2;
+  header_index_.resize(capacity);
+  const size_t mask = capacity - 1;
+
+  for (uint32_t i = 0; i < parsed_.size(); ++i) {
     if (parsed_[i].is_continuation())
       continue;
     auto name =
         base::MakeStringPiece(parsed_[i].name_begin, parsed_[i].name_end);
-    if (base::EqualsCaseInsensitiveASCII(search, name))
-      return i;
+    const uint32_t hash = HashHeaderName(name);
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+      HeaderIndexEntry& entry = header_index_[slot];
+      if (entry.first == kNoHeader) {
+        entry.hash = hash;
+        entry.first = entry.last = i;
+        break;
+      }
+      if (entry.hash == hash &&
+          base::EqualsCaseInsensitiveASCII(
+              name, base::MakeStringPiece(parsed_[entry.first].name_begin,
+                                          parsed_[entry.first].name_end))) {
+        parsed_[entry.last].next_with_same_name = i;
+        entry.last = i;
+        break;
+      }
+    }
   }
+}
 
-  return std::string::npos;
+size_t HttpResponseHeaders::FindHeader(size_t from,
+                                       base::StringPiece search) const {
+  if (header_index_.empty())
+    return std::string::npos;
+
+  const size_t mask = header_index_.size() - 1;
+  const uint32_t hash = HashHeaderName(search);
+  for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    const HeaderIndexEntry& entry = header_index_[slot];
+    if (entry.first == kNoHeader)
+      return std::string::npos;
+    if (entry.hash != hash)
+      continue;
+    const ParsedHeader& first = parsed_[entry.first];
+    if (!base::EqualsCaseInsensitiveASCII(
+            search, base::MakeStringPiece(first.name_begin, first.name_end))) {
+      continue;
+    }
+    for (uint32_t i = entry.first; i != kNoHeader;
+         i = parsed_[i].next_with_same_name) {
+      if (i >= from)
+        return i;
+    }
+    return std::string::npos;
+  }
 }
 
 bool HttpResponseHeaders::GetCacheControlDirective(
@@ -10,12 +10,14 @@
 
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base/callback.h"
 #include "base/memory/ref_counted.h"
 #include "base/strings/string_piece.h"
 #include "base/time/time.h"
+#include "base/types/pass_key.h"
 #include "net/base/net_export.h"
 #include "net/http/http_version.h"
 #include "net/log/net_log_capture_mode.h"
@@ -65,6 +67,49 @@ class NET_EXPORT HttpResponseHeaders
   static const char kContentRange[];
   static const char kLastModified[];
 
+  // Builds an HttpResponseHeaders object directly from a status and a list of
+  // header name/value pairs, without first assembling an intermediate raw
+  // header string. This is used by the HTTP/2 and HTTP/3 code to convert a
+  // decoded header block. The produced object is identical to the one that
+  // would be created by joining the same lines with NULs and passing them to
+  // the std::string constructor.
+  //
+  // The builder only stores references to the names and values passed to
+  // AddHeader(), so they must outlive the call to Build().
+  class NET_EXPORT Builder {
+   public:
+    // |status| is the status code, optionally followed by a reason phrase,
+    // for example "200" or "404 Not Found".
+    Builder(HttpVersion version, base::StringPiece status);
+
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+
+    ~Builder();
+
+    // Reserves space for |count| headers. Optional.
+    void Reserve(size_t count) { headers_.reserve(count); }
+
+    // Adds a header line. |name| and |value| must not contain NULs or line
+    // breaks, and must remain valid until Build() is called.
+    Builder& AddHeader(base::StringPiece name, base::StringPiece value) {
+      headers_.emplace_back(name, value);
+      return *this;
+    }
+
+    scoped_refptr<HttpResponseHeaders> Build();
+
+   private:
+    using KeyValuePairs =
+        std::vector<std::pair<base::StringPiece, base::StringPiece>>;
+
+    const HttpVersion version_;
+    const base::StringPiece status_;
+    KeyValuePairs headers_;
+  };
+
+  using BuilderPassKey = base::PassKey<Builder>;
+
   HttpResponseHeaders() = delete;
 
   // Parses the given raw_headers.  raw_headers should be formatted thus:
@@ -82,6 +127,15 @@ class NET_EXPORT HttpResponseHeaders
   // be passed to the pickle's various Read* methods.
   explicit HttpResponseHeaders(base::PickleIterator* pickle_iter);
 
+  // Called by Builder::Build(). Writes the status line and |headers| straight
+  // into raw_headers_ with a single allocation.
+  HttpResponseHeaders(
+      BuilderPassKey,
+      HttpVersion version,
+      base::StringPiece status,
+      const std::vector<std::pair<base::StringPiece, base::StringPiece>>&
+          headers);
+
   // Takes headers as an ASCII string and tries to parse them as HTTP response
   // headers. returns nullptr on failure. Unlike the HttpResponseHeaders
   // constructor that takes a std::string, HttpUtil::AssembleRawHeaders should
@@ -349,11 +403,21 @@ class NET_EXPORT HttpResponseHeaders
   struct ParsedHeader;
   typedef std::vector<ParsedHeader> HeaderList;
 
+  // A slot of |header_index_|.
+  struct HeaderIndexEntry;
+
   ~HttpResponseHeaders();
 
   // Initializes from the given raw headers.
   void Parse(const std::string& raw_input);
 
+  // Populates parsed_ from the header lines in raw_headers_ that follow the
+  // status line. |status_line_len| includes the status line's terminating NUL.
+  void ParseHeaderLines(size_t status_line_len);
+
+  // Records the Net.HttpResponseCode histogram for a newly received response.
+  void RecordResponseCodeHistogram() const;
+
   // Helper function for ParseStatusLine.
   // Tries to extract the "HTTP/X.Y" from a status line formatted like:
   //    HTTP/1.1 200 OK
@@ -372,6 +436,10 @@ class NET_EXPORT HttpResponseHeaders
                        std::string::const_iterator line_end,
                        bool has_headers);
 
+  // Rebuilds |header_index_| from |parsed_|. Must be called whenever |parsed_|
+  // is repopulated.
+  void BuildHeaderIndex();
+
   // Find the header in our list (case-insensitive) starting with |parsed_| at
   // index |from|.  Returns string::npos if not found.
   size_t FindHeader(size_t from, base::StringPiece name) const;
@@ -427,6 +495,13 @@ class NET_EXPORT HttpResponseHeaders
   // header-value pairs within raw_headers_.
   HeaderList parsed_;
 
+  // Open-addressed hash table from case-insensitive header name to the first
+  // and last non-continuation entries of |parsed_| with that name, which are
+  // chained in order through ParsedHeader::next_with_same_name. Lets
+  // FindHeader() avoid comparing against every header. Empty if there are no
+  // headers, otherwise sized to a power of two at most half full.
+  std::vector<HeaderIndexEntry> header_index_;
+
   // The raw_headers_ consists of the normalized status line (terminated with a
   // null byte) and then followed by the raw null-terminated headers from the
   // input that was passed to our constructor.  We preserve the input [*] to
@@ -0,0 +1,130 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_response_headers.h"
+
+#include <string>
+
+#include "base/check.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/http/http_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixHttpResponseHeaders[] =
+    "HttpResponseHeaders.";
+static constexpr char kMetricParseTimeUs[] = "parse_time";
+static constexpr char kMetricLookupTimeUs[] = "lookup_time";
+
+constexpr int kIterations = 20000;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHttpResponseHeaders,
+                                         story);
+  reporter.RegisterImportantMetric(kMetricParseTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricLookupTimeUs, "us");
+  return reporter;
+}
+
+// A typical CDN-fronted response: caching and security policy headers,
+// several cookies, and edge/tracing headers added by the CDN.
+std::string MakeCdnResponseHeaders(int num_edge_headers) {
+  std::string headers =
+      "HTTP/1.1 200 OK\r\n"
+      "Date: Tue, 07 Jun 2022 10:00:00 GMT\r\n"
+      "Content-Type: text/html; charset=utf-8\r\n"
+      "Content-Length: 48213\r\n"
+      "Content-Encoding: gzip\r\n"
+      "Cache-Control: public, max-age=300, s-maxage=3600, "
+      "stale-while-revalidate=60\r\n"
+      "Age: 112\r\n"
+      "ETag: \"5f3a-1b2c3d4e\"\r\n"
+      "Last-Modified: Mon, 06 Jun 2022 22:13:41 GMT\r\n"
+      "Vary: Accept-Encoding, Origin\r\n"
+      "Accept-Ranges: bytes\r\n"
+      "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+      "X-Content-Type-Options: nosniff\r\n"
+      "X-Frame-Options: SAMEORIGIN\r\n"
+      "Alt-Svc: h3=\":443\"; ma=86400\r\n"
+      "Server: edge\r\n"
+      "Via: 1.1 varnish, 1.1 varnish\r\n";
+  for (int i = 0; i < 6; ++i) {
+    headers += base::StringPrintf(
+        "Set-Cookie: c%d=%s; Path=/; Secure; HttpOnly\r\n", i,
+        std::string(40, 'a' + i).c_str());
+  }
+  for (int i = 0; i < num_edge_headers; ++i)
+    headers += base::StringPrintf("X-Edge-Header-%d: %d\r\n", i, i * 7919);
+  headers += "\r\n";
+  return HttpUtil::AssembleRawHeaders(headers);
+}
+
+// Roughly the lookups HttpNetworkTransaction and HttpCache::Transaction make
+// for a cacheable 200 response.
+void DoTypicalLookups(const HttpResponseHeaders& headers) {
+  std::string value;
+  CHECK(headers.HasHeaderValue("cache-control", "public"));
+  CHECK(!headers.HasHeaderValue("cache-control", "no-store"));
+  CHECK(!headers.HasHeaderValue("cache-control", "no-cache"));
+  CHECK(!headers.HasHeaderValue("pragma", "no-cache"));
+  CHECK(headers.HasHeader("etag"));
+  CHECK(headers.HasHeader("last-modified"));
+  CHECK(headers.GetNormalizedHeader("vary", &value));
+  CHECK(headers.GetContentLength() > 0);
+  CHECK(headers.IsKeepAlive());
+  base::TimeDelta max_age;
+  CHECK(headers.GetMaxAgeValue(&max_age));
+  base::Time date;
+  CHECK(headers.GetDateValue(&date));
+  CHECK(!headers.HasHeader("content-range"));
+  CHECK(!headers.HasHeader("www-authenticate"));
+  CHECK(!headers.IsRedirect(nullptr));
+  CHECK(headers.GetMimeType(&value));
+  size_t iter = 0;
+  while (headers.EnumerateHeader(&iter, "set-cookie", &value)) {
+  }
+  CHECK(headers.EnumerateHeader(nullptr, "alt-svc", &value));
+  CHECK(headers.EnumerateHeader(nullptr, "strict-transport-security", &value));
+}
+
+void RunTest(const std::string& story, int num_edge_headers) {
+  const std::string raw_headers = MakeCdnResponseHeaders(num_edge_headers);
+  auto reporter = SetUpReporter(story);
+
+  {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      auto headers = base::MakeRefCounted<HttpResponseHeaders>(raw_headers);
+      CHECK_EQ(200, headers->response_code());
+    }
+    reporter.AddResult(kMetricParseTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+
+  {
+    auto headers = base::MakeRefCounted<HttpResponseHeaders>(raw_headers);
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i)
+      DoTypicalLookups(*headers);
+    reporter.AddResult(kMetricLookupTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+}
+
+TEST(HttpResponseHeadersPerfTest, CdnResponse) {
+  RunTest("CdnResponse", /*num_edge_headers=*/8);
+}
+
+TEST(HttpResponseHeadersPerfTest, HeaderHeavyCdnResponse) {
+  RunTest("HeaderHeavyCdnResponse", /*num_edge_headers=*/64);
+}
+
+}  // namespace
+}  // namespace net
@@ -11,8 +11,11 @@
 #include <limits>
 #include <memory>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/pickle.h"
+#include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 #include "base/values.h"
@@ -564,6 +567,49 @@ TEST(HttpResponseHeadersTest, EnumerateHeader_DateValued) {
   EXPECT_EQ("Wed, 01 Aug 2007 23:23:45 GMT", value);
 }
 
+// Lookups go through a hash index over header names, so exercise many names
+// (forcing index growth and probe collisions), mixed case, repeated headers
+// interleaved with others, and rebuilding the index after modification.
+TEST(HttpResponseHeadersTest, ManyHeaders) {
+  std::string headers = "HTTP/1.1 200 OK\n";
+  for (int i = 0; i < 100; ++i) {
+    headers += base::StringPrintf("X-Header-%d: value-%d\n", i, i);
+    if (i % 10 == 0)
+      headers += base::StringPrintf("Set-Cookie: cookie%d=1\n", i / 10);
+  }
+  headers += "Vary: accept-encoding, origin\n";
+  HeadersToRaw(&headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(headers);
+
+  for (int i = 0; i < 100; ++i) {
+    std::string value;
+    EXPECT_TRUE(parsed->GetNormalizedHeader(
+        base::StringPrintf("x-HEADER-%d", i), &value));
+    EXPECT_EQ(base::StringPrintf("value-%d", i), value);
+  }
+  EXPECT_FALSE(parsed->HasHeader("X-Header-100"));
+  EXPECT_FALSE(parsed->HasHeader("X-Header-"));
+  EXPECT_FALSE(parsed->HasHeader(""));
+
+  size_t iter = 0;
+  std::string value;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(parsed->EnumerateHeader(&iter, "set-cookie", &value));
+    EXPECT_EQ(base::StringPrintf("cookie%d=1", i), value);
+  }
+  EXPECT_FALSE(parsed->EnumerateHeader(&iter, "set-cookie", &value));
+
+  EXPECT_TRUE(parsed->HasHeaderValue("vary", "ORIGIN"));
+  EXPECT_FALSE(parsed->HasHeaderValue("vary", "cookie"));
+
+  parsed->RemoveHeader("x-header-50");
+  parsed->AddHeader("X-Added", "added");
+  EXPECT_FALSE(parsed->HasHeader("X-Header-50"));
+  EXPECT_TRUE(parsed->HasHeader("X-Header-51"));
+  EXPECT_TRUE(parsed->GetNormalizedHeader("x-added", &value));
+  EXPECT_EQ("added", value);
+}
+
 TEST(HttpResponseHeadersTest, DefaultDateToGMT) {
   // Verify we make the best interpretation when parsing dates that incorrectly
   // do not end in "GMT" as RFC2616 requires.
@@ -2382,6 +2428,83 @@ INSTANTIATE_TEST_SUITE_P(HttpResponseHeaders,
                          GetCurrentAgeTest,
                          testing::ValuesIn(get_current_age_tests));
 
+struct BuilderTestData {
+  HttpVersion version;
+  const char* status;
+  std::vector<std::pair<const char*, const char*>> headers;
+  // Equivalent input for the std::string constructor, using '\n' as the line
+  // separator.
+  const char* raw_equivalent;
+};
+
+class HttpResponseHeadersBuilderTest
+    : public HttpResponseHeadersTest,
+      public ::testing::WithParamInterface<BuilderTestData> {};
+
+TEST_P(HttpResponseHeadersBuilderTest, MatchesRawHeadersConstructor) {
+  const BuilderTestData& test = GetParam();
+
+  HttpResponseHeaders::Builder builder(test.version, test.status);
+  for (const auto& [name, value] : test.headers)
+    builder.AddHeader(name, value);
+  scoped_refptr<HttpResponseHeaders> built = builder.Build();
+
+  std::string raw_headers = test.raw_equivalent;
+  HeadersToRaw(&raw_headers);
+  auto parsed = base::MakeRefCounted<HttpResponseHeaders>(raw_headers);
+
+  EXPECT_EQ(parsed->raw_headers(), built->raw_headers());
+  EXPECT_EQ(parsed->GetStatusLine(), built->GetStatusLine());
+  EXPECT_EQ(parsed->response_code(), built->response_code());
+  EXPECT_EQ(parsed->GetHttpVersion(), built->GetHttpVersion());
+
+  size_t parsed_iter = 0;
+  size_t built_iter = 0;
+  std::string parsed_name, parsed_value, built_name, built_value;
+  while (parsed->EnumerateHeaderLines(&parsed_iter, &parsed_name,
+                                      &parsed_value)) {
+    ASSERT_TRUE(
+        built->EnumerateHeaderLines(&built_iter, &built_name, &built_value));
+    EXPECT_EQ(parsed_name, built_name);
+    EXPECT_EQ(parsed_value, built_value);
+  }
+  EXPECT_FALSE(
+      built->EnumerateHeaderLines(&built_iter, &built_name, &built_value));
+}
+
+const BuilderTestData builder_tests[] = {
+    {HttpVersion(1, 1), "200", {}, "HTTP/1.1 200"},
+    {HttpVersion(1, 1), "404 Not Found", {}, "HTTP/1.1 404 Not Found"},
+    {HttpVersion(1, 0),
+     "200 OK",
+     {{"Content-Type", "text/html"}},
+     "HTTP/1.0 200 OK\nContent-Type:text/html"},
+    {HttpVersion(2, 0),
+     "204",
+     {{"cache-control", "max-age=60, public"}, {"vary", "accept-encoding"}},
+     "HTTP/2.0 204\ncache-control:max-age=60, public\nvary:accept-encoding"},
+    // Repeated and non-coalescing headers.
+    {HttpVersion(1, 1),
+     "200",
+     {{"set-cookie", "a=b, c=d"},
+      {"set-cookie", "e=f"},
+      {"accept-ranges", "bytes"},
+      {"Accept-Ranges", "none"}},
+     "HTTP/1.1 200\nset-cookie:a=b, c=d\nset-cookie:e=f\naccept-ranges:bytes\n"
+     "Accept-Ranges:none"},
+    // Whitespace is trimmed the same way as when parsing.
+    {HttpVersion(1, 1),
+     "  301   Moved  ",
+     {{"location", "  /foo  "}, {"x-empty", ""}},
+     "HTTP/1.1   301   Moved  \nlocation:  /foo  \nx-empty:"},
+    // A malformed status code is normalized the same way.
+    {HttpVersion(1, 1), "abc", {{"a", "b"}}, "HTTP/1.1 abc\na:b"},
+};
+
+INSTANTIATE_TEST_SUITE_P(HttpResponseHeaders,
+                         HttpResponseHeadersBuilderTest,
+                         testing::ValuesIn(builder_tests));
+
 }  // namespace
 
 }  // namespace net
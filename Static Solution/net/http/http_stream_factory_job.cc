@@ -754,6 +754,9 @@ int HttpStreamFactory::Job::DoInitConnectionImpl() {
                       ptr_factory_.GetWeakPtr())
                 : base::RepeatingClosure();
 
+        if (job_type_ != PRECONNECT && !is_websocket_)
+          session_->spdy_session_pool()->OnSessionRequested(spdy_session_key_);
+
         bool is_blocking_request_for_session;
         existing_spdy_session_ = session_->spdy_session_pool()->RequestSession(
             spdy_session_key_, enable_ip_based_pooling_, is_websocket_,
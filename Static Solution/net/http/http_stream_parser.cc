@@ -574,9 +574,14 @@ int HttpStreamParser::DoSendRequestComplete(int result) {
 int HttpStreamParser::DoReadHeaders() {
   io_state_ = STATE_READ_HEADERS_COMPLETE;
 
-  // Grow the read buffer if necessary.
-  if (read_buf_->RemainingCapacity() == 0)
-    read_buf_->SetCapacity(read_buf_->capacity() + kHeaderBufInitialSize);
+  // Grow the read buffer if necessary. Double it up to |kMaxHeaderBufSize|, so
+  // that large header blocks only cost a logarithmic number of reallocations
+  // (and copies of the bytes read so far) rather than one per 4K.
+  if (read_buf_->RemainingCapacity() == 0) {
+    int capacity = read_buf_->capacity();
+    read_buf_->SetCapacity(std::max(std::min(2 * capacity, kMaxHeaderBufSize),
+                                    capacity + kHeaderBufInitialSize));
+  }
 
   // http://crbug.com/16371: We're seeing |user_buf_->data()| return NULL.
   // See if the user is passing in an IOBuffer with a NULL |data_|.
@@ -154,8 +154,8 @@ class NET_EXPORT_PRIVATE HttpStreamParser {
     STATE_DONE
   };
 
-  // The number of bytes by which the header buffer is grown when it reaches
-  // capacity.
+  // The minimum number of bytes by which the header buffer is grown when it
+  // reaches capacity. It is doubled otherwise, see DoReadHeaders().
   static const int kHeaderBufInitialSize = 4 * 1024;  // 4K
 
   // |kMaxHeaderBufSize| is the number of bytes that the response headers can
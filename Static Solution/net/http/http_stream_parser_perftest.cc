@@ -0,0 +1,147 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_stream_parser.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_util.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/socket_test_util.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixHttpStreamParser[] = "HttpStreamParser.";
+static constexpr char kMetricResponseTimeUs[] = "time_per_response";
+static constexpr char kMetricLocateEndOfHeadersTimeUs[] =
+    "locate_end_of_headers_time";
+
+constexpr int kIterations = 2000;
+
+// Typical TCP segment payload; the parser sees one of these per read.
+constexpr size_t kReadSize = 1460;
+
+constexpr size_t kBodySize = 1024;
+
+constexpr char kRequestLine[] = "GET / HTTP/1.1\r\n";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHttpStreamParser, story);
+  reporter.RegisterImportantMetric(kMetricResponseTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricLocateEndOfHeadersTimeUs, "us");
+  return reporter;
+}
+
+// Returns a response with |num_headers| headers with |value_size| byte values
+// and a |kBodySize| byte body.
+std::string MakeResponse(int num_headers, size_t value_size) {
+  std::string response = "HTTP/1.1 200 OK\r\n";
+  for (int i = 0; i < num_headers; ++i) {
+    response += base::StringPrintf("X-Header-%d: %s\r\n", i,
+                                   std::string(value_size, 'v').c_str());
+  }
+  response += base::StringPrintf("Content-Length: %zu\r\n\r\n", kBodySize);
+  response += std::string(kBodySize, 'b');
+  return response;
+}
+
+// Sends a request and reads back |response|, delivered |kReadSize| bytes per
+// socket read.
+void ReadResponse(const std::string& response) {
+  std::vector<MockRead> reads;
+  for (size_t offset = 0; offset < response.size(); offset += kReadSize) {
+    size_t len = std::min(kReadSize, response.size() - offset);
+    reads.emplace_back(SYNCHRONOUS, response.data() + offset,
+                       static_cast<int>(len));
+  }
+  MockWrite writes[] = {MockWrite(SYNCHRONOUS, "GET / HTTP/1.1\r\n\r\n")};
+  StaticSocketDataProvider data(reads, writes);
+  data.set_connect_data(MockConnect(SYNCHRONOUS, OK));
+  MockTCPClientSocket socket(AddressList(), nullptr, &data);
+  TestCompletionCallback callback;
+  CHECK_EQ(OK, socket.Connect(callback.callback()));
+
+  HttpRequestInfo request;
+  request.method = "GET";
+  request.url = GURL("http://localhost");
+  scoped_refptr<GrowableIOBuffer> read_buffer =
+      base::MakeRefCounted<GrowableIOBuffer>();
+  HttpStreamParser parser(&socket, /*connection_is_reused=*/false, &request,
+                          read_buffer.get(), NetLogWithSource());
+
+  HttpResponseInfo response_info;
+  CHECK_EQ(OK, parser.SendRequest(kRequestLine, HttpRequestHeaders(),
+                                  TRAFFIC_ANNOTATION_FOR_TESTS, &response_info,
+                                  callback.callback()));
+  CHECK_EQ(OK, parser.ReadResponseHeaders(callback.callback()));
+
+  auto body = base::MakeRefCounted<IOBuffer>(kBodySize);
+  size_t body_read = 0;
+  while (body_read < kBodySize) {
+    int rv =
+        parser.ReadResponseBody(body.get(), kBodySize, callback.callback());
+    CHECK_GT(rv, 0);
+    body_read += rv;
+  }
+  CHECK(parser.IsResponseBodyComplete());
+}
+
+void RunResponseTest(const std::string& story,
+                     int num_headers,
+                     size_t value_size) {
+  base::test::SingleThreadTaskEnvironment task_environment;
+  const std::string response = MakeResponse(num_headers, value_size);
+  auto reporter = SetUpReporter(story);
+
+  {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i)
+      ReadResponse(response);
+    reporter.AddResult(kMetricResponseTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+
+  {
+    const size_t expected = response.size() - kBodySize;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      CHECK_EQ(expected,
+               HttpUtil::LocateEndOfHeaders(response.data(), response.size()));
+    }
+    reporter.AddResult(kMetricLocateEndOfHeadersTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+}
+
+// Headers and body arrive in a single read.
+TEST(HttpStreamParserPerfTest, SmallHeaders) {
+  RunResponseTest("SmallHeaders", /*num_headers=*/4, /*value_size=*/32);
+}
+
+// Headers span tens of reads, and the header buffer has to grow repeatedly.
+TEST(HttpStreamParserPerfTest, LargeHeaders) {
+  RunResponseTest("LargeHeaders", /*num_headers=*/128, /*value_size=*/480);
+}
+
+}  // namespace
+}  // namespace net
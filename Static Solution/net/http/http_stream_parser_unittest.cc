@@ -19,6 +19,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/run_loop.h"
 #include "base/strings/string_piece.h"
+#include "base/strings/stringprintf.h"
 #include "base/test/task_environment.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "net/base/chunked_upload_data_stream.h"
@@ -1572,6 +1573,44 @@ TEST(HttpStreamParser, ReceivedBytesMultiReadExcludesNextResponse) {
   EXPECT_EQ(next_response_size, get_runner.read_buffer()->offset());
 }
 
+// Headers spread over many reads are found and parsed once complete, the
+// header buffer grows geometrically rather than 4K at a time, and the body
+// bytes that arrived with the end of the headers are returned first.
+TEST(HttpStreamParser, LargeHeadersAcrossManyReads) {
+  std::string headers = "HTTP/1.1 200 OK\r\n";
+  for (int i = 0; i < 100; ++i) {
+    headers += base::StringPrintf("X-Header-%d: %s\r\n", i,
+                                  std::string(400, 'v').c_str());
+  }
+  headers += "Content-Length: 8\r\n\r\n";
+  const std::string response = headers + "body" + "tail";
+  ASSERT_GT(response.size(), 32u * 1024u);
+  ASSERT_LT(response.size(), 64u * 1024u);
+
+  SimpleGetRunner get_runner;
+  std::vector<std::string> chunks;
+  const size_t kChunkSize = 1000;
+  for (size_t offset = 0; offset < response.size(); offset += kChunkSize)
+    chunks.push_back(response.substr(offset, kChunkSize));
+  for (const std::string& chunk : chunks)
+    get_runner.AddRead(chunk);
+  get_runner.SetupParserAndSendRequest();
+  get_runner.ReadHeaders();
+
+  const HttpResponseHeaders* response_headers =
+      get_runner.response_info()->headers.get();
+  ASSERT_TRUE(response_headers);
+  EXPECT_EQ(200, response_headers->response_code());
+  EXPECT_TRUE(response_headers->HasHeader("X-Header-99"));
+  EXPECT_EQ(static_cast<int64_t>(headers.size()),
+            get_runner.parser()->received_bytes());
+  // 4K doubled four times.
+  EXPECT_EQ(64 * 1024, get_runner.read_buffer()->capacity());
+
+  int read_lengths[] = {4, 4, 0};
+  EXPECT_EQ("bodytail", get_runner.ReadBody(4, read_lengths));
+}
+
 // Test that "received_bytes" calculation works fine when there is no
 // network activity at all; that is when all data is read from read buffer.
 // In this case read buffer contains two responses. We expect that only
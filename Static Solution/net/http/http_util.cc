@@ -7,6 +7,8 @@
 
 #include "net/http/http_util.h"
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/check_op.h"
@@ -530,25 +532,30 @@ static size_t LocateEndOfHeadersHelper(const char* buf,
                                        size_t buf_len,
                                        size_t i,
                                        bool accept_empty_header_list) {
-  char last_c = '\0';
-  bool was_lf = false;
-  if (accept_empty_header_list) {
-    // Normally two line breaks signal the end of a header list. An empty header
-    // list ends with a single line break at the start of the buffer.
-    last_c = '\n';
-    was_lf = true;
-  }
-
-  for (; i < buf_len; ++i) {
-    char c = buf[i];
-    if (c == '\n') {
-      if (was_lf)
-        return i + 1;
-      was_lf = true;
-    } else if (c != '\r' || last_c != '\n') {
-      was_lf = false;
+  // The end of headers is a line feed preceded by another line feed and at
+  // most one carriage return. Only line feeds can complete the marker, so jump
+  // from one to the next with memchr(), which is vectorized on all supported
+  // platforms, rather than examining every byte of long header values.
+  //
+  // Normally two line breaks signal the end of a header list. An empty header
+  // list ends with a single line break at the start of the buffer, so in that
+  // case behave as if a line feed immediately preceded |i|.
+  bool has_previous_lf = accept_empty_header_list;
+  size_t after_previous_lf = i;
+
+  while (i < buf_len) {
+    const void* lf = memchr(buf + i, '\n', buf_len - i);
+    if (!lf)
+      break;
+    size_t lf_offset = static_cast<const char*>(lf) - buf;
+    if (has_previous_lf) {
+      size_t gap = lf_offset - after_previous_lf;
+      if (gap == 0 || (gap == 1 && buf[after_previous_lf] == '\r'))
+        return lf_offset + 1;
     }
-    last_c = c;
+    has_previous_lf = true;
+    after_previous_lf = lf_offset + 1;
+    i = after_previous_lf;
   }
   return std::string::npos;
 }
@@ -824,6 +831,36 @@ int HttpUtil::MapStatusCodeForHistogram(int code) {
 //                     of token, separators, and quoted-string>
 //
 
+// static
+bool HttpUtil::ParseHeaderLine(std::string::const_iterator line_begin,
+                               std::string::const_iterator line_end,
+                               std::string::const_iterator* name_begin,
+                               std::string::const_iterator* name_end,
+                               std::string::const_iterator* values_begin,
+                               std::string::const_iterator* values_end) {
+  std::string::const_iterator colon = std::find(line_begin, line_end, ':');
+  if (colon == line_end)
+    return false;  // skip malformed header
+
+  // If the name starts with LWS, it is an invalid line.
+  // Leading LWS implies a line continuation, and these should have
+  // already been joined by AssembleRawHeaders().
+  if (line_begin == colon || IsLWS(*line_begin))
+    return false;
+
+  *name_begin = line_begin;
+  *name_end = colon;
+  TrimLWS(name_begin, name_end);
+  DCHECK(*name_begin < *name_end);
+  if (!IsToken(base::MakeStringPiece(*name_begin, *name_end)))
+    return false;  // skip malformed header
+
+  *values_begin = colon + 1;
+  *values_end = line_end;
+  TrimLWS(values_begin, values_end);
+  return true;
+}
+
 HttpUtil::HeadersIterator::HeadersIterator(
     std::string::const_iterator headers_begin,
     std::string::const_iterator headers_end,
@@ -835,31 +872,10 @@ HttpUtil::HeadersIterator::~HeadersIterator() = default;
 
 bool HttpUtil::HeadersIterator::GetNext() {
   while (lines_.GetNext()) {
-    name_begin_ = lines_.token_begin();
-    values_end_ = lines_.token_end();
-
-    std::string::const_iterator colon(std::find(name_begin_, values_end_, ':'));
-    if (colon == values_end_)
-      continue;  // skip malformed header
-
-    name_end_ = colon;
-
-    // If the name starts with LWS, it is an invalid line.
-    // Leading LWS implies a line continuation, and these should have
-    // already been joined by AssembleRawHeaders().
-    if (name_begin_ == name_end_ || IsLWS(*name_begin_))
-      continue;
-
-    TrimLWS(&name_begin_, &name_end_);
-    DCHECK(name_begin_ < name_end_);
-    if (!IsToken(base::MakeStringPiece(name_begin_, name_end_)))
-      continue;  // skip malformed header
-
-    values_begin_ = colon + 1;
-    TrimLWS(&values_begin_, &values_end_);
-
-    // if we got a header name, then we are done.
-    return true;
+    if (ParseHeaderLine(lines_.token_begin(), lines_.token_end(), &name_begin_,
+                        &name_end_, &values_begin_, &values_end_)) {
+      return true;
+    }
   }
   return false;
 }
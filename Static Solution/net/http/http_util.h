@@ -268,6 +268,16 @@ class NET_EXPORT HttpUtil {
       const HttpResponseHeaders& headers,
       const std::string& field_name);
 
+  // Splits the header line [line_begin, line_end), without its terminator,
+  // into an LWS-trimmed name and value. Returns false if the line is not a
+  // well-formed "name: value" line. The line must not contain continuations.
+  static bool ParseHeaderLine(std::string::const_iterator line_begin,
+                              std::string::const_iterator line_end,
+                              std::string::const_iterator* name_begin,
+                              std::string::const_iterator* name_end,
+                              std::string::const_iterator* values_begin,
+                              std::string::const_iterator* values_end);
+
   // Used to iterate over the name/value pairs of HTTP headers.  To iterate
   // over the values in a multi-value header, use ValuesIterator.
   // See AssembleRawHeaders for joining line continuations (this iterator
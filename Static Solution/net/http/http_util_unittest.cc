@@ -338,6 +338,8 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
       {"foo\nbar\n\njunk", 9},
       {"foo\nbar\n\r\njunk", 10},
       {"foo\nbar\r\n\njunk", 10},
+      {"foo\n\r\r\nbar", std::string::npos},
+      {"foo: a\rb\n\n", 10},
   };
   for (size_t i = 0; i < std::size(tests); ++i) {
     size_t input_len = strlen(tests[i].input);
@@ -346,6 +348,24 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
   }
 }
 
+// Resuming the search part way through the buffer, as HttpStreamParser does
+// after each read, must find the same end of headers as long as the search
+// starts no later than 3 bytes before the previous end of the buffer.
+TEST(HttpUtilTest, LocateEndOfHeadersFromOffset) {
+  const std::string input = "HTTP/1.1 200 OK\r\nFoo: " +
+                            std::string(300, 'x') + "\r\nBar: 2\r\n\r\nbody";
+  const size_t expected = input.find("body");
+  for (size_t end = 1; end <= input.size(); ++end) {
+    const size_t start = end > 4 ? end - 4 : 0;
+    size_t eoh = HttpUtil::LocateEndOfHeaders(input.data(), end, start);
+    if (end < expected) {
+      EXPECT_EQ(std::string::npos, eoh) << end;
+    } else if (start <= expected - 4) {
+      EXPECT_EQ(expected, eoh) << end;
+    }
+  }
+}
+
 TEST(HttpUtilTest, LocateEndOfAdditionalHeaders) {
   struct {
     const char* const input;
@@ -92,6 +92,7 @@ int MockDiskEntry::ReadData(int index,
   DCHECK(index >= 0 && index < kNumCacheEntryDataIndices);
   DCHECK(!callback.is_null());
 
+  read_count_++;
   if (fail_requests_ & FAIL_READ)
     return ERR_CACHE_READ_FAILURE;
 
@@ -120,6 +121,14 @@ int MockDiskEntry::ReadData(int index,
 
 void MockDiskEntry::ResumeDiskEntryOperation() {
   DCHECK(!resume_callback_.is_null());
+  if (deferred_write_index_ >= 0) {
+    std::vector<char>& data = data_[deferred_write_index_];
+    data.resize(deferred_write_offset_);
+    data.insert(data.end(), deferred_write_data_.begin(),
+                deferred_write_data_.end());
+    deferred_write_index_ = -1;
+    deferred_write_data_.clear();
+  }
   CallbackLater(std::move(resume_callback_), resume_return_code_);
   resume_return_code_ = 0;
 }
@@ -146,20 +155,25 @@ int MockDiskEntry::WriteData(int index,
   if (offset + buf_len > max_file_size_ && index == 1)
     return net::ERR_FAILED;
 
-  data_[index].resize(offset + buf_len);
-  if (buf_len)
-    memcpy(&data_[index][offset], buf->data(), buf_len);
-
-  if (MockHttpCache::GetTestMode(test_mode_) & TEST_MODE_SYNC_CACHE_WRITE)
-    return buf_len;
-
-  if (defer_op_ == DEFER_WRITE) {
+  const bool sync_write =
+      MockHttpCache::GetTestMode(test_mode_) & TEST_MODE_SYNC_CACHE_WRITE;
+  if (!sync_write && defer_op_ == DEFER_WRITE) {
     defer_op_ = DEFER_NONE;
+    deferred_write_index_ = index;
+    deferred_write_offset_ = offset;
+    deferred_write_data_.assign(buf->data(), buf->data() + buf_len);
     resume_callback_ = std::move(callback);
     resume_return_code_ = buf_len;
     return ERR_IO_PENDING;
   }
 
+  data_[index].resize(offset + buf_len);
+  if (buf_len)
+    memcpy(&data_[index][offset], buf->data(), buf_len);
+
+  if (sync_write)
+    return buf_len;
+
   CallbackLater(std::move(callback), buf_len);
   return ERR_IO_PENDING;
 }
@@ -103,16 +103,20 @@ class MockDiskEntry : public disk_cache::Entry,
   static void IgnoreCallbacks(bool value);
 
   // Defers invoking the callback for the given operation. Calling code should
-  // invoke ResumeDiskEntryOperation to resume.
+  // invoke ResumeDiskEntryOperation to resume. The data of a deferred write
+  // is not visible until then either.
   void SetDefer(DeferOp defer_op) { defer_op_ = defer_op; }
 
   // Resumes deferred cache operation by posting |resume_callback_| with
-  // |resume_return_code_|.
+  // |resume_return_code_|, after applying the deferred write if there is one.
   void ResumeDiskEntryOperation();
 
   // Sets the maximum length of a stream. This is only applied to stream 1.
   void set_max_file_size(int val) { max_file_size_ = val; }
 
+  // Returns the number of times ReadData was called.
+  int read_count() const { return read_count_; }
+
  private:
   friend class base::RefCounted<MockDiskEntry>;
   struct CallbackInfo;
@@ -147,11 +151,15 @@ class MockDiskEntry : public disk_cache::Entry,
   bool busy_ = false;
   bool delayed_ = false;
   bool cancel_ = false;
+  int read_count_ = 0;
 
   // Used for pause and restart.
   DeferOp defer_op_ = DEFER_NONE;
   CompletionOnceCallback resume_callback_;
   int resume_return_code_ = 0;
+  int deferred_write_index_ = -1;
+  int deferred_write_offset_ = 0;
+  std::vector<char> deferred_write_data_;
 
   static bool ignore_callbacks_;
 };
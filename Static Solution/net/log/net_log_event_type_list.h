@@ -74,12 +74,30 @@ EVENT_TYPE(HOST_RESOLVER_MANAGER_REQUEST)
 EVENT_TYPE(HOST_RESOLVER_MANAGER_IPV6_REACHABILITY_CHECK)
 
 // This event is logged when a request is handled by a cache entry.
-// It contains the following parameter:
+// It contains the following parameters:
 //   {
 //     "results": <HostCache::Entry of results>,
+//     "total_hits": <Number of times the entry has been served>,
+//     "expired_by_ms": <Time since the entry expired, only if stale>,
+//     "network_changes": <Network changes since the entry was cached, only if
+//                         stale>,
 //   }
 EVENT_TYPE(HOST_RESOLVER_MANAGER_CACHE_HIT)
 
+// This event is logged when a cache hit starts a background Job to refresh
+// the entry before it expires. The Job's HOST_RESOLVER_MANAGER_JOB events
+// reference this source, and their END phase carries the refresh's outcome.
+// It contains the following parameters:
+//   {
+//     "total_hits": <Number of times the entry has been served>,
+//     "remaining_ttl_ms": <Time left until the entry expires>,
+//   }
+EVENT_TYPE(HOST_RESOLVER_MANAGER_REFRESH_AHEAD)
+
+// This event is logged when a cache hit would have started a refresh, but the
+// refresh budget for the current minute is exhausted.
+EVENT_TYPE(HOST_RESOLVER_MANAGER_REFRESH_AHEAD_BUDGET_EXHAUSTED)
+
 // This event is logged when a request is handled by a HOSTS entry.
 // It contains the following parameter:
 //   {
@@ -1018,6 +1036,21 @@ EVENT_TYPE(HTTP_CACHE_CALLER_REQUEST_HEADERS)
 EVENT_TYPE(HTTP_CACHE_RESTART_PARTIAL_REQUEST)
 EVENT_TYPE(HTTP_CACHE_RE_SEND_PARTIAL_REQUEST)
 
+// The start/end of a revalidation that HttpCache runs in the background for an
+// entry that it served stale.
+//
+// The START event has the parameters:
+//   {
+//     "source_dependency": <Source identifier for the request that was served
+//                           the stale entry>,
+//   }
+//
+// The END event has these parameters:
+//   {
+//     "net_error": <Net error code integer>,
+//   }
+EVENT_TYPE(HTTP_CACHE_BACKGROUND_REVALIDATION)
+
 // ------------------------------------------------------------------------
 // Disk Cache / Memory Cache
 // ------------------------------------------------------------------------
@@ -45,3 +45,4 @@ SOURCE_TYPE(HTTP_AUTH_CONTROLLER)
 SOURCE_TYPE(HTTP3_SESSION)
 SOURCE_TYPE(WEB_TRANSPORT_CLIENT)
 SOURCE_TYPE(NETWORK_SERVICE_HOST_RESOLVER)
+SOURCE_TYPE(HTTP_CACHE_BACKGROUND_REVALIDATION)
@@ -4,6 +4,7 @@
 
 #include "net/socket/transport_connect_job.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -29,6 +30,7 @@
 #include "net/dns/public/secure_dns_policy.h"
 #include "net/log/net_log_event_type.h"
 #include "net/log/net_log_source.h"
+#include "net/nqe/network_quality_estimator.h"
 #include "net/socket/socket_tag.h"
 #include "net/socket/transport_connect_sub_job.h"
 #include "third_party/abseil-cpp/absl/types/variant.h"
@@ -387,17 +389,20 @@ int TransportConnectJob::DoTransportConnect() {
   if (!ipv6_addresses.empty()) {
     ipv6_job_ = std::make_unique<TransportConnectSubJob>(
         std::move(ipv6_addresses), this, SUB_JOB_IPV6);
-    int result = ipv6_job_->Start();
-    if (result != ERR_IO_PENDING)
-      return HandleSubJobComplete(result, ipv6_job_.get());
     if (ipv4_job_) {
+      // The timer is started first, so that OnSubJobAddressFailed() can cut
+      // it short even if the first IPv6 address fails synchronously.
+      //
       // This use of base::Unretained is safe because |fallback_timer_| is
       // owned by this object.
       fallback_timer_.Start(
-          FROM_HERE, kIPv6FallbackTime,
+          FROM_HERE, GetIPv6FallbackTime(),
           base::BindOnce(&TransportConnectJob::StartIPv4JobAsync,
                          base::Unretained(this)));
     }
+    int result = ipv6_job_->Start();
+    if (result != ERR_IO_PENDING)
+      return HandleSubJobComplete(result, ipv6_job_.get());
     return ERR_IO_PENDING;
   }
 
@@ -498,6 +503,43 @@ void TransportConnectJob::StartIPv4JobAsync() {
     OnSubJobComplete(result, ipv4_job_.get());
 }
 
+void TransportConnectJob::OnSubJobAddressFailed(TransportConnectSubJob* job) {
+  if (!base::FeatureList::IsEnabled(features::kHappyEyeballsRttFallback))
+    return;
+  if (job->type() != SUB_JOB_IPV6 || !fallback_timer_.IsRunning())
+    return;
+  DCHECK(ipv4_job_);
+  DCHECK(!ipv4_job_->started());
+
+  // The IPv6 SubJob keeps going through its remaining addresses, but there is
+  // no point in giving it a head start any longer. Restart the timer rather
+  // than starting the IPv4 SubJob here, as `job` is in the middle of its
+  // DoLoop.
+  //
+  // This use of base::Unretained is safe because |fallback_timer_| is owned by
+  // this object.
+  fallback_timer_.Start(FROM_HERE, base::TimeDelta(),
+                        base::BindOnce(&TransportConnectJob::StartIPv4JobAsync,
+                                       base::Unretained(this)));
+}
+
+base::TimeDelta TransportConnectJob::GetIPv6FallbackTime() {
+  if (!base::FeatureList::IsEnabled(features::kHappyEyeballsRttFallback))
+    return kIPv6FallbackTime;
+
+  absl::optional<base::TimeDelta> transport_rtt;
+  if (network_quality_estimator())
+    transport_rtt = network_quality_estimator()->GetTransportRTT();
+  if (!transport_rtt)
+    return kIPv6FallbackTime;
+
+  base::TimeDelta delay =
+      transport_rtt.value() *
+      features::kHappyEyeballsRttFallbackMultiplier.Get();
+  delay = std::min(delay, features::kHappyEyeballsRttFallbackMaxDelay.Get());
+  return std::max(delay, features::kHappyEyeballsRttFallbackMinDelay.Get());
+}
+
 int TransportConnectJob::ConnectInternal() {
   next_state_ = STATE_RESOLVE_HOST;
   return DoLoop(OK);
@@ -110,9 +110,10 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   // TransportConnectJobs will start a second connection attempt to just the
   // IPv4 addresses after this much time. (This is "Happy Eyeballs".)
   //
-  // TODO(willchan): Base this off RTT instead of statically setting it. Note we
-  // choose a timeout that is different from the backup connect job timer so
-  // they don't synchronize.
+  // If `features::kHappyEyeballsRttFallback` is enabled, the delay is instead
+  // derived from the transport RTT when one is known; this value remains the
+  // fallback. Note we choose a timeout that is different from the backup
+  // connect job timer so they don't synchronize.
   static constexpr base::TimeDelta kIPv6FallbackTime = base::Milliseconds(300);
 
   struct NET_EXPORT_PRIVATE EndpointResultOverride {
@@ -187,9 +188,19 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   // be called from within `DoLoop`.
   void OnSubJobComplete(int result, TransportConnectSubJob* job);
 
+  // Called back from the IPv6 SubJob when a connection attempt to one of its
+  // addresses fails and it moves on to the next one. Starts the IPv4 SubJob
+  // early, if enabled.
+  void OnSubJobAddressFailed(TransportConnectSubJob* job);
+
   // Called from |fallback_timer_|.
   void StartIPv4JobAsync();
 
+  // Returns how long the IPv6 SubJob runs alone before the IPv4 one is
+  // started. Derived from the transport RTT if `kHappyEyeballsRttFallback` is
+  // enabled and an estimate is available, `kIPv6FallbackTime` otherwise.
+  base::TimeDelta GetIPv6FallbackTime();
+
   // Begins the host resolution and the TCP connect.  Returns OK on success
   // and ERR_IO_PENDING if it cannot immediately service the request.
   // Otherwise, it returns a net error code.
@@ -221,7 +232,7 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
 
   // The addresses are divided into IPv4 and IPv6, which are performed partially
   // in parallel. If the list of IPv6 addresses is non-empty, then the IPv6 jobs
-  // go first, followed after `kIPv6FallbackTime` by the IPv4 addresses. The
+  // go first, followed after `GetIPv6FallbackTime()` by the IPv4 addresses. The
   // first sub-job to establish a connection wins. If one sub-job fails, the
   // other one is launched if needed, and we wait for it to complete.
   std::unique_ptr<TransportConnectSubJob> ipv4_job_;
@@ -22,6 +22,7 @@
 #include "net/dns/mock_host_resolver.h"
 #include "net/dns/public/secure_dns_policy.h"
 #include "net/log/net_log.h"
+#include "net/nqe/network_quality_estimator_test_util.h"
 #include "net/socket/connect_job_test_util.h"
 #include "net/socket/connection_attempts.h"
 #include "net/socket/stream_socket.h"
@@ -379,6 +380,91 @@ TEST_F(TransportConnectJobTest, IPv6FallbackSocketIPv6FinishesFirst) {
   EXPECT_EQ(3, client_socket_factory_.allocation_count());
 }
 
+// Test that the IPv4 fallback delay is derived from the transport RTT when
+// kHappyEyeballsRttFallback is enabled.
+TEST_F(TransportConnectJobTest, IPv6FallbackTimeFromTransportRtt) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeatureWithParameters(
+      features::kHappyEyeballsRttFallback,
+      {{features::kHappyEyeballsRttFallbackMultiplier.name, "2"},
+       {features::kHappyEyeballsRttFallbackMinDelay.name, "100ms"},
+       {features::kHappyEyeballsRttFallbackMaxDelay.name, "2s"}});
+
+  TestNetworkQualityEstimator network_quality_estimator;
+  network_quality_estimator.SetStartTimeNullTransportRtt(
+      base::Milliseconds(80));
+  CommonConnectJobParams common_connect_job_params(common_connect_job_params_);
+  common_connect_job_params.network_quality_estimator =
+      &network_quality_estimator;
+
+  MockTransportClientSocketFactory::Rule rules[] = {
+      MockTransportClientSocketFactory::Rule(
+          MockTransportClientSocketFactory::Type::kStalled,
+          std::vector{IPEndPoint(ParseIP("2:abcd::3:4:ff"), 80)}),
+      MockTransportClientSocketFactory::Rule(
+          MockTransportClientSocketFactory::Type::kSynchronous,
+          std::vector{IPEndPoint(ParseIP("2.2.2.2"), 80)})};
+  client_socket_factory_.SetRules(rules);
+  host_resolver_.rules()->AddIPLiteralRule(kHostName, "2:abcd::3:4:ff,2.2.2.2",
+                                           std::string());
+
+  TestConnectJobDelegate test_delegate;
+  TransportConnectJob transport_connect_job(
+      DEFAULT_PRIORITY, SocketTag(), &common_connect_job_params,
+      DefaultParams(), &test_delegate, nullptr /* net_log */);
+  EXPECT_THAT(transport_connect_job.Connect(), test::IsError(ERR_IO_PENDING));
+
+  // The fallback delay is twice the 80ms RTT.
+  FastForwardBy(base::Milliseconds(159));
+  EXPECT_FALSE(test_delegate.has_result());
+  EXPECT_EQ(1, client_socket_factory_.allocation_count());
+
+  FastForwardBy(base::Milliseconds(1));
+  EXPECT_TRUE(test_delegate.has_result());
+  EXPECT_THAT(test_delegate.WaitForResult(), test::IsOk());
+  IPEndPoint endpoint;
+  test_delegate.socket()->GetLocalAddress(&endpoint);
+  EXPECT_TRUE(endpoint.address().IsIPv4());
+}
+
+// Test that the IPv4 attempt starts as soon as an IPv6 address fails when
+// kHappyEyeballsRttFallback is enabled, rather than after the fallback delay.
+TEST_F(TransportConnectJobTest, IPv6AddressFailureStartsIPv4Immediately) {
+  base::test::ScopedFeatureList feature_list(
+      features::kHappyEyeballsRttFallback);
+
+  MockTransportClientSocketFactory::Rule rules[] = {
+      // The first IPv6 attempt fails.
+      MockTransportClientSocketFactory::Rule(
+          MockTransportClientSocketFactory::Type::kPendingFailing,
+          std::vector{IPEndPoint(ParseIP("1:abcd::3:4:ff"), 80)}),
+      // The second IPv6 attempt stalls.
+      MockTransportClientSocketFactory::Rule(
+          MockTransportClientSocketFactory::Type::kStalled,
+          std::vector{IPEndPoint(ParseIP("2:abcd::3:4:ff"), 80)}),
+      // The IPv4 attempt starts without waiting for the fallback delay.
+      MockTransportClientSocketFactory::Rule(
+          MockTransportClientSocketFactory::Type::kPending,
+          std::vector{IPEndPoint(ParseIP("2.2.2.2"), 80)})};
+  client_socket_factory_.SetRules(rules);
+  host_resolver_.rules()->AddIPLiteralRule(
+      kHostName, "1:abcd::3:4:ff,2:abcd::3:4:ff,2.2.2.2", std::string());
+
+  TestConnectJobDelegate test_delegate;
+  TransportConnectJob transport_connect_job(
+      DEFAULT_PRIORITY, SocketTag(), &common_connect_job_params_,
+      DefaultParams(), &test_delegate, nullptr /* net_log */);
+  EXPECT_THAT(transport_connect_job.Connect(), test::IsError(ERR_IO_PENDING));
+
+  RunUntilIdle();
+  EXPECT_TRUE(test_delegate.has_result());
+  EXPECT_THAT(test_delegate.WaitForResult(), test::IsOk());
+  IPEndPoint endpoint;
+  test_delegate.socket()->GetLocalAddress(&endpoint);
+  EXPECT_TRUE(endpoint.address().IsIPv4());
+  EXPECT_EQ(3, client_socket_factory_.allocation_count());
+}
+
 TEST_F(TransportConnectJobTest, IPv6NoIPv4AddressesToFallbackTo) {
   client_socket_factory_.set_default_client_socket_type(
       MockTransportClientSocketFactory::Type::kDelayed);
@@ -256,6 +256,7 @@ int TransportConnectSubJob::DoTransportConnectComplete(int result) {
       next_state_ = STATE_OBTAIN_LOCK;
       ++current_address_index_;
       result = OK;
+      parent_job_->OnSubJobAddressFailed(this);
     }
 
     return result;
@@ -25,6 +25,7 @@ BufferedSpdyFramer::BufferedSpdyFramer(uint32_t max_header_list_size,
                                        const NetLogWithSource& net_log,
                                        TimeFunc time_func)
     : spdy_framer_(spdy::SpdyFramer::ENABLE_COMPRESSION),
+      coalescer_(max_header_list_size, net_log),
       max_header_list_size_(max_header_list_size),
       net_log_(net_log),
       time_func_(time_func) {
@@ -106,19 +107,20 @@ void BufferedSpdyFramer::OnStreamPadding(spdy::SpdyStreamId stream_id,
 
 spdy::SpdyHeadersHandlerInterface* BufferedSpdyFramer::OnHeaderFrameStart(
     spdy::SpdyStreamId stream_id) {
-  coalescer_ =
-      std::make_unique<HeaderCoalescer>(max_header_list_size_, net_log_);
-  return coalescer_.get();
+  coalescer_.Reset();
+  return &coalescer_;
 }
 
 void BufferedSpdyFramer::OnHeaderFrameEnd(spdy::SpdyStreamId stream_id) {
-  if (coalescer_->error_seen()) {
+  if (coalescer_.error_seen()) {
     visitor_->OnStreamError(stream_id,
                             "Could not parse Spdy Control Frame Header.");
     control_frame_fields_.reset();
     return;
   }
   DCHECK(control_frame_fields_.get());
+  spdy::Http2HeaderBlock headers = coalescer_.release_headers();
+  RecordHeaderBlock(headers);
   switch (control_frame_fields_->type) {
     case spdy::SpdyFrameType::HEADERS:
       visitor_->OnHeaders(
@@ -126,13 +128,12 @@ void BufferedSpdyFramer::OnHeaderFrameEnd(spdy::SpdyStreamId stream_id) {
           control_frame_fields_->weight,
           control_frame_fields_->parent_stream_id,
           control_frame_fields_->exclusive, control_frame_fields_->fin,
-          coalescer_->release_headers(),
-          control_frame_fields_->recv_first_byte_time);
+          std::move(headers), control_frame_fields_->recv_first_byte_time);
       break;
     case spdy::SpdyFrameType::PUSH_PROMISE:
       visitor_->OnPushPromise(control_frame_fields_->stream_id,
                               control_frame_fields_->promised_stream_id,
-                              coalescer_->release_headers());
+                              std::move(headers));
       break;
     default:
       DCHECK(false) << "Unexpect control frame type: "
@@ -325,4 +326,16 @@ uint32_t BufferedSpdyFramer::header_encoder_table_size() const {
 
 BufferedSpdyFramer::ControlFrameFields::ControlFrameFields() = default;
 
+void BufferedSpdyFramer::RecordHeaderBlock(
+    const spdy::Http2HeaderBlock& headers) {
+  const size_t block_bytes = headers.TotalBytesUsed();
+  header_block_stats_.blocks++;
+  header_block_stats_.compressed_bytes += coalescer_.compressed_header_bytes();
+  header_block_stats_.uncompressed_bytes +=
+      coalescer_.uncompressed_header_bytes();
+  header_block_stats_.header_block_bytes += block_bytes;
+  header_block_stats_.max_header_block_bytes =
+      std::max(header_block_stats_.max_header_block_bytes, block_bytes);
+}
+
 }  // namespace net
@@ -242,12 +242,36 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer
 
   int frames_received() const { return frames_received_; }
 
+  // Accounting for the header blocks decoded by this framer over its
+  // lifetime, used to attribute HPACK decoding memory to the session.
+  struct HeaderBlockStats {
+    // Number of HEADERS and PUSH_PROMISE header blocks delivered to the
+    // visitor.
+    size_t blocks = 0;
+    // Sum of HPACK-encoded header block sizes.
+    size_t compressed_bytes = 0;
+    // Sum of decoded header block sizes, as reported by the HPACK decoder.
+    size_t uncompressed_bytes = 0;
+    // Sum of the bytes held by the keys and values of the delivered
+    // spdy::Http2HeaderBlocks.
+    size_t header_block_bytes = 0;
+    // Largest single delivered spdy::Http2HeaderBlock, in bytes.
+    size_t max_header_block_bytes = 0;
+  };
+  const HeaderBlockStats& header_block_stats() const {
+    return header_block_stats_;
+  }
+
   // Updates the maximum size of the header encoder compression table.
   void UpdateHeaderEncoderTableSize(uint32_t value);
   // Returns the maximum size of the header encoder compression table.
   uint32_t header_encoder_table_size() const;
 
  private:
+  // Updates |header_block_stats_| for a header block about to be delivered to
+  // the visitor.
+  void RecordHeaderBlock(const spdy::Http2HeaderBlock& headers);
+
   spdy::SpdyFramer spdy_framer_;
   http2::Http2DecoderAdapter deframer_;
   raw_ptr<BufferedSpdyFramerVisitorInterface> visitor_ = nullptr;
@@ -282,7 +306,11 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer
   };
   std::unique_ptr<GoAwayFields> goaway_fields_;
 
-  std::unique_ptr<HeaderCoalescer> coalescer_;
+  // Decodes every header block of the session. Created once and reset at
+  // the start of each block rather than reallocated per frame.
+  HeaderCoalescer coalescer_;
+
+  HeaderBlockStats header_block_stats_;
 
   const uint32_t max_header_list_size_;
   NetLogWithSource net_log_;
@@ -254,6 +254,43 @@ TEST_F(BufferedSpdyFramerTest, ReadHeadersHeaderBlock) {
   EXPECT_EQ(headers, visitor.headers_);
 }
 
+TEST_F(BufferedSpdyFramerTest, HeaderBlockStats) {
+  spdy::Http2HeaderBlock headers;
+  headers["alpha"] = "beta";
+  headers["gamma"] = "delta";
+  spdy::Http2HeaderBlock larger_headers = headers.Clone();
+  larger_headers["epsilon"] = std::string(100, 'x');
+
+  NetLogWithSource net_log;
+  BufferedSpdyFramer framer(kMaxHeaderListSizeForTest, net_log);
+  spdy::SpdyHeadersIR headers_ir(/*stream_id=*/1, headers.Clone());
+  spdy::SpdyHeadersIR larger_headers_ir(/*stream_id=*/3,
+                                        larger_headers.Clone());
+  spdy::SpdySerializedFrame frame = framer.SerializeFrame(headers_ir);
+  spdy::SpdySerializedFrame larger_frame =
+      framer.SerializeFrame(larger_headers_ir);
+
+  TestBufferedSpdyVisitor visitor;
+  EXPECT_EQ(0u, visitor.buffered_spdy_framer_.header_block_stats().blocks);
+
+  visitor.SimulateInFramer(frame);
+  EXPECT_EQ(headers, visitor.headers_);
+  visitor.SimulateInFramer(larger_frame);
+  EXPECT_EQ(0, visitor.error_count_);
+  EXPECT_EQ(2, visitor.headers_frame_count_);
+  // The reused coalescer must not leak headers from the first block.
+  EXPECT_EQ(larger_headers, visitor.headers_);
+
+  const BufferedSpdyFramer::HeaderBlockStats& stats =
+      visitor.buffered_spdy_framer_.header_block_stats();
+  EXPECT_EQ(2u, stats.blocks);
+  EXPECT_EQ(headers.TotalBytesUsed() + larger_headers.TotalBytesUsed(),
+            stats.header_block_bytes);
+  EXPECT_EQ(larger_headers.TotalBytesUsed(), stats.max_header_block_bytes);
+  EXPECT_GT(stats.compressed_bytes, 0u);
+  EXPECT_GT(stats.uncompressed_bytes, 0u);
+}
+
 TEST_F(BufferedSpdyFramerTest, ReadPushPromiseHeaderBlock) {
   spdy::Http2HeaderBlock headers;
   headers["alpha"] = "beta";
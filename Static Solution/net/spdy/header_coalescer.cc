@@ -56,12 +56,28 @@ void HeaderCoalescer::OnHeader(absl::string_view key, absl::string_view value) {
     error_seen_ = true;
 }
 
+void HeaderCoalescer::OnHeaderBlockEnd(size_t uncompressed_header_bytes,
+                                       size_t compressed_header_bytes) {
+  uncompressed_header_bytes_ = uncompressed_header_bytes;
+  compressed_header_bytes_ = compressed_header_bytes;
+}
+
 spdy::Http2HeaderBlock HeaderCoalescer::release_headers() {
   DCHECK(headers_valid_);
   headers_valid_ = false;
   return std::move(headers_);
 }
 
+void HeaderCoalescer::Reset() {
+  headers_.clear();
+  headers_valid_ = true;
+  header_list_size_ = 0;
+  error_seen_ = false;
+  regular_header_seen_ = false;
+  uncompressed_header_bytes_ = 0;
+  compressed_header_bytes_ = 0;
+}
+
 bool HeaderCoalescer::AddHeader(base::StringPiece key,
                                 base::StringPiece value) {
   if (key.empty()) {
@@ -126,5 +142,4 @@ bool HeaderCoalescer::AddHeader(base::StringPiece key,
   return true;
 }
 
-
 }  // namespace net
@@ -24,11 +24,26 @@ class NET_EXPORT_PRIVATE HeaderCoalescer
   void OnHeader(absl::string_view key, absl::string_view value) override;
 
   void OnHeaderBlockEnd(size_t uncompressed_header_bytes,
-                        size_t compressed_header_bytes) override {}
+                        size_t compressed_header_bytes) override;
 
   spdy::Http2HeaderBlock release_headers();
   bool error_seen() const { return error_seen_; }
 
+  // Prepares this object to decode the next header block, so that a single
+  // HeaderCoalescer can be reused for every HEADERS and PUSH_PROMISE frame of
+  // a session.
+  void Reset();
+
+  // Size of the header list decoded so far, as defined by RFC 7540 Section
+  // 6.5.2 (including the 32 byte per-entry overhead).
+  size_t header_list_size() const { return header_list_size_; }
+
+  // Sizes reported by the HPACK decoder for the last complete header block.
+  size_t uncompressed_header_bytes() const {
+    return uncompressed_header_bytes_;
+  }
+  size_t compressed_header_bytes() const { return compressed_header_bytes_; }
+
  private:
   // Helper to add a header. Return true on success.
   bool AddHeader(base::StringPiece key, base::StringPiece value);
@@ -38,6 +53,8 @@ class NET_EXPORT_PRIVATE HeaderCoalescer
   size_t header_list_size_ = 0;
   bool error_seen_ = false;
   bool regular_header_seen_ = false;
+  size_t uncompressed_header_bytes_ = 0;
+  size_t compressed_header_bytes_ = 0;
   const uint32_t max_header_list_size_;
   NetLogWithSource net_log_;
 };
@@ -58,6 +58,26 @@ TEST_F(HeaderCoalescerTest, CorrectHeaders) {
               ElementsAre(Pair(":foo", "bar"), Pair("baz", "qux")));
 }
 
+TEST_F(HeaderCoalescerTest, ResetForNextHeaderBlock) {
+  header_coalescer_.OnHeader("foo", "bar");
+  header_coalescer_.OnHeader(":baz", "qux");
+  EXPECT_TRUE(header_coalescer_.error_seen());
+
+  header_coalescer_.Reset();
+  EXPECT_FALSE(header_coalescer_.error_seen());
+  EXPECT_EQ(0u, header_coalescer_.header_list_size());
+
+  header_coalescer_.OnHeader(":status", "200");
+  header_coalescer_.OnHeader("foo", "bar");
+  header_coalescer_.OnHeaderBlockEnd(/*uncompressed_header_bytes=*/17,
+                                     /*compressed_header_bytes=*/5);
+  EXPECT_FALSE(header_coalescer_.error_seen());
+  EXPECT_EQ(17u, header_coalescer_.uncompressed_header_bytes());
+  EXPECT_EQ(5u, header_coalescer_.compressed_header_bytes());
+  EXPECT_THAT(header_coalescer_.release_headers(),
+              ElementsAre(Pair(":status", "200"), Pair("foo", "bar")));
+}
+
 TEST_F(HeaderCoalescerTest, EmptyHeaderKey) {
   header_coalescer_.OnHeader("", "foo");
   EXPECT_TRUE(header_coalescer_.error_seen());
@@ -0,0 +1,71 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/http2_preconnect_predictor.h"
+
+#include "base/check_op.h"
+#include "base/metrics/histogram_macros.h"
+
+namespace net {
+
+namespace {
+
+CoOccurrencePredictor<NetworkIsolationKey, SpdySessionKey>::Params
+ToPredictorParams(const Http2PreconnectPredictor::Params& params) {
+  return {params.group_window, params.min_confidence,
+          params.max_followers_per_leader, params.max_leaders};
+}
+
+}  // namespace
+
+Http2PreconnectPredictor::Http2PreconnectPredictor(const Params& params,
+                                                   Delegate* delegate,
+                                                   TimeFunc time_func)
+    : socket_budget_(params.socket_budget),
+      delegate_(delegate),
+      predictor_(ToPredictorParams(params), this, time_func) {
+  DCHECK(delegate_);
+}
+
+Http2PreconnectPredictor::~Http2PreconnectPredictor() = default;
+
+void Http2PreconnectPredictor::OnRequest(const SpdySessionKey& key) {
+  if (!predictor_.OnKeySeen(key.network_isolation_key(), key))
+    return;
+  DCHECK_GT(outstanding_preconnects_, 0u);
+  --outstanding_preconnects_;
+  ++stats_.hits;
+}
+
+void Http2PreconnectPredictor::OnNetworkChanged() {
+  const size_t released = predictor_.AbandonGroups();
+  DCHECK_EQ(outstanding_preconnects_, released);
+  outstanding_preconnects_ = 0;
+}
+
+bool Http2PreconnectPredictor::OnPrediction(const SpdySessionKey& key) {
+  // Followers are predicted most likely first, so the budget goes to the most
+  // likely ones.
+  if (delegate_->HasAvailableSessionForPrediction(key))
+    return false;
+  if (outstanding_preconnects_ >= socket_budget_) {
+    ++stats_.over_budget;
+    return false;
+  }
+  ++outstanding_preconnects_;
+  ++stats_.preconnects;
+  delegate_->PreconnectForPrediction(key);
+  return true;
+}
+
+void Http2PreconnectPredictor::OnGroupEnded(size_t hits, size_t misses) {
+  DCHECK_GE(outstanding_preconnects_, misses);
+  outstanding_preconnects_ -= misses;
+  stats_.misses += misses;
+  UMA_HISTOGRAM_COUNTS_100("Net.Http2PreconnectPredictor.HitsPerGroup", hits);
+  UMA_HISTOGRAM_COUNTS_100("Net.Http2PreconnectPredictor.MissesPerGroup",
+                           misses);
+}
+
+}  // namespace net
@@ -0,0 +1,108 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SPDY_HTTP2_PRECONNECT_PREDICTOR_H_
+#define NET_SPDY_HTTP2_PRECONNECT_PREDICTOR_H_
+
+#include <stddef.h>
+
+#include "base/memory/raw_ptr.h"
+#include "base/time/time.h"
+#include "net/base/co_occurrence_predictor.h"
+#include "net/base/net_export.h"
+#include "net/base/network_isolation_key.h"
+#include "net/spdy/spdy_session_key.h"
+
+namespace net {
+
+// Learns which HTTP/2 sessions are requested together under the same
+// NetworkIsolationKey, and asks its Delegate to warm up the likely followers
+// as soon as the first session of such a group is requested. Requests are
+// grouped by NetworkIsolationKey, as described in CoOccurrencePredictor.
+//
+// The number of preconnected sessions that have not yet been claimed by a
+// request is bounded by Params::socket_budget across all groups.
+class NET_EXPORT_PRIVATE Http2PreconnectPredictor
+    : public CoOccurrencePredictor<NetworkIsolationKey,
+                                   SpdySessionKey>::Delegate {
+ public:
+  class NET_EXPORT_PRIVATE Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    // Returns true if there already is an available session for |key|, in
+    // which case no preconnect is issued for it.
+    virtual bool HasAvailableSessionForPrediction(
+        const SpdySessionKey& key) const = 0;
+
+    // Starts warming up a session (DNS, TCP and TLS) for |key|.
+    virtual void PreconnectForPrediction(const SpdySessionKey& key) = 0;
+  };
+
+  struct NET_EXPORT_PRIVATE Params {
+    // Requests made within this long of a group's first request belong to
+    // that group.
+    base::TimeDelta group_window = base::Seconds(5);
+    // A follower is preconnected once it has been seen with its leader this
+    // many more times than it has been missed.
+    int min_confidence = 2;
+    // Maximum number of preconnected sessions not yet claimed by a request.
+    size_t socket_budget = 6;
+    // Maximum number of followers remembered per leading key.
+    size_t max_followers_per_leader = 8;
+    // Maximum number of leading keys remembered.
+    size_t max_leaders = 256;
+  };
+
+  struct Stats {
+    // Preconnects issued.
+    size_t preconnects = 0;
+    // Preconnected keys that were requested before their group ended.
+    size_t hits = 0;
+    // Preconnected keys that were not requested before their group ended.
+    size_t misses = 0;
+    // Predictions dropped because |socket_budget| was exhausted.
+    size_t over_budget = 0;
+  };
+
+  using TimeFunc = base::TimeTicks (*)();
+
+  Http2PreconnectPredictor(const Params& params,
+                           Delegate* delegate,
+                           TimeFunc time_func);
+
+  Http2PreconnectPredictor(const Http2PreconnectPredictor&) = delete;
+  Http2PreconnectPredictor& operator=(const Http2PreconnectPredictor&) = delete;
+
+  ~Http2PreconnectPredictor() override;
+
+  // Called for every request that may be served by an HTTP/2 session for
+  // |key|. Must not be called for preconnects.
+  void OnRequest(const SpdySessionKey& key);
+
+  // Ends all groups in progress without learning from them, and releases the
+  // budget held by their unclaimed preconnects. Learned associations are
+  // kept.
+  void OnNetworkChanged();
+
+  // Number of preconnected keys that have not yet been requested.
+  size_t outstanding_preconnects() const { return outstanding_preconnects_; }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // CoOccurrencePredictor::Delegate implementation:
+  bool OnPrediction(const SpdySessionKey& key) override;
+  void OnGroupEnded(size_t hits, size_t misses) override;
+
+  const size_t socket_budget_;
+  const raw_ptr<Delegate> delegate_;
+  CoOccurrencePredictor<NetworkIsolationKey, SpdySessionKey> predictor_;
+  size_t outstanding_preconnects_ = 0;
+  Stats stats_;
+};
+
+}  // namespace net
+
+#endif  // NET_SPDY_HTTP2_PRECONNECT_PREDICTOR_H_
@@ -0,0 +1,190 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/http2_preconnect_predictor.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_server.h"
+#include "net/base/schemeful_site.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/socket/socket_tag.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace net {
+namespace {
+
+base::TimeTicks g_now;
+
+base::TimeTicks TestTimeFunc() {
+  return g_now;
+}
+
+class TestDelegate : public Http2PreconnectPredictor::Delegate {
+ public:
+  bool HasAvailableSessionForPrediction(
+      const SpdySessionKey& key) const override {
+    return available_.count(key) > 0;
+  }
+
+  void PreconnectForPrediction(const SpdySessionKey& key) override {
+    preconnects_.push_back(key);
+  }
+
+  void set_available(const SpdySessionKey& key) { available_.insert(key); }
+
+  const std::vector<SpdySessionKey>& preconnects() const {
+    return preconnects_;
+  }
+
+ private:
+  std::set<SpdySessionKey> available_;
+  std::vector<SpdySessionKey> preconnects_;
+};
+
+SpdySessionKey MakeKey(const std::string& host,
+                       const NetworkIsolationKey& network_isolation_key =
+                           NetworkIsolationKey()) {
+  return SpdySessionKey(HostPortPair(host, 443), ProxyServer::Direct(),
+                        PRIVACY_MODE_DISABLED,
+                        SpdySessionKey::IsProxySession::kFalse, SocketTag(),
+                        network_isolation_key, SecureDnsPolicy::kAllow);
+}
+
+class Http2PreconnectPredictorTest : public testing::Test {
+ protected:
+  Http2PreconnectPredictorTest()
+      : leader_(MakeKey("www.example.org")),
+        follower1_(MakeKey("cdn.example.org")),
+        follower2_(MakeKey("fonts.example.com")) {
+    g_now = base::TimeTicks() + base::Days(1);
+  }
+
+  void CreatePredictor(const Http2PreconnectPredictor::Params& params =
+                           Http2PreconnectPredictor::Params()) {
+    params_ = params;
+    predictor_ = std::make_unique<Http2PreconnectPredictor>(params, &delegate_,
+                                                            &TestTimeFunc);
+  }
+
+  // Requests |leader| followed by |followers| in a fresh group.
+  void RunGroup(const SpdySessionKey& leader,
+                const std::vector<SpdySessionKey>& followers) {
+    g_now += params_.group_window + base::Seconds(1);
+    predictor_->OnRequest(leader);
+    for (const SpdySessionKey& follower : followers)
+      predictor_->OnRequest(follower);
+  }
+
+  const SpdySessionKey leader_;
+  const SpdySessionKey follower1_;
+  const SpdySessionKey follower2_;
+  Http2PreconnectPredictor::Params params_;
+  TestDelegate delegate_;
+  std::unique_ptr<Http2PreconnectPredictor> predictor_;
+};
+
+TEST_F(Http2PreconnectPredictorTest, PreconnectsOnceConfident) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+  EXPECT_TRUE(delegate_.preconnects().empty());
+
+  // The follower has now been seen twice with the leader.
+  RunGroup(leader_, {});
+  ASSERT_EQ(1u, delegate_.preconnects().size());
+  EXPECT_EQ(follower1_, delegate_.preconnects()[0]);
+  EXPECT_EQ(1u, predictor_->outstanding_preconnects());
+  EXPECT_EQ(1u, predictor_->stats().preconnects);
+}
+
+TEST_F(Http2PreconnectPredictorTest, CountsHitsAndMisses) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+
+  // Preconnected follower requested within the window: a hit.
+  RunGroup(leader_, {follower1_});
+  EXPECT_EQ(1u, predictor_->stats().hits);
+  EXPECT_EQ(0u, predictor_->outstanding_preconnects());
+
+  // Preconnected follower not requested before the group ends: a miss.
+  RunGroup(leader_, {});
+  RunGroup(follower2_, {});
+  EXPECT_EQ(2u, predictor_->stats().preconnects);
+  EXPECT_EQ(1u, predictor_->stats().hits);
+  EXPECT_EQ(1u, predictor_->stats().misses);
+  EXPECT_EQ(0u, predictor_->outstanding_preconnects());
+}
+
+TEST_F(Http2PreconnectPredictorTest, RespectsSocketBudget) {
+  Http2PreconnectPredictor::Params params;
+  params.socket_budget = 1;
+  CreatePredictor(params);
+
+  RunGroup(leader_, {follower1_, follower2_});
+  RunGroup(leader_, {follower1_, follower2_});
+  RunGroup(leader_, {});
+
+  EXPECT_EQ(1u, delegate_.preconnects().size());
+  EXPECT_EQ(1u, predictor_->outstanding_preconnects());
+  EXPECT_EQ(1u, predictor_->stats().over_budget);
+}
+
+TEST_F(Http2PreconnectPredictorTest, SkipsAvailableSessions) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+  delegate_.set_available(follower1_);
+  RunGroup(leader_, {});
+
+  EXPECT_TRUE(delegate_.preconnects().empty());
+  EXPECT_EQ(0u, predictor_->outstanding_preconnects());
+}
+
+TEST_F(Http2PreconnectPredictorTest, GroupsAreSeparatedByNetworkIsolationKey) {
+  CreatePredictor();
+  const SchemefulSite site_a(GURL("https://a.test"));
+  const SchemefulSite site_b(GURL("https://b.test"));
+  const NetworkIsolationKey nik_a(site_a, site_a);
+  const NetworkIsolationKey nik_b(site_b, site_b);
+  const SpdySessionKey leader_a = MakeKey("www.example.org", nik_a);
+  const SpdySessionKey follower_b = MakeKey("cdn.example.org", nik_b);
+
+  // Requests under different NetworkIsolationKeys never form a group.
+  for (int i = 0; i < 3; ++i)
+    RunGroup(leader_a, {follower_b});
+  EXPECT_TRUE(delegate_.preconnects().empty());
+}
+
+TEST_F(Http2PreconnectPredictorTest, NetworkChangeReleasesBudget) {
+  CreatePredictor();
+
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {follower1_});
+  RunGroup(leader_, {});
+  ASSERT_EQ(1u, predictor_->outstanding_preconnects());
+
+  predictor_->OnNetworkChanged();
+  EXPECT_EQ(0u, predictor_->outstanding_preconnects());
+  EXPECT_EQ(0u, predictor_->stats().misses);
+
+  // Learned associations survive the network change.
+  RunGroup(leader_, {});
+  EXPECT_EQ(2u, delegate_.preconnects().size());
+}
+
+}  // namespace
+}  // namespace net
@@ -5,8 +5,10 @@
 #include "net/spdy/spdy_http_utils.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "base/feature_list.h"
 #include "base/strings/abseil_string_conversions.h"
 #include "base/strings/escape.h"
 #include "base/strings/strcat.h"
@@ -15,6 +17,7 @@
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/time/time.h"
+#include "net/base/features.h"
 #include "net/base/load_flags.h"
 #include "net/base/url_util.h"
 #include "net/http/http_request_headers.h"
@@ -42,11 +45,41 @@ void AddSpdyHeader(const std::string& name,
 
 int SpdyHeadersToHttpResponse(const spdy::Http2HeaderBlock& headers,
                               HttpResponseInfo* response) {
+  scoped_refptr<HttpResponseHeaders> response_headers =
+      SpdyHeadersToHttpResponseHeaders(headers);
+  if (!response_headers)
+    return ERR_INCOMPLETE_HTTP2_HEADERS;
+
+  response->headers = std::move(response_headers);
+
+  // When there are multiple location headers the response is a potential
+  // response smuggling attack.
+  if (HttpUtil::HeadersContainMultipleCopiesOfField(*response->headers,
+                                                    "location")) {
+    return ERR_RESPONSE_HEADERS_MULTIPLE_LOCATION;
+  }
+
+  response->was_fetched_via_spdy = true;
+  return OK;
+}
+
+scoped_refptr<HttpResponseHeaders> SpdyHeadersToHttpResponseHeaders(
+    const spdy::Http2HeaderBlock& headers) {
+  if (base::FeatureList::IsEnabled(
+          features::kSpdyHeadersToHttpResponseUseBuilder)) {
+    return SpdyHeadersToHttpResponseHeadersUsingBuilder(headers);
+  }
+  return SpdyHeadersToHttpResponseHeadersUsingRawString(headers);
+}
+
+scoped_refptr<HttpResponseHeaders>
+SpdyHeadersToHttpResponseHeadersUsingRawString(
+    const spdy::Http2HeaderBlock& headers) {
   // The ":status" header is required.
   spdy::Http2HeaderBlock::const_iterator it =
       headers.find(spdy::kHttp2StatusHeader);
   if (it == headers.end())
-    return ERR_INCOMPLETE_HTTP2_HEADERS;
+    return nullptr;
 
   const auto status = base::StringViewToStringPiece(it->second);
   std::string raw_headers =
@@ -83,17 +116,48 @@ int SpdyHeadersToHttpResponse(const spdy::Http2HeaderBlock& headers,
     } while (end != value.npos);
   }
 
-  response->headers = new HttpResponseHeaders(raw_headers);
+  return base::MakeRefCounted<HttpResponseHeaders>(raw_headers);
+}
 
-  // When there are multiple location headers the response is a potential
-  // response smuggling attack.
-  if (HttpUtil::HeadersContainMultipleCopiesOfField(*response->headers,
-                                                    "location")) {
-    return ERR_RESPONSE_HEADERS_MULTIPLE_LOCATION;
+scoped_refptr<HttpResponseHeaders>
+SpdyHeadersToHttpResponseHeadersUsingBuilder(
+    const spdy::Http2HeaderBlock& headers) {
+  // The ":status" header is required.
+  spdy::Http2HeaderBlock::const_iterator it =
+      headers.find(spdy::kHttp2StatusHeader);
+  if (it == headers.end())
+    return nullptr;
+
+  // A repeated ":status" is joined with NULs by the header block. Only the
+  // first value is used for the status line.
+  base::StringPiece status = base::StringViewToStringPiece(it->second);
+  status = status.substr(0, status.find('\0'));
+
+  HttpResponseHeaders::Builder builder(HttpVersion(1, 1), status);
+  builder.Reserve(headers.size());
+  for (const auto& [name_view, value_view] : headers) {
+    const auto name = base::StringViewToStringPiece(name_view);
+    DCHECK_GT(name.size(), 0u);
+    if (name[0] == ':') {
+      // https://tools.ietf.org/html/rfc7540#section-8.1.2.4
+      // Skip pseudo headers.
+      continue;
+    }
+    // Split NUL-separated values into one header line per value, as above.
+    // The pieces point into |headers|, which outlives the builder.
+    const auto value = base::StringViewToStringPiece(value_view);
+    size_t start = 0;
+    size_t end = 0;
+    do {
+      end = value.find('\0', start);
+      builder.AddHeader(name, end != value.npos
+                                  ? value.substr(start, end - start)
+                                  : value.substr(start));
+      start = end + 1;
+    } while (end != value.npos);
   }
 
-  response->was_fetched_via_spdy = true;
-  return OK;
+  return builder.Build();
 }
 
 void CreateSpdyHeadersFromHttpRequest(const HttpRequestInfo& info,
@@ -5,6 +5,7 @@
 #ifndef NET_SPDY_SPDY_HTTP_UTILS_H_
 #define NET_SPDY_SPDY_HTTP_UTILS_H_
 
+#include "base/memory/scoped_refptr.h"
 #include "net/base/net_export.h"
 #include "net/base/request_priority.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/spdy_framer.h"
@@ -14,6 +15,7 @@
 
 namespace net {
 
+class HttpResponseHeaders;
 class HttpResponseInfo;
 struct HttpRequestInfo;
 class HttpRequestHeaders;
@@ -27,6 +29,27 @@ class HttpRequestHeaders;
 NET_EXPORT int SpdyHeadersToHttpResponse(const spdy::Http2HeaderBlock& headers,
                                          HttpResponseInfo* response);
 
+// Converts a spdy::Http2HeaderBlock into HttpResponseHeaders. Returns nullptr
+// if the ":status" pseudo-header is missing. Uses one of the two
+// implementations below depending on the
+// features::kSpdyHeadersToHttpResponseUseBuilder feature.
+NET_EXPORT scoped_refptr<HttpResponseHeaders> SpdyHeadersToHttpResponseHeaders(
+    const spdy::Http2HeaderBlock& headers);
+
+// Implementation of SpdyHeadersToHttpResponseHeaders() that assembles an
+// intermediate NUL-separated raw header string and parses it. Exposed for
+// tests and benchmarks.
+NET_EXPORT scoped_refptr<HttpResponseHeaders>
+SpdyHeadersToHttpResponseHeadersUsingRawString(
+    const spdy::Http2HeaderBlock& headers);
+
+// Implementation of SpdyHeadersToHttpResponseHeaders() that feeds views into
+// |headers| straight into HttpResponseHeaders::Builder. Exposed for tests and
+// benchmarks.
+NET_EXPORT scoped_refptr<HttpResponseHeaders>
+SpdyHeadersToHttpResponseHeadersUsingBuilder(
+    const spdy::Http2HeaderBlock& headers);
+
 // Create a spdy::Http2HeaderBlock from HttpRequestInfo and HttpRequestHeaders.
 NET_EXPORT void CreateSpdyHeadersFromHttpRequest(
     const HttpRequestInfo& info,
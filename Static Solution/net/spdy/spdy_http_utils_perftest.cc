@@ -0,0 +1,179 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_http_utils.h"
+
+#include <string>
+#include <utility>
+
+#include "base/check.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/log/net_log_with_source.h"
+#include "net/spdy/buffered_spdy_framer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace net {
+namespace {
+
+static constexpr char kMetricPrefixSpdyHeaders[] =
+    "SpdyHeadersToHttpResponse.";
+static constexpr char kMetricRawStringTimeUs[] =
+    "raw_string_time_per_response";
+static constexpr char kMetricBuilderTimeUs[] = "builder_time_per_response";
+static constexpr char kMetricDecodeTimeUs[] = "decode_time_per_response";
+static constexpr char kMetricHeaderBlockBytes[] =
+    "header_block_bytes_per_response";
+
+constexpr int kIterations = 20000;
+
+// Large enough for the header-heavy response below.
+constexpr uint32_t kMaxHeaderListSize = 256 * 1024;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixSpdyHeaders, story);
+  reporter.RegisterImportantMetric(kMetricRawStringTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricBuilderTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricDecodeTimeUs, "us");
+  reporter.RegisterImportantMetric(kMetricHeaderBlockBytes, "bytes");
+  return reporter;
+}
+
+// A header-heavy response, roughly what a CDN in front of a large web
+// application sends: long cookies, security policies and tracing headers.
+spdy::Http2HeaderBlock MakeHeavyResponseHeaders() {
+  spdy::Http2HeaderBlock headers;
+  headers[spdy::kHttp2StatusHeader] = "200";
+  headers["content-type"] = "text/html; charset=utf-8";
+  headers["cache-control"] = "private, max-age=0, must-revalidate";
+  headers["content-encoding"] = "br";
+  headers["vary"] = "accept-encoding, origin, cookie";
+  headers["strict-transport-security"] =
+      "max-age=31536000; includeSubDomains; preload";
+  headers["content-security-policy"] =
+      "default-src 'self'; script-src 'self' 'unsafe-inline' "
+      "https://cdn.example.com https://analytics.example.com; "
+      "img-src * data:; style-src 'self' 'unsafe-inline'; frame-ancestors "
+      "'none'; report-uri https://csp.example.com/report";
+  for (int i = 0; i < 12; ++i) {
+    headers.AppendValueOrAddHeader(
+        "set-cookie",
+        base::StringPrintf("cookie%d=%s; Path=/; Secure; HttpOnly; "
+                           "SameSite=Lax; Max-Age=86400",
+                           i, std::string(48, 'a' + i).c_str()));
+  }
+  for (int i = 0; i < 24; ++i) {
+    headers[base::StringPrintf("x-edge-header-%d", i)] =
+        base::StringPrintf("value-%d-%s", i, std::string(24, 'z').c_str());
+  }
+  return headers;
+}
+
+// Counts delivered header blocks; everything else is ignored.
+class CountingVisitor : public BufferedSpdyFramerVisitorInterface {
+ public:
+  void OnError(http2::Http2DecoderAdapter::SpdyFramerError) override {
+    CHECK(false);
+  }
+  void OnStreamError(spdy::SpdyStreamId, const std::string&) override {
+    CHECK(false);
+  }
+  void OnHeaders(spdy::SpdyStreamId stream_id,
+                 bool has_priority,
+                 int weight,
+                 spdy::SpdyStreamId parent_stream_id,
+                 bool exclusive,
+                 bool fin,
+                 spdy::Http2HeaderBlock headers,
+                 base::TimeTicks recv_first_byte_time) override {
+    HttpResponseInfo response;
+    CHECK_EQ(OK, SpdyHeadersToHttpResponse(headers, &response));
+    ++headers_count_;
+  }
+  void OnDataFrameHeader(spdy::SpdyStreamId, size_t, bool) override {}
+  void OnStreamFrameData(spdy::SpdyStreamId, const char*, size_t) override {}
+  void OnStreamEnd(spdy::SpdyStreamId) override {}
+  void OnStreamPadding(spdy::SpdyStreamId, size_t) override {}
+  void OnSettings() override {}
+  void OnSetting(spdy::SpdySettingsId, uint32_t) override {}
+  void OnSettingsAck() override {}
+  void OnSettingsEnd() override {}
+  void OnPing(spdy::SpdyPingId, bool) override {}
+  void OnRstStream(spdy::SpdyStreamId, spdy::SpdyErrorCode) override {}
+  void OnGoAway(spdy::SpdyStreamId,
+                spdy::SpdyErrorCode,
+                base::StringPiece) override {}
+  void OnWindowUpdate(spdy::SpdyStreamId, int) override {}
+  void OnPushPromise(spdy::SpdyStreamId,
+                     spdy::SpdyStreamId,
+                     spdy::Http2HeaderBlock) override {}
+  void OnAltSvc(spdy::SpdyStreamId,
+                base::StringPiece,
+                const spdy::SpdyAltSvcWireFormat::AlternativeServiceVector&)
+      override {}
+  bool OnUnknownFrame(spdy::SpdyStreamId, uint8_t) override { return true; }
+
+  int headers_count() const { return headers_count_; }
+
+ private:
+  int headers_count_ = 0;
+};
+
+TEST(SpdyHttpUtilsPerfTest, HeaderHeavyResponse) {
+  const spdy::Http2HeaderBlock headers = MakeHeavyResponseHeaders();
+  auto reporter = SetUpReporter("HeaderHeavyResponse");
+
+  {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      scoped_refptr<HttpResponseHeaders> response_headers =
+          SpdyHeadersToHttpResponseHeadersUsingRawString(headers);
+      CHECK(response_headers);
+    }
+    reporter.AddResult(kMetricRawStringTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+
+  {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      scoped_refptr<HttpResponseHeaders> response_headers =
+          SpdyHeadersToHttpResponseHeadersUsingBuilder(headers);
+      CHECK(response_headers);
+    }
+    reporter.AddResult(kMetricBuilderTimeUs,
+                       timer.Elapsed().InMicrosecondsF() / kIterations);
+  }
+
+  // End to end: HPACK-decode a HEADERS frame per response on one session
+  // framer, then convert it.
+  BufferedSpdyFramer encoder(kMaxHeaderListSize, NetLogWithSource());
+  BufferedSpdyFramer decoder(kMaxHeaderListSize, NetLogWithSource());
+  CountingVisitor visitor;
+  decoder.set_visitor(&visitor);
+  std::string frames;
+  for (int i = 0; i < kIterations; ++i) {
+    spdy::SpdyHeadersIR headers_ir(/*stream_id=*/2 * i + 1, headers.Clone());
+    spdy::SpdySerializedFrame frame = encoder.SerializeFrame(headers_ir);
+    frames.append(frame.data(), frame.size());
+  }
+  base::ElapsedTimer timer;
+  size_t processed = decoder.ProcessInput(frames.data(), frames.size());
+  reporter.AddResult(kMetricDecodeTimeUs,
+                     timer.Elapsed().InMicrosecondsF() / kIterations);
+  EXPECT_EQ(frames.size(), processed);
+  EXPECT_EQ(kIterations, visitor.headers_count());
+  reporter.AddResult(
+      kMetricHeaderBlockBytes,
+      static_cast<size_t>(decoder.header_block_stats().header_block_bytes /
+                          kIterations));
+}
+
+}  // namespace
+}  // namespace net
@@ -8,7 +8,10 @@
 
 #include <limits>
 
+#include "net/base/net_errors.h"
 #include "net/http/http_request_info.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/spdy_framer.h"
 #include "net/third_party/quiche/src/quiche/spdy/test_tools/spdy_test_utils.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -71,4 +74,57 @@ TEST(SpdyHttpUtilsTest, CreateSpdyHeadersFromHttpRequestConnectHTTP2) {
   EXPECT_EQ("Chrome/1.1", headers["user-agent"]);
 }
 
+TEST(SpdyHttpUtilsTest, SpdyHeadersToHttpResponseHeadersMissingStatus) {
+  spdy::Http2HeaderBlock headers;
+  headers["content-type"] = "text/html";
+  EXPECT_FALSE(SpdyHeadersToHttpResponseHeadersUsingRawString(headers));
+  EXPECT_FALSE(SpdyHeadersToHttpResponseHeadersUsingBuilder(headers));
+
+  HttpResponseInfo response;
+  EXPECT_EQ(ERR_INCOMPLETE_HTTP2_HEADERS,
+            SpdyHeadersToHttpResponse(headers, &response));
+}
+
+// The builder-based conversion must produce exactly the same
+// HttpResponseHeaders as the raw-string conversion.
+TEST(SpdyHttpUtilsTest, SpdyHeadersToHttpResponseHeadersBuilderMatchesRaw) {
+  spdy::Http2HeaderBlock headers;
+  headers[spdy::kHttp2StatusHeader] = "200";
+  headers["content-type"] = "text/html; charset=utf-8";
+  headers["cache-control"] = "max-age=3600, public";
+  headers.AppendValueOrAddHeader("set-cookie", "a=b");
+  headers.AppendValueOrAddHeader("set-cookie", "c=d; Secure");
+  headers["vary"] = "accept-encoding, origin";
+  headers["x-empty"] = "";
+
+  scoped_refptr<HttpResponseHeaders> raw =
+      SpdyHeadersToHttpResponseHeadersUsingRawString(headers);
+  scoped_refptr<HttpResponseHeaders> built =
+      SpdyHeadersToHttpResponseHeadersUsingBuilder(headers);
+  ASSERT_TRUE(raw);
+  ASSERT_TRUE(built);
+  EXPECT_EQ(raw->raw_headers(), built->raw_headers());
+  EXPECT_EQ(200, built->response_code());
+
+  size_t iter = 0;
+  std::string value;
+  EXPECT_TRUE(built->EnumerateHeader(&iter, "set-cookie", &value));
+  EXPECT_EQ("a=b", value);
+  EXPECT_TRUE(built->EnumerateHeader(&iter, "set-cookie", &value));
+  EXPECT_EQ("c=d; Secure", value);
+  EXPECT_FALSE(built->EnumerateHeader(&iter, "set-cookie", &value));
+}
+
+TEST(SpdyHttpUtilsTest, SpdyHeadersToHttpResponseHeadersRepeatedStatus) {
+  spdy::Http2HeaderBlock headers;
+  headers.AppendValueOrAddHeader(spdy::kHttp2StatusHeader, "200");
+  headers.AppendValueOrAddHeader(spdy::kHttp2StatusHeader, "404");
+
+  scoped_refptr<HttpResponseHeaders> built =
+      SpdyHeadersToHttpResponseHeadersUsingBuilder(headers);
+  ASSERT_TRUE(built);
+  EXPECT_EQ(200, built->response_code());
+  EXPECT_EQ("HTTP/1.1 200", built->GetStatusLine());
+}
+
 }  // namespace net
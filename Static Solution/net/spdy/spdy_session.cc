@@ -3016,6 +3016,14 @@ void SpdySession::RecordHistograms() {
                           bytes_pushed_and_unclaimed_count_);
   UMA_HISTOGRAM_BOOLEAN("Net.SpdySession.ServerSupportsWebSocket",
                         support_websocket_);
+  if (buffered_spdy_framer_) {
+    const BufferedSpdyFramer::HeaderBlockStats& stats =
+        buffered_spdy_framer_->header_block_stats();
+    UMA_HISTOGRAM_COUNTS_10M("Net.SpdySession.HeaderBlockBytesReceived",
+                             stats.header_block_bytes);
+    UMA_HISTOGRAM_COUNTS_1M("Net.SpdySession.MaxHeaderBlockBytes",
+                            stats.max_header_block_bytes);
+  }
 }
 
 void SpdySession::RecordProtocolErrorHistogram(
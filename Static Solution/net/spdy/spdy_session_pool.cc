@@ -475,6 +475,38 @@ void SpdySessionPool::CloseAllSessions() {
   }
 }
 
+void SpdySessionPool::EnablePreconnectPrediction(
+    const Http2PreconnectPredictor::Params& params,
+    PreconnectCallback preconnect_callback) {
+  DCHECK(preconnect_callback);
+  DCHECK(!preconnect_predictor_);
+  preconnect_callback_ = std::move(preconnect_callback);
+  preconnect_predictor_ =
+      std::make_unique<Http2PreconnectPredictor>(params, this, time_func_);
+}
+
+void SpdySessionPool::OnSessionRequested(const SpdySessionKey& key) {
+  if (!preconnect_predictor_)
+    return;
+  // Only learn from plain direct connections; proxied and tagged sessions
+  // can't be recreated from the key alone.
+  if (!key.proxy_server().is_direct() ||
+      key.is_proxy_session() == SpdySessionKey::IsProxySession::kTrue ||
+      key.socket_tag() != SocketTag()) {
+    return;
+  }
+  preconnect_predictor_->OnRequest(key);
+}
+
+bool SpdySessionPool::HasAvailableSessionForPrediction(
+    const SpdySessionKey& key) const {
+  return HasAvailableSession(key, /*is_websocket=*/false);
+}
+
+void SpdySessionPool::PreconnectForPrediction(const SpdySessionKey& key) {
+  preconnect_callback_.Run(key);
+}
+
 std::unique_ptr<base::Value> SpdySessionPool::SpdySessionPoolInfoToValue()
     const {
   base::Value::List list;
@@ -493,6 +525,8 @@ std::unique_ptr<base::Value> SpdySessionPool::SpdySessionPoolInfoToValue()
 
 void SpdySessionPool::OnIPAddressChanged() {
   DCHECK(cleanup_sessions_on_ip_address_changed_);
+  if (preconnect_predictor_)
+    preconnect_predictor_->OnNetworkChanged();
   WeakSessionList current_sessions = GetCurrentSessions();
   for (WeakSessionList::const_iterator it = current_sessions.begin();
        it != current_sessions.end(); ++it) {
@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/memory/raw_ptr.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
@@ -28,6 +29,7 @@
 #include "net/proxy_resolution/proxy_config.h"
 #include "net/socket/connect_job.h"
 #include "net/socket/ssl_client_socket.h"
+#include "net/spdy/http2_preconnect_predictor.h"
 #include "net/spdy/http2_push_promise_index.h"
 #include "net/spdy/server_push_delegate.h"
 #include "net/spdy/spdy_session_key.h"
@@ -50,10 +52,16 @@ class TransportSecurityState;
 // This is a very simple pool for open SpdySessions.
 class NET_EXPORT SpdySessionPool
     : public NetworkChangeNotifier::IPAddressObserver,
-      public SSLClientContext::Observer {
+      public SSLClientContext::Observer,
+      public Http2PreconnectPredictor::Delegate {
  public:
   typedef base::TimeTicks (*TimeFunc)();
 
+  // Warms up a session (DNS, TCP and TLS) for the given key. Used for
+  // predictive preconnects, see EnablePreconnectPrediction().
+  using PreconnectCallback =
+      base::RepeatingCallback<void(const SpdySessionKey& key)>;
+
   // Struct to hold randomly generated frame parameters to be used for sending
   // frames on the wire to "grease" frame type.  Frame type has to be one of
   // the reserved values defined in
@@ -319,6 +327,29 @@ class NET_EXPORT SpdySessionPool
   std::set<std::string> GetDnsAliasesForSessionKey(
       const SpdySessionKey& key) const;
 
+  // Starts learning which sessions are requested together per
+  // NetworkIsolationKey, and invoking |preconnect_callback| to warm up the
+  // likely followers when the first session of a group is requested. See
+  // Http2PreconnectPredictor.
+  void EnablePreconnectPrediction(
+      const Http2PreconnectPredictor::Params& params,
+      PreconnectCallback preconnect_callback);
+
+  // Informs the preconnect predictor, if enabled, that a request that may be
+  // served over HTTP/2 is looking for a session for |key|. Must not be called
+  // for preconnects.
+  void OnSessionRequested(const SpdySessionKey& key);
+
+  // Returns the preconnect predictor, or nullptr if prediction is disabled.
+  const Http2PreconnectPredictor* preconnect_predictor() const {
+    return preconnect_predictor_.get();
+  }
+
+  // Http2PreconnectPredictor::Delegate implementation:
+  bool HasAvailableSessionForPrediction(
+      const SpdySessionKey& key) const override;
+  void PreconnectForPrediction(const SpdySessionKey& key) override;
+
  private:
   friend class SpdySessionPoolPeer;  // For testing.
 
@@ -499,6 +530,11 @@ class NET_EXPORT SpdySessionPool
 
   const bool cleanup_sessions_on_ip_address_changed_;
 
+  // Learns co-requested sessions and preconnects them. Null unless
+  // EnablePreconnectPrediction() has been called.
+  std::unique_ptr<Http2PreconnectPredictor> preconnect_predictor_;
+  PreconnectCallback preconnect_callback_;
+
   base::WeakPtrFactory<SpdySessionPool> weak_ptr_factory_{this};
 };
 
@@ -12,6 +12,7 @@
 #include "base/bind.h"
 #include "base/check.h"
 #include "base/logging.h"
+#include "base/memory/raw_ptr.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
@@ -24,7 +25,9 @@
 #include "net/dns/dns_util.h"
 #include "net/dns/public/dns_protocol.h"
 #include "net/http/http_status_code.h"
+#include "net/socket/stream_socket.h"
 #include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/embedded_test_server_connection_listener.h"
 #include "net/test/embedded_test_server/http_request.h"
 #include "net/test/embedded_test_server/http_response.h"
 #include "url/gurl.h"
@@ -62,7 +65,28 @@ std::unique_ptr<test_server::HttpResponse> MakeHttpResponseFromDns(
 
 }  // namespace
 
-TestDohServer::TestDohServer() {
+class TestDohServer::ConnectionCounter
+    : public test_server::EmbeddedTestServerConnectionListener {
+ public:
+  explicit ConnectionCounter(TestDohServer* server) : server_(server) {}
+
+  std::unique_ptr<StreamSocket> AcceptedSocket(
+      std::unique_ptr<StreamSocket> socket) override {
+    base::AutoLock lock(server_->lock_);
+    server_->connections_accepted_++;
+    return socket;
+  }
+
+  void ReadFromSocket(const StreamSocket& socket, int rv) override {}
+
+ private:
+  const raw_ptr<TestDohServer> server_;
+};
+
+TestDohServer::TestDohServer(test_server::HttpConnection::Protocol protocol)
+    : connection_counter_(std::make_unique<ConnectionCounter>(this)),
+      server_(EmbeddedTestServer::TYPE_HTTPS, protocol) {
+  server_.SetConnectionListener(connection_counter_.get());
   server_.RegisterRequestHandler(base::BindRepeating(
       &TestDohServer::HandleRequest, base::Unretained(this)));
 }
@@ -136,6 +160,11 @@ int TestDohServer::QueriesServed() {
   return queries_served_;
 }
 
+int TestDohServer::ConnectionsAccepted() {
+  base::AutoLock lock(lock_);
+  return connections_accepted_;
+}
+
 std::unique_ptr<test_server::HttpResponse> TestDohServer::HandleRequest(
     const test_server::HttpRequest& request) {
   GURL request_url = request.GetURL();
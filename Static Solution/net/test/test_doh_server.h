@@ -19,6 +19,7 @@
 #include "net/base/ip_address.h"
 #include "net/dns/dns_response.h"
 #include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/http_connection.h"
 #include "net/test/embedded_test_server/http_response.h"
 
 namespace net {
@@ -27,7 +28,11 @@ namespace net {
 // at the level of individual DNS records.
 class TestDohServer {
  public:
-  TestDohServer();
+  // `protocol` selects whether queries are served over HTTP/1.1 or HTTP/2. Over
+  // HTTP/2, concurrent queries from a client are multiplexed over a single
+  // connection.
+  explicit TestDohServer(test_server::HttpConnection::Protocol protocol =
+                             test_server::HttpConnection::Protocol::kHttp1);
   ~TestDohServer();
 
   // Configures the hostname the DoH server serves from. If not specified, the
@@ -72,6 +77,9 @@ class TestDohServer {
   // Returns the number of queries served so far.
   int QueriesServed();
 
+  // Returns the number of connections accepted so far.
+  int ConnectionsAccepted();
+
   // Returns the URI template to connect to this server. The server's listening
   // port must have been allocated with `Start` or `InitializeAndListen` before
   // calling this function.
@@ -82,6 +90,8 @@ class TestDohServer {
   std::string GetPostOnlyTemplate();
 
  private:
+  class ConnectionCounter;
+
   std::unique_ptr<test_server::HttpResponse> HandleRequest(
       const test_server::HttpRequest& request);
 
@@ -94,7 +104,10 @@ class TestDohServer {
   std::multimap<std::pair<std::string, uint16_t>, DnsResourceRecord> records_
       GUARDED_BY(lock_);
   int queries_served_ GUARDED_BY(lock_) = 0;
-  EmbeddedTestServer server_{EmbeddedTestServer::TYPE_HTTPS};
+  int connections_accepted_ GUARDED_BY(lock_) = 0;
+  // Must outlive `server_`, which notifies it from the background thread.
+  std::unique_ptr<ConnectionCounter> connection_counter_;
+  EmbeddedTestServer server_;
 };
 
 }  // namespace net
@@ -0,0 +1,202 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Replays a recorded trace of cache accesses against the eviction policies of
+// the simple cache, and reports the hit ratio each of them achieves.
+//
+// Each line of the trace is "<time> <key> <size>": the time of the access in
+// seconds since the Unix epoch, the cache key, and the size in bytes of the
+// entry for that key. Blank lines and lines starting with '#' are ignored.
+// A miss inserts the entry; eviction then works as in SimpleIndex, except
+// that it completes immediately.
+
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/format_macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "net/disk_cache/simple/simple_eviction_policy.h"
+#include "net/disk_cache/simple/simple_index.h"
+#include "net/disk_cache/simple/simple_util.h"
+
+namespace disk_cache {
+namespace {
+
+const char kMaxSizeSwitch[] = "max-size";
+const char kPolicySwitch[] = "policy";
+
+const char kRecencyPolicy[] = "recency";
+const char kFrequencyPolicy[] = "frequency";
+
+// As in SimpleIndex.
+const uint64_t kEvictionMarginDivisor = 20;
+
+struct Access {
+  base::Time time;
+  uint64_t entry_hash;
+  uint32_t size;
+};
+
+struct ReplayResult {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t hit_bytes = 0;
+  uint64_t total_bytes = 0;
+  uint64_t evictions = 0;
+};
+
+void PrintUsage(std::ostream* stream) {
+  *stream << "Usage: disk_cache_eviction_simulator "
+          << "--max-size=<bytes> "
+          << "[--policy=<policy>] "
+          << "<trace file>" << std::endl
+          << "  with <policy>='recency'|'frequency', or both if omitted"
+          << std::endl
+          << "  and each line of <trace file> '<seconds> <key> <size>'"
+          << std::endl;
+}
+
+bool ReadTrace(const base::FilePath& path, std::vector<Access>* trace) {
+  std::string contents;
+  if (!base::ReadFileToString(path, &contents)) {
+    std::cerr << "Could not read " << path.AsUTF8Unsafe() << std::endl;
+    return false;
+  }
+  int line_number = 0;
+  for (base::StringPiece line : base::SplitStringPiece(
+           contents, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL)) {
+    ++line_number;
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::vector<base::StringPiece> fields = base::SplitStringPiece(
+        line, " \t", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    int64_t seconds;
+    unsigned size;
+    if (fields.size() != 3 || !base::StringToInt64(fields[0], &seconds) ||
+        !base::StringToUint(fields[2], &size)) {
+      std::cerr << "Malformed trace line " << line_number << std::endl;
+      return false;
+    }
+    trace->push_back({base::Time::UnixEpoch() + base::Seconds(seconds),
+                      simple_util::GetEntryHashKey(std::string(fields[1])),
+                      size});
+  }
+  return true;
+}
+
+ReplayResult Replay(const std::vector<Access>& trace,
+                    uint64_t max_size,
+                    SimpleEvictionPolicy* policy) {
+  const uint64_t high_watermark = max_size - max_size / kEvictionMarginDivisor;
+  const uint64_t low_watermark =
+      max_size - 2 * (max_size / kEvictionMarginDivisor);
+  policy->SetMaxSize(max_size);
+
+  SimpleIndex::EntrySet entries;
+  uint64_t cache_size = 0;
+  ReplayResult result;
+  std::vector<uint64_t> victims;
+  for (const Access& access : trace) {
+    policy->RecordAccess(access.entry_hash);
+    result.total_bytes += access.size;
+    auto it = entries.find(access.entry_hash);
+    if (it != entries.end()) {
+      ++result.hits;
+      result.hit_bytes += access.size;
+      it->second.SetLastUsedTime(access.time);
+      continue;
+    }
+
+    ++result.misses;
+    const EntryMetadata metadata(access.time, access.size);
+    cache_size += metadata.GetEntrySize();
+    entries.emplace(access.entry_hash, metadata);
+    if (cache_size <= high_watermark)
+      continue;
+
+    victims.clear();
+    policy->SelectEntriesToEvict(entries, access.time,
+                                 cache_size - low_watermark, &victims);
+    for (uint64_t victim : victims) {
+      auto victim_it = entries.find(victim);
+      cache_size -= victim_it->second.GetEntrySize();
+      entries.erase(victim_it);
+    }
+    result.evictions += victims.size();
+  }
+  return result;
+}
+
+void PrintResult(const std::string& policy_name, const ReplayResult& result) {
+  const uint64_t requests = result.hits + result.misses;
+  std::cout << base::StringPrintf(
+                   "%-10s hits %.2f%% bytes %.2f%% (%" PRIu64 " of %" PRIu64
+                   " requests, %" PRIu64 " evictions)",
+                   policy_name.c_str(),
+                   requests ? 100.0 * result.hits / requests : 0.0,
+                   result.total_bytes
+                       ? 100.0 * result.hit_bytes / result.total_bytes
+                       : 0.0,
+                   result.hits, requests, result.evictions)
+            << std::endl;
+}
+
+bool Main(int argc, char** argv) {
+  base::AtExitManager at_exit_manager;
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (command_line.HasSwitch("help")) {
+    PrintUsage(&std::cout);
+    return true;
+  }
+
+  uint64_t max_size = 0;
+  if (command_line.GetArgs().size() != 1 ||
+      !base::StringToUint64(command_line.GetSwitchValueASCII(kMaxSizeSwitch),
+                            &max_size) ||
+      max_size == 0) {
+    PrintUsage(&std::cerr);
+    return false;
+  }
+  const std::string policy = command_line.GetSwitchValueASCII(kPolicySwitch);
+  if (!policy.empty() && policy != kRecencyPolicy &&
+      policy != kFrequencyPolicy) {
+    PrintUsage(&std::cerr);
+    return false;
+  }
+
+  std::vector<Access> trace;
+  if (!ReadTrace(base::FilePath(command_line.GetArgs()[0]), &trace))
+    return false;
+
+  if (policy.empty() || policy == kRecencyPolicy) {
+    SimpleRecencyEvictionPolicy recency(/*use_size_heuristic=*/true);
+    PrintResult(kRecencyPolicy, Replay(trace, max_size, &recency));
+  }
+  if (policy.empty() || policy == kFrequencyPolicy) {
+    SimpleFrequencyEvictionPolicy frequency(/*use_size_heuristic=*/true);
+    PrintResult(kFrequencyPolicy, Replay(trace, max_size, &frequency));
+  }
+  return true;
+}
+
+}  // namespace
+}  // namespace disk_cache
+
+int main(int argc, char** argv) {
+  return !disk_cache::Main(argc, argv);
+}
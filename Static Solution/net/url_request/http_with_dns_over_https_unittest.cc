@@ -15,8 +15,10 @@
 #include "base/test/scoped_feature_list.h"
 #include "net/base/features.h"
 #include "net/base/network_change_notifier.h"
+#include "net/base/network_isolation_key.h"
 #include "net/base/privacy_mode.h"
 #include "net/base/proxy_server.h"
+#include "net/base/test_completion_callback.h"
 #include "net/dns/context_host_resolver.h"
 #include "net/dns/dns_client.h"
 #include "net/dns/dns_config.h"
@@ -33,8 +35,10 @@
 #include "net/dns/public/util.h"
 #include "net/http/http_stream_factory_test_util.h"
 #include "net/log/net_log.h"
+#include "net/log/net_log_with_source.h"
 #include "net/socket/transport_client_socket_pool.h"
 #include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/http_connection.h"
 #include "net/test/embedded_test_server/http_request.h"
 #include "net/test/embedded_test_server/http_response.h"
 #include "net/test/gtest_util.h"
@@ -123,8 +127,11 @@ class DohProber : public NetworkChangeNotifier::DNSObserver {
 // configured to use it.
 class DnsOverHttpsIntegrationTest : public TestWithTaskEnvironment {
  public:
-  DnsOverHttpsIntegrationTest()
-      : host_resolver_proc_(base::MakeRefCounted<TestHostResolverProc>()) {
+  explicit DnsOverHttpsIntegrationTest(
+      test_server::HttpConnection::Protocol doh_protocol =
+          test_server::HttpConnection::Protocol::kHttp1)
+      : doh_server_(doh_protocol),
+        host_resolver_proc_(base::MakeRefCounted<TestHostResolverProc>()) {
     doh_server_.SetHostname(kDohHostname);
     EXPECT_TRUE(doh_server_.Start());
 
@@ -219,6 +226,14 @@ class HttpsWithDnsOverHttpsTest : public DnsOverHttpsIntegrationTest {
   uint32_t test_https_requests_served_ = 0;
 };
 
+// A `DnsOverHttpsIntegrationTest` whose DoH server speaks HTTP/2.
+class Http2DnsOverHttpsIntegrationTest : public DnsOverHttpsIntegrationTest {
+ public:
+  Http2DnsOverHttpsIntegrationTest()
+      : DnsOverHttpsIntegrationTest(
+            test_server::HttpConnection::Protocol::kHttp2) {}
+};
+
 class TestHttpDelegate : public HttpStreamRequest::Delegate {
  public:
   explicit TestHttpDelegate(base::RunLoop* loop) : loop_(loop) {}
@@ -433,6 +448,33 @@ TEST_F(HttpsWithDnsOverHttpsTest, HttpsMetadata) {
   EXPECT_EQ(d.data_received(), kTestBody);
 }
 
+// Test that the A, AAAA and HTTPS queries for a host, which are sent in
+// parallel, and later queries are all multiplexed over a single HTTP/2
+// connection to the DoH server.
+TEST_F(Http2DnsOverHttpsIntegrationTest, QueriesShareConnection) {
+  base::test::ScopedFeatureList features;
+  features.InitAndEnableFeature(features::kUseDnsHttpsSvcb);
+  ResetContext();
+  doh_server_.AddAddressRecord(kHostname, IPAddress::IPv4Localhost());
+  doh_server_.AddAddressRecord(kHostname, IPAddress::IPv6Localhost());
+  const char kOtherHostname[] = "baz.example.com";
+  doh_server_.AddAddressRecord(kOtherHostname, IPAddress::IPv4Localhost());
+
+  for (const char* hostname : {kHostname, kOtherHostname}) {
+    SCOPED_TRACE(hostname);
+    std::unique_ptr<HostResolver::ResolveHostRequest> request =
+        context()->host_resolver()->CreateRequest(
+            url::SchemeHostPort(url::kHttpsScheme, hostname, 443),
+            NetworkIsolationKey(), NetLogWithSource(), absl::nullopt);
+    TestCompletionCallback callback;
+    int rv = request->Start(callback.callback());
+    EXPECT_THAT(callback.GetResult(rv), IsOk());
+  }
+
+  EXPECT_EQ(6, doh_server_.QueriesServed());
+  EXPECT_EQ(1, doh_server_.ConnectionsAccepted());
+}
+
 TEST_F(DnsOverHttpsIntegrationTest, EncryptedClientHello) {
   // Configure a test server that speaks ECH.
   static constexpr char kRealName[] = "secret.example";